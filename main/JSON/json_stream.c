@@ -0,0 +1,391 @@
+#include "json_stream.h"
+
+#include <string.h>
+
+enum {
+    ST_VALUE = 0,     // expecting a value
+    ST_VALUE_OR_END,  // after '[': value or ']'
+    ST_KEY_OR_END,    // after '{': key or '}'
+    ST_KEY,           // after ',' inside an object
+    ST_COLON,         // after a key
+    ST_AFTER_VALUE,   // expecting ',' or a closing bracket
+    ST_STRING,
+    ST_STRING_ESC,
+    ST_STRING_UNICODE,
+    ST_NUMBER,
+    ST_LITERAL,
+};
+
+static const char *const s_literals[] = {"true", "false", "null"};
+static const json_stream_event_t s_literal_events[] = {JSON_STREAM_TRUE, JSON_STREAM_FALSE, JSON_STREAM_NULL};
+
+void json_stream_init(json_stream_t *js, char *tok_buf, size_t tok_size, json_stream_cb_t cb, void *ctx)
+{
+    memset(js, 0, sizeof(*js));
+    js->cb = cb;
+    js->ctx = ctx;
+    js->tok = tok_buf;
+    js->tok_size = tok_size;
+    js->state = ST_VALUE;
+    if (tok_buf != NULL && tok_size > 0) {
+        tok_buf[0] = '\0';
+    }
+}
+
+static bool is_ws(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool top_is_array(const json_stream_t *js)
+{
+    if (js->skip_depth > 0) {
+        return (js->skip_is_array >> (js->skip_depth - 1)) & 1u;
+    }
+    return js->depth > 0 && js->stack[js->depth - 1].is_array;
+}
+
+static bool emit(json_stream_t *js, json_stream_event_t ev, const char *value, size_t len)
+{
+    if (js->skip_depth > 0 || js->cb == NULL) {
+        return true;
+    }
+    return js->cb(js, ev, value, len, js->ctx);
+}
+
+static void tok_reset(json_stream_t *js)
+{
+    js->tok_len = 0;
+    js->tok_truncated = false;
+    if (js->tok_size > 0) {
+        js->tok[0] = '\0';
+    }
+}
+
+static void tok_put(json_stream_t *js, char c)
+{
+    if (js->in_key) {
+        if (js->skip_depth > 0 || js->depth == 0) {
+            return;
+        }
+        char *key = js->stack[js->depth - 1].key;
+        size_t n = strlen(key);
+        if (n < JSON_STREAM_KEY_MAX - 1) {
+            key[n] = c;
+            key[n + 1] = '\0';
+        }
+        return;
+    }
+
+    if (js->tok_len + 1 < js->tok_size) {
+        js->tok[js->tok_len++] = c;
+        js->tok[js->tok_len] = '\0';
+    } else {
+        js->tok_truncated = true;
+    }
+}
+
+static void tok_put_utf8(json_stream_t *js, uint16_t cp)
+{
+    if (cp >= 0xD800 && cp <= 0xDFFF) {
+        // Surrogate pairs are not worth the state; nothing we display needs them.
+        tok_put(js, '?');
+    } else if (cp < 0x80) {
+        tok_put(js, (char)cp);
+    } else if (cp < 0x800) {
+        tok_put(js, (char)(0xC0 | (cp >> 6)));
+        tok_put(js, (char)(0x80 | (cp & 0x3F)));
+    } else {
+        tok_put(js, (char)(0xE0 | (cp >> 12)));
+        tok_put(js, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        tok_put(js, (char)(0x80 | (cp & 0x3F)));
+    }
+}
+
+// A complete value (scalar or container) was consumed at the current level.
+static void value_done(json_stream_t *js)
+{
+    if (js->depth == 0 && js->skip_depth == 0) {
+        js->done = true;
+    }
+    js->state = ST_AFTER_VALUE;
+}
+
+static bool push(json_stream_t *js, bool is_array)
+{
+    json_stream_event_t ev = is_array ? JSON_STREAM_ARRAY_BEGIN : JSON_STREAM_OBJECT_BEGIN;
+
+    if (js->skip_depth > 0 || js->depth >= JSON_STREAM_MAX_DEPTH) {
+        if (js->skip_depth >= 32) {
+            return false;
+        }
+        if (is_array) {
+            js->skip_is_array |= (1u << js->skip_depth);
+        } else {
+            js->skip_is_array &= ~(1u << js->skip_depth);
+        }
+        js->skip_depth++;
+    } else {
+        if (!emit(js, ev, NULL, 0)) {
+            return false;
+        }
+        json_stream_level_t *lvl = &js->stack[js->depth++];
+        lvl->is_array = is_array;
+        lvl->key[0] = '\0';
+    }
+
+    js->state = is_array ? ST_VALUE_OR_END : ST_KEY_OR_END;
+    return true;
+}
+
+static bool pop(json_stream_t *js, bool is_array)
+{
+    if (js->skip_depth > 0) {
+        if (top_is_array(js) != is_array) {
+            return false;
+        }
+        js->skip_depth--;
+        value_done(js);
+        return true;
+    }
+
+    if (js->depth == 0 || js->stack[js->depth - 1].is_array != is_array) {
+        return false;
+    }
+    js->depth--;
+    value_done(js);
+    return emit(js, is_array ? JSON_STREAM_ARRAY_END : JSON_STREAM_OBJECT_END, NULL, 0);
+}
+
+static bool begin_value(json_stream_t *js, char c)
+{
+    switch (c) {
+    case '{':
+        return push(js, false);
+    case '[':
+        return push(js, true);
+    case '"':
+        js->in_key = false;
+        tok_reset(js);
+        js->state = ST_STRING;
+        return true;
+    case 't':
+    case 'f':
+    case 'n':
+        js->lit_kind = (c == 't') ? 0 : (c == 'f') ? 1 : 2;
+        js->lit_pos = 1;
+        js->state = ST_LITERAL;
+        return true;
+    default:
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            js->in_key = false;
+            tok_reset(js);
+            tok_put(js, c);
+            js->state = ST_NUMBER;
+            return true;
+        }
+        return false;
+    }
+}
+
+static bool begin_key(json_stream_t *js)
+{
+    js->in_key = true;
+    if (js->skip_depth == 0 && js->depth > 0) {
+        js->stack[js->depth - 1].key[0] = '\0';
+    }
+    js->state = ST_STRING;
+    return true;
+}
+
+static bool end_string(json_stream_t *js)
+{
+    if (js->in_key) {
+        js->in_key = false;
+        js->state = ST_COLON;
+        return true;
+    }
+    value_done(js);
+    return emit(js, JSON_STREAM_STRING, js->tok, js->tok_len);
+}
+
+static bool step(json_stream_t *js, char c)
+{
+    switch (js->state) {
+    case ST_VALUE:
+        if (is_ws(c)) {
+            return true;
+        }
+        if (js->done) {
+            return false;
+        }
+        return begin_value(js, c);
+
+    case ST_VALUE_OR_END:
+        if (is_ws(c)) {
+            return true;
+        }
+        if (c == ']') {
+            return pop(js, true);
+        }
+        return begin_value(js, c);
+
+    case ST_KEY_OR_END:
+        if (is_ws(c)) {
+            return true;
+        }
+        if (c == '}') {
+            return pop(js, false);
+        }
+        return (c == '"') && begin_key(js);
+
+    case ST_KEY:
+        if (is_ws(c)) {
+            return true;
+        }
+        return (c == '"') && begin_key(js);
+
+    case ST_COLON:
+        if (is_ws(c)) {
+            return true;
+        }
+        if (c != ':') {
+            return false;
+        }
+        js->state = ST_VALUE;
+        return true;
+
+    case ST_AFTER_VALUE:
+        if (is_ws(c)) {
+            return true;
+        }
+        if (js->done) {
+            return false;
+        }
+        if (c == ',') {
+            js->state = top_is_array(js) ? ST_VALUE : ST_KEY;
+            return true;
+        }
+        if (c == '}') {
+            return pop(js, false);
+        }
+        if (c == ']') {
+            return pop(js, true);
+        }
+        return false;
+
+    case ST_STRING:
+        if (c == '"') {
+            return end_string(js);
+        }
+        if (c == '\\') {
+            js->state = ST_STRING_ESC;
+            return true;
+        }
+        if ((unsigned char)c < 0x20) {
+            return false;
+        }
+        tok_put(js, c);
+        return true;
+
+    case ST_STRING_ESC:
+        js->state = ST_STRING;
+        switch (c) {
+        case '"':  tok_put(js, '"'); return true;
+        case '\\': tok_put(js, '\\'); return true;
+        case '/':  tok_put(js, '/'); return true;
+        case 'b':  tok_put(js, '\b'); return true;
+        case 'f':  tok_put(js, '\f'); return true;
+        case 'n':  tok_put(js, '\n'); return true;
+        case 'r':  tok_put(js, '\r'); return true;
+        case 't':  tok_put(js, '\t'); return true;
+        case 'u':
+            js->esc_code = 0;
+            js->esc_count = 0;
+            js->state = ST_STRING_UNICODE;
+            return true;
+        default:
+            return false;
+        }
+
+    case ST_STRING_UNICODE: {
+        uint16_t v;
+        if (c >= '0' && c <= '9') {
+            v = (uint16_t)(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            v = (uint16_t)(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            v = (uint16_t)(c - 'A' + 10);
+        } else {
+            return false;
+        }
+        js->esc_code = (uint16_t)((js->esc_code << 4) | v);
+        if (++js->esc_count == 4) {
+            tok_put_utf8(js, js->esc_code);
+            js->state = ST_STRING;
+        }
+        return true;
+    }
+
+    case ST_NUMBER:
+        if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+            tok_put(js, c);
+            return true;
+        }
+        value_done(js);
+        if (!emit(js, JSON_STREAM_NUMBER, js->tok, js->tok_len)) {
+            return false;
+        }
+        // The terminating character belongs to the enclosing container.
+        return step(js, c);
+
+    case ST_LITERAL: {
+        const char *lit = s_literals[js->lit_kind];
+        if (c != lit[js->lit_pos]) {
+            return false;
+        }
+        js->lit_pos++;
+        if (lit[js->lit_pos] == '\0') {
+            value_done(js);
+            return emit(js, s_literal_events[js->lit_kind], NULL, 0);
+        }
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
+
+bool json_stream_feed(json_stream_t *js, const char *data, size_t len)
+{
+    if (js == NULL || js->failed) {
+        return false;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        if (!step(js, data[i])) {
+            js->failed = true;
+            return false;
+        }
+        js->offset++;
+    }
+    return true;
+}
+
+bool json_stream_finish(json_stream_t *js)
+{
+    if (js == NULL || js->failed) {
+        return false;
+    }
+
+    // A bare top-level number has no terminator.
+    if (js->state == ST_NUMBER && js->depth == 0 && js->skip_depth == 0) {
+        value_done(js);
+        if (!emit(js, JSON_STREAM_NUMBER, js->tok, js->tok_len)) {
+            js->failed = true;
+            return false;
+        }
+    }
+    return js->done;
+}
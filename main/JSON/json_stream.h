@@ -0,0 +1,115 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fixed-memory, push-style JSON tokenizer.
+//
+// Feed the document in arbitrary chunks (e.g. straight from a socket read)
+// and receive one callback per value. No DOM is built and nothing is
+// allocated; the only storage is the struct below plus a caller-provided
+// token buffer for string/number values.
+
+#define JSON_STREAM_MAX_DEPTH 8
+#define JSON_STREAM_KEY_MAX   24
+
+typedef enum {
+    JSON_STREAM_OBJECT_BEGIN = 0,
+    JSON_STREAM_OBJECT_END,
+    JSON_STREAM_ARRAY_BEGIN,
+    JSON_STREAM_ARRAY_END,
+    JSON_STREAM_STRING,
+    JSON_STREAM_NUMBER,
+    JSON_STREAM_TRUE,
+    JSON_STREAM_FALSE,
+    JSON_STREAM_NULL,
+} json_stream_event_t;
+
+typedef struct json_stream json_stream_t;
+
+// Called once per value. For *_BEGIN/*_END events the container itself is
+// not part of the path yet/anymore, so every event sees the path of the
+// value it describes. `value` is NUL-terminated for STRING/NUMBER (possibly
+// truncated to the token buffer, see json_stream_value_truncated()) and NULL
+// otherwise. Return false to abort parsing.
+typedef bool (*json_stream_cb_t)(json_stream_t *js, json_stream_event_t ev, const char *value, size_t len, void *ctx);
+
+typedef struct {
+    bool is_array;
+    char key[JSON_STREAM_KEY_MAX];
+} json_stream_level_t;
+
+struct json_stream {
+    json_stream_cb_t cb;
+    void *ctx;
+
+    char *tok;
+    size_t tok_size;
+    size_t tok_len;
+    bool tok_truncated;
+
+    json_stream_level_t stack[JSON_STREAM_MAX_DEPTH];
+    uint8_t depth;
+    // Containers nested deeper than JSON_STREAM_MAX_DEPTH are skipped silently
+    // (up to 32 more levels); one bit per skipped level records array vs object.
+    uint8_t skip_depth;
+    uint32_t skip_is_array;
+
+    uint8_t state;
+    uint8_t lit_kind;
+    uint8_t lit_pos;
+    uint8_t esc_count;
+    uint16_t esc_code;
+    bool in_key;
+    bool done;
+    bool failed;
+    uint32_t offset;
+};
+
+void json_stream_init(json_stream_t *js, char *tok_buf, size_t tok_size, json_stream_cb_t cb, void *ctx);
+
+// Consume the next chunk. Returns false on syntax error or when the callback aborted.
+bool json_stream_feed(json_stream_t *js, const char *data, size_t len);
+
+// True when exactly one complete top-level value has been consumed without error.
+bool json_stream_finish(json_stream_t *js);
+
+// Number of open containers enclosing the current value.
+static inline int json_stream_depth(const json_stream_t *js)
+{
+    return js->depth;
+}
+
+// Member key of the value at `level` (0 = root container), or "" for array elements.
+static inline const char *json_stream_key(const json_stream_t *js, int level)
+{
+    if (level < 0 || level >= js->depth || js->stack[level].is_array) {
+        return "";
+    }
+    return js->stack[level].key;
+}
+
+static inline bool json_stream_in_array(const json_stream_t *js, int level)
+{
+    return level >= 0 && level < js->depth && js->stack[level].is_array;
+}
+
+static inline bool json_stream_value_truncated(const json_stream_t *js)
+{
+    return js->tok_truncated;
+}
+
+// Byte offset of the parser in the stream (useful for error logs).
+static inline uint32_t json_stream_offset(const json_stream_t *js)
+{
+    return js->offset;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -47,8 +47,30 @@ typedef struct {
     uint8_t fb_bits_per_pixel;
     uint8_t madctl_val; // save current value of LCD_CMD_MADCTL register
     uint8_t colmod_cal; // save surrent value of LCD_CMD_COLMOD register
+    // Address window last sent with CASET/RASET (inclusive, gap applied),
+    // and where the last memory write left the write pointer.
+    bool win_valid;
+    bool wr_valid;      // last command was RAMWR/RAMWRC, so RAMWRC can continue it
+    int win_x0;
+    int win_x1;
+    int win_y0;
+    int win_y1;
+    int wr_y;           // next row to be written; always at column win_x0
+    // Vertical scroll area [scroll_y0, scroll_y1) in frame memory rows (gap
+    // applied), empty when scrolling is off.
+    int scroll_y0;
+    int scroll_y1;
 } st7789t_panel_t;
 
+// Rows of frame memory in the current orientation.
+#define ST7789T_GRAM_ROWS(st7789t) (((st7789t)->madctl_val & LCD_CMD_MV_BIT) ? 240 : 320)
+
+// RAMCTRL's second byte: RGB565 is sent little-endian (LVGL's byte order,
+// so no swap is needed); the packed 12-bit format is defined MSB first.
+#define ST7789T_RAMCTRL_LE  0xE8
+#define ST7789T_RAMCTRL_MSB 0xE0
+#define ST7789T_RAMCTRL(st7789t) ((st7789t)->fb_bits_per_pixel == 12 ? ST7789T_RAMCTRL_MSB : ST7789T_RAMCTRL_LE)
+
 esp_err_t esp_lcd_new_panel_st7789t(const esp_lcd_panel_io_handle_t io, const esp_lcd_panel_dev_st7789t_config_t *panel_dev_config, esp_lcd_panel_handle_t *ret_panel)
 {
 #if CONFIG_LCD_ENABLE_DEBUG_LOG
@@ -82,6 +104,10 @@ esp_err_t esp_lcd_new_panel_st7789t(const esp_lcd_panel_io_handle_t io, const es
 
     uint8_t fb_bits_per_pixel = 0;
     switch (panel_dev_config->bits_per_pixel) {
+    case 12: // RGB444, two pixels in three bytes
+        st7789t->colmod_cal = 0x53;
+        fb_bits_per_pixel = 12;
+        break;
     case 16: // RGB565
         st7789t->colmod_cal = 0x55;
         fb_bits_per_pixel = 16;
@@ -140,6 +166,10 @@ static esp_err_t panel_st7789t_reset(esp_lcd_panel_t *panel)
 {
     st7789t_panel_t *st7789t = __containerof(panel, st7789t_panel_t, base);
     esp_lcd_panel_io_handle_t io = st7789t->io;
+    st7789t->win_valid = false;
+    st7789t->wr_valid = false;
+    st7789t->scroll_y0 = 0;
+    st7789t->scroll_y1 = 0;
 
     // perform hardware reset
     if (st7789t->reset_gpio_num >= 0) {
@@ -159,6 +189,8 @@ static esp_err_t panel_st7789t_init(esp_lcd_panel_t *panel)
 {
     st7789t_panel_t *st7789t = __containerof(panel, st7789t_panel_t, base);
     esp_lcd_panel_io_handle_t io = st7789t->io;
+    st7789t->win_valid = false;
+    st7789t->wr_valid = false;
     // LCD goes into sleep mode and display will be turned off after power on reset, exit sleep mode first
     // printf("AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA\r\n");
     esp_lcd_panel_io_tx_param(io, LCD_CMD_SLPOUT, NULL, 0);
@@ -169,9 +201,9 @@ static esp_err_t panel_st7789t_init(esp_lcd_panel_t *panel)
     /* Memory Data Access Control, MX=MV=1, MY=ML=MH=0, RGB=0 */
     esp_lcd_panel_io_tx_param(io, 0x36, (uint8_t []){0x00}, 1);                           // 0x36: 接口像素格式 X镜像，Y镜像
     /* Interface Pixel Format, 16bits/pixel for RGB/MCU interface */
-    esp_lcd_panel_io_tx_param(io, 0x3A, (uint8_t []){0x55}, 1);                           // 0x3A: Porch 设置
+    esp_lcd_panel_io_tx_param(io, 0x3A, (uint8_t []){st7789t->colmod_cal}, 1);            // 0x3A: Porch 设置
     
-    esp_lcd_panel_io_tx_param(io, 0xB0, (uint8_t []){0x00, 0xE8}, 2);   
+    esp_lcd_panel_io_tx_param(io, 0xB0, (uint8_t []){0x00, ST7789T_RAMCTRL(st7789t)}, 2);   
     /* Porch Setting */
     esp_lcd_panel_io_tx_param(io, 0xB2, (uint8_t []){0x0c, 0x0c, 0x00, 0x33, 0x33}, 5);      
     /* Gate Control, Vgh=13.65V, Vgl=-10.43V */
@@ -215,22 +247,49 @@ static esp_err_t panel_st7789t_draw_bitmap(esp_lcd_panel_t *panel, int x_start,
     y_start += st7789t->y_gap;
     y_end += st7789t->y_gap;
 
-    // define an area of frame memory where MCU can access
-    esp_lcd_panel_io_tx_param(io, LCD_CMD_CASET, (uint8_t[]) {
-        (x_start >> 8) & 0xFF,
-        x_start & 0xFF,
-        ((x_end - 1) >> 8) & 0xFF,
-        (x_end - 1) & 0xFF,
-    }, 4);
-    esp_lcd_panel_io_tx_param(io, LCD_CMD_RASET, (uint8_t[]) {
-        (y_start >> 8) & 0xFF,
-        y_start & 0xFF,
-        ((y_end - 1) >> 8) & 0xFF,
-        (y_end - 1) & 0xFF,
-    }, 4);
-    // transfer frame buffer
-    size_t len = (x_end - x_start) * (y_end - y_start) * st7789t->fb_bits_per_pixel / 8;
-    esp_lcd_panel_io_tx_color(io, LCD_CMD_RAMWR, color_data, len);
+    // Same columns, starting on the row the last write stopped at: carry on
+    // with RAMWRC and no address commands. This is the common case, LVGL
+    // flushing a screen in full-width bands from top to bottom.
+    int ramwr_cmd = LCD_CMD_RAMWR;
+    if (st7789t->win_valid && st7789t->wr_valid && x_start == st7789t->win_x0 && x_end - 1 == st7789t->win_x1 &&
+            y_start == st7789t->wr_y && y_end - 1 <= st7789t->win_y1) {
+        ramwr_cmd = LCD_CMD_RAMWRC;
+    } else {
+        // define an area of frame memory where MCU can access. The window runs
+        // to the bottom of frame memory, so the next band below can continue
+        // into it; RAMWR only writes the rows it sends.
+        int win_y1 = ST7789T_GRAM_ROWS(st7789t) - 1;
+        if (win_y1 < y_end - 1) {
+            win_y1 = y_end - 1;
+        }
+        if (!st7789t->win_valid || x_start != st7789t->win_x0 || x_end - 1 != st7789t->win_x1) {
+            esp_lcd_panel_io_tx_param(io, LCD_CMD_CASET, (uint8_t[]) {
+                (x_start >> 8) & 0xFF,
+                x_start & 0xFF,
+                ((x_end - 1) >> 8) & 0xFF,
+                (x_end - 1) & 0xFF,
+            }, 4);
+        }
+        if (!st7789t->win_valid || y_start != st7789t->win_y0 || win_y1 != st7789t->win_y1) {
+            esp_lcd_panel_io_tx_param(io, LCD_CMD_RASET, (uint8_t[]) {
+                (y_start >> 8) & 0xFF,
+                y_start & 0xFF,
+                (win_y1 >> 8) & 0xFF,
+                win_y1 & 0xFF,
+            }, 4);
+        }
+        st7789t->win_valid = true;
+        st7789t->win_x0 = x_start;
+        st7789t->win_x1 = x_end - 1;
+        st7789t->win_y0 = y_start;
+        st7789t->win_y1 = win_y1;
+    }
+    st7789t->wr_valid = true;
+    st7789t->wr_y = y_end;
+
+    // transfer frame buffer (an odd last RGB444 pixel takes a whole byte)
+    size_t len = ((x_end - x_start) * (y_end - y_start) * st7789t->fb_bits_per_pixel + 7) / 8;
+    esp_lcd_panel_io_tx_color(io, ramwr_cmd, color_data, len);
 
     return ESP_OK;
 }
@@ -240,6 +299,7 @@ static esp_err_t panel_st7789t_invert_color(esp_lcd_panel_t *panel, bool invert_
     st7789t_panel_t *st7789t = __containerof(panel, st7789t_panel_t, base);
     esp_lcd_panel_io_handle_t io = st7789t->io;
     int command = 0;
+    st7789t->wr_valid = false;
     if (invert_color_data) {
         command = LCD_CMD_INVON;
     } else {
@@ -253,6 +313,8 @@ static esp_err_t panel_st7789t_mirror(esp_lcd_panel_t *panel, bool mirror_x, boo
 {
     st7789t_panel_t *st7789t = __containerof(panel, st7789t_panel_t, base);
     esp_lcd_panel_io_handle_t io = st7789t->io;
+    st7789t->win_valid = false;
+    st7789t->wr_valid = false;
     if (mirror_x) {
         st7789t->madctl_val |= LCD_CMD_MX_BIT;
     } else {
@@ -273,6 +335,8 @@ static esp_err_t panel_st7789t_swap_xy(esp_lcd_panel_t *panel, bool swap_axes)
 {
     st7789t_panel_t *st7789t = __containerof(panel, st7789t_panel_t, base);
     esp_lcd_panel_io_handle_t io = st7789t->io;
+    st7789t->win_valid = false;
+    st7789t->wr_valid = false;
     if (swap_axes) {
         st7789t->madctl_val |= LCD_CMD_MV_BIT;
     } else {
@@ -297,6 +361,7 @@ static esp_err_t panel_st7789t_disp_on_off(esp_lcd_panel_t *panel, bool on_off)
     st7789t_panel_t *st7789t = __containerof(panel, st7789t_panel_t, base);
     esp_lcd_panel_io_handle_t io = st7789t->io;
     int command = 0;
+    st7789t->wr_valid = false;
     if (on_off) {
         command = LCD_CMD_DISPON;
     } else {
@@ -305,3 +370,96 @@ static esp_err_t panel_st7789t_disp_on_off(esp_lcd_panel_t *panel, bool on_off)
     esp_lcd_panel_io_tx_param(io, command, NULL, 0);
     return ESP_OK;
 }
+
+esp_err_t esp_lcd_panel_st7789t_set_bits_per_pixel(esp_lcd_panel_handle_t panel, unsigned int bits_per_pixel)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    st7789t_panel_t *st7789t = __containerof(panel, st7789t_panel_t, base);
+    esp_lcd_panel_io_handle_t io = st7789t->io;
+
+    uint8_t colmod_cal;
+    switch (bits_per_pixel) {
+    case 12:
+        colmod_cal = 0x53;
+        break;
+    case 16:
+        colmod_cal = 0x55;
+        break;
+    default:
+        ESP_RETURN_ON_FALSE(false, ESP_ERR_NOT_SUPPORTED, TAG, "unsupported pixel width");
+    }
+    if (st7789t->fb_bits_per_pixel == bits_per_pixel) {
+        return ESP_OK;
+    }
+
+    // Frame memory keeps its contents; only data sent from now on changes.
+    st7789t->colmod_cal = colmod_cal;
+    st7789t->fb_bits_per_pixel = bits_per_pixel;
+    st7789t->wr_valid = false;
+    esp_lcd_panel_io_tx_param(io, 0xB0, (uint8_t []){0x00, ST7789T_RAMCTRL(st7789t)}, 2);
+    esp_lcd_panel_io_tx_param(io, LCD_CMD_COLMOD, (uint8_t[]) {
+        st7789t->colmod_cal
+    }, 1);
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_st7789t_set_scroll_area(esp_lcd_panel_handle_t panel, int y_start, int y_end)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    st7789t_panel_t *st7789t = __containerof(panel, st7789t_panel_t, base);
+    esp_lcd_panel_io_handle_t io = st7789t->io;
+    // The gate lines scroll: with MV set they would run across the screen.
+    ESP_RETURN_ON_FALSE(!(st7789t->madctl_val & LCD_CMD_MV_BIT), ESP_ERR_NOT_SUPPORTED, TAG, "axes swapped");
+
+    int rows = ST7789T_GRAM_ROWS(st7789t);
+    int top = y_start + st7789t->y_gap;
+    int height = y_end - y_start;
+    if (height == 0) {
+        top = 0;
+        height = rows;
+    }
+    ESP_RETURN_ON_FALSE(top >= 0 && height > 0 && top + height <= rows, ESP_ERR_INVALID_ARG, TAG, "invalid scroll area");
+    int bottom = rows - top - height;
+
+    st7789t->wr_valid = false;
+    esp_lcd_panel_io_tx_param(io, LCD_CMD_VSCRDEF, (uint8_t[]) {
+        (top >> 8) & 0xFF,
+        top & 0xFF,
+        (height >> 8) & 0xFF,
+        height & 0xFF,
+        (bottom >> 8) & 0xFF,
+        bottom & 0xFF,
+    }, 6);
+    if (y_end == y_start) {
+        // Whole screen, unscrolled; NORON leaves scroll mode.
+        st7789t->scroll_y0 = 0;
+        st7789t->scroll_y1 = 0;
+        esp_lcd_panel_io_tx_param(io, LCD_CMD_VSCSAD, (uint8_t[]) {0, 0}, 2);
+        esp_lcd_panel_io_tx_param(io, LCD_CMD_NORON, NULL, 0);
+        return ESP_OK;
+    }
+    st7789t->scroll_y0 = top;
+    st7789t->scroll_y1 = top + height;
+    esp_lcd_panel_io_tx_param(io, LCD_CMD_VSCSAD, (uint8_t[]) {
+        (top >> 8) & 0xFF,
+        top & 0xFF,
+    }, 2);
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_st7789t_scroll_to(esp_lcd_panel_handle_t panel, int y)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    st7789t_panel_t *st7789t = __containerof(panel, st7789t_panel_t, base);
+    esp_lcd_panel_io_handle_t io = st7789t->io;
+
+    int line = y + st7789t->y_gap;
+    ESP_RETURN_ON_FALSE(line >= st7789t->scroll_y0 && line < st7789t->scroll_y1, ESP_ERR_INVALID_ARG, TAG,
+                        "outside the scroll area");
+    st7789t->wr_valid = false;
+    esp_lcd_panel_io_tx_param(io, LCD_CMD_VSCSAD, (uint8_t[]) {
+        (line >> 8) & 0xFF,
+        line & 0xFF,
+    }, 2);
+    return ESP_OK;
+}
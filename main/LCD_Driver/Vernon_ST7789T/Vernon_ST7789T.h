@@ -22,7 +22,7 @@ typedef struct {
         lcd_color_rgb_endian_t color_space; /*!< @deprecated Set RGB color space, please use rgb_endian instead */
         lcd_color_rgb_endian_t rgb_endian;  /*!< Set RGB data endian: RGB or BGR */
     };
-    unsigned int bits_per_pixel;       /*!< Color depth, in bpp */
+    unsigned int bits_per_pixel;       /*!< Color depth, in bpp: 12 (RGB444), 16 (RGB565) or 18 (RGB666) */
     struct {
         unsigned int reset_active_high: 1; /*!< Setting this if the panel reset is high level active */
     } flags;                               /*!< LCD panel config flags */
@@ -42,6 +42,52 @@ typedef struct {
  */
 esp_err_t esp_lcd_new_panel_st7789t(const esp_lcd_panel_io_handle_t io, const esp_lcd_panel_dev_st7789t_config_t *panel_dev_config, esp_lcd_panel_handle_t *ret_panel);
 
+/**
+ * @brief Switch the wire format of the color data sent from now on
+ *
+ * @note 16 is RGB565 (two bytes per pixel, little-endian). 12 is RGB444, two pixels packed
+ *       into three bytes, MSB first. Call between frames: frame memory is not redrawn.
+ *
+ * @param[in] panel LCD panel handle returned by esp_lcd_new_panel_st7789t()
+ * @param[in] bits_per_pixel 12 or 16
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NOT_SUPPORTED if the pixel width is not 12 or 16
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_st7789t_set_bits_per_pixel(esp_lcd_panel_handle_t panel, unsigned int bits_per_pixel);
+
+/**
+ * @brief Set the rows that hardware vertical scrolling moves; the rest stay fixed
+ *
+ * @note Rows [y_start, y_end) of frame memory, in draw_bitmap() coordinates. Until the next
+ *       esp_lcd_panel_st7789t_scroll_to(), screen row y_start + k shows frame memory row
+ *       y_start + k. With y_start == y_end scrolling is turned off. Portrait only (axes not swapped).
+ *
+ * @param[in] panel LCD panel handle returned by esp_lcd_new_panel_st7789t()
+ * @param[in] y_start First scrolled row
+ * @param[in] y_end One past the last scrolled row
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_ERR_NOT_SUPPORTED if the axes are swapped
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_st7789t_set_scroll_area(esp_lcd_panel_handle_t panel, int y_start, int y_end);
+
+/**
+ * @brief Scroll the area set with esp_lcd_panel_st7789t_set_scroll_area()
+ *
+ * @note The first screen row of the area shows frame memory row y, the rows below it follow
+ *       and wrap around within the area. Frame memory is not touched.
+ *
+ * @param[in] panel LCD panel handle returned by esp_lcd_new_panel_st7789t()
+ * @param[in] y Frame memory row inside the scroll area
+ * @return
+ *          - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *          - ESP_OK                on success
+ */
+esp_err_t esp_lcd_panel_st7789t_scroll_to(esp_lcd_panel_handle_t panel, int y);
+
 #ifdef __cplusplus
 }
 #endif
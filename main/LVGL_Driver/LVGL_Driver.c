@@ -1,40 +1,431 @@
 #include "LVGL_Driver.h"
 
+#include <string.h>
+#include "freertos/semphr.h"
+#include "lcd_pack.h"
+
+#if LCD_USE_DIRECT_MODE
+#include "lcd_tiles.h"
+#endif
+#if LCD_USE_HW_TICKER
+#include "lcd_ticker.h"
+#endif
+
 static const char *TAG_LVGL = "WS_LVGL";
 
+#if LCD_USE_DIRECT_MODE
+static lv_color_t fb[EXAMPLE_LCD_H_RES * EXAMPLE_LCD_V_RES];
+// Changed tiles are copied out of the framebuffer, one tile row at most per
+// transfer, so LVGL can draw the next frame while they are being sent.
+static lv_color_t tx_buf[2][EXAMPLE_LCD_H_RES * LCD_TILE_H];
+static int tx_next;
+static SemaphoreHandle_t tx_free;                                            // counts tx buffers not queued to the panel
+static lcd_tiles_t tiles;
+static uint32_t tile_hash[LCD_TILES_COLS(EXAMPLE_LCD_H_RES) * LCD_TILES_ROWS(EXAMPLE_LCD_V_RES)];
+static uint8_t tile_marked[LCD_TILES_COLS(EXAMPLE_LCD_H_RES) * LCD_TILES_ROWS(EXAMPLE_LCD_V_RES)];
+static uint32_t redrawn_px;
+#else
 static lv_color_t buf1[ LVGL_BUF_LEN ];
 static lv_color_t buf2[ LVGL_BUF_LEN];
+#endif
 // static lv_color_t* buf1 = (lv_color_t*) heap_caps_malloc(LVGL_BUF_LEN , MALLOC_CAP_SPIRAM);
 // static lv_color_t* buf2 = (lv_color_t*) heap_caps_malloc(LVGL_BUF_LEN , MALLOC_CAP_SPIRAM);
     
 
 lv_disp_draw_buf_t disp_buf;                                                 // contains internal graphic buffer(s) called draw buffer(s)
 lv_disp_drv_t disp_drv;                                                      // contains callback functions
+
+// Flush pipeline: LVGL draws the next band (in direct mode, the next tile
+// row) while the previous one is on the wire. When it gets ahead of the
+// SPI bus it blocks instead of spinning on the flushing flag, so the other
+// tasks and idle get the CPU for the rest of the transfer.
+#define LCD_FLUSH_WAIT_MAX_MS 50                                             // a missed give only costs one extra poll
+
+// What the transfer-done ISR does for each transfer.
+typedef enum {
+    LCD_TX_LVGL,   // releases LVGL's band (partial mode) or a tx buffer (direct mode)
+    LCD_TX_PART,   // more of the same band follows
+    LCD_TX_TICKER, // a ticker row: nothing to release
+} lcd_tx_kind_t;
+
+#define LCD_TX_RING 4                                                        // two LVGL buffers and a ticker row in flight
+
+static SemaphoreHandle_t flush_done;                                         // given by the transfer-done ISR
+static int64_t tx_issue_us[LCD_TX_RING];                                     // transfers in flight, oldest at tx_tail
+static uint8_t tx_kind[LCD_TX_RING];
+static uint8_t tx_head;
+static uint8_t tx_tail;
+static int64_t tx_last_done_us;
+static volatile uint32_t wire_us;                                            // SPI busy with pixels, updated in the ISR
+static uint32_t wire_taken_us;
+static int64_t frame_start_us;
+static uint32_t frame_wait_us;
+static uint32_t frame_wire_us;
+static lvgl_flush_stats_t flush_stats;
+
+// Wire format: wanted by the UI, and what the panel is set to. Switched
+// between frames, in lcd_render_start_cb.
+static bool rgb444_req;
+static bool rgb444;
+
+#if LCD_USE_HW_TICKER
+// Hardware-scrolled ticker (see lcd_ticker.h). One wrapped line of the text
+// at a time is drawn into `ticker_card` by a hidden canvas; each step sends
+// one of its rows. LVGL's flushes leave the ticker's rows alone while it runs.
+#define LCD_TICKER_MAX_H     24
+#define LCD_TICKER_MAX_LINES 16
+#define LCD_TICKER_TEXT_LEN  128
+#define LCD_TICKER_PAD       4                                               // left and right of the text
+#define LCD_TICKER_STEP_MS   60                                              // one row per step
+#define LCD_TICKER_HOLD_MS   2500                                            // each line, once it is centred
+
+static lcd_ticker_t ticker;
+static bool ticker_on;
+static lv_timer_t *ticker_timer;
+static lv_obj_t *ticker_canvas;
+static lv_color_t ticker_card[EXAMPLE_LCD_H_RES * LCD_TICKER_MAX_H];
+static lv_color_t ticker_row[EXAMPLE_LCD_H_RES];
+static int ticker_card_line;                                                 // line drawn in ticker_card, -1 if none
+static char ticker_text[LCD_TICKER_TEXT_LEN];
+static uint16_t ticker_line_start[LCD_TICKER_MAX_LINES + 1];
+static const lv_font_t *ticker_font;
+static lv_color_t ticker_fg;
+static lv_color_t ticker_bg;
+#endif
     
-void example_increase_lvgl_tick(void *arg)
+void LVGL_TickUpdate(void)
 {
-    /* Tell LVGL how many milliseconds has elapsed */
-    lv_tick_inc(EXAMPLE_LVGL_TICK_PERIOD_MS);
+    /* Tell LVGL how many milliseconds has elapsed since the last call */
+    static int64_t last_us;
+    int64_t now_us = esp_timer_get_time();
+    if (last_us == 0) {
+        last_us = now_us;
+        return;
+    }
+    uint32_t ms = (uint32_t)((now_us - last_us) / 1000);
+    if (ms > 0) {
+        lv_tick_inc(ms);
+        last_us += (int64_t)ms * 1000;
+    }
+}
+
+static void lcd_tx_begin(lcd_tx_kind_t kind)
+{
+    uint8_t i = tx_head++ & (LCD_TX_RING - 1);
+    tx_issue_us[i] = esp_timer_get_time();
+    tx_kind[i] = (uint8_t)kind;
+}
+
+static void lcd_flush_wait(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    int64_t start_us = esp_timer_get_time();
+    xSemaphoreTake(sem, ticks);
+    frame_wait_us += (uint32_t)(esp_timer_get_time() - start_us);
 }
 
 bool example_notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
 {
+    // A queued transfer starts on the wire when the one before it is done.
+    int64_t now_us = esp_timer_get_time();
+    uint8_t i = tx_tail++ & (LCD_TX_RING - 1);
+    int64_t start_us = tx_issue_us[i];
+    if (start_us < tx_last_done_us) {
+        start_us = tx_last_done_us;
+    }
+    wire_us += (uint32_t)(now_us - start_us);
+    tx_last_done_us = now_us;
+    if (tx_kind[i] != LCD_TX_LVGL) {
+        return false;
+    }
+
+    BaseType_t woken = pdFALSE;
+#if LCD_USE_DIRECT_MODE
+    // The framebuffer was released in the flush callback; this frees a tx buffer.
+    xSemaphoreGiveFromISR(tx_free, &woken);
+#else
     lv_disp_drv_t *disp_driver = (lv_disp_drv_t *)user_ctx;
     lv_disp_flush_ready(disp_driver);
-    return false;
+    xSemaphoreGiveFromISR(flush_done, &woken);
+#endif
+    return woken == pdTRUE;
+}
+
+// Called by LVGL while the buffer it needs is still being sent.
+static void lcd_flush_wait_cb(lv_disp_drv_t *drv)
+{
+    lcd_flush_wait(flush_done, pdMS_TO_TICKS(LCD_FLUSH_WAIT_MAX_MS));
+}
+
+static void lcd_render_start_cb(lv_disp_drv_t *drv)
+{
+    if (rgb444 != rgb444_req) {
+        // COLMOD goes out as a polled command, after the last band of the
+        // previous frame has been sent.
+        rgb444 = rgb444_req;
+        esp_lcd_panel_st7789t_set_bits_per_pixel((esp_lcd_panel_handle_t) drv->user_data, rgb444 ? 12 : 16);
+    }
+    frame_start_us = esp_timer_get_time();
+    frame_wait_us = 0;
+    frame_wire_us = wire_us;
+}
+
+// End of a refresh. The last band was handed over but may still be on the
+// wire; its bus time shows up in the next frame's figure.
+static void lcd_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    uint32_t frame_us = (uint32_t)(esp_timer_get_time() - frame_start_us);
+    uint32_t render_us = frame_us > frame_wait_us ? frame_us - frame_wait_us : 0;
+
+    flush_stats.frames++;
+    flush_stats.render_us += render_us;
+    flush_stats.wait_us += frame_wait_us;
+    ESP_LOGD(TAG_LVGL, "frame %u px: render %u us, wire %u us, wait %u us", (unsigned)px, (unsigned)render_us,
+             (unsigned)(wire_us - frame_wire_us), (unsigned)frame_wait_us);
+}
+
+void LVGL_SetRgb444(bool on)
+{
+    if (on != rgb444_req) {
+        rgb444_req = on;
+        ESP_LOGI(TAG_LVGL, "wire format %s", on ? "RGB444" : "RGB565");
+    }
+}
+
+void LVGL_TakeFlushStats(lvgl_flush_stats_t *out_stats)
+{
+    uint32_t now_us = wire_us;
+
+    *out_stats = flush_stats;
+    out_stats->wire_us = now_us - wire_taken_us;
+    wire_taken_us = now_us;
+    memset(&flush_stats, 0, sizeof(flush_stats));
+}
+
+#if LCD_USE_DIRECT_MODE
+static void lcd_send_fb_rows(esp_lcd_panel_handle_t panel_handle, int x1, int x2, int y1, int y2)
+{
+    int w = x2 - x1 + 1;
+
+    lcd_flush_wait(tx_free, portMAX_DELAY);
+    lv_color_t *tx = tx_buf[tx_next];
+    tx_next ^= 1;
+    for (int y = y1; y <= y2; y++) {
+        memcpy(&tx[(y - y1) * w], &fb[y * EXAMPLE_LCD_H_RES + x1], w * sizeof(lv_color_t));
+    }
+    if (rgb444) {
+        lcd_pack_rgb444((uint8_t *)tx, (const uint16_t *)tx, w * (y2 - y1 + 1));
+    }
+    lcd_tx_begin(LCD_TX_LVGL);
+    esp_lcd_panel_draw_bitmap(panel_handle, x1 + Offset_X, y1 + Offset_Y, x2 + Offset_X + 1, y2 + Offset_Y + 1, tx);
+}
+
+static void lcd_send_span(const lcd_span_t *span, void *ctx)
+{
+    esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t) ctx;
+#if LCD_USE_HW_TICKER
+    // Only the rows above and below the ticker.
+    int t1 = ticker.y0;
+    int t2 = ticker.y0 + ticker.h - 1;
+    if (ticker_on && span->y1 <= t2 && span->y2 >= t1) {
+        if (span->y1 < t1) {
+            lcd_send_fb_rows(panel_handle, span->x1, span->x2, span->y1, t1 - 1);
+        }
+        if (span->y2 > t2) {
+            lcd_send_fb_rows(panel_handle, span->x1, span->x2, t2 + 1, span->y2);
+        }
+        return;
+    }
+#endif
+    lcd_send_fb_rows(panel_handle, span->x1, span->x2, span->y1, span->y2);
+}
+
+// Direct mode: called once per area LVGL redrew into fb, with the whole
+// screen as `area`. The areas are collected and diffed on the last call.
+static void lcd_direct_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    const lv_area_t *redrawn = drv->draw_ctx->clip_area;
+    lcd_tiles_mark(&tiles, redrawn->x1, redrawn->y1, redrawn->x2, redrawn->y2);
+    redrawn_px += lv_area_get_size(redrawn);
+
+    if (lv_disp_flush_is_last(drv)) {
+        uint32_t sent_px = lcd_tiles_flush(&tiles, (const uint16_t *)fb, lcd_send_span, drv->user_data);
+        ESP_LOGD(TAG_LVGL, "frame: %u px redrawn, %u px sent", (unsigned)redrawn_px, (unsigned)sent_px);
+        redrawn_px = 0;
+    }
+    lv_disp_flush_ready(drv);
+}
+#endif
+
+// Rows y1..y2 of a band LVGL drew for `area`.
+static void lcd_send_rows(esp_lcd_panel_handle_t panel_handle, const lv_area_t *area, lv_color_t *color_map, int y1, int y2, lcd_tx_kind_t kind)
+{
+    int w = lv_area_get_width(area);
+    lv_color_t *px = &color_map[(y1 - area->y1) * w];
+    if (rgb444) {
+        // In place: LVGL draws the next band into the other buffer.
+        lcd_pack_rgb444((uint8_t *)px, (const uint16_t *)px, w * (y2 - y1 + 1));
+    }
+    // copy a buffer's content to a specific area of the display
+    lcd_tx_begin(kind);
+    esp_lcd_panel_draw_bitmap(panel_handle, area->x1 + Offset_X, y1 + Offset_Y, area->x2 + Offset_X + 1, y2 + Offset_Y + 1, px);
 }
 
 void example_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
 {
     esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t) drv->user_data;
-    int offsetx1 = area->x1;
-    int offsetx2 = area->x2;
-    int offsety1 = area->y1;
-    int offsety2 = area->y2;
-    // copy a buffer's content to a specific area of the display
-    esp_lcd_panel_draw_bitmap(panel_handle, offsetx1 + Offset_X, offsety1 + Offset_Y, offsetx2 + Offset_X + 1, offsety2 + Offset_Y + 1, color_map);
+#if LCD_USE_HW_TICKER
+    // Only the rows above and below the ticker; the band is released with the last of them.
+    int t1 = ticker.y0;
+    int t2 = ticker.y0 + ticker.h - 1;
+    if (ticker_on && area->y1 <= t2 && area->y2 >= t1) {
+        bool above = area->y1 < t1;
+        bool below = area->y2 > t2;
+        if (above) {
+            lcd_send_rows(panel_handle, area, color_map, area->y1, t1 - 1, below ? LCD_TX_PART : LCD_TX_LVGL);
+        }
+        if (below) {
+            lcd_send_rows(panel_handle, area, color_map, t2 + 1, area->y2, LCD_TX_LVGL);
+        }
+        if (!above && !below) {
+            lv_disp_flush_ready(drv);
+        }
+        return;
+    }
+#endif
+    lcd_send_rows(panel_handle, area, color_map, area->y1, area->y2, LCD_TX_LVGL);
 }
 
+#if LCD_USE_HW_TICKER
+// Hand rows the ticker drew over back to LVGL, which redraws them.
+static void lcd_ticker_release(int y, int h)
+{
+    lv_area_t a = {0, (lv_coord_t)y, EXAMPLE_LCD_H_RES - 1, (lv_coord_t)(y + h - 1)};
+#if LCD_USE_DIRECT_MODE
+    lcd_tiles_forget(&tiles, a.x1, a.y1, a.x2, a.y2);
+#endif
+    _lv_inv_area(disp, &a);
+}
+
+static void lcd_ticker_draw_card(int line)
+{
+    char txt[LCD_TICKER_TEXT_LEN];
+    int start = ticker_line_start[line];
+    int len = ticker_line_start[line + 1] - start;
+    memcpy(txt, &ticker_text[start], len);
+    while (len > 0 && (txt[len - 1] == '\n' || txt[len - 1] == '\r')) {
+        len--;
+    }
+    txt[len] = '\0';
+
+    lv_draw_label_dsc_t dsc;
+    lv_draw_label_dsc_init(&dsc);
+    dsc.font = ticker_font;
+    dsc.color = ticker_fg;
+    dsc.align = LV_TEXT_ALIGN_CENTER;
+    lv_canvas_fill_bg(ticker_canvas, ticker_bg, LV_OPA_COVER);
+    lv_canvas_draw_text(ticker_canvas, LCD_TICKER_PAD, (ticker.h - lv_font_get_line_height(ticker_font)) / 2,
+                        EXAMPLE_LCD_H_RES - 2 * LCD_TICKER_PAD, &dsc, txt);
+    ticker_card_line = line;
+}
+
+// Row `line_row` of a line's card to frame memory row mem_y. The polled
+// scroll command sent after it waits for the transfer, so ticker_row is
+// free again for the next step.
+static void lcd_ticker_send_row(esp_lcd_panel_handle_t panel_handle, int line, int line_row, int mem_y)
+{
+    if (line != ticker_card_line) {
+        lcd_ticker_draw_card(line);
+    }
+    memcpy(ticker_row, &ticker_card[line_row * EXAMPLE_LCD_H_RES], sizeof(ticker_row));
+    if (rgb444) {
+        lcd_pack_rgb444((uint8_t *)ticker_row, (const uint16_t *)ticker_row, EXAMPLE_LCD_H_RES);
+    }
+    lcd_tx_begin(LCD_TX_TICKER);
+    esp_lcd_panel_draw_bitmap(panel_handle, Offset_X, mem_y + Offset_Y, EXAMPLE_LCD_H_RES + Offset_X, mem_y + Offset_Y + 1, ticker_row);
+}
+
+static void lcd_ticker_timer_cb(lv_timer_t *timer)
+{
+    esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t) disp_drv.user_data;
+    lcd_ticker_step_t step = lcd_ticker_step(&ticker);
+
+    lcd_ticker_send_row(panel_handle, step.line, step.line_row, step.mem_y);
+    esp_lcd_panel_st7789t_scroll_to(panel_handle, step.scroll_y + Offset_Y);
+    lv_timer_set_period(timer, step.hold ? LCD_TICKER_HOLD_MS : LCD_TICKER_STEP_MS);
+}
+
+void LVGL_TickerShow(int y, int h, const char *text, const lv_font_t *font, lv_color_t fg, lv_color_t bg)
+{
+    esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t) disp_drv.user_data;
+    if (h <= 0 || h > LCD_TICKER_MAX_H || y < 0 || y + h > EXAMPLE_LCD_V_RES) {
+        ESP_LOGW(TAG_LVGL, "ticker rows %d+%d out of range", y, h);
+        return;
+    }
+    if (ticker_on && ticker.y0 == y && ticker.h == h && ticker_font == font && lv_color_to16(ticker_fg) == lv_color_to16(fg) &&
+            lv_color_to16(ticker_bg) == lv_color_to16(bg) && strncmp(ticker_text, text, sizeof(ticker_text) - 1) == 0) {
+        return;
+    }
+    if (ticker_on && (ticker.y0 != y || ticker.h != h)) {
+        lcd_ticker_release(ticker.y0, ticker.h);
+    }
+
+    strlcpy(ticker_text, text, sizeof(ticker_text));
+    ticker_font = font;
+    ticker_fg = fg;
+    ticker_bg = bg;
+    int lines = 0;
+    uint32_t pos = 0;
+    while (ticker_text[pos] != '\0' && lines < LCD_TICKER_MAX_LINES) {
+        ticker_line_start[lines++] = (uint16_t)pos;
+        pos += _lv_txt_get_next_line(&ticker_text[pos], font, 0, EXAMPLE_LCD_H_RES - 2 * LCD_TICKER_PAD, NULL, LV_TEXT_FLAG_NONE);
+    }
+    if (lines == 0) {
+        ticker_line_start[lines++] = 0;
+    }
+    ticker_line_start[lines] = (uint16_t)pos;
+
+    if (ticker_canvas == NULL) {
+        ticker_canvas = lv_canvas_create(lv_layer_sys());
+        lv_obj_add_flag(ticker_canvas, LV_OBJ_FLAG_HIDDEN);
+        ticker_timer = lv_timer_create(lcd_ticker_timer_cb, LCD_TICKER_HOLD_MS, NULL);
+    }
+    lv_canvas_set_buffer(ticker_canvas, ticker_card, EXAMPLE_LCD_H_RES, h, LV_IMG_CF_TRUE_COLOR);
+    lcd_ticker_init(&ticker, y, h, lines);
+    ticker_on = true;
+
+    // The first line in one transfer, unscrolled; scroll_to waits for it.
+    esp_lcd_panel_st7789t_set_scroll_area(panel_handle, y + Offset_Y, y + h + Offset_Y);
+    lcd_ticker_draw_card(0);
+    if (rgb444) {
+        lcd_pack_rgb444((uint8_t *)ticker_card, (const uint16_t *)ticker_card, EXAMPLE_LCD_H_RES * h);
+        ticker_card_line = -1;
+    }
+    lcd_tx_begin(LCD_TX_TICKER);
+    esp_lcd_panel_draw_bitmap(panel_handle, Offset_X, y + Offset_Y, EXAMPLE_LCD_H_RES + Offset_X, y + h + Offset_Y, ticker_card);
+    esp_lcd_panel_st7789t_scroll_to(panel_handle, y + Offset_Y);
+
+    if (lines > 1) {
+        lv_timer_set_period(ticker_timer, LCD_TICKER_HOLD_MS);
+        lv_timer_reset(ticker_timer);
+        lv_timer_resume(ticker_timer);
+    } else {
+        lv_timer_pause(ticker_timer);
+    }
+    ESP_LOGI(TAG_LVGL, "ticker: %d lines in rows %d-%d", lines, y, y + h - 1);
+}
+
+void LVGL_TickerHide(void)
+{
+    if (!ticker_on) {
+        return;
+    }
+    ticker_on = false;
+    lv_timer_pause(ticker_timer);
+    esp_lcd_panel_st7789t_set_scroll_area((esp_lcd_panel_handle_t) disp_drv.user_data, 0, 0);
+    lcd_ticker_release(ticker.y0, ticker.h);
+}
+#endif
+
 /* Rotate display and touch, when rotated screen in LVGL. Called when driver parameters are updated. */
 void example_lvgl_port_update_callback(lv_disp_drv_t *drv)
 {
@@ -71,30 +462,36 @@ void LVGL_Init(void)
     ESP_LOGI(TAG_LVGL, "Initialize LVGL library");
     lv_init();
     
+    flush_done = xSemaphoreCreateBinary();
+#if LCD_USE_DIRECT_MODE
+    tx_free = xSemaphoreCreateCounting(2, 2);
+    lcd_tiles_init(&tiles, EXAMPLE_LCD_H_RES, EXAMPLE_LCD_V_RES, tile_hash, tile_marked);
+    lv_disp_draw_buf_init(&disp_buf, fb, NULL, EXAMPLE_LCD_H_RES * EXAMPLE_LCD_V_RES);        // one full-screen buffer, LVGL draws in place
+#else
     lv_disp_draw_buf_init(&disp_buf, buf1, buf2, LVGL_BUF_LEN );                              // initialize LVGL draw buffers
+#endif
 
     ESP_LOGI(TAG_LVGL, "Register display driver to LVGL");
     lv_disp_drv_init(&disp_drv);                                                                        // Create a new screen object and initialize the associated device
     disp_drv.hor_res = EXAMPLE_LCD_H_RES;             
     disp_drv.ver_res = EXAMPLE_LCD_V_RES;                                                     // Horizontal pixel count
     // disp_drv.rotated = LV_DISP_ROT_90; // 图像旋转                                                            // Vertical axis pixel count
+#if LCD_USE_DIRECT_MODE
+    disp_drv.direct_mode = 1;
+    disp_drv.flush_cb = lcd_direct_flush_cb;
+#else
     disp_drv.flush_cb = example_lvgl_flush_cb;                                                          // Function : copy a buffer's content to a specific area of the display
+    disp_drv.wait_cb = lcd_flush_wait_cb;                                                               // block (not spin) while the other band is on the wire
+#endif
+    disp_drv.render_start_cb = lcd_render_start_cb;
+    disp_drv.monitor_cb = lcd_monitor_cb;
     disp_drv.drv_update_cb = example_lvgl_port_update_callback;                                         // Function : Rotate display and touch, when rotated screen in LVGL. Called when driver parameters are updated. 
     disp_drv.draw_buf = &disp_buf;                                                                      // LVGL will use this buffer(s) to draw the screens contents
     disp_drv.user_data = panel_handle;                
     ESP_LOGI(TAG_LVGL,"Register display indev to LVGL");                                                  // Custom display driver user data
     disp = lv_disp_drv_register(&disp_drv);                                                  // Create screen objects
     
-    /********************* LVGL *********************/
-    ESP_LOGI(TAG_LVGL, "Install LVGL tick timer");
-    // Tick interface for LVGL (using esp_timer to generate 2ms periodic event)
-    const esp_timer_create_args_t lvgl_tick_timer_args = {
-        .callback = &example_increase_lvgl_tick,
-        .name = "lvgl_tick"
-    };
-    
-    esp_timer_handle_t lvgl_tick_timer = NULL;
-    ESP_ERROR_CHECK(esp_timer_create(&lvgl_tick_timer_args, &lvgl_tick_timer));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(lvgl_tick_timer, EXAMPLE_LVGL_TICK_PERIOD_MS * 1000));
-
+    // No periodic tick timer: the UI loop calls LVGL_TickUpdate() before
+    // lv_timer_handler(), so an idle screen does not wake the CPU every 2 ms.
+    LVGL_TickUpdate();
 }
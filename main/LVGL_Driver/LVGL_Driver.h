@@ -9,9 +9,39 @@
 #include "demos/lv_demos.h"
 
 #include "ST7789.h"
+#include "config.h"
 
 #define LVGL_BUF_LEN  (EXAMPLE_LCD_H_RES * 20)
-#define EXAMPLE_LVGL_TICK_PERIOD_MS    2
+
+// Optional: render into one full-screen framebuffer (LVGL direct mode) and
+// send only the tiles whose pixels changed (see lcd_tiles.h), instead of
+// re-sending every area LVGL redraws. Costs ~110 KB of RAM for the
+// framebuffer in place of the two 20-row buffers.
+#ifndef LCD_USE_DIRECT_MODE
+#define LCD_USE_DIRECT_MODE 0
+#endif
+
+// Optional: send flat, text-only screens as 12-bit RGB444 (see lcd_pack.h),
+// a quarter fewer bytes than RGB565. The UI picks it per screen with
+// LVGL_SetRgb444().
+#ifndef LCD_USE_RGB444
+#define LCD_USE_RGB444 0
+#endif
+
+// Optional: scroll long text (the MBTA alert) through a band of rows with
+// the panel's hardware vertical scroll (see lcd_ticker.h). A step costs
+// one new row of pixels on the wire instead of a redraw of the band.
+#ifndef LCD_USE_HW_TICKER
+#define LCD_USE_HW_TICKER 0
+#endif
+
+// Flush pipeline timings, summed over the frames since the last call.
+typedef struct {
+    uint32_t frames;
+    uint32_t render_us; // drawing (refresh time minus wait_us)
+    uint32_t wire_us;   // SPI busy with pixel data
+    uint32_t wait_us;   // drawing blocked on a buffer still being sent
+} lvgl_flush_stats_t;
 
 extern lv_disp_draw_buf_t disp_buf;                                                 // contains internal graphic buffer(s) called draw buffer(s)
 extern lv_disp_drv_t disp_drv;                                                      // contains callback functions
@@ -21,6 +51,20 @@ bool example_notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd
 void example_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map);
 /* Rotate display and touch, when rotated screen in LVGL. Called when driver parameters are updated. */
 void example_lvgl_port_update_callback(lv_disp_drv_t *drv);
-void example_increase_lvgl_tick(void *arg);
+// Advance the LVGL tick from esp_timer; call right before lv_timer_handler().
+void LVGL_TickUpdate(void);
+// Counts since the last call, then resets them. UI task only.
+void LVGL_TakeFlushStats(lvgl_flush_stats_t *out_stats);
+// Wire format for the frames from the next refresh on: RGB444 or RGB565.
+// What is already on the panel is not redrawn. UI task only.
+void LVGL_SetRgb444(bool on);
+#if LCD_USE_HW_TICKER
+// Scroll `text`, wrapped to the screen width, up through screen rows
+// y .. y + h - 1 one line at a time; LVGL stops drawing those rows. Does
+// nothing if the arguments are unchanged. UI task only.
+void LVGL_TickerShow(int y, int h, const char *text, const lv_font_t *font, lv_color_t fg, lv_color_t bg);
+// Hand the rows back to LVGL, which redraws them. UI task only.
+void LVGL_TickerHide(void);
+#endif
 
 void LVGL_Init(void);                     // Call this function to initialize the screen (must be called in the main function) !!!!!
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include "lcd_pack.h"
+
+// Green's 6 bits to the nearest of 16 levels. For red and blue (5 bits)
+// dropping the low bit already is the nearest level.
+static const uint8_t s_g6_to_4[64] = {
+    0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4,
+    4, 4, 4, 5, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7,
+    8, 8, 8, 8, 9, 9, 9, 9, 10, 10, 10, 10, 10, 11, 11, 11,
+    11, 12, 12, 12, 12, 13, 13, 13, 13, 14, 14, 14, 14, 15, 15, 15,
+};
+
+// One pixel as 12 bits, 0xRGB.
+static inline uint32_t rgb565_to_444(uint32_t c)
+{
+    uint32_t r = c >> 12;
+    uint32_t g = s_g6_to_4[(c >> 5) & 0x3F];
+    uint32_t b = (c >> 1) & 0x0F;
+    return (r << 8) | (g << 4) | b;
+}
+
+size_t lcd_pack_rgb444(uint8_t *dst, const uint16_t *src, size_t px)
+{
+    uint8_t *d = dst;
+
+    // Two pixels per step: both are read before any of the three bytes is
+    // written, and dst never runs ahead of src, so packing in place is safe.
+    // Plain shifts and masks on 32-bit words; RV32IMAC has no SIMD to use.
+    for (; px >= 2; px -= 2) {
+        uint32_t p = (rgb565_to_444(src[0]) << 12) | rgb565_to_444(src[1]);
+        src += 2;
+        d[0] = (uint8_t)(p >> 16);
+        d[1] = (uint8_t)(p >> 8);
+        d[2] = (uint8_t)p;
+        d += 3;
+    }
+    if (px) {
+        uint32_t p = rgb565_to_444(src[0]);
+        d[0] = (uint8_t)(p >> 4);
+        d[1] = (uint8_t)(p << 4);
+        d += 2;
+    }
+    return (size_t)(d - dst);
+}
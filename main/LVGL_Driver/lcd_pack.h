@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 12-bit RGB444 wire format (ST7789 COLMOD 0x53): two pixels in three
+// bytes, R1G1 B1R2 G2B2, high nibble first. A quarter fewer bytes on the
+// SPI bus than RGB565, at 16 levels per channel: enough for flat colors
+// and anti-aliased text, not for gradients or fades.
+
+// Bytes on the wire for px pixels. An odd last pixel takes two bytes.
+#define LCD_RGB444_BYTES(px) (((px) * 3 + 1) / 2)
+
+// Pack px RGB565 pixels (LVGL's native order, LV_COLOR_16_SWAP off) from
+// src into dst, which may be the same buffer. Each channel is rounded to
+// the nearest 4-bit level. Returns LCD_RGB444_BYTES(px).
+size_t lcd_pack_rgb444(uint8_t *dst, const uint16_t *src, size_t px);
+
+#ifdef __cplusplus
+}
+#endif
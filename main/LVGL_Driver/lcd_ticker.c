@@ -0,0 +1,31 @@
+#include "lcd_ticker.h"
+
+void lcd_ticker_init(lcd_ticker_t *t, int16_t y0, int16_t h, uint16_t lines)
+{
+    t->y0 = y0;
+    t->h = h;
+    t->lines = lines;
+    t->pos = 0;
+}
+
+lcd_ticker_step_t lcd_ticker_step(lcd_ticker_t *t)
+{
+    uint32_t tape = (uint32_t)t->lines * (uint32_t)t->h;
+    uint32_t in = (t->pos + (uint32_t)t->h) % tape;
+
+    lcd_ticker_step_t s = {
+        .line = (uint16_t)(in / (uint32_t)t->h),
+        .line_row = (int16_t)(in % (uint32_t)t->h),
+        // Where the row that just scrolled out is, shown at the bottom next.
+        .mem_y = (int16_t)(t->y0 + (int16_t)(t->pos % (uint32_t)t->h)),
+    };
+    t->pos = (t->pos + 1) % tape;
+    s.scroll_y = (int16_t)(t->y0 + (int16_t)(t->pos % (uint32_t)t->h));
+    s.hold = t->pos % (uint32_t)t->h == 0;
+    return s;
+}
+
+int16_t lcd_ticker_mem_row(const lcd_ticker_t *t, int16_t y)
+{
+    return (int16_t)(t->y0 + (int16_t)((t->pos + (uint32_t)(y - t->y0)) % (uint32_t)t->h));
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Row bookkeeping for a text ticker moved by the panel's hardware vertical
+// scroll (see LCD_USE_HW_TICKER in LVGL_Driver.h). The ticker is a band of
+// h full-width screen rows from y0. Its text is wrapped into lines, one
+// per h-row card, and the cards are stacked into a looping tape that
+// scrolls up one row per step.
+//
+// Frame memory holds the h tape rows on screen, tape row t in row
+// y0 + t % h. Each step writes the one row about to come in at the bottom
+// over the row that just went out at the top, then moves the scroll start
+// down by one: a single row of pixels on the wire instead of the band.
+// No ESP-IDF or LVGL calls, so it runs on the host.
+
+typedef struct {
+    int16_t y0;
+    int16_t h;
+    uint16_t lines;
+    uint32_t pos; // tape row at the top of the band
+} lcd_ticker_t;
+
+typedef struct {
+    uint16_t line;    // text line the new row belongs to
+    int16_t line_row; // its row within that line's card
+    int16_t mem_y;    // frame memory row to write it to
+    int16_t scroll_y; // frame memory row shown at y0 once it is written
+    bool hold;        // a whole card is on screen now
+} lcd_ticker_step_t;
+
+// Card 0 goes into frame memory rows y0 .. y0 + h - 1, scroll start y0.
+void lcd_ticker_init(lcd_ticker_t *t, int16_t y0, int16_t h, uint16_t lines);
+
+// The next row to send and the scroll start to set after it.
+lcd_ticker_step_t lcd_ticker_step(lcd_ticker_t *t);
+
+// Frame memory row shown at screen row y (y0 <= y < y0 + h).
+int16_t lcd_ticker_mem_row(const lcd_ticker_t *t, int16_t y);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,114 @@
+#include "lcd_tiles.h"
+
+#include <string.h>
+
+#define TILE_MARKED 0x01
+#define TILE_VALID  0x02
+
+void lcd_tiles_init(lcd_tiles_t *t, int16_t hor_res, int16_t ver_res, uint32_t *hash, uint8_t *marked)
+{
+    t->hor_res = hor_res;
+    t->ver_res = ver_res;
+    t->cols = LCD_TILES_COLS(hor_res);
+    t->rows = LCD_TILES_ROWS(ver_res);
+    t->hash = hash;
+    t->marked = marked;
+    memset(hash, 0, sizeof(uint32_t) * t->cols * t->rows);
+    memset(marked, 0, (size_t)t->cols * t->rows);
+}
+
+void lcd_tiles_mark(lcd_tiles_t *t, int16_t x1, int16_t y1, int16_t x2, int16_t y2)
+{
+    x1 = x1 < 0 ? 0 : x1;
+    y1 = y1 < 0 ? 0 : y1;
+    x2 = x2 >= t->hor_res ? t->hor_res - 1 : x2;
+    y2 = y2 >= t->ver_res ? t->ver_res - 1 : y2;
+    if (x1 > x2 || y1 > y2) {
+        return;
+    }
+
+    for (int r = y1 / LCD_TILE_H; r <= y2 / LCD_TILE_H; r++) {
+        uint8_t *row = &t->marked[r * t->cols];
+        for (int c = x1 / LCD_TILE_W; c <= x2 / LCD_TILE_W; c++) {
+            row[c] |= TILE_MARKED;
+        }
+    }
+}
+
+void lcd_tiles_forget(lcd_tiles_t *t, int16_t x1, int16_t y1, int16_t x2, int16_t y2)
+{
+    x1 = x1 < 0 ? 0 : x1;
+    y1 = y1 < 0 ? 0 : y1;
+    x2 = x2 >= t->hor_res ? t->hor_res - 1 : x2;
+    y2 = y2 >= t->ver_res ? t->ver_res - 1 : y2;
+    if (x1 > x2 || y1 > y2) {
+        return;
+    }
+
+    for (int r = y1 / LCD_TILE_H; r <= y2 / LCD_TILE_H; r++) {
+        uint8_t *row = &t->marked[r * t->cols];
+        for (int c = x1 / LCD_TILE_W; c <= x2 / LCD_TILE_W; c++) {
+            row[c] &= (uint8_t)~TILE_VALID;
+        }
+    }
+}
+
+static uint32_t tile_hash(const lcd_tiles_t *t, const uint16_t *fb, int c, int r)
+{
+    int x1 = c * LCD_TILE_W;
+    int y1 = r * LCD_TILE_H;
+    int w = t->hor_res - x1 < LCD_TILE_W ? t->hor_res - x1 : LCD_TILE_W;
+    int h = t->ver_res - y1 < LCD_TILE_H ? t->ver_res - y1 : LCD_TILE_H;
+
+    // FNV-1a over the pixels.
+    uint32_t hash = 2166136261u;
+    for (int y = y1; y < y1 + h; y++) {
+        const uint16_t *px = &fb[y * t->hor_res + x1];
+        for (int x = 0; x < w; x++) {
+            hash = (hash ^ px[x]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+uint32_t lcd_tiles_flush(lcd_tiles_t *t, const uint16_t *fb, lcd_tiles_span_cb_t cb, void *ctx)
+{
+    uint32_t px = 0;
+
+    for (int r = 0; r < t->rows; r++) {
+        uint8_t *row = &t->marked[r * t->cols];
+        int run = -1; // first changed column of the open run
+
+        for (int c = 0; c <= t->cols; c++) {
+            bool changed = false;
+            if (c < t->cols && (row[c] & TILE_MARKED)) {
+                uint32_t hash = tile_hash(t, fb, c, r);
+                changed = !(row[c] & TILE_VALID) || t->hash[r * t->cols + c] != hash;
+                t->hash[r * t->cols + c] = hash;
+                row[c] = TILE_VALID;
+            }
+            if (changed) {
+                if (run < 0) {
+                    run = c;
+                }
+                continue;
+            }
+            if (run < 0) {
+                continue;
+            }
+
+            int x2 = c * LCD_TILE_W - 1;
+            int y2 = r * LCD_TILE_H + LCD_TILE_H - 1;
+            lcd_span_t span = {
+                .x1 = (int16_t)(run * LCD_TILE_W),
+                .y1 = (int16_t)(r * LCD_TILE_H),
+                .x2 = (int16_t)(x2 < t->hor_res ? x2 : t->hor_res - 1),
+                .y2 = (int16_t)(y2 < t->ver_res ? y2 : t->ver_res - 1),
+            };
+            px += (uint32_t)(span.x2 - span.x1 + 1) * (uint32_t)(span.y2 - span.y1 + 1);
+            cb(&span, ctx);
+            run = -1;
+        }
+    }
+    return px;
+}
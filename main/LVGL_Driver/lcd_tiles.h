@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Dirty-tile diffing for the direct-mode framebuffer (see LCD_USE_DIRECT_MODE
+// in LVGL_Driver.h). LVGL invalidates whole objects: a label whose text
+// changed by one digit, or a bar moved by one pixel, is redrawn edge to
+// edge. The areas it redrew are split into LCD_TILE_W x LCD_TILE_H tiles.
+// Each tile's hash is compared with the one last sent, and only runs of
+// changed tiles go out over SPI.
+//
+// One 32-bit hash per tile stands in for a copy of the previous frame,
+// which would cost another full framebuffer of RAM. No ESP-IDF calls, so
+// it runs on the host.
+
+#define LCD_TILE_W 16
+#define LCD_TILE_H 16
+
+// Inclusive pixel coordinates, like lv_area_t.
+typedef struct {
+    int16_t x1;
+    int16_t y1;
+    int16_t x2;
+    int16_t y2;
+} lcd_span_t;
+
+// Called for each run of changed tiles, top to bottom, left to right.
+typedef void (*lcd_tiles_span_cb_t)(const lcd_span_t *span, void *ctx);
+
+typedef struct {
+    int16_t hor_res;
+    int16_t ver_res;
+    int16_t cols;
+    int16_t rows;
+    uint32_t *hash;  // cols * rows
+    uint8_t *marked; // cols * rows: bit 0 redrawn, bit 1 hash valid
+} lcd_tiles_t;
+
+#define LCD_TILES_COLS(hor_res) (((hor_res) + LCD_TILE_W - 1) / LCD_TILE_W)
+#define LCD_TILES_ROWS(ver_res) (((ver_res) + LCD_TILE_H - 1) / LCD_TILE_H)
+
+// `hash` and `marked` hold LCD_TILES_COLS * LCD_TILES_ROWS entries each.
+void lcd_tiles_init(lcd_tiles_t *t, int16_t hor_res, int16_t ver_res, uint32_t *hash, uint8_t *marked);
+
+// Note an area LVGL redrew (clipped to the screen).
+void lcd_tiles_mark(lcd_tiles_t *t, int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+
+// Drop the hashes of the tiles an area covers: the panel no longer shows
+// what was sent for them, so they go out again the next time they are marked.
+void lcd_tiles_forget(lcd_tiles_t *t, int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+
+// Hash the marked tiles of `fb` (hor_res x ver_res RGB565, row-major),
+// report the runs that changed and clear the marks. Returns the number of
+// pixels reported.
+uint32_t lcd_tiles_flush(lcd_tiles_t *t, const uint16_t *fb, lcd_tiles_span_cb_t cb, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,94 +3,246 @@
 
 #include "Wireless.h"
 
+#include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <time.h>
 
 #include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
 #include "freertos/task.h"
 
-#include "esp_crt_bundle.h"
-#include "esp_http_client.h"
 #include "esp_log.h"
-#include "esp_sntp.h"
-
-#include "cJSON.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+
+#include "iso8601.h"
+#include "json_stream.h"
+#include "mbta_alerts.h"
+#include "mbta_included.h"
+#include "mbta_schedule.h"
+#include "net_service.h"
+#include "seqlock.h"
+#include "snapshot.h"
+#include "time_sync.h"
+#include "ui_notify.h"
+
+// Optional: receive predictions over a Server-Sent Events stream instead of
+// polling (see mbta_stream.h). Polling remains the default.
+#ifndef MBTA_USE_STREAMING
+#define MBTA_USE_STREAMING 0
+#endif
+
+#if MBTA_USE_STREAMING
+#include "mbta_stream.h"
+#endif
+
+// Optional: fetch every configured stop with one request and split the
+// predictions per stop while parsing (see config.h.example).
+#ifndef MBTA_USE_COMBINED_FETCH
+#define MBTA_USE_COMBINED_FETCH 0
+#endif
+
+// Service alerts for the stop table on their own slow schedule (see
+// mbta_alerts.h).
+#ifndef MBTA_USE_ALERTS
+#define MBTA_USE_ALERTS 1
+#endif
+
+// Scheduled departures (prefetched once per service day and kept in flash)
+// stand in when a stop has no predictions or the network is down.
+#ifndef MBTA_USE_SCHEDULE_CACHE
+#define MBTA_USE_SCHEDULE_CACHE 1
+#endif
+
+#if MBTA_USE_STREAMING
+// One stream carries every stop; the combined request only applies to polling.
+#undef MBTA_USE_COMBINED_FETCH
+#define MBTA_USE_COMBINED_FETCH 0
+#endif
 
 #define MBTA_POLL_PERIOD_MS   (MBTA_FETCH_PERIOD_MS)
 #define MBTA_HTTP_TIMEOUT_MS  (8000)
-
-// User-provided endpoints
-// Note: keep responses small so they fit in our JSON buffer.
-#define MBTA_BUS_URL MBTA_STOP_1_URL
-#define MBTA_T_URL   MBTA_STOP_2_URL
-
-// Titles (kept simple; can be made dynamic later by including route/stop/trip)
-#define MBTA_BUS_TITLE MBTA_STOP_1_NAME
-#define MBTA_T_TITLE   MBTA_STOP_2_NAME
+// A poll that could not start within this (other jobs ahead of it on the
+// network service) is skipped and counts as failed.
+#define MBTA_NET_DEADLINE_MS  (20000)
+#define MBTA_TIME_WAIT_MS     (10000)
+#define MBTA_MAX_EPOCHS       (8)
+#define MBTA_URL_MAX          (256)
+#define MBTA_API_BASE         "https://api-v3.mbta.com/predictions?"
+
+// Adaptive poll interval: poll often while the next arrival is close and
+// back off when it is far or there is no service. The interval is about
+// 1/MBTA_POLL_ARRIVAL_DIVISOR of the wait for the next arrival.
+#ifndef MBTA_POLL_MIN_MS
+#define MBTA_POLL_MIN_MS (MBTA_POLL_PERIOD_MS / 2)
+#endif
+#ifndef MBTA_POLL_MAX_MS
+#define MBTA_POLL_MAX_MS (MBTA_POLL_PERIOD_MS * 4)
+#endif
+#define MBTA_POLL_ARRIVAL_DIVISOR (8)
+
+// Exponential backoff (with jitter) after failed requests.
+#define MBTA_RETRY_MIN_MS (10000)
+#define MBTA_RETRY_MAX_MS (5 * 60 * 1000)
+
+// Hold off once this few requests remain in the server's rate-limit window.
+#define MBTA_RATELIMIT_RESERVE (2)
+
+// Requests of different jobs start at least this far apart: the spread
+// only holds until the adaptive intervals drift jobs back into step.
+#define MBTA_JOB_SPACING_MS (MBTA_POLL_MIN_MS / MBTA_JOB_COUNT)
+
+// Upper bound on one scheduler sleep, so WiFi and display-hour changes are
+// picked up even with a long poll period.
+#define MBTA_SCHED_MAX_SLEEP_MS (15000)
+
+// With streaming, nothing is fetched on a timer; besides stream changes the
+// task only wakes to let later arrivals move up once the first has departed
+// and to follow the display hours.
+#define MBTA_STREAM_REFRESH_MS (15000)
+
+// A service day runs past midnight until this hour; its schedule is
+// fetched once, retrying after MBTA_SCHEDULE_RETRY_MS on failure.
+#define MBTA_SERVICE_DAY_START_HOUR (3)
+#define MBTA_SCHEDULE_RETRY_MS      (15 * 60 * 1000)
+
+// One configured stop. Predictions for it are those at stop_id on route_id
+// ("" == any route).
+typedef struct {
+    const char *stop_id;
+    const char *route_id;
+    const char *name;
+} mbta_stop_cfg_t;
+
+#ifndef MBTA_STOPS
+// Older configs only define the two MBTA_STOP_n_* stops. Their filters
+// lived in the hand-written MBTA_STOP_n_URL, which is no longer used;
+// rather than drop a route filter silently, make them move to the table.
+#if (defined(MBTA_STOP_1_URL) && !defined(MBTA_STOP_1_ROUTE)) || \
+    (defined(MBTA_STOP_2_URL) && !defined(MBTA_STOP_2_ROUTE))
+#error "MBTA_STOP_n_URL is gone; define MBTA_STOPS (see config.h.example)"
+#endif
+#ifndef MBTA_STOP_1_ROUTE
+#define MBTA_STOP_1_ROUTE ""
+#endif
+#ifndef MBTA_STOP_2_ROUTE
+#define MBTA_STOP_2_ROUTE ""
+#endif
+#define MBTA_STOPS \
+    {MBTA_STOP_1_ID, MBTA_STOP_1_ROUTE, MBTA_STOP_1_NAME}, \
+    {MBTA_STOP_2_ID, MBTA_STOP_2_ROUTE, MBTA_STOP_2_NAME},
+#endif
+
+// In priority order: the first stop with upcoming arrivals is shown.
+static const mbta_stop_cfg_t s_stops[] = {MBTA_STOPS};
+#define MBTA_STOP_COUNT ((int)(sizeof(s_stops) / sizeof(s_stops[0])))
+_Static_assert(sizeof(s_stops) / sizeof(s_stops[0]) <= MBTA_MAX_STOPS, "too many MBTA_STOPS");
+
+// A fetch job is one request on its own schedule: every stop in combined
+// mode, otherwise one job per stop. The stream (job 0) also covers every stop.
+#if MBTA_USE_COMBINED_FETCH || MBTA_USE_STREAMING
+#define MBTA_JOB_COUNT 1
+#else
+#define MBTA_JOB_COUNT MBTA_STOP_COUNT
+#endif
 
 static const char *TAG = "MBTA";
 
-static SemaphoreHandle_t s_state_mu;
-static mbta_state_t s_state;
+// Written by mbta_task only (and MBTA_TaskStart before it runs).
+static seqlock_t s_state_pub;
+static mbta_state_t s_state_bufs[2];
 static uint32_t s_state_version;
 
-static void mbta_state_set(const mbta_state_t *src)
+#if MBTA_USE_STREAMING
+static TaskHandle_t s_mbta_task;
+// Arrival time (esp_timer, low 32 bits) of the stream event behind the
+// pending wakeup, or 0.
+static volatile uint32_t s_stream_event_us;
+static struct {
+    uint32_t publishes;
+    uint32_t last_latency_us;
+    uint32_t max_latency_us;
+} s_stream_stats;
+#endif
+
+static bool mbta_stops_same_content(const mbta_state_t *a, const mbta_state_t *b)
 {
-    if (s_state_mu == NULL) {
-        return;
+    if (a->stop_count != b->stop_count || a->shown_stop != b->shown_stop) {
+        return false;
+    }
+    for (int i = 0; i < a->stop_count; i++) {
+        const mbta_stop_state_t *sa = &a->stops[i];
+        const mbta_stop_state_t *sb = &b->stops[i];
+        if (sa->has_data != sb->has_data || sa->scheduled != sb->scheduled || sa->stale != sb->stale ||
+            sa->arrival_count != sb->arrival_count ||
+            memcmp(sa->arrivals_epoch, sb->arrivals_epoch, sizeof(sa->arrivals_epoch)) != 0 ||
+            memcmp(sa->arrival_details, sb->arrival_details, sizeof(sa->arrival_details)) != 0) {
+            return false;
+        }
     }
+    return true;
+}
 
-    xSemaphoreTake(s_state_mu, portMAX_DELAY);
-    s_state = *src;
-    // Ensure version is monotonic across updates (UI uses it to detect changes).
-    s_state_version++;
-    s_state.version = s_state_version;
-    xSemaphoreGive(s_state_mu);
+static bool mbta_state_same_content(const mbta_state_t *a, const mbta_state_t *b)
+{
+    return a->mode == b->mode &&
+           a->no_bus_service_banner == b->no_bus_service_banner &&
+           a->arrival_count == b->arrival_count &&
+           a->scheduled == b->scheduled &&
+           a->stale == b->stale &&
+           memcmp(a->arrivals_epoch, b->arrivals_epoch, sizeof(a->arrivals_epoch)) == 0 &&
+           memcmp(a->arrival_details, b->arrival_details, sizeof(a->arrival_details)) == 0 &&
+           strcmp(a->title, b->title) == 0 &&
+           mbta_stops_same_content(a, b) &&
+           a->has_data == b->has_data &&
+           a->display_off == b->display_off;
 }
 
-bool MBTA_GetState(mbta_state_t *out_state)
+static void mbta_state_set(const mbta_state_t *src)
 {
-    if (out_state == NULL || s_state_mu == NULL) {
-        return false;
+    mbta_state_t *st = seqlock_write_begin(&s_state_pub);
+    // Only bump the version when something the UI renders changed; an
+    // unchanged poll (e.g. a 304) must not make it re-set every label.
+    bool changed = !mbta_state_same_content(st, src);
+    // The loader is tracked apart from the version, but still needs a wakeup.
+    bool loader_changed = st->is_fetching != src->is_fetching || st->refresh_ms != src->refresh_ms;
+    *st = *src;
+    if (changed) {
+        // Ensure version is monotonic across updates (UI uses it to detect changes).
+        s_state_version++;
     }
-
-    bool ok = false;
-    if (xSemaphoreTake(s_state_mu, pdMS_TO_TICKS(10)) == pdTRUE) {
-        *out_state = s_state;
-        ok = true;
-        xSemaphoreGive(s_state_mu);
+    st->version = s_state_version;
+    seqlock_write_end(&s_state_pub);
+    if (changed || loader_changed) {
+        UiNotify_Signal();
     }
-    return ok;
 }
 
-static void mbta_set_timezone(void)
+static void mbta_state_set_fetching(bool is_fetching)
 {
-    // Localized timezone from config.h
-    setenv("TZ", DEFAULT_TIMEZONE, 1);
-    tzset();
+    // The UI tracks is_fetching separately from version.
+    mbta_state_t *st = seqlock_write_begin(&s_state_pub);
+    st->is_fetching = is_fetching;
+    seqlock_write_end(&s_state_pub);
+    UiNotify_Signal();
 }
 
-static time_t timegm_compat(struct tm *tmv)
+bool MBTA_GetState(mbta_state_t *out_state)
 {
-    // newlib in ESP-IDF doesn't always provide timegm(); emulate it.
-    char old_tz[64] = {0};
-    const char *old = getenv("TZ");
-    if (old) {
-        strlcpy(old_tz, old, sizeof(old_tz));
+    // Nothing published before MBTA_TaskStart().
+    if (out_state == NULL || seqlock_version(&s_state_pub) == 0) {
+        return false;
     }
+    seqlock_read(&s_state_pub, out_state);
+    return true;
+}
 
-    setenv("TZ", "UTC0", 1);
-    tzset();
-    time_t t = mktime(tmv);
-
-    if (old) {
-        setenv("TZ", old_tz, 1);
-    } else {
-        setenv("TZ", DEFAULT_TIMEZONE, 1);
+bool MBTA_GetStateIfChanged(mbta_state_t *out_state, uint32_t *seen)
+{
+    if (out_state == NULL || seen == NULL) {
+        return false;
     }
-    tzset();
-    return t;
+    return seqlock_read_if_changed(&s_state_pub, out_state, seen);
 }
 
 static bool mbta_time_is_sane(void)
@@ -100,340 +252,1032 @@ static bool mbta_time_is_sane(void)
     return now > 1577836800;
 }
 
-static void mbta_time_sync_sntp(void)
+#if !MBTA_USE_STREAMING && !MBTA_USE_COMBINED_FETCH
+// Per-stop URLs are already filtered server-side.
+static const mbta_stop_cfg_t s_match_all = {NULL, NULL, NULL};
+#endif
+
+// Earliest upcoming predictions, ascending.
+typedef struct {
+    time_t epochs[MBTA_MAX_EPOCHS];
+    mbta_arrival_detail_t details[MBTA_MAX_EPOCHS];
+    int count;
+} mbta_epoch_list_t;
+
+// Relationships of a kept prediction, resolved against `included` once the
+// whole response has been read.
+typedef struct {
+    uint32_t trip_key;
+    uint32_t vehicle_key;
+    int16_t stop_sequence;
+} mbta_prediction_ref_t;
+
+typedef struct {
+    json_stream_t js;
+    char tok[48];
+    time_t now;
+
+    const mbta_stop_cfg_t *filters;
+    int filter_count;
+
+    // Fields of the data[] item currently being parsed (0/"" == absent).
+    time_t item_arrival;
+    time_t item_departure;
+    char item_stop[24];
+    char item_route[32];
+    mbta_prediction_ref_t item_ref;
+
+    // One list per filter, with the refs of each kept prediction.
+    mbta_epoch_list_t lists[MBTA_MAX_STOPS];
+    mbta_prediction_ref_t refs[MBTA_MAX_STOPS][MBTA_MAX_EPOCHS];
+    bool saw_data;
+
+    mbta_included_index_t included;
+
+    uint32_t body_bytes;
+    char last_modified[40];
+    // x-ratelimit-remaining / x-ratelimit-reset (-1/0 == absent).
+    long ratelimit_remaining;
+    time_t ratelimit_reset;
+} prediction_parser_t;
+
+// Request URL and validator per fetch job, so a 304 can skip the body.
+typedef struct {
+    char url[MBTA_URL_MAX];
+    char last_modified[40];
+    uint32_t body_bytes;
+} mbta_job_t;
+
+static mbta_job_t s_jobs[MBTA_MAX_STOPS];
+
+// Last parsed (or stream) predictions per stop; only the mbta task touches these.
+static mbta_epoch_list_t s_stop_lists[MBTA_MAX_STOPS];
+static bool s_stop_ok[MBTA_MAX_STOPS];
+// Restored at boot and not refreshed since.
+static bool s_stop_stale[MBTA_MAX_STOPS];
+static time_t s_stop_fetched_at[MBTA_MAX_STOPS];
+static uint32_t s_stop_refresh_ms[MBTA_MAX_STOPS];
+
+// Consecutive failures per job, and the earliest time (esp_timer) the
+// server's rate limit lets any job run again.
+#if !MBTA_USE_STREAMING
+static uint8_t s_job_failures[MBTA_MAX_STOPS];
+#endif
+static int64_t s_ratelimit_hold_us;
+static int s_shown_stop;
+
+#if MBTA_USE_SCHEDULE_CACHE
+// Mapped schedule image (NULL == none), and when a failed prefetch may be
+// retried.
+static const uint8_t *s_schedule;
+static int64_t s_schedule_retry_us;
+#endif
+
+static struct {
+    uint32_t polls;
+    uint32_t not_modified;
+    uint32_t bytes_saved;
+} s_fetch_stats;
+
+static void prediction_insert(mbta_epoch_list_t *l, mbta_prediction_ref_t *refs, time_t epoch,
+                              const mbta_prediction_ref_t *ref)
 {
-    if (mbta_time_is_sane()) {
+    // Keep only the earliest MBTA_MAX_EPOCHS; the response can be any length.
+    int pos = l->count;
+    while (pos > 0 && l->epochs[pos - 1] > epoch) {
+        pos--;
+    }
+    if (pos >= MBTA_MAX_EPOCHS) {
         return;
     }
 
-    mbta_set_timezone();
+    int last = (l->count < MBTA_MAX_EPOCHS) ? l->count : MBTA_MAX_EPOCHS - 1;
+    memmove(&l->epochs[pos + 1], &l->epochs[pos], (size_t)(last - pos) * sizeof(time_t));
+    memmove(&refs[pos + 1], &refs[pos], (size_t)(last - pos) * sizeof(*refs));
+    l->epochs[pos] = epoch;
+    refs[pos] = *ref;
+    if (l->count < MBTA_MAX_EPOCHS) {
+        l->count++;
+    }
+}
 
-    // Simple SNTP init (IDF 5.x)
-    esp_sntp_setoperatingmode(ESP_SNTP_OPMODE_POLL);
-    esp_sntp_setservername(0, "pool.ntp.org");
-    esp_sntp_init();
+static bool filter_field_matches(const char *want, const char *got)
+{
+    return want == NULL || want[0] == '\0' || strcmp(want, got) == 0;
+}
 
-    // Wait up to ~10 seconds for time to become sane.
-    for (int i = 0; i < 20; i++) {
-        if (mbta_time_is_sane()) {
-            ESP_LOGI(TAG, "Time synced");
-            return;
+// Route a finished data[] item to every slot whose filter it matches.
+static void prediction_demux(prediction_parser_t *p, time_t epoch)
+{
+    for (int i = 0; i < p->filter_count; i++) {
+        const mbta_stop_cfg_t *f = &p->filters[i];
+        if (filter_field_matches(f->stop_id, p->item_stop) &&
+            filter_field_matches(f->route_id, p->item_route)) {
+            prediction_insert(&p->lists[i], p->refs[i], epoch, &p->item_ref);
         }
-        vTaskDelay(pdMS_TO_TICKS(500));
     }
-
-    ESP_LOGW(TAG, "Time not synced (TLS may fail)");
 }
 
-static bool iso8601_to_epoch_utc(const char *s, time_t *out_epoch)
+// data[] is complete: only the trips/vehicles of kept predictions need an
+// index slot.
+static void prediction_reserve_included(prediction_parser_t *p)
 {
-    // Parses: YYYY-MM-DDTHH:MM:SS(.sss)?(Z|±HH:MM)
-    if (s == NULL || out_epoch == NULL) {
-        return false;
+    for (int i = 0; i < p->filter_count; i++) {
+        for (int k = 0; k < p->lists[i].count; k++) {
+            const mbta_prediction_ref_t *ref = &p->refs[i][k];
+            if (ref->trip_key != 0) {
+                mbta_included_reserve(&p->included, ref->trip_key);
+            }
+            if (ref->vehicle_key != 0) {
+                mbta_included_reserve(&p->included, ref->vehicle_key);
+            }
+        }
     }
+    mbta_included_close(&p->included);
+}
 
-    int year = 0, mon = 0, day = 0, hour = 0, min = 0, sec = 0;
-    int n = sscanf(s, "%4d-%2d-%2dT%2d:%2d:%2d", &year, &mon, &day, &hour, &min, &sec);
-    if (n != 6) {
-        return false;
+// Project the included trip/vehicle of every kept prediction.
+static void prediction_resolve_details(prediction_parser_t *p)
+{
+    for (int i = 0; i < p->filter_count; i++) {
+        for (int k = 0; k < p->lists[i].count; k++) {
+            const mbta_prediction_ref_t *ref = &p->refs[i][k];
+            mbta_arrival_detail_t *d = &p->lists[i].details[k];
+            memset(d, 0, sizeof(*d));
+            d->stops_away = -1;
+
+            const mbta_included_entry_t *trip = mbta_included_find(&p->included, ref->trip_key);
+            if (trip != NULL) {
+                strlcpy(d->headsign, trip->headsign, sizeof(d->headsign));
+            }
+            const mbta_included_entry_t *vehicle = mbta_included_find(&p->included, ref->vehicle_key);
+            if (vehicle != NULL) {
+                d->occupancy = vehicle->occupancy;
+                int away = ref->stop_sequence - vehicle->current_stop_sequence;
+                if (ref->stop_sequence >= 0 && vehicle->current_stop_sequence >= 0 && away >= 0) {
+                    d->stops_away = (int8_t)(away > INT8_MAX ? INT8_MAX : away);
+                }
+            }
+        }
     }
+}
 
-    const char *p = strchr(s, 'T');
-    if (p == NULL) {
-        return false;
+static bool prediction_on_json(json_stream_t *js, json_stream_event_t ev, const char *value, size_t len, void *ctx)
+{
+    (void)len;
+    prediction_parser_t *p = (prediction_parser_t *)ctx;
+    int depth = json_stream_depth(js);
+
+    // Predictions live under data[...], the trips/vehicles they reference
+    // under included[...].
+    if (depth >= 1 && strcmp(json_stream_key(js, 0), "included") == 0) {
+        mbta_included_on_json(&p->included, js, ev, value);
+        return true;
     }
-    // Move to end of seconds component.
-    p = strchr(p, ':');
-    if (p == NULL) {
-        return false;
+    if (depth < 1 || strcmp(json_stream_key(js, 0), "data") != 0) {
+        return true;
     }
-    p = strchr(p + 1, ':');
-    if (p == NULL) {
-        return false;
+
+    if (depth == 1) {
+        if (ev == JSON_STREAM_ARRAY_BEGIN) {
+            p->saw_data = true;
+        } else if (ev == JSON_STREAM_ARRAY_END) {
+            prediction_reserve_included(p);
+        }
+        return true;
     }
-    p = p + 1; // at seconds
-    // Advance past 2 digits of seconds.
-    if (p[0] == '\0' || p[1] == '\0') {
-        return false;
+
+    if (!json_stream_in_array(js, 1)) {
+        return true;
     }
-    p += 2;
 
-    // Optional fractional seconds
-    if (*p == '.') {
-        p++;
-        while (*p >= '0' && *p <= '9') {
-            p++;
+    if (depth == 2) {
+        if (ev == JSON_STREAM_OBJECT_BEGIN) {
+            p->item_arrival = 0;
+            p->item_departure = 0;
+            p->item_stop[0] = '\0';
+            p->item_route[0] = '\0';
+            p->item_ref.trip_key = 0;
+            p->item_ref.vehicle_key = 0;
+            p->item_ref.stop_sequence = -1;
+        } else if (ev == JSON_STREAM_OBJECT_END) {
+            time_t epoch = p->item_arrival ? p->item_arrival : p->item_departure;
+            // Filter out stale predictions.
+            if (epoch != 0 && epoch >= p->now - 30) {
+                prediction_demux(p, epoch);
+            }
         }
+        return true;
     }
 
-    int tz_offset_sec = 0;
-    if (*p == 'Z' || *p == '\0') {
-        tz_offset_sec = 0;
-    } else if (*p == '+' || *p == '-') {
-        int sign = (*p == '-') ? -1 : 1;
-        int tzh = 0, tzm = 0;
-        // Supports ±HH:MM
-        if (sscanf(p + 1, "%2d:%2d", &tzh, &tzm) != 2) {
-            return false;
+    // data[i].relationships.{stop,route,trip,vehicle}.data.id
+    if (depth == 6 && ev == JSON_STREAM_STRING && strcmp(json_stream_key(js, 2), "relationships") == 0 &&
+        strcmp(json_stream_key(js, 4), "data") == 0 && strcmp(json_stream_key(js, 5), "id") == 0) {
+        const char *rel = json_stream_key(js, 3);
+        if (strcmp(rel, "stop") == 0) {
+            strlcpy(p->item_stop, value, sizeof(p->item_stop));
+        } else if (strcmp(rel, "route") == 0) {
+            strlcpy(p->item_route, value, sizeof(p->item_route));
+        } else if (strcmp(rel, "trip") == 0) {
+            p->item_ref.trip_key = mbta_resource_key(MBTA_RESOURCE_TRIP, value);
+        } else if (strcmp(rel, "vehicle") == 0) {
+            p->item_ref.vehicle_key = mbta_resource_key(MBTA_RESOURCE_VEHICLE, value);
         }
-        tz_offset_sec = sign * (tzh * 3600 + tzm * 60);
-    } else {
-        return false;
+        return true;
     }
 
-    struct tm tmv = {0};
-    tmv.tm_year = year - 1900;
-    tmv.tm_mon = mon - 1;
-    tmv.tm_mday = day;
-    tmv.tm_hour = hour;
-    tmv.tm_min = min;
-    tmv.tm_sec = sec;
-    tmv.tm_isdst = -1;
-
-    // Interpret the parsed wall-clock as UTC then correct by the explicit offset.
-    time_t base = timegm_compat(&tmv);
-    if (base == (time_t)-1) {
-        return false;
+    if (depth == 4 && ev == JSON_STREAM_NUMBER && strcmp(json_stream_key(js, 2), "attributes") == 0 &&
+        strcmp(json_stream_key(js, 3), "stop_sequence") == 0) {
+        long seq = strtol(value, NULL, 10);
+        p->item_ref.stop_sequence = (seq >= 0 && seq <= INT16_MAX) ? (int16_t)seq : -1;
+        return true;
     }
 
-    // If string is local time with an offset, UTC = local - offset.
-    // Example: 12:00-05:00 => offset=-18000 => UTC = local - (-18000) = local + 5h.
-    *out_epoch = base - tz_offset_sec;
+    if (depth == 4 && ev == JSON_STREAM_STRING && strcmp(json_stream_key(js, 2), "attributes") == 0) {
+        const char *key = json_stream_key(js, 3);
+        time_t epoch = 0;
+        if (strcmp(key, "arrival_time") == 0) {
+            if (iso8601_to_epoch_utc(value, &epoch)) {
+                p->item_arrival = epoch;
+            }
+        } else if (strcmp(key, "departure_time") == 0) {
+            if (iso8601_to_epoch_utc(value, &epoch)) {
+                p->item_departure = epoch;
+            }
+        }
+    }
     return true;
 }
 
-static esp_err_t http_get_to_buffer(const char *url, char *buf, size_t buf_size, int *out_http_status)
+static bool prediction_on_body(const char *data, size_t len, void *ctx)
+{
+    prediction_parser_t *p = (prediction_parser_t *)ctx;
+    p->body_bytes += (uint32_t)len;
+    return json_stream_feed(&p->js, data, len);
+}
+
+static void prediction_on_header(const char *name, const char *value, void *ctx)
 {
-    if (buf == NULL || buf_size == 0) {
-        return ESP_ERR_INVALID_ARG;
+    prediction_parser_t *p = (prediction_parser_t *)ctx;
+    if (strcasecmp(name, "Last-Modified") == 0) {
+        strlcpy(p->last_modified, value, sizeof(p->last_modified));
+    } else if (strcasecmp(name, "x-ratelimit-remaining") == 0) {
+        p->ratelimit_remaining = strtol(value, NULL, 10);
+    } else if (strcasecmp(name, "x-ratelimit-reset") == 0) {
+        // UTC epoch seconds at which the window ends.
+        p->ratelimit_reset = (time_t)strtoll(value, NULL, 10);
     }
+}
 
-    esp_http_client_config_t config = {
-        .url = url,
-        .method = HTTP_METHOD_GET,
+// Copy the arrivals that have not departed yet (same cutoff as the UI).
+// out_details may be NULL.
+static int upcoming_arrivals(const mbta_epoch_list_t *list, time_t now, time_t *out_epochs,
+                             mbta_arrival_detail_t *out_details, int max_arrivals)
+{
+    int n = 0;
+    for (int i = 0; i < list->count && n < max_arrivals; i++) {
+        if (MBTA_MinutesUntil(list->epochs[i], now) >= 0) {
+            if (out_details != NULL) {
+                out_details[n] = list->details[i];
+            }
+            out_epochs[n++] = list->epochs[i];
+        }
+    }
+    return n;
+}
+
+static void mbta_note_ratelimit(const prediction_parser_t *p, int http_status)
+{
+    bool exhausted = http_status == 429 ||
+                     (p->ratelimit_remaining >= 0 && p->ratelimit_remaining <= MBTA_RATELIMIT_RESERVE);
+    if (!exhausted || p->ratelimit_reset == 0) {
+        return;
+    }
+
+    long wait_s = (long)(p->ratelimit_reset - time(NULL));
+    if (wait_s <= 0) {
+        return;
+    }
+    if (wait_s > MBTA_RETRY_MAX_MS / 1000) {
+        wait_s = MBTA_RETRY_MAX_MS / 1000;
+    }
+    s_ratelimit_hold_us = esp_timer_get_time() + (int64_t)wait_s * 1000000;
+    ESP_LOGW(TAG, "rate limit: %ld request(s) left, holding %lds", p->ratelimit_remaining, wait_s);
+}
+
+// One request for `job`; out_lists[i] receives the predictions matching
+// filters[i]. After a 304 they are left as the previous 200 set them.
+static bool fetch_predictions(mbta_job_t *job, const mbta_stop_cfg_t *filters, int filter_count,
+                              mbta_epoch_list_t *out_lists)
+{
+    if (job == NULL || filters == NULL || filter_count <= 0 || filter_count > MBTA_MAX_STOPS || out_lists == NULL) {
+        return false;
+    }
+
+    // Parsed straight off the socket: no body buffer, no DOM. The parser
+    // (with its `included` index) is too big for the task stack; only the
+    // mbta task fetches.
+    static prediction_parser_t parser;
+    memset(&parser, 0, sizeof(parser));
+    mbta_included_init(&parser.included);
+    parser.now = time(NULL);
+    parser.filters = filters;
+    parser.filter_count = filter_count;
+    parser.ratelimit_remaining = -1;
+    json_stream_init(&parser.js, parser.tok, sizeof(parser.tok), prediction_on_json, &parser);
+
+    char extra_headers[sizeof(job->last_modified) + 24] = {0};
+    if (job->last_modified[0] != '\0') {
+        snprintf(extra_headers, sizeof(extra_headers), "If-Modified-Since: %s\r\n", job->last_modified);
+    }
+
+    http_conn_request_t req = {
+        .url = job->url,
         .timeout_ms = MBTA_HTTP_TIMEOUT_MS,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-        .user_agent = "mbta-lcd/1.0",
+        .extra_headers = extra_headers,
+        .on_header = prediction_on_header,
+        .on_body = prediction_on_body,
+        .ctx = &parser,
     };
 
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == NULL) {
-        return ESP_FAIL;
+    int http_status = 0;
+    esp_err_t err = NetService_Get(&req, NET_PRIO_HIGH, MBTA_NET_DEADLINE_MS, &http_status);
+    s_fetch_stats.polls++;
+    mbta_note_ratelimit(&parser, http_status);
+
+    if (err == ESP_OK && http_status == 304 && job->last_modified[0] != '\0') {
+        // Nothing changed since the last 200: keep the epochs parsed then.
+        s_fetch_stats.not_modified++;
+        s_fetch_stats.bytes_saved += job->body_bytes;
+        ESP_LOGI(TAG, "304 Not Modified (%u/%u polls, ~%u bytes saved)",
+                 (unsigned)s_fetch_stats.not_modified, (unsigned)s_fetch_stats.polls,
+                 (unsigned)s_fetch_stats.bytes_saved);
+        return true;
     }
 
-    // NOTE: Don't use esp_http_client_perform() here, because it can consume the
-    // response internally unless you provide an event handler. We want to read
-    // the body into our own buffer.
-    esp_err_t err = esp_http_client_open(client, 0);
-    if (err != ESP_OK) {
-        esp_http_client_cleanup(client);
-        return err;
+    // Any failure invalidates the validator so the next poll is unconditional.
+    job->last_modified[0] = '\0';
+
+    if (err == ESP_ERR_INVALID_RESPONSE || (err == ESP_OK && http_status >= 200 && http_status < 300 && !json_stream_finish(&parser.js))) {
+        ESP_LOGW(TAG, "JSON parse failed (offset=%u)", (unsigned)json_stream_offset(&parser.js));
+        return false;
+    }
+    if (err != ESP_OK || http_status < 200 || http_status >= 300) {
+        ESP_LOGW(TAG, "HTTP GET failed (%s), status=%d", esp_err_to_name(err), http_status);
+        return false;
+    }
+    if (!parser.saw_data) {
+        return false;
     }
 
-    int64_t content_len = esp_http_client_fetch_headers(client);
+    prediction_resolve_details(&parser);
+    ESP_LOGD(TAG, "included: %u seen, %d indexed, %u dropped", (unsigned)parser.included.seen,
+             parser.included.used, (unsigned)parser.included.dropped);
 
-    int status = esp_http_client_get_status_code(client);
-    if (out_http_status) {
-        *out_http_status = status;
+    strlcpy(job->last_modified, parser.last_modified, sizeof(job->last_modified));
+    job->body_bytes = parser.body_bytes;
+    memcpy(out_lists, parser.lists, (size_t)filter_count * sizeof(mbta_epoch_list_t));
+    return true;
+}
+
+#if MBTA_USE_STREAMING
+static void mbta_on_stream_changed(uint32_t event_us, void *ctx)
+{
+    (void)ctx;
+    if (s_stream_event_us == 0) {
+        s_stream_event_us = event_us ? event_us : 1;
+    }
+    if (s_mbta_task != NULL) {
+        xTaskNotifyGive(s_mbta_task);
     }
+}
 
-    ESP_LOGI(TAG, "HTTP status=%d content_len=%lld", status, (long long)content_len);
+static void mbta_stream_note_publish(void)
+{
+    uint32_t event_us = s_stream_event_us;
+    if (event_us == 0) {
+        return;
+    }
+    s_stream_event_us = 0;
 
-    int total = 0;
-    while (total < (int)buf_size - 1) {
-        int r = esp_http_client_read(client, buf + total, (int)buf_size - 1 - total);
-        if (r < 0) {
-            esp_http_client_close(client);
-            esp_http_client_cleanup(client);
-            return ESP_FAIL;
-        }
-        if (r == 0) {
-            break;
-        }
-        total += r;
+    uint32_t latency_us = (uint32_t)esp_timer_get_time() - event_us;
+    s_stream_stats.publishes++;
+    s_stream_stats.last_latency_us = latency_us;
+    if (latency_us > s_stream_stats.max_latency_us) {
+        s_stream_stats.max_latency_us = latency_us;
     }
-    buf[total] = '\0';
+    ESP_LOGI(TAG, "stream event -> publish %uus (max %uus, %u publishes)", (unsigned)latency_us,
+             (unsigned)s_stream_stats.max_latency_us, (unsigned)s_stream_stats.publishes);
+}
+#endif
 
-    // Detect truncation: if we filled the buffer, try reading 1 more byte.
-    if (total == (int)buf_size - 1) {
-        char extra;
-        int more = esp_http_client_read(client, &extra, 1);
-        if (more > 0) {
-            ESP_LOGW(TAG, "HTTP body truncated (buf=%u)", (unsigned)buf_size);
-        }
+// Append filter[stop] for every configured stop to the `len` bytes of
+// `url`. Routes narrow it down only when every stop names one; a stop on
+// "any route" needs all of its routes. Responses can still hold other
+// stop/route pairs, so matching is left to the parser.
+static size_t mbta_url_add_stops(char *url, size_t size, size_t len)
+{
+    if (len < size) {
+        len += (size_t)snprintf(url + len, size - len, "filter[stop]=");
+    }
+    for (int i = 0; i < MBTA_STOP_COUNT && len < size; i++) {
+        len += (size_t)snprintf(url + len, size - len, "%s%s", i > 0 ? "," : "", s_stops[i].stop_id);
     }
 
-    esp_http_client_close(client);
-    esp_http_client_cleanup(client);
-    return ESP_OK;
+    bool all_routes = true;
+    for (int i = 0; i < MBTA_STOP_COUNT; i++) {
+        all_routes = all_routes && s_stops[i].route_id != NULL && s_stops[i].route_id[0] != '\0';
+    }
+    for (int i = 0; all_routes && i < MBTA_STOP_COUNT && len < size; i++) {
+        len += (size_t)snprintf(url + len, size - len, "%s%s", i > 0 ? "," : "&filter[route]=", s_stops[i].route_id);
+    }
+    return len;
 }
 
-static int cmp_time_t(const void *a, const void *b)
+#if MBTA_USE_STREAMING
+static mbta_stream_slot_t s_stream_slots[MBTA_MAX_STOPS];
+#endif
+
+// Build every job's request URL from the stop table (once, at start).
+static void mbta_jobs_init(void)
 {
-    const time_t *ta = (const time_t *)a;
-    const time_t *tb = (const time_t *)b;
-    if (*ta < *tb) return -1;
-    if (*ta > *tb) return 1;
-    return 0;
+#if MBTA_USE_STREAMING
+    // All stops on one stream, split per stop while parsing. Streams carry
+    // no `included` resources.
+    char *url = s_jobs[0].url;
+    size_t len = mbta_url_add_stops(url, MBTA_URL_MAX, strlcpy(url, MBTA_API_BASE, MBTA_URL_MAX));
+    if (len >= MBTA_URL_MAX) {
+        ESP_LOGE(TAG, "stream URL too long, stops dropped");
+    }
+    for (int i = 0; i < MBTA_STOP_COUNT; i++) {
+        s_stream_slots[i].stop_id = s_stops[i].stop_id;
+        s_stream_slots[i].route_id = s_stops[i].route_id;
+    }
+#elif MBTA_USE_COMBINED_FETCH
+    // All stops in one request; route filters are applied while parsing.
+    char *url = s_jobs[0].url;
+    size_t len = mbta_url_add_stops(url, MBTA_URL_MAX, strlcpy(url, MBTA_API_BASE, MBTA_URL_MAX));
+    if (len < MBTA_URL_MAX) {
+        len += (size_t)snprintf(url + len, MBTA_URL_MAX - len, "&include=trip,vehicle&page[limit]=%d",
+                                20 * MBTA_STOP_COUNT);
+    }
+    if (len >= MBTA_URL_MAX) {
+        ESP_LOGE(TAG, "combined URL too long, stops dropped");
+    }
+#else
+    for (int i = 0; i < MBTA_STOP_COUNT; i++) {
+        const mbta_stop_cfg_t *stop = &s_stops[i];
+        bool has_route = stop->route_id != NULL && stop->route_id[0] != '\0';
+        int len = snprintf(s_jobs[i].url, MBTA_URL_MAX, MBTA_API_BASE "filter[stop]=%s%s%s&include=trip,vehicle&page[limit]=10",
+                           stop->stop_id, has_route ? "&filter[route]=" : "", has_route ? stop->route_id : "");
+        if (len >= MBTA_URL_MAX) {
+            ESP_LOGE(TAG, "URL for stop %d too long", i);
+        }
+    }
+#endif
 }
 
-static bool parse_prediction_epochs(const char *json, time_t *out_epochs, int max_epochs, int *out_count)
+#if MBTA_USE_ALERTS
+// Alerts at any configured stop.
+static void mbta_alerts_url(char *url, size_t size)
 {
-    if (out_count) {
-        *out_count = 0;
+    size_t len = mbta_url_add_stops(url, size, strlcpy(url, "https://api-v3.mbta.com/alerts?", size));
+
+    // Only alerts in effect now, and only the fields the banner needs.
+    if (len < size) {
+        len += (size_t)snprintf(url + len, size - len,
+                                "&filter[datetime]=NOW&fields[alert]=short_header,severity,updated_at");
     }
-    if (json == NULL || out_epochs == NULL || max_epochs <= 0) {
-        return false;
+    if (len >= size) {
+        ESP_LOGE(TAG, "alerts URL too long");
     }
+}
+#endif
 
-    cJSON *root = cJSON_Parse(json);
-    if (root == NULL) {
-        int len = (json != NULL) ? (int)strlen(json) : 0;
-        ESP_LOGW(TAG, "JSON parse failed (len=%d)", len);
-        if (json != NULL && len > 0) {
-            char preview[257];
-            int n = len < 256 ? len : 256;
-            memcpy(preview, json, (size_t)n);
-            preview[n] = '\0';
-            // Avoid multi-line log spam.
-            for (int i = 0; i < n; i++) {
-                if (preview[i] == '\n' || preview[i] == '\r') {
-                    preview[i] = ' ';
+// Identifies the stop table: cached data only applies to the one it was
+// built for.
+static uint32_t mbta_stops_hash(void)
+{
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < MBTA_STOP_COUNT; i++) {
+        const char *fields[2] = {s_stops[i].stop_id, s_stops[i].route_id ? s_stops[i].route_id : ""};
+        for (int f = 0; f < 2; f++) {
+            for (const char *c = fields[f];; c++) {
+                h ^= (uint8_t)*c;
+                h *= 16777619u;
+                if (*c == '\0') {
+                    break;
                 }
             }
-            ESP_LOGW(TAG, "JSON preview: %s", preview);
         }
-        return false;
     }
+    return h;
+}
 
-    cJSON *data = cJSON_GetObjectItemCaseSensitive(root, "data");
-    if (!cJSON_IsArray(data)) {
-        cJSON_Delete(root);
-        return false;
+#if MBTA_USE_SCHEDULE_CACHE
+// Local midnight of the service date `now` falls in; `date` (optional)
+// receives it as YYYY-MM-DD.
+static time_t mbta_service_day_start(time_t now, char *date, size_t date_size)
+{
+    time_t shifted = now - MBTA_SERVICE_DAY_START_HOUR * 3600;
+    struct tm tm;
+    localtime_r(&shifted, &tm);
+    if (date != NULL) {
+        strftime(date, date_size, "%Y-%m-%d", &tm);
     }
+    tm.tm_hour = 0;
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    return mktime(&tm);
+}
 
-    int count = 0;
-    time_t now = time(NULL);
+typedef struct {
+    json_stream_t js;
+    char tok[48];
+    mbta_schedule_builder_t *builder;
+    int stop;
+    time_t day_start;
 
-    cJSON *item = NULL;
-    cJSON_ArrayForEach(item, data) {
-        if (count >= max_epochs) {
-            break;
-        }
+    // Schedule currently being parsed.
+    time_t item_arrival;
+    time_t item_departure;
+    int item_direction;
+    char item_route[16];
 
-        cJSON *attributes = cJSON_GetObjectItemCaseSensitive(item, "attributes");
-        if (!cJSON_IsObject(attributes)) {
-            continue;
-        }
+    bool saw_data;
+    bool overflow;
+} schedule_parser_t;
 
-        const cJSON *arrival = cJSON_GetObjectItemCaseSensitive(attributes, "arrival_time");
-        const cJSON *departure = cJSON_GetObjectItemCaseSensitive(attributes, "departure_time");
+static bool schedule_on_json(json_stream_t *js, json_stream_event_t ev, const char *value, size_t len, void *ctx)
+{
+    (void)len;
+    schedule_parser_t *p = (schedule_parser_t *)ctx;
+    int depth = json_stream_depth(js);
 
-        const char *tstr = NULL;
-        if (cJSON_IsString(arrival) && arrival->valuestring) {
-            tstr = arrival->valuestring;
-        } else if (cJSON_IsString(departure) && departure->valuestring) {
-            tstr = departure->valuestring;
-        }
+    if (depth < 1 || strcmp(json_stream_key(js, 0), "data") != 0) {
+        return true;
+    }
 
-        if (tstr == NULL) {
-            continue;
+    if (depth == 1) {
+        if (ev == JSON_STREAM_ARRAY_BEGIN) {
+            p->saw_data = true;
         }
+        return true;
+    }
 
-        time_t epoch = 0;
-        if (!iso8601_to_epoch_utc(tstr, &epoch)) {
-            continue;
+    // data[i] (the scheduled stop of one trip)
+    if (depth == 2) {
+        if (ev == JSON_STREAM_OBJECT_BEGIN) {
+            p->item_arrival = 0;
+            p->item_departure = 0;
+            p->item_direction = 0;
+            p->item_route[0] = '\0';
+        } else if (ev == JSON_STREAM_OBJECT_END) {
+            // The last stop of a trip only has an arrival time.
+            time_t epoch = p->item_departure ? p->item_departure : p->item_arrival;
+            long minute = (long)(epoch - p->day_start) / 60;
+            if (epoch != 0 && minute >= 0 && minute <= UINT16_MAX &&
+                !mbta_schedule_builder_add(p->builder, p->stop, p->item_route, p->item_direction, (uint16_t)minute)) {
+                p->overflow = true;
+            }
         }
+        return true;
+    }
 
-        // Filter out stale predictions.
-        if (epoch < now - 30) {
-            continue;
+    // data[i].relationships.route.data.id
+    if (depth == 6 && ev == JSON_STREAM_STRING && strcmp(json_stream_key(js, 2), "relationships") == 0 &&
+        strcmp(json_stream_key(js, 3), "route") == 0 && strcmp(json_stream_key(js, 5), "id") == 0) {
+        strlcpy(p->item_route, value, sizeof(p->item_route));
+        return true;
+    }
+
+    if (depth == 4 && strcmp(json_stream_key(js, 2), "attributes") == 0) {
+        const char *key = json_stream_key(js, 3);
+        if (ev == JSON_STREAM_NUMBER && strcmp(key, "direction_id") == 0) {
+            p->item_direction = (int)strtol(value, NULL, 10);
+        } else if (ev == JSON_STREAM_STRING && strcmp(key, "departure_time") == 0) {
+            iso8601_to_epoch_utc(value, &p->item_departure);
+        } else if (ev == JSON_STREAM_STRING && strcmp(key, "arrival_time") == 0) {
+            iso8601_to_epoch_utc(value, &p->item_arrival);
         }
+    }
+    return true;
+}
 
-        out_epochs[count++] = epoch;
+static bool schedule_on_body(const char *data, size_t len, void *ctx)
+{
+    schedule_parser_t *p = (schedule_parser_t *)ctx;
+    return json_stream_feed(&p->js, data, len);
+}
+
+// Every scheduled departure of `stop` on `date` into the builder.
+static bool fetch_schedule(int stop, const char *date, time_t day_start, mbta_schedule_builder_t *builder)
+{
+    const mbta_stop_cfg_t *cfg = &s_stops[stop];
+    bool has_route = cfg->route_id != NULL && cfg->route_id[0] != '\0';
+    char url[320];
+    int len = snprintf(url, sizeof(url),
+                       "https://api-v3.mbta.com/schedules?filter[stop]=%s%s%s&filter[date]=%s"
+                       "&fields[schedule]=arrival_time,departure_time,direction_id",
+                       cfg->stop_id, has_route ? "&filter[route]=" : "", has_route ? cfg->route_id : "", date);
+    if (len >= (int)sizeof(url)) {
+        return false;
+    }
+
+    static schedule_parser_t parser;
+    memset(&parser, 0, sizeof(parser));
+    parser.builder = builder;
+    parser.stop = stop;
+    parser.day_start = day_start;
+    json_stream_init(&parser.js, parser.tok, sizeof(parser.tok), schedule_on_json, &parser);
+
+    http_conn_request_t req = {
+        .url = url,
+        .timeout_ms = MBTA_HTTP_TIMEOUT_MS,
+        .on_body = schedule_on_body,
+        .ctx = &parser,
+    };
+
+    int http_status = 0;
+    esp_err_t err = NetService_Get(&req, NET_PRIO_NORMAL, 0, &http_status);
+    if (err != ESP_OK || http_status != 200 || !json_stream_finish(&parser.js) || !parser.saw_data) {
+        ESP_LOGW(TAG, "schedule for stop %d failed (%s), status=%d", stop, esp_err_to_name(err), http_status);
+        return false;
     }
+    if (parser.overflow) {
+        ESP_LOGW(TAG, "schedule for stop %d truncated", stop);
+    }
+    return true;
+}
 
-    cJSON_Delete(root);
+// Prefetch today's schedule unless the cached one is already today's.
+static void mbta_schedule_refresh(void)
+{
+    char date[16];
+    time_t day_start = mbta_service_day_start(time(NULL), date, sizeof(date));
+    if (s_schedule != NULL && ((const mbta_schedule_header_t *)s_schedule)->day_start == day_start) {
+        return;
+    }
+    int64_t now_us = esp_timer_get_time();
+    if (now_us < s_schedule_retry_us || now_us < s_ratelimit_hold_us) {
+        return;
+    }
+    s_schedule_retry_us = now_us + (int64_t)MBTA_SCHEDULE_RETRY_MS * 1000;
+
+    // Once a day: borrow the heap rather than keep ~16KB around.
+    mbta_schedule_builder_t *builder = malloc(sizeof(*builder));
+    uint8_t *image = malloc(MBTA_SCHEDULE_IMAGE_MAX);
+    if (builder == NULL || image == NULL) {
+        ESP_LOGW(TAG, "no memory for the schedule");
+        goto out;
+    }
+    mbta_schedule_builder_init(builder);
 
-    if (count == 0) {
-        if (out_count) {
-            *out_count = 0;
+    for (int i = 0; i < MBTA_STOP_COUNT; i++) {
+        if (!fetch_schedule(i, date, day_start, builder)) {
+            goto out;
         }
-        return true;
     }
 
-    qsort(out_epochs, (size_t)count, sizeof(time_t), cmp_time_t);
-    if (out_count) {
-        *out_count = count;
+    size_t size = mbta_schedule_encode(builder, day_start, mbta_stops_hash(), image, MBTA_SCHEDULE_IMAGE_MAX);
+    if (size == 0) {
+        ESP_LOGW(TAG, "schedule for %s does not fit", date);
+        goto out;
     }
-    return true;
+    s_schedule = mbta_schedule_store(image, size);
+    if (s_schedule != NULL) {
+        const mbta_schedule_header_t *hdr = (const mbta_schedule_header_t *)s_schedule;
+        ESP_LOGI(TAG, "schedule for %s: %u departures, %u series, %u bytes", date, (unsigned)hdr->departures,
+                 (unsigned)hdr->series_count, (unsigned)hdr->size);
+    }
+
+out:
+    free(image);
+    free(builder);
 }
 
-static bool fetch_arrivals_minutes(const char *url, int *out_minutes, int max_minutes, int *out_count)
+// Next scheduled departures at `stop`, if today's schedule is cached.
+static int schedule_upcoming(int stop, time_t now, time_t *out_epochs, int max_epochs)
 {
-    if (out_count) {
-        *out_count = 0;
+    if (s_schedule == NULL) {
+        return 0;
     }
-    if (url == NULL || out_minutes == NULL || max_minutes <= 0) {
-        return false;
+    time_t day_start = (time_t)((const mbta_schedule_header_t *)s_schedule)->day_start;
+    if (mbta_service_day_start(now, NULL, 0) != day_start) {
+        return 0;
     }
 
-    // MBTA can return fairly large JSON; keep this generous but bounded.
-    char *buf = (char *)calloc(1, 16384);
-    if (buf == NULL) {
-        return false;
+    uint16_t mins[3];
+    long from = (long)(now - day_start) / 60;
+    if (max_epochs > 3 || from > UINT16_MAX) {
+        return 0;
+    }
+    int n = mbta_schedule_departures(s_schedule, stop, (uint16_t)from, mins, max_epochs);
+    for (int i = 0; i < n; i++) {
+        out_epochs[i] = day_start + (time_t)mins[i] * 60;
+    }
+    return n;
+}
+#endif
+
+// Fill the per-stop slots of `next` and pick the stop to show: the first
+// one in table order with upcoming arrivals. As with the old bus -> T
+// fallback, an empty stop hands over to the next one but a failed one does
+// not (it is shown as "no data", or with its scheduled times if cached).
+// Scheduled times of an empty stop are only shown when no stop has
+// predictions.
+static void mbta_state_fill_stops(mbta_state_t *next)
+{
+    time_t now = time(NULL);
+    int shown = -1;
+
+    next->stop_count = MBTA_STOP_COUNT;
+    for (int i = 0; i < MBTA_STOP_COUNT; i++) {
+        mbta_stop_state_t *stop = &next->stops[i];
+        stop->has_data = s_stop_ok[i];
+        if (s_stop_ok[i]) {
+            stop->arrival_count = upcoming_arrivals(&s_stop_lists[i], now, stop->arrivals_epoch,
+                                                    stop->arrival_details, 3);
+            stop->fetched_at = s_stop_fetched_at[i];
+            stop->stale = s_stop_stale[i] && stop->arrival_count > 0;
+        }
+#if MBTA_USE_SCHEDULE_CACHE
+        if (stop->arrival_count == 0) {
+            stop->arrival_count = schedule_upcoming(i, now, stop->arrivals_epoch, 3);
+            if (stop->arrival_count > 0) {
+                stop->has_data = true;
+                stop->scheduled = true;
+                for (int k = 0; k < stop->arrival_count; k++) {
+                    memset(&stop->arrival_details[k], 0, sizeof(stop->arrival_details[k]));
+                    stop->arrival_details[k].stops_away = -1;
+                }
+            }
+        }
+#endif
+        stop->refresh_ms = s_stop_refresh_ms[i];
+        if (shown < 0 && (!stop->has_data || (stop->arrival_count > 0 && (!stop->scheduled || !s_stop_ok[i])))) {
+            shown = i;
+        }
+    }
+    for (int i = 0; shown < 0 && i < MBTA_STOP_COUNT; i++) {
+        if (next->stops[i].arrival_count > 0) {
+            shown = i;
+        }
+    }
+    if (shown < 0) {
+        shown = MBTA_STOP_COUNT - 1;
     }
 
-    int http_status = 0;
-    esp_err_t err = http_get_to_buffer(url, buf, 16384, &http_status);
-    if (err != ESP_OK || http_status < 200 || http_status >= 300) {
-        ESP_LOGW(TAG, "HTTP GET failed (%s), status=%d", esp_err_to_name(err), http_status);
-        free(buf);
+    const mbta_stop_state_t *stop = &next->stops[shown];
+    next->shown_stop = shown;
+    next->mode = (shown == 0) ? MBTA_MODE_BUS : MBTA_MODE_T;
+    next->no_bus_service_banner = shown != 0;
+    next->has_data = stop->has_data;
+    next->arrival_count = stop->arrival_count;
+    next->scheduled = stop->scheduled;
+    next->stale = stop->stale;
+    memcpy(next->arrivals_epoch, stop->arrivals_epoch, sizeof(next->arrivals_epoch));
+    memcpy(next->arrival_details, stop->arrival_details, sizeof(next->arrival_details));
+    next->fetched_at = stop->fetched_at;
+    next->refresh_ms = stop->refresh_ms;
+    strlcpy(next->title, s_stops[shown].name, sizeof(next->title));
+
+    ESP_LOGI(TAG, "showing stop %d ok=%d cnt=%d%s", shown, (int)stop->has_data, stop->arrival_count,
+             stop->scheduled ? " (scheduled)" : "");
+    s_shown_stop = shown;
+}
+
+static void mbta_stop_mark(int stop, bool ok)
+{
+    // Restored arrivals stay up (marked stale) until a fetch succeeds.
+    s_stop_ok[stop] = ok || s_stop_stale[stop];
+    if (ok) {
+        s_stop_fetched_at[stop] = time(NULL);
+        s_stop_stale[stop] = false;
+    }
+}
+
+// Persisted predictions: the first few epochs of every stop (of the first
+// 8 with a bigger MBTA_MAX_STOPS; the rest start empty).
+#define MBTA_SNAPSHOT_STOPS (MBTA_MAX_STOPS < 8 ? MBTA_MAX_STOPS : 8)
+
+typedef struct {
+    uint32_t stops_hash;
+    struct {
+        int64_t fetched_at;
+        int64_t epochs[3];
+        uint8_t ok;
+        uint8_t count;
+    } stops[MBTA_SNAPSHOT_STOPS];
+} mbta_snapshot_t;
+_Static_assert(sizeof(mbta_snapshot_t) <= SNAPSHOT_MAX_SIZE, "mbta snapshot too big");
+
+static void mbta_snapshot_save(void)
+{
+    mbta_snapshot_t snap = {0};
+    snap.stops_hash = mbta_stops_hash();
+    for (int i = 0; i < MBTA_STOP_COUNT && i < MBTA_SNAPSHOT_STOPS; i++) {
+        const mbta_epoch_list_t *list = &s_stop_lists[i];
+        snap.stops[i].ok = s_stop_ok[i] && !s_stop_stale[i];
+        snap.stops[i].fetched_at = s_stop_fetched_at[i];
+        snap.stops[i].count = (uint8_t)(list->count < 3 ? list->count : 3);
+        for (int k = 0; k < snap.stops[i].count; k++) {
+            snap.stops[i].epochs[k] = list->epochs[k];
+        }
+    }
+    Snapshot_Save(SNAPSHOT_MBTA, &snap, sizeof(snap));
+}
+
+// Last-known predictions from before the reset, shown as stale until the
+// first fetch. Returns true if any were restored.
+static bool mbta_snapshot_restore(void)
+{
+    mbta_snapshot_t snap;
+    if (!Snapshot_Load(SNAPSHOT_MBTA, &snap, sizeof(snap)) || snap.stops_hash != mbta_stops_hash()) {
         return false;
     }
+    bool any = false;
+    for (int i = 0; i < MBTA_STOP_COUNT && i < MBTA_SNAPSHOT_STOPS; i++) {
+        if (!snap.stops[i].ok) {
+            continue;
+        }
+        mbta_epoch_list_t *list = &s_stop_lists[i];
+        memset(list, 0, sizeof(*list));
+        list->count = snap.stops[i].count;
+        for (int k = 0; k < list->count; k++) {
+            list->epochs[k] = (time_t)snap.stops[i].epochs[k];
+            list->details[k].stops_away = -1;
+        }
+        s_stop_ok[i] = true;
+        s_stop_stale[i] = true;
+        s_stop_fetched_at[i] = (time_t)snap.stops[i].fetched_at;
+        any = true;
+    }
+    return any;
+}
 
-    ESP_LOGI(TAG, "HTTP %d len=%d", http_status, (int)strlen(buf));
+#if MBTA_USE_STREAMING
+// Returns true if any stop is live.
+static bool mbta_stream_refresh(void)
+{
+    bool any_live = false;
+    for (int i = 0; i < MBTA_STOP_COUNT; i++) {
+        // Streams carry no `included` resources, so no details.
+        mbta_epoch_list_t fresh = {0};
+        for (int k = 0; k < MBTA_MAX_EPOCHS; k++) {
+            fresh.details[k].stops_away = -1;
+        }
+        bool live = MBTA_StreamGetEpochs(i, fresh.epochs, MBTA_MAX_EPOCHS, &fresh.count);
+        // Restored arrivals stay until the stream is live.
+        if (live || !s_stop_stale[i]) {
+            s_stop_lists[i] = fresh;
+        }
+        mbta_stop_mark(i, live);
+        any_live |= live;
+    }
+    return any_live;
+}
+#else
+static struct {
+    uint32_t cycles;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} s_cycle_stats;
+
+static void mbta_note_cycle(int64_t start_us, uint32_t start_polls)
+{
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start_us);
+    s_cycle_stats.cycles++;
+    s_cycle_stats.last_us = us;
+    s_cycle_stats.total_us += us;
+    if (us > s_cycle_stats.max_us) {
+        s_cycle_stats.max_us = us;
+    }
+    ESP_LOGI(TAG, "refresh %ums in %u request(s) (avg %ums, max %ums)", (unsigned)(us / 1000),
+             (unsigned)(s_fetch_stats.polls - start_polls),
+             (unsigned)(s_cycle_stats.total_us / s_cycle_stats.cycles / 1000),
+             (unsigned)(s_cycle_stats.max_us / 1000));
+}
 
-    time_t epochs[8] = {0};
-    int epoch_count = 0;
-    bool ok = parse_prediction_epochs(buf, epochs, (int)(sizeof(epochs) / sizeof(epochs[0])), &epoch_count);
-    free(buf);
+static bool mbta_job_covers(int job, int stop)
+{
+    return MBTA_USE_COMBINED_FETCH || job == stop;
+}
 
+static bool mbta_run_job(int job)
+{
+    int64_t start_us = esp_timer_get_time();
+    uint32_t start_polls = s_fetch_stats.polls;
+#if MBTA_USE_COMBINED_FETCH
+    // All stops in one round-trip, split per stop while parsing.
+    (void)job;
+    bool ok = fetch_predictions(&s_jobs[0], s_stops, MBTA_STOP_COUNT, s_stop_lists);
+    for (int i = 0; i < MBTA_STOP_COUNT; i++) {
+        mbta_stop_mark(i, ok);
+    }
+#else
+    bool ok = fetch_predictions(&s_jobs[job], &s_match_all, 1, &s_stop_lists[job]);
+    mbta_stop_mark(job, ok);
+#endif
+    mbta_note_cycle(start_us, start_polls);
+    return ok;
+}
+
+// +/-25%, so jobs (and displays) that failed together do not retry in step.
+static uint32_t mbta_jitter_ms(uint32_t ms)
+{
+    return ms - ms / 4 + esp_random() % (ms / 2 + 1);
+}
+
+// Interval until `job` runs again. Failures back off exponentially;
+// otherwise it follows the earliest upcoming arrival at the job's stops.
+static uint32_t mbta_job_interval_ms(int job, bool ok)
+{
     if (!ok) {
-        return false;
+        uint32_t ms = MBTA_RETRY_MIN_MS;
+        for (int i = 0; i < s_job_failures[job] && ms < MBTA_RETRY_MAX_MS; i++) {
+            ms *= 2;
+        }
+        if (ms > MBTA_RETRY_MAX_MS) {
+            ms = MBTA_RETRY_MAX_MS;
+        }
+        if (s_job_failures[job] < UINT8_MAX) {
+            s_job_failures[job]++;
+        }
+        return mbta_jitter_ms(ms);
     }
+    s_job_failures[job] = 0;
 
     time_t now = time(NULL);
-    int n = 0;
-    for (int i = 0; i < epoch_count && n < max_minutes; i++) {
-        long delta = (long)(epochs[i] - now);
-        int mins = (int)((delta + 59) / 60);
-        if (mins < 0) {
-            continue;
+    time_t head = 0;
+    for (int i = 0; i < MBTA_STOP_COUNT; i++) {
+        time_t first;
+        if (mbta_job_covers(job, i) &&
+            upcoming_arrivals(&s_stop_lists[i], now, &first, NULL, 1) == 1 &&
+            (head == 0 || first < head)) {
+            head = first;
         }
-        out_minutes[n++] = mins;
+    }
+    if (head == 0) {
+        // No service right now: nothing to count down.
+        return MBTA_POLL_MAX_MS;
     }
 
-    if (out_count) {
-        *out_count = n;
+    int64_t ms = (head > now) ? (int64_t)(head - now) * 1000 / MBTA_POLL_ARRIVAL_DIVISOR : 0;
+    if (ms < MBTA_POLL_MIN_MS) {
+        ms = MBTA_POLL_MIN_MS;
+    } else if (ms > MBTA_POLL_MAX_MS) {
+        ms = MBTA_POLL_MAX_MS;
+    }
+    return (uint32_t)ms;
+}
+
+// Spread the jobs evenly over one poll period, starting now, so requests
+// never burst however many stops are configured.
+static void mbta_schedule_spread(int64_t *due_us, int64_t now_us)
+{
+    for (int j = 0; j < MBTA_JOB_COUNT; j++) {
+        due_us[j] = now_us + (int64_t)j * MBTA_POLL_PERIOD_MS * 1000 / MBTA_JOB_COUNT;
     }
-    return true;
 }
 
+static int mbta_schedule_next(const int64_t *due_us)
+{
+    int next = 0;
+    for (int j = 1; j < MBTA_JOB_COUNT; j++) {
+        if (due_us[j] < due_us[next]) {
+            next = j;
+        }
+    }
+    return next;
+}
+#endif
+
 static void mbta_task(void *arg)
 {
     (void)arg;
 
-    ESP_LOGI(TAG, "MBTA task started");
+    ESP_LOGI(TAG, "MBTA task started (%d stops, %d fetch jobs)", MBTA_STOP_COUNT, MBTA_JOB_COUNT);
+
+#if !MBTA_USE_STREAMING
+    int64_t due_us[MBTA_JOB_COUNT] = {0};
+    bool scheduled = false;
+    int last_job = -1;
+    int64_t spaced_us = 0; // earliest start for a job other than last_job
+#endif
 
     while (1) {
+        // Set once predictions were fetched this round.
+        bool fetched = false;
         mbta_state_t next = {0};
         next.has_data = false;
         next.mode = MBTA_MODE_BUS;
         next.no_bus_service_banner = false;
         next.arrival_count = 0;
-        memset(next.arrivals_min, 0, sizeof(next.arrivals_min));
-        strlcpy(next.title, MBTA_BUS_TITLE, sizeof(next.title));
+        memset(next.arrivals_epoch, 0, sizeof(next.arrivals_epoch));
+        strlcpy(next.title, s_stops[0].name, sizeof(next.title));
 
         wireless_status_t wifi = Wireless_GetStatus();
         ESP_LOGD(TAG, "poll wifi=%d", (int)wifi);
@@ -447,55 +1291,60 @@ static void mbta_task(void *arg)
         bool in_hours = (timeinfo.tm_hour >= MBTA_SHOW_START_HOUR && timeinfo.tm_hour < MBTA_SHOW_END_HOUR);
 
         // Always allow fetching if time isn't synced yet, otherwise respect hours.
-        if (wifi == WIRELESS_STATUS_CONNECTED && (in_hours || !time_is_synced)) {
+        bool active = wifi == WIRELESS_STATUS_CONNECTED && (in_hours || !time_is_synced);
+        if (active) {
             next.display_off = false;
-            // Set fetching status to true before starting
-            mbta_state_t current;
-            if (MBTA_GetState(&current)) {
-                current.is_fetching = true;
-                mbta_state_set(&current);
+#if MBTA_USE_STREAMING
+            // TLS validation needs a sane RTC; returns at once when synced.
+            TimeSync_Wait(MBTA_TIME_WAIT_MS);
+            MBTA_StreamSetEnabled(true);
+            fetched = mbta_stream_refresh();
+            mbta_snapshot_save();
+#else
+            // TLS validation needs a sane RTC; returns at once when synced.
+            TimeSync_Wait(MBTA_TIME_WAIT_MS);
+
+            int64_t now_us = esp_timer_get_time();
+            if (!scheduled) {
+                mbta_schedule_spread(due_us, now_us);
+                scheduled = true;
             }
-
-            // Ensure RTC is sane for TLS validation (no-op once synced).
-            mbta_time_sync_sntp();
-
-            int mins[3] = {0};
-            int cnt = 0;
-
-            bool bus_ok = fetch_arrivals_minutes(MBTA_BUS_URL, mins, 3, &cnt);
-            ESP_LOGI(TAG, "bus_ok=%d cnt=%d", (int)bus_ok, cnt);
-            if (bus_ok && cnt > 0) {
-                next.mode = MBTA_MODE_BUS;
-                next.no_bus_service_banner = false;
-                next.has_data = true;
-                next.arrival_count = cnt;
-                memcpy(next.arrivals_min, mins, (size_t)cnt * sizeof(int));
-                strlcpy(next.title, MBTA_BUS_TITLE, sizeof(next.title));
-            } else if (bus_ok && cnt == 0) {
-                // Bus query succeeded but predictions list is empty (data[] == []) => try T
-                int tmins[3] = {0};
-                int tcnt = 0;
-                bool t_ok = fetch_arrivals_minutes(MBTA_T_URL, tmins, 3, &tcnt);
-
-                ESP_LOGI(TAG, "t_ok=%d tcnt=%d", (int)t_ok, tcnt);
-
-                next.mode = MBTA_MODE_T;
-                next.no_bus_service_banner = true;
-                next.has_data = t_ok;
-                next.arrival_count = t_ok ? tcnt : 0;
-                if (t_ok && tcnt > 0) {
-                    memcpy(next.arrivals_min, tmins, (size_t)tcnt * sizeof(int));
+            int job = mbta_schedule_next(due_us);
+            if (due_us[job] <= now_us && (job == last_job || spaced_us <= now_us)) {
+                // The loader only tracks the stop on screen.
+                if (mbta_job_covers(job, s_shown_stop)) {
+                    mbta_state_set_fetching(true);
+                }
+                last_job = job;
+                spaced_us = now_us + (int64_t)MBTA_JOB_SPACING_MS * 1000;
+                bool ok = mbta_run_job(job);
+                if (ok) {
+                    mbta_snapshot_save();
+                    fetched = true;
+                }
+                uint32_t interval_ms = mbta_job_interval_ms(job, ok);
+                due_us[job] = esp_timer_get_time() + (int64_t)interval_ms * 1000;
+                for (int i = 0; i < MBTA_STOP_COUNT; i++) {
+                    if (mbta_job_covers(job, i)) {
+                        s_stop_refresh_ms[i] = interval_ms;
+                    }
+                }
+                ESP_LOGI(TAG, "job %d %s, next in %us", job, ok ? "ok" : "failed", (unsigned)(interval_ms / 1000));
+            }
+            // Nothing runs until the rate-limit window resets.
+            for (int j = 0; j < MBTA_JOB_COUNT; j++) {
+                if (due_us[j] < s_ratelimit_hold_us) {
+                    due_us[j] = s_ratelimit_hold_us;
                 }
-                strlcpy(next.title, MBTA_T_TITLE, sizeof(next.title));
-            } else {
-                // Bus query failed (HTTP/TLS/parse). Do NOT fall back to T.
-                next.mode = MBTA_MODE_BUS;
-                next.no_bus_service_banner = false;
-                next.has_data = false;
-                next.arrival_count = 0;
-                strlcpy(next.title, MBTA_BUS_TITLE, sizeof(next.title));
             }
+#endif
+            mbta_state_fill_stops(&next);
+#if MBTA_USE_STREAMING
+            // The loader runs while the stream connects or waits for its reset.
+            next.is_fetching = !fetched;
+#else
             next.is_fetching = false;
+#endif
         } else if (wifi == WIRELESS_STATUS_CONNECTED && !in_hours) {
             // Outside hours: explicitly set no data and a sleeping title
             next.display_off = true;
@@ -504,33 +1353,106 @@ static void mbta_task(void *arg)
         } else {
             // No wifi or other state
             next.display_off = !in_hours;
+            // Offline: what is left of the predictions (or the ones restored
+            // at boot), then the schedule.
+            if (in_hours && time_is_synced) {
+                mbta_state_fill_stops(&next);
+            }
         }
 
+#if MBTA_USE_STREAMING
+        // Keep the connections closed outside display hours.
+        if (next.display_off || wifi != WIRELESS_STATUS_CONNECTED) {
+            MBTA_StreamSetEnabled(false);
+        }
         mbta_state_set(&next);
-        vTaskDelay(pdMS_TO_TICKS(MBTA_POLL_PERIOD_MS));
+        mbta_stream_note_publish();
+#else
+        mbta_state_set(&next);
+#endif
+
+#if MBTA_USE_SCHEDULE_CACHE
+        // Only once predictions are up, so the first ones never wait for it.
+        if (fetched) {
+            mbta_schedule_refresh();
+        }
+#else
+        (void)fetched;
+#endif
+
+#if MBTA_USE_STREAMING
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MBTA_STREAM_REFRESH_MS));
+#else
+        uint32_t sleep_ms = MBTA_SCHED_MAX_SLEEP_MS;
+        if (!active) {
+            // Re-spread from scratch on resume rather than bursting every
+            // overdue job at once.
+            scheduled = false;
+        } else {
+            int job = mbta_schedule_next(due_us);
+            int64_t start_us = due_us[job];
+            if (job != last_job && start_us < spaced_us) {
+                start_us = spaced_us;
+            }
+            int64_t wait_us = start_us - esp_timer_get_time();
+            if (wait_us < (int64_t)sleep_ms * 1000) {
+                sleep_ms = (wait_us > 0) ? (uint32_t)(wait_us / 1000) : 0;
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(sleep_ms) + 1);
+#endif
     }
 }
 
 void MBTA_TaskStart(void)
 {
-    if (s_state_mu == NULL) {
-        s_state_mu = xSemaphoreCreateMutex();
+    // Start only once
+    if (seqlock_version(&s_state_pub) != 0) {
+        return;
     }
+    seqlock_init(&s_state_pub, s_state_bufs, sizeof(mbta_state_t));
+
+    mbta_jobs_init();
+#if MBTA_USE_SCHEDULE_CACHE
+    s_schedule = mbta_schedule_load(mbta_stops_hash());
+#endif
 
     // Seed state
-    memset(&s_state, 0, sizeof(s_state));
-    s_state.mode = MBTA_MODE_BUS;
-    s_state.has_data = false;
-    strlcpy(s_state.title, MBTA_BUS_TITLE, sizeof(s_state.title));
+    mbta_state_t *st = seqlock_write_begin(&s_state_pub);
+    st->mode = MBTA_MODE_BUS;
+    st->has_data = false;
+    strlcpy(st->title, s_stops[0].name, sizeof(st->title));
+    // Warm boot: with the RTC still running (software reset) the restored
+    // epochs extrapolate; after a power loss they wait for SNTP.
+    if (mbta_snapshot_restore() && mbta_time_is_sane()) {
+        mbta_state_fill_stops(st);
+    }
     s_state_version = 1;
-    s_state.version = s_state_version;
+    st->version = s_state_version;
+    seqlock_write_end(&s_state_pub);
 
+    // TLS and the body parsers run on the network service.
     xTaskCreatePinnedToCore(
         mbta_task,
         "mbta_task",
-        8192,
+        6144,
         NULL,
         3,
+#if MBTA_USE_STREAMING
+        &s_mbta_task,
+#else
         NULL,
+#endif
         0);
+
+#if MBTA_USE_ALERTS
+    char alerts_url[320];
+    mbta_alerts_url(alerts_url, sizeof(alerts_url));
+    MBTA_AlertsTaskStart(alerts_url);
+#endif
+
+#if MBTA_USE_STREAMING
+    // Every stop stays live, so falling back to the next one is instant.
+    MBTA_StreamStart(s_jobs[0].url, s_stream_slots, MBTA_STOP_COUNT, mbta_on_stream_changed, NULL);
+#endif
 }
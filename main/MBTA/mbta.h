@@ -2,6 +2,8 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
+#include <time.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -13,17 +15,80 @@ typedef enum {
     MBTA_MODE_T,
 } mbta_mode_t;
 
+typedef enum {
+    MBTA_OCCUPANCY_UNKNOWN = 0,
+    MBTA_OCCUPANCY_MANY_SEATS,
+    MBTA_OCCUPANCY_FEW_SEATS,
+    MBTA_OCCUPANCY_STANDING,
+    MBTA_OCCUPANCY_FULL,
+} mbta_occupancy_t;
+
+// Trip/vehicle details of one arrival ("" / unknown when not provided).
 typedef struct {
+    char headsign[24];
+    uint8_t occupancy;  // mbta_occupancy_t
+    int8_t stops_away;  // -1 == unknown
+} mbta_arrival_detail_t;
+
+// Stop table capacity (see MBTA_STOPS in config.h.example). Every slot
+// adds ~140 bytes to each copy of mbta_state_t. Only override it with a
+// compiler flag, so every file sees the same value.
+#ifndef MBTA_MAX_STOPS
+#define MBTA_MAX_STOPS 8
+#endif
+
+// Latest arrivals of one configured stop.
+typedef struct {
+    // False until the stop has been fetched, and after a failed fetch.
+    bool has_data;
+    // Arrivals are from the cached schedule, not predictions.
+    bool scheduled;
+    // Arrivals were restored at boot and not confirmed by a fetch yet.
+    bool stale;
+    time_t arrivals_epoch[3];
+    mbta_arrival_detail_t arrival_details[3];
+    int arrival_count;
+    time_t fetched_at;
+    // Interval until the stop is fetched again (0 == not polled, e.g. streaming).
+    uint32_t refresh_ms;
+} mbta_stop_state_t;
+
+typedef struct {
+    // MBTA_MODE_BUS while the first configured stop is shown, MBTA_MODE_T
+    // once it had no arrivals and a later stop is shown instead.
     mbta_mode_t mode;
     bool no_bus_service_banner;
 
-    // Up to 3 upcoming arrivals in minutes (0 == due).
-    int arrivals_min[3];
+    // Up to 3 upcoming arrivals as absolute UTC epochs, ascending. The UI
+    // derives minutes from the RTC so countdowns keep moving between fetches.
+    time_t arrivals_epoch[3];
     int arrival_count;
 
+    // True when those are scheduled times (no predictions, or offline).
+    bool scheduled;
+
+    // True while they are the last-known predictions from before a reset
+    // (fetched_at says how old).
+    bool stale;
+
+    // Details for arrivals_epoch[i], when the response included them.
+    mbta_arrival_detail_t arrival_details[3];
+
+    // When the arrivals were last confirmed by the server (0 == never).
+    time_t fetched_at;
+
+    // Adaptive interval until they are fetched again (0 == not polled).
+    uint32_t refresh_ms;
+
     // UI title to show under the WiFi bar.
     char title[96];
 
+    // Every configured stop in table order; the fields above describe
+    // stops[shown_stop].
+    mbta_stop_state_t stops[MBTA_MAX_STOPS];
+    int stop_count;
+    int shown_stop;
+
     // If false, UI should show "No data" / placeholders.
     bool has_data;
 
@@ -39,9 +104,60 @@ typedef struct {
 
 void MBTA_TaskStart(void);
 
-// Snapshot the latest state. Returns true on success.
+// Snapshot the latest state. Never blocks; false before MBTA_TaskStart().
 bool MBTA_GetState(mbta_state_t *out_state);
 
+// Like MBTA_GetState(), but only copies when something was published since
+// *seen (start at 0), then updates *seen. Cheap when nothing changed.
+bool MBTA_GetStateIfChanged(mbta_state_t *out_state, uint32_t *seen);
+
+// Minutes until `epoch`, rounded up (0 == due). Negative once the
+// prediction is about two minutes in the past (vehicle has left).
+static inline int MBTA_MinutesUntil(time_t epoch, time_t now)
+{
+    long delta = (long)(epoch - now);
+    return (int)((delta + 59) / 60);
+}
+
+// Minutes for the arrivals in `st` that have not left yet as of `now`.
+// Returns the number written to out_minutes.
+static inline int MBTA_ArrivalsMinutes(const mbta_state_t *st, time_t now, int *out_minutes, int max_minutes)
+{
+    int n = 0;
+    for (int i = 0; i < st->arrival_count && n < max_minutes; i++) {
+        int mins = MBTA_MinutesUntil(st->arrivals_epoch[i], now);
+        if (mins >= 0) {
+            out_minutes[n++] = mins;
+        }
+    }
+    return n;
+}
+
+// The countdown on screen: the state it came from and the minutes derived
+// from it. Start with count = -1 (nothing rendered).
+typedef struct {
+    uint32_t version;
+    int minutes[3];
+    int count;
+} mbta_countdown_t;
+
+// Re-derive the minutes of `st` at `now`. Returns true, with *shown
+// updated, when they or the state differ from what *shown holds: only then
+// does the screen need a re-render.
+static inline bool MBTA_CountdownUpdate(mbta_countdown_t *shown, const mbta_state_t *st, time_t now)
+{
+    int mins[3] = {0};
+    int count = MBTA_ArrivalsMinutes(st, now, mins, 3);
+    if (st->version == shown->version && count == shown->count &&
+        memcmp(mins, shown->minutes, sizeof(mins)) == 0) {
+        return false;
+    }
+    shown->version = st->version;
+    shown->count = count;
+    memcpy(shown->minutes, mins, sizeof(mins));
+    return true;
+}
+
 #ifdef __cplusplus
 }
 #endif
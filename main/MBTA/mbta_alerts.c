@@ -0,0 +1,273 @@
+#include "mbta_alerts.h"
+#include "mbta.h"
+#include "config.h"
+
+#include "Wireless.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+
+#include "net_service.h"
+#include "seqlock.h"
+#include "time_sync.h"
+#include "ui_notify.h"
+#include "json_stream.h"
+
+// Alerts change on the scale of minutes to hours.
+#ifndef MBTA_ALERTS_PERIOD_MS
+#define MBTA_ALERTS_PERIOD_MS (5 * 60 * 1000)
+#endif
+
+#define MBTA_ALERTS_RETRY_MS      (60 * 1000)
+#define MBTA_ALERTS_IDLE_MS       (15000)
+#define MBTA_ALERTS_TIMEOUT_MS    (8000)
+#define MBTA_ALERTS_URL_MAX       (320)
+
+static const char *TAG = "MBTA_ALERTS";
+
+// Written by alerts_task only.
+static seqlock_t s_alerts_pub;
+static mbta_alerts_state_t s_alerts_bufs[2];
+static char s_alerts_url[MBTA_ALERTS_URL_MAX];
+
+typedef struct {
+    json_stream_t js;
+    char tok[128];
+
+    // Alert currently being parsed.
+    uint32_t item_id_hash;
+    uint32_t item_updated_hash;
+    uint8_t item_severity;
+    char item_header[96];
+
+    int count;
+    uint32_t fingerprint;
+    uint8_t severity;
+    char header[96];
+    bool saw_data;
+
+    uint32_t body_bytes;
+    char last_modified[40];
+} alerts_parser_t;
+
+static uint32_t fnv1a(const char *s)
+{
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// murmur3 finalizer: spreads the bits before the alerts are summed.
+static uint32_t mix32(uint32_t h)
+{
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+static void alerts_state_set(const mbta_alerts_state_t *src)
+{
+    mbta_alerts_state_t *st = seqlock_write_begin(&s_alerts_pub);
+    uint32_t version = st->version;
+    *st = *src;
+    st->version = version + 1;
+    seqlock_write_end(&s_alerts_pub);
+    UiNotify_Signal();
+}
+
+bool MBTA_GetAlerts(mbta_alerts_state_t *out_state)
+{
+    if (out_state == NULL || s_alerts_pub.size == 0) {
+        return false;
+    }
+    seqlock_read(&s_alerts_pub, out_state);
+    return true;
+}
+
+static bool alerts_on_json(json_stream_t *js, json_stream_event_t ev, const char *value, size_t len, void *ctx)
+{
+    (void)len;
+    alerts_parser_t *p = (alerts_parser_t *)ctx;
+    int depth = json_stream_depth(js);
+
+    if (depth < 1 || strcmp(json_stream_key(js, 0), "data") != 0) {
+        return true;
+    }
+
+    if (depth == 1) {
+        if (ev == JSON_STREAM_ARRAY_BEGIN) {
+            p->saw_data = true;
+        }
+        return true;
+    }
+
+    // data[i] (the alert itself)
+    if (depth == 2) {
+        if (ev == JSON_STREAM_OBJECT_BEGIN) {
+            p->item_id_hash = 0;
+            p->item_updated_hash = 0;
+            p->item_severity = 0;
+            p->item_header[0] = '\0';
+        } else if (ev == JSON_STREAM_OBJECT_END && p->item_id_hash != 0) {
+            // Summed, so the fingerprint does not depend on response order.
+            p->fingerprint += mix32(p->item_id_hash * 0x9E3779B1u ^ p->item_updated_hash);
+            p->count++;
+            if (p->count == 1 || p->item_severity > p->severity) {
+                p->severity = p->item_severity;
+                strlcpy(p->header, p->item_header, sizeof(p->header));
+            }
+        }
+        return true;
+    }
+
+    // data[i].id
+    if (depth == 3 && ev == JSON_STREAM_STRING && strcmp(json_stream_key(js, 2), "id") == 0) {
+        p->item_id_hash = fnv1a(value);
+        return true;
+    }
+
+    // data[i].attributes.{short_header,severity,updated_at}
+    if (depth == 4 && strcmp(json_stream_key(js, 2), "attributes") == 0) {
+        const char *key = json_stream_key(js, 3);
+        if (ev == JSON_STREAM_STRING && strcmp(key, "updated_at") == 0) {
+            p->item_updated_hash = fnv1a(value);
+        } else if (ev == JSON_STREAM_STRING && strcmp(key, "short_header") == 0) {
+            strlcpy(p->item_header, value, sizeof(p->item_header));
+        } else if (ev == JSON_STREAM_NUMBER && strcmp(key, "severity") == 0) {
+            long sev = strtol(value, NULL, 10);
+            p->item_severity = (uint8_t)(sev < 0 ? 0 : (sev > 10 ? 10 : sev));
+        }
+    }
+    return true;
+}
+
+static bool alerts_on_body(const char *data, size_t len, void *ctx)
+{
+    alerts_parser_t *p = (alerts_parser_t *)ctx;
+    p->body_bytes += (uint32_t)len;
+    return json_stream_feed(&p->js, data, len);
+}
+
+static void alerts_on_header(const char *name, const char *value, void *ctx)
+{
+    alerts_parser_t *p = (alerts_parser_t *)ctx;
+    if (strcasecmp(name, "Last-Modified") == 0) {
+        strlcpy(p->last_modified, value, sizeof(p->last_modified));
+    }
+}
+
+// One request. *changed is set when the alerts differ from `cur`; `next`
+// then holds them.
+static bool fetch_alerts(char *last_modified, size_t last_modified_size, const mbta_alerts_state_t *cur,
+                         mbta_alerts_state_t *next, bool *changed)
+{
+    static alerts_parser_t parser;
+    memset(&parser, 0, sizeof(parser));
+    json_stream_init(&parser.js, parser.tok, sizeof(parser.tok), alerts_on_json, &parser);
+
+    char extra_headers[64] = {0};
+    if (last_modified[0] != '\0') {
+        snprintf(extra_headers, sizeof(extra_headers), "If-Modified-Since: %s\r\n", last_modified);
+    }
+
+    http_conn_request_t req = {
+        .url = s_alerts_url,
+        .timeout_ms = MBTA_ALERTS_TIMEOUT_MS,
+        .extra_headers = extra_headers,
+        .on_header = alerts_on_header,
+        .on_body = alerts_on_body,
+        .ctx = &parser,
+    };
+
+    *changed = false;
+    int http_status = 0;
+    esp_err_t err = NetService_Get(&req, NET_PRIO_LOW, 0, &http_status);
+
+    if (err == ESP_OK && http_status == 304 && last_modified[0] != '\0') {
+        return true;
+    }
+
+    last_modified[0] = '\0';
+    if (err != ESP_OK || http_status < 200 || http_status >= 300) {
+        ESP_LOGW(TAG, "HTTP GET failed (%s), status=%d", esp_err_to_name(err), http_status);
+        return false;
+    }
+    if (!json_stream_finish(&parser.js) || !parser.saw_data) {
+        ESP_LOGW(TAG, "JSON parse failed (offset=%u)", (unsigned)json_stream_offset(&parser.js));
+        return false;
+    }
+    strlcpy(last_modified, parser.last_modified, last_modified_size);
+
+    uint32_t fingerprint = parser.count ? (parser.fingerprint ? parser.fingerprint : 1) : 0;
+    if (cur->has_data && fingerprint == cur->fingerprint) {
+        ESP_LOGD(TAG, "%d alert(s) unchanged (%u bytes)", parser.count, (unsigned)parser.body_bytes);
+        return true;
+    }
+
+    memset(next, 0, sizeof(*next));
+    next->has_data = true;
+    next->count = parser.count;
+    next->severity = parser.severity;
+    next->fingerprint = fingerprint;
+    strlcpy(next->header, parser.header, sizeof(next->header));
+    *changed = true;
+    ESP_LOGI(TAG, "%d alert(s), fingerprint %08x: %s", next->count, (unsigned)fingerprint, next->header);
+    return true;
+}
+
+static void alerts_task(void *arg)
+{
+    (void)arg;
+
+    char last_modified[40] = "";
+
+    while (1) {
+        // Nothing to show outside display hours, nor before the first SNTP
+        // sync (TLS needs a sane RTC).
+        mbta_state_t st;
+        bool display_off = MBTA_GetState(&st) && st.display_off;
+        if (Wireless_GetStatus() != WIRELESS_STATUS_CONNECTED || display_off || !TimeSync_IsSynced()) {
+            vTaskDelay(pdMS_TO_TICKS(MBTA_ALERTS_IDLE_MS));
+            continue;
+        }
+
+        mbta_alerts_state_t cur = {0};
+        MBTA_GetAlerts(&cur);
+
+        mbta_alerts_state_t next;
+        bool changed = false;
+        bool ok = fetch_alerts(last_modified, sizeof(last_modified), &cur, &next, &changed);
+        if (changed) {
+            alerts_state_set(&next);
+        }
+
+        // A failed fetch keeps the last alerts: they stay valid for minutes.
+        vTaskDelay(pdMS_TO_TICKS(ok ? MBTA_ALERTS_PERIOD_MS : MBTA_ALERTS_RETRY_MS));
+    }
+}
+
+void MBTA_AlertsTaskStart(const char *url)
+{
+    // Start only once
+    if (s_alerts_pub.size != 0 || url == NULL) {
+        return;
+    }
+    seqlock_init(&s_alerts_pub, s_alerts_bufs, sizeof(mbta_alerts_state_t));
+    strlcpy(s_alerts_url, url, sizeof(s_alerts_url));
+
+    // Below the prediction task: alerts can always wait. The request and its
+    // parser run on the network service, hence the small stack.
+    xTaskCreatePinnedToCore(alerts_task, "mbta_alerts", 4096, NULL, 1, NULL, 0);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Service alerts for the configured stops/routes.
+//
+// Fetched by a low-priority task on its own slow schedule (minutes), next
+// to the prediction polling. Each response is reduced to a fingerprint of
+// the active alert ids and their updated_at; the state (and its version)
+// only changes when the fingerprint does, so an unchanged alert list costs
+// neither a re-render nor, thanks to If-Modified-Since, a body.
+
+typedef struct {
+    // False until the first successful fetch.
+    bool has_data;
+
+    // Alerts currently in effect (0 == none, hide the banner).
+    int count;
+
+    // short_header of the most severe one and its severity (0-10).
+    char header[96];
+    uint8_t severity;
+
+    // Over every alert's id and updated_at; 0 == no alerts.
+    uint32_t fingerprint;
+
+    // Monotonic version, incremented on change.
+    uint32_t version;
+} mbta_alerts_state_t;
+
+// Poll `url` (an /alerts request, copied) every MBTA_ALERTS_PERIOD_MS.
+void MBTA_AlertsTaskStart(const char *url);
+
+// Snapshot the latest alerts. Returns true on success.
+bool MBTA_GetAlerts(mbta_alerts_state_t *out_state);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,160 @@
+#include "mbta_included.h"
+#include "mbta.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t fnv1a(const char *s)
+{
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t resource_key_from_hash(mbta_resource_type_t type, uint32_t id_hash)
+{
+    uint32_t key = id_hash ^ ((uint32_t)type * 0x9E3779B1u);
+    return key ? key : 1;
+}
+
+uint32_t mbta_resource_key(mbta_resource_type_t type, const char *id)
+{
+    return resource_key_from_hash(type, fnv1a(id));
+}
+
+void mbta_included_init(mbta_included_index_t *idx)
+{
+    memset(idx, 0, sizeof(*idx));
+}
+
+// Slot holding `key`, or the empty slot where it would go (NULL if full).
+static mbta_included_entry_t *index_probe(const mbta_included_index_t *idx, uint32_t key)
+{
+    uint32_t mask = MBTA_INCLUDED_SLOTS - 1;
+    for (uint32_t i = 0; i < MBTA_INCLUDED_SLOTS; i++) {
+        const mbta_included_entry_t *e = &idx->slots[(key + i) & mask];
+        if (e->key == key || e->key == 0) {
+            return (mbta_included_entry_t *)e;
+        }
+    }
+    return NULL;
+}
+
+bool mbta_included_reserve(mbta_included_index_t *idx, uint32_t key)
+{
+    mbta_included_entry_t *e = index_probe(idx, key);
+    if (e == NULL) {
+        return false;
+    }
+    if (e->key == 0) {
+        e->key = key;
+        e->current_stop_sequence = -1;
+        idx->used++;
+    }
+    return true;
+}
+
+const mbta_included_entry_t *mbta_included_find(const mbta_included_index_t *idx, uint32_t key)
+{
+    const mbta_included_entry_t *e = index_probe(idx, key);
+    return (e != NULL && e->key == key && e->filled) ? e : NULL;
+}
+
+static uint8_t occupancy_from_status(const char *s)
+{
+    if (strcmp(s, "MANY_SEATS_AVAILABLE") == 0 || strcmp(s, "EMPTY") == 0) {
+        return MBTA_OCCUPANCY_MANY_SEATS;
+    }
+    if (strcmp(s, "FEW_SEATS_AVAILABLE") == 0) {
+        return MBTA_OCCUPANCY_FEW_SEATS;
+    }
+    if (strcmp(s, "STANDING_ROOM_ONLY") == 0 || strcmp(s, "CRUSHED_STANDING_ROOM_ONLY") == 0) {
+        return MBTA_OCCUPANCY_STANDING;
+    }
+    if (strcmp(s, "FULL") == 0 || strcmp(s, "NOT_ACCEPTING_PASSENGERS") == 0) {
+        return MBTA_OCCUPANCY_FULL;
+    }
+    return MBTA_OCCUPANCY_UNKNOWN;
+}
+
+static void index_store_item(mbta_included_index_t *idx)
+{
+    idx->seen++;
+    if (idx->item_type == MBTA_RESOURCE_OTHER || idx->item_id_hash == 0) {
+        return;
+    }
+
+    uint32_t key = resource_key_from_hash(idx->item_type, idx->item_id_hash);
+    mbta_included_entry_t *e = index_probe(idx, key);
+    if (e == NULL || (e->key == 0 && idx->closed)) {
+        if (e == NULL) {
+            idx->dropped++;
+        }
+        return;
+    }
+    if (e->key == 0) {
+        e->key = key;
+        idx->used++;
+    }
+
+    e->filled = true;
+    e->occupancy = idx->item_occupancy;
+    e->current_stop_sequence = idx->item_stop_sequence;
+    memcpy(e->headsign, idx->item_headsign, sizeof(e->headsign));
+}
+
+void mbta_included_on_json(mbta_included_index_t *idx, const json_stream_t *js, json_stream_event_t ev,
+                           const char *value)
+{
+    int depth = json_stream_depth(js);
+    if (depth < 2 || !json_stream_in_array(js, 1)) {
+        return;
+    }
+
+    // included[i] (the resource itself)
+    if (depth == 2) {
+        if (ev == JSON_STREAM_OBJECT_BEGIN) {
+            idx->item_id_hash = 0;
+            idx->item_type = MBTA_RESOURCE_OTHER;
+            idx->item_occupancy = MBTA_OCCUPANCY_UNKNOWN;
+            idx->item_stop_sequence = -1;
+            idx->item_headsign[0] = '\0';
+        } else if (ev == JSON_STREAM_OBJECT_END) {
+            // Keys come in any order (MBTA sends them sorted, so attributes
+            // precede id/type); only now is the key known.
+            index_store_item(idx);
+        }
+        return;
+    }
+
+    // included[i].{id,type}
+    if (depth == 3 && ev == JSON_STREAM_STRING) {
+        const char *key = json_stream_key(js, 2);
+        if (strcmp(key, "id") == 0) {
+            idx->item_id_hash = fnv1a(value);
+        } else if (strcmp(key, "type") == 0) {
+            if (strcmp(value, "trip") == 0) {
+                idx->item_type = MBTA_RESOURCE_TRIP;
+            } else if (strcmp(value, "vehicle") == 0) {
+                idx->item_type = MBTA_RESOURCE_VEHICLE;
+            }
+        }
+        return;
+    }
+
+    // included[i].attributes.*: only the fields the UI shows.
+    if (depth == 4 && strcmp(json_stream_key(js, 2), "attributes") == 0) {
+        const char *attr = json_stream_key(js, 3);
+        if (ev == JSON_STREAM_STRING && strcmp(attr, "headsign") == 0) {
+            strlcpy(idx->item_headsign, value, sizeof(idx->item_headsign));
+        } else if (ev == JSON_STREAM_STRING && strcmp(attr, "occupancy_status") == 0) {
+            idx->item_occupancy = occupancy_from_status(value);
+        } else if (ev == JSON_STREAM_NUMBER && strcmp(attr, "current_stop_sequence") == 0) {
+            long seq = strtol(value, NULL, 10);
+            idx->item_stop_sequence = (seq >= 0 && seq <= INT16_MAX) ? (int16_t)seq : -1;
+        }
+    }
+}
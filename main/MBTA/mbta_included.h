@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "json_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Index over the `included` array of a JSON:API response.
+//
+// Each trip/vehicle resource is projected into a fixed-size entry of an
+// open-addressed table keyed by (type, id), as it streams past, so the
+// relationships of a prediction resolve with one lookup. Once the caller
+// knows which resources it references (after data[]), it reserves their
+// keys and closes the index; from then on only reserved entries are
+// filled, so a long `included` array cannot crowd them out.
+
+#define MBTA_INCLUDED_SLOTS 64 // power of two
+
+typedef enum {
+    MBTA_RESOURCE_OTHER = 0,
+    MBTA_RESOURCE_TRIP,
+    MBTA_RESOURCE_VEHICLE,
+} mbta_resource_type_t;
+
+typedef struct {
+    uint32_t key; // 0 == empty slot
+    bool filled;
+    uint8_t occupancy;              // mbta_occupancy_t (vehicle)
+    int16_t current_stop_sequence;  // vehicle, -1 == unknown
+    char headsign[24];              // trip
+} mbta_included_entry_t;
+
+typedef struct {
+    mbta_included_entry_t slots[MBTA_INCLUDED_SLOTS];
+    int used;
+    bool closed;
+
+    // Resource currently being parsed.
+    uint32_t item_id_hash;
+    mbta_resource_type_t item_type;
+    uint8_t item_occupancy;
+    int16_t item_stop_sequence;
+    char item_headsign[24];
+
+    uint32_t seen;
+    uint32_t dropped;
+} mbta_included_index_t;
+
+uint32_t mbta_resource_key(mbta_resource_type_t type, const char *id);
+
+void mbta_included_init(mbta_included_index_t *idx);
+
+// Make sure `key` has a slot. Returns false when the table is full.
+bool mbta_included_reserve(mbta_included_index_t *idx, uint32_t key);
+
+// Stop taking resources that were not reserved.
+static inline void mbta_included_close(mbta_included_index_t *idx)
+{
+    idx->closed = true;
+}
+
+// Feed a json_stream event whose path starts with "included".
+void mbta_included_on_json(mbta_included_index_t *idx, const json_stream_t *js, json_stream_event_t ev,
+                           const char *value);
+
+// Entry for `key`, or NULL if the response did not include it.
+const mbta_included_entry_t *mbta_included_find(const mbta_included_index_t *idx, uint32_t key);
+
+#ifdef __cplusplus
+}
+#endif
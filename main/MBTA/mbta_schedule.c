@@ -0,0 +1,218 @@
+#include "mbta_schedule.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// The image format only; the partition it lives in is handled in
+// mbta_schedule_store.c.
+
+static uint32_t fnv1a_bytes(const uint8_t *p, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void mbta_schedule_builder_init(mbta_schedule_builder_t *b)
+{
+    memset(b, 0, sizeof(*b));
+}
+
+bool mbta_schedule_builder_add(mbta_schedule_builder_t *b, int stop, const char *route, int direction,
+                               uint16_t minute)
+{
+    int s = 0;
+    while (s < b->series_count) {
+        const mbta_schedule_series_t *ser = &b->series[s];
+        if (ser->stop == stop && ser->direction == direction &&
+            strncmp(ser->route, route, sizeof(ser->route) - 1) == 0) {
+            break;
+        }
+        s++;
+    }
+    if (s == b->series_count) {
+        if (b->series_count == MBTA_SCHEDULE_MAX_SERIES) {
+            b->overflow = true;
+            return false;
+        }
+        mbta_schedule_series_t *ser = &b->series[b->series_count++];
+        strlcpy(ser->route, route, sizeof(ser->route));
+        ser->stop = (uint8_t)stop;
+        ser->direction = (uint8_t)direction;
+    }
+
+    if (b->dep_count == MBTA_SCHEDULE_MAX_DEPARTURES) {
+        b->overflow = true;
+        return false;
+    }
+    b->deps[b->dep_count].minute = minute;
+    b->deps[b->dep_count].series = (uint8_t)s;
+    b->dep_count++;
+    return true;
+}
+
+static int dep_cmp(const void *a, const void *b)
+{
+    const mbta_schedule_dep_t *da = (const mbta_schedule_dep_t *)a;
+    const mbta_schedule_dep_t *db = (const mbta_schedule_dep_t *)b;
+    if (da->series != db->series) {
+        return (int)da->series - (int)db->series;
+    }
+    return (int)da->minute - (int)db->minute;
+}
+
+size_t mbta_schedule_encode(mbta_schedule_builder_t *b, int64_t day_start, uint32_t config_hash, uint8_t *out,
+                            size_t out_size)
+{
+    qsort(b->deps, (size_t)b->dep_count, sizeof(b->deps[0]), dep_cmp);
+
+    int block_count = 0;
+    int delta_count = 0;
+    int d = 0;
+    for (int s = 0; s < b->series_count; s++) {
+        mbta_schedule_series_t *ser = &b->series[s];
+        ser->first_block = (uint16_t)block_count;
+        ser->count = 0;
+        mbta_schedule_block_t *blk = NULL;
+        uint16_t prev = 0;
+        for (; d < b->dep_count && b->deps[d].series == s; d++) {
+            uint16_t minute = b->deps[d].minute;
+            if (blk != NULL && minute == prev) {
+                continue; // duplicate (e.g. the same trip listed twice)
+            }
+            // A new block every MBTA_SCHEDULE_BLOCK departures, or when the
+            // gap does not fit a delta.
+            if (blk == NULL || blk->count == MBTA_SCHEDULE_BLOCK || minute - prev > UINT8_MAX) {
+                if (block_count == MBTA_SCHEDULE_MAX_BLOCKS) {
+                    return 0;
+                }
+                blk = &b->blocks[block_count++];
+                blk->first_minute = minute;
+                blk->delta_index = (uint16_t)delta_count;
+                blk->count = 1;
+            } else {
+                b->deltas[delta_count++] = (uint8_t)(minute - prev);
+                blk->count++;
+            }
+            prev = minute;
+            ser->count++;
+        }
+        ser->block_count = (uint16_t)(block_count - ser->first_block);
+    }
+
+    size_t series_off = sizeof(mbta_schedule_header_t);
+    size_t blocks_off = series_off + (size_t)b->series_count * sizeof(mbta_schedule_series_t);
+    size_t deltas_off = blocks_off + (size_t)block_count * sizeof(mbta_schedule_block_t);
+    size_t size = deltas_off + (size_t)delta_count;
+    if (size > out_size) {
+        return 0;
+    }
+
+    mbta_schedule_header_t hdr = {
+        .magic = MBTA_SCHEDULE_MAGIC,
+        .version = MBTA_SCHEDULE_VERSION,
+        .series_count = (uint16_t)b->series_count,
+        .size = (uint32_t)size,
+        .day_start = day_start,
+        .config_hash = config_hash,
+        .departures = (uint32_t)(delta_count + block_count),
+    };
+    memcpy(out + series_off, b->series, (size_t)b->series_count * sizeof(mbta_schedule_series_t));
+    memcpy(out + blocks_off, b->blocks, (size_t)block_count * sizeof(mbta_schedule_block_t));
+    memcpy(out + deltas_off, b->deltas, (size_t)delta_count);
+    hdr.checksum = fnv1a_bytes(out + sizeof(hdr), size - sizeof(hdr));
+    memcpy(out, &hdr, sizeof(hdr));
+    return size;
+}
+
+bool mbta_schedule_valid(const uint8_t *image, size_t size)
+{
+    if (image == NULL || size < sizeof(mbta_schedule_header_t)) {
+        return false;
+    }
+    const mbta_schedule_header_t *hdr = (const mbta_schedule_header_t *)image;
+    return hdr->magic == MBTA_SCHEDULE_MAGIC && hdr->version == MBTA_SCHEDULE_VERSION &&
+           hdr->size >= sizeof(*hdr) && hdr->size <= size &&
+           hdr->series_count <= MBTA_SCHEDULE_MAX_SERIES &&
+           hdr->checksum == fnv1a_bytes(image + sizeof(*hdr), hdr->size - sizeof(*hdr));
+}
+
+// Departures of one block, decoded.
+static int block_decode(const mbta_schedule_block_t *blk, const uint8_t *deltas, uint16_t *out)
+{
+    uint16_t minute = blk->first_minute;
+    out[0] = minute;
+    for (int n = 1; n < blk->count; n++) {
+        minute += deltas[blk->delta_index + n - 1];
+        out[n] = minute;
+    }
+    return blk->count;
+}
+
+// Insert into the ascending out[0..*n), keeping at most `max`.
+static void next_insert(uint16_t *out, int *n, int max, uint16_t minute)
+{
+    int pos = *n;
+    while (pos > 0 && out[pos - 1] > minute) {
+        pos--;
+    }
+    if (pos >= max) {
+        return;
+    }
+    int last = (*n < max) ? *n : max - 1;
+    memmove(&out[pos + 1], &out[pos], (size_t)(last - pos) * sizeof(*out));
+    out[pos] = minute;
+    if (*n < max) {
+        (*n)++;
+    }
+}
+
+int mbta_schedule_departures(const uint8_t *image, int stop, uint16_t from_minute, uint16_t *out_minutes, int max)
+{
+    const mbta_schedule_header_t *hdr = (const mbta_schedule_header_t *)image;
+    const mbta_schedule_series_t *series = (const mbta_schedule_series_t *)(image + sizeof(*hdr));
+    const mbta_schedule_block_t *blocks = (const mbta_schedule_block_t *)(series + hdr->series_count);
+    int total_blocks = 0;
+    for (int s = 0; s < hdr->series_count; s++) {
+        total_blocks += series[s].block_count;
+    }
+    const uint8_t *deltas = (const uint8_t *)(blocks + total_blocks);
+
+    int n = 0;
+    for (int s = 0; s < hdr->series_count; s++) {
+        const mbta_schedule_series_t *ser = &series[s];
+        if (ser->stop != stop || ser->block_count == 0) {
+            continue;
+        }
+
+        // Last block starting at or before from_minute (else the first).
+        const mbta_schedule_block_t *first = &blocks[ser->first_block];
+        int lo = 0;
+        int hi = ser->block_count - 1;
+        while (lo < hi) {
+            int mid = (lo + hi + 1) / 2;
+            if (first[mid].first_minute <= from_minute) {
+                lo = mid;
+            } else {
+                hi = mid - 1;
+            }
+        }
+
+        // Decode from there until this series has contributed `max`.
+        int taken = 0;
+        for (int bi = lo; bi < ser->block_count && taken < max; bi++) {
+            uint16_t mins[MBTA_SCHEDULE_BLOCK];
+            int count = block_decode(&first[bi], deltas, mins);
+            for (int k = 0; k < count && taken < max; k++) {
+                if (mins[k] >= from_minute) {
+                    next_insert(out_minutes, &n, max, mins[k]);
+                    taken++;
+                }
+            }
+        }
+    }
+    return n;
+}
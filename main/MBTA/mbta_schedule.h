@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Compact daily schedule image, kept in the MBTA_SCHEDULE_PARTITION data
+// partition so scheduled departures can stand in for predictions without
+// any network traffic.
+//
+// Departures are minutes since local midnight of the service date (past
+// 1440 for trips after midnight), grouped in one series per
+// (stop, route, direction). Each series is split into blocks of up to
+// MBTA_SCHEDULE_BLOCK departures: an absolute first minute, then one-byte
+// deltas. Lookups binary-search the block heads and decode at most one
+// block, straight from the memory-mapped partition.
+//
+// Layout: header | series[series_count] | blocks[] | deltas[]
+
+#define MBTA_SCHEDULE_MAGIC   0x3143534Du // "MSC1"
+#define MBTA_SCHEDULE_VERSION 1
+
+#define MBTA_SCHEDULE_BLOCK          16
+#define MBTA_SCHEDULE_MAX_SERIES     24
+#define MBTA_SCHEDULE_MAX_DEPARTURES 1536
+#define MBTA_SCHEDULE_IMAGE_MAX      8192
+// Gaps over 255 min also start a block; a service day has few of those.
+#define MBTA_SCHEDULE_MAX_BLOCKS \
+    (MBTA_SCHEDULE_MAX_DEPARTURES / MBTA_SCHEDULE_BLOCK + MBTA_SCHEDULE_MAX_SERIES * 8)
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t series_count;
+    uint32_t size;        // whole image, header included
+    uint32_t checksum;    // FNV-1a over everything after the header
+    int64_t day_start;    // UTC epoch of local midnight of the service date
+    uint32_t config_hash; // stop table the image was built for
+    uint32_t departures;
+} mbta_schedule_header_t;
+
+typedef struct {
+    char route[12];
+    uint8_t stop;         // index in the stop table
+    uint8_t direction;
+    uint16_t count;       // departures
+    uint16_t first_block;
+    uint16_t block_count;
+} mbta_schedule_series_t;
+
+typedef struct {
+    uint16_t first_minute;
+    uint16_t delta_index; // deltas of the block's remaining departures
+    uint16_t count;       // departures in the block
+} mbta_schedule_block_t;
+
+typedef struct {
+    uint16_t minute;
+    uint8_t series;
+} mbta_schedule_dep_t;
+
+// Collects departures in any order before encoding (large: allocate it).
+typedef struct {
+    mbta_schedule_series_t series[MBTA_SCHEDULE_MAX_SERIES];
+    int series_count;
+    mbta_schedule_dep_t deps[MBTA_SCHEDULE_MAX_DEPARTURES];
+    int dep_count;
+    bool overflow;
+
+    // Encoder scratch.
+    mbta_schedule_block_t blocks[MBTA_SCHEDULE_MAX_BLOCKS];
+    uint8_t deltas[MBTA_SCHEDULE_MAX_DEPARTURES];
+} mbta_schedule_builder_t;
+
+void mbta_schedule_builder_init(mbta_schedule_builder_t *b);
+
+// Returns false (and sets overflow) when a table is full.
+bool mbta_schedule_builder_add(mbta_schedule_builder_t *b, int stop, const char *route, int direction,
+                               uint16_t minute);
+
+// Encode into `out`. Returns the image size, or 0 if it does not fit.
+size_t mbta_schedule_encode(mbta_schedule_builder_t *b, int64_t day_start, uint32_t config_hash, uint8_t *out,
+                            size_t out_size);
+
+// True when `image` is a complete image of this version.
+bool mbta_schedule_valid(const uint8_t *image, size_t size);
+
+// Up to `max` departures of `stop` at or after `from_minute`, ascending,
+// across all of its series. Returns the number written.
+int mbta_schedule_departures(const uint8_t *image, int stop, uint16_t from_minute, uint16_t *out_minutes, int max);
+
+// The partition side (mbta_schedule_store.c).
+
+// Map the partition and check the stored image. Returns it (NULL if none
+// or it was built for another stop table).
+const uint8_t *mbta_schedule_load(uint32_t config_hash);
+
+// Replace the stored image. Returns the newly mapped image (NULL on error).
+const uint8_t *mbta_schedule_store(const uint8_t *image, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,80 @@
+#include "mbta_schedule.h"
+#include "config.h"
+
+#include "esp_log.h"
+#include "esp_partition.h"
+
+// Data partition holding the image (see partitions.csv).
+#ifndef MBTA_SCHEDULE_PARTITION
+#define MBTA_SCHEDULE_PARTITION "flash_test"
+#endif
+
+#define MBTA_SCHEDULE_SECTOR 4096
+
+static const char *TAG = "MBTA_SCHED";
+
+static const esp_partition_t *s_part;
+static esp_partition_mmap_handle_t s_map;
+static const uint8_t *s_mapped;
+
+static const uint8_t *schedule_map(void)
+{
+    if (s_mapped != NULL) {
+        esp_partition_munmap(s_map);
+        s_mapped = NULL;
+    }
+    const void *ptr = NULL;
+    esp_err_t err = esp_partition_mmap(s_part, 0, MBTA_SCHEDULE_IMAGE_MAX, ESP_PARTITION_MMAP_DATA, &ptr, &s_map);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "mmap failed (%s)", esp_err_to_name(err));
+        return NULL;
+    }
+    s_mapped = (const uint8_t *)ptr;
+    return s_mapped;
+}
+
+const uint8_t *mbta_schedule_load(uint32_t config_hash)
+{
+    if (s_part == NULL) {
+        s_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, MBTA_SCHEDULE_PARTITION);
+        if (s_part == NULL || s_part->size < MBTA_SCHEDULE_IMAGE_MAX) {
+            ESP_LOGW(TAG, "no '%s' partition, schedule cache disabled", MBTA_SCHEDULE_PARTITION);
+            s_part = NULL;
+            return NULL;
+        }
+    }
+
+    const uint8_t *image = schedule_map();
+    if (!mbta_schedule_valid(image, MBTA_SCHEDULE_IMAGE_MAX)) {
+        return NULL;
+    }
+    if (((const mbta_schedule_header_t *)image)->config_hash != config_hash) {
+        ESP_LOGI(TAG, "cached schedule is for another stop table");
+        return NULL;
+    }
+    return image;
+}
+
+const uint8_t *mbta_schedule_store(const uint8_t *image, size_t size)
+{
+    if (s_part == NULL || size > MBTA_SCHEDULE_IMAGE_MAX) {
+        return NULL;
+    }
+    if (s_mapped != NULL) {
+        esp_partition_munmap(s_map);
+        s_mapped = NULL;
+    }
+
+    size_t erase = (size + MBTA_SCHEDULE_SECTOR - 1) / MBTA_SCHEDULE_SECTOR * MBTA_SCHEDULE_SECTOR;
+    esp_err_t err = esp_partition_erase_range(s_part, 0, erase);
+    if (err == ESP_OK) {
+        err = esp_partition_write(s_part, 0, image, size);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "write failed (%s)", esp_err_to_name(err));
+        return NULL;
+    }
+
+    const uint8_t *mapped = schedule_map();
+    return mbta_schedule_valid(mapped, MBTA_SCHEDULE_IMAGE_MAX) ? mapped : NULL;
+}
@@ -0,0 +1,599 @@
+#include "mbta_stream.h"
+#include "config.h"
+
+#include "Wireless.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "http_conn.h"
+#include "iso8601.h"
+#include "json_stream.h"
+
+// Predictions tracked over all slots (the old per-stop streams had 32 each).
+#define MBTA_STREAM_TABLE_SIZE      (16 * MBTA_STREAM_SLOT_MAX)
+#define MBTA_STREAM_NOTIFY_DEPTH    (3)   // arrivals the UI shows
+#define MBTA_STREAM_STALE_SEC       (30)
+#define MBTA_STREAM_IDLE_TIMEOUT_MS (90 * 1000)
+#define MBTA_STREAM_RETRY_MIN_MS    (2000)
+#define MBTA_STREAM_RETRY_MAX_MS    (60 * 1000)
+#define MBTA_STREAM_TASK_STACK      (8192)
+
+#ifdef MBTA_API_KEY
+#define MBTA_STREAM_HEADERS "Accept: text/event-stream\r\nx-api-key: " MBTA_API_KEY "\r\n"
+#else
+#define MBTA_STREAM_HEADERS "Accept: text/event-stream\r\n"
+#endif
+
+static const char *TAG = "MBTA_SSE";
+
+typedef enum {
+    SSE_EVENT_OTHER = 0,
+    SSE_EVENT_RESET,
+    SSE_EVENT_ADD,
+    SSE_EVENT_UPDATE,
+    SSE_EVENT_REMOVE,
+} sse_event_t;
+
+typedef enum {
+    SSE_LINE_FIELD = 0,  // reading the field name
+    SSE_LINE_VALUE_START, // after ':', one optional space
+    SSE_LINE_VALUE,
+    SSE_LINE_SKIP,       // comment or unknown field
+} sse_line_state_t;
+
+_Static_assert(MBTA_STREAM_SLOT_MAX <= 32, "slot mask is 32 bits");
+
+typedef struct {
+    uint32_t id_hash;
+    uint32_t slots; // bit i: matches slot i
+    time_t epoch;
+} mbta_stream_entry_t;
+
+typedef struct {
+    const char *url;
+    const mbta_stream_slot_t *slots;
+    int slot_count;
+    mbta_stream_changed_cb_t on_changed;
+    void *ctx;
+
+    // Stream task only.
+    mbta_stream_entry_t table[MBTA_STREAM_TABLE_SIZE];
+    int count;
+    bool got_reset;
+
+    sse_line_state_t line_state;
+    char field[8];
+    uint8_t field_len;
+    char event_name[12];
+    uint8_t event_len;
+    sse_event_t event;
+    bool data_started;
+    uint32_t event_us;
+
+    json_stream_t js;
+    char tok[64];
+
+    // Resource currently being parsed (0 == absent).
+    uint32_t item_hash;
+    bool item_has_id;
+    bool item_is_prediction;
+    time_t item_arrival;
+    time_t item_departure;
+    char item_stop[24];
+    char item_route[32];
+
+    // Head of line last reported to the owner, per slot.
+    time_t notified[MBTA_STREAM_SLOT_MAX][MBTA_STREAM_NOTIFY_DEPTH];
+    int notified_count[MBTA_STREAM_SLOT_MAX];
+    bool notified_live;
+
+    uint32_t events;
+
+    // Guarded by s_mu (read by MBTA_StreamGetEpochs).
+    time_t head[MBTA_STREAM_SLOT_MAX][MBTA_STREAM_HEAD_MAX];
+    int head_count[MBTA_STREAM_SLOT_MAX];
+    bool live;
+} mbta_stream_t;
+
+static SemaphoreHandle_t s_mu;
+static mbta_stream_t s_stream;
+static volatile bool s_enabled;
+
+static uint32_t now_us32(void)
+{
+    return (uint32_t)esp_timer_get_time();
+}
+
+static uint32_t fnv1a(const char *s)
+{
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void table_remove(mbta_stream_t *s, uint32_t id_hash)
+{
+    for (int i = 0; i < s->count; i++) {
+        if (s->table[i].id_hash == id_hash) {
+            s->table[i] = s->table[--s->count];
+            return;
+        }
+    }
+}
+
+static void table_upsert(mbta_stream_t *s, uint32_t id_hash, uint32_t slots, time_t epoch)
+{
+    int victim = 0;
+    for (int i = 0; i < s->count; i++) {
+        if (s->table[i].id_hash == id_hash) {
+            s->table[i].slots = slots;
+            s->table[i].epoch = epoch;
+            return;
+        }
+        if (s->table[i].epoch > s->table[victim].epoch) {
+            victim = i;
+        }
+    }
+
+    mbta_stream_entry_t entry = {.id_hash = id_hash, .slots = slots, .epoch = epoch};
+    if (s->count < MBTA_STREAM_TABLE_SIZE) {
+        s->table[s->count++] = entry;
+        return;
+    }
+
+    // Full: make room in the past first, then at the far end, so the
+    // earliest arrivals (the ones shown) are never the ones dropped.
+    time_t stale = time(NULL) - MBTA_STREAM_STALE_SEC;
+    for (int i = 0; i < s->count; i++) {
+        if (s->table[i].epoch < stale) {
+            s->table[i] = entry;
+            return;
+        }
+    }
+    if (epoch < s->table[victim].epoch) {
+        s->table[victim] = entry;
+    }
+}
+
+// Earliest non-stale epochs of `slot`, ascending.
+static int table_head(const mbta_stream_t *s, int slot, time_t now, time_t *out, int max)
+{
+    int n = 0;
+    for (int i = 0; i < s->count; i++) {
+        time_t epoch = s->table[i].epoch;
+        if ((s->table[i].slots & (1u << slot)) == 0 || epoch < now - MBTA_STREAM_STALE_SEC) {
+            continue;
+        }
+        int pos = n;
+        while (pos > 0 && out[pos - 1] > epoch) {
+            pos--;
+        }
+        if (pos >= max) {
+            continue;
+        }
+        int last = (n < max) ? n : max - 1;
+        memmove(&out[pos + 1], &out[pos], (size_t)(last - pos) * sizeof(time_t));
+        out[pos] = epoch;
+        if (n < max) {
+            n++;
+        }
+    }
+    return n;
+}
+
+// Refresh the published heads and tell the owner if what the UI shows
+// changed for any slot.
+static void stream_publish(mbta_stream_t *s)
+{
+    time_t now = time(NULL);
+    bool changed = s->notified_live != s->got_reset;
+    s->notified_live = s->got_reset;
+
+    for (int slot = 0; slot < s->slot_count; slot++) {
+        time_t head[MBTA_STREAM_HEAD_MAX];
+        int n = s->got_reset ? table_head(s, slot, now, head, MBTA_STREAM_HEAD_MAX) : 0;
+
+        xSemaphoreTake(s_mu, portMAX_DELAY);
+        memcpy(s->head[slot], head, (size_t)n * sizeof(time_t));
+        s->head_count[slot] = n;
+        s->live = s->got_reset;
+        xSemaphoreGive(s_mu);
+
+        int shown = (n < MBTA_STREAM_NOTIFY_DEPTH) ? n : MBTA_STREAM_NOTIFY_DEPTH;
+        if (s->notified_count[slot] != shown ||
+            memcmp(s->notified[slot], head, (size_t)shown * sizeof(time_t)) != 0) {
+            s->notified_count[slot] = shown;
+            memcpy(s->notified[slot], head, (size_t)shown * sizeof(time_t));
+            changed = true;
+        }
+    }
+
+    if (changed && s->on_changed) {
+        s->on_changed(s->event_us ? s->event_us : now_us32(), s->ctx);
+    }
+}
+
+static bool slot_field_matches(const char *want, const char *got)
+{
+    return want == NULL || want[0] == '\0' || strcmp(want, got) == 0;
+}
+
+// Slots the prediction being parsed belongs to.
+static uint32_t stream_item_slots(const mbta_stream_t *s)
+{
+    uint32_t slots = 0;
+    for (int i = 0; i < s->slot_count; i++) {
+        if (slot_field_matches(s->slots[i].stop_id, s->item_stop) &&
+            slot_field_matches(s->slots[i].route_id, s->item_route)) {
+            slots |= 1u << i;
+        }
+    }
+    return slots;
+}
+
+static void stream_apply_item(mbta_stream_t *s)
+{
+    if (!s->item_has_id || !s->item_is_prediction) {
+        return;
+    }
+
+    time_t epoch = s->item_arrival ? s->item_arrival : s->item_departure;
+    // `remove` only carries the id.
+    uint32_t slots = (s->event == SSE_EVENT_REMOVE) ? 0 : stream_item_slots(s);
+    if (slots == 0 || epoch == 0) {
+        // A prediction without times is a skipped stop; treat it as gone.
+        table_remove(s, s->item_hash);
+    } else {
+        table_upsert(s, s->item_hash, slots, epoch);
+    }
+}
+
+// `reset` carries an array of resources, the other events a single resource.
+static bool stream_on_json(json_stream_t *js, json_stream_event_t ev, const char *value, size_t len, void *ctx)
+{
+    (void)len;
+    mbta_stream_t *s = (mbta_stream_t *)ctx;
+    int depth = json_stream_depth(js);
+    int base = 0;
+
+    if (s->event == SSE_EVENT_RESET) {
+        if (depth < 1 || !json_stream_in_array(js, 0)) {
+            return true;
+        }
+        base = 1;
+    }
+
+    if (depth == base) {
+        if (ev == JSON_STREAM_OBJECT_BEGIN) {
+            s->item_hash = 0;
+            s->item_has_id = false;
+            s->item_is_prediction = true;
+            s->item_arrival = 0;
+            s->item_departure = 0;
+            s->item_stop[0] = '\0';
+            s->item_route[0] = '\0';
+        } else if (ev == JSON_STREAM_OBJECT_END) {
+            stream_apply_item(s);
+        }
+        return true;
+    }
+
+    if (ev != JSON_STREAM_STRING) {
+        return true;
+    }
+
+    const char *key = json_stream_key(js, base);
+    if (depth == base + 1) {
+        if (strcmp(key, "id") == 0) {
+            s->item_hash = fnv1a(value);
+            s->item_has_id = true;
+        } else if (strcmp(key, "type") == 0) {
+            s->item_is_prediction = strcmp(value, "prediction") == 0;
+        }
+    } else if (depth == base + 2 && strcmp(key, "attributes") == 0) {
+        const char *attr = json_stream_key(js, base + 1);
+        time_t epoch = 0;
+        if (strcmp(attr, "arrival_time") == 0) {
+            if (iso8601_to_epoch_utc(value, &epoch)) {
+                s->item_arrival = epoch;
+            }
+        } else if (strcmp(attr, "departure_time") == 0) {
+            if (iso8601_to_epoch_utc(value, &epoch)) {
+                s->item_departure = epoch;
+            }
+        }
+    } else if (depth == base + 4 && strcmp(key, "relationships") == 0 &&
+               strcmp(json_stream_key(js, base + 2), "data") == 0 &&
+               strcmp(json_stream_key(js, base + 3), "id") == 0) {
+        // relationships.{stop,route}.data.id
+        const char *rel = json_stream_key(js, base + 1);
+        if (strcmp(rel, "stop") == 0) {
+            strlcpy(s->item_stop, value, sizeof(s->item_stop));
+        } else if (strcmp(rel, "route") == 0) {
+            strlcpy(s->item_route, value, sizeof(s->item_route));
+        }
+    }
+    return true;
+}
+
+static void sse_event_reset(mbta_stream_t *s)
+{
+    s->event = SSE_EVENT_OTHER;
+    s->event_len = 0;
+    s->event_name[0] = '\0';
+    s->data_started = false;
+    s->event_us = 0;
+}
+
+static void sse_event_name_done(mbta_stream_t *s)
+{
+    s->event_name[s->event_len] = '\0';
+    if (strcmp(s->event_name, "reset") == 0) {
+        s->event = SSE_EVENT_RESET;
+    } else if (strcmp(s->event_name, "add") == 0) {
+        s->event = SSE_EVENT_ADD;
+    } else if (strcmp(s->event_name, "update") == 0) {
+        s->event = SSE_EVENT_UPDATE;
+    } else if (strcmp(s->event_name, "remove") == 0) {
+        s->event = SSE_EVENT_REMOVE;
+    } else {
+        s->event = SSE_EVENT_OTHER;
+    }
+}
+
+static bool sse_data(mbta_stream_t *s, const char *data, size_t len)
+{
+    if (s->event == SSE_EVENT_OTHER) {
+        return true;
+    }
+    if (!s->data_started) {
+        // The payload is parsed as it arrives; a reset can be tens of KB.
+        s->data_started = true;
+        json_stream_init(&s->js, s->tok, sizeof(s->tok), stream_on_json, s);
+        if (s->event == SSE_EVENT_RESET) {
+            s->count = 0;
+        }
+    }
+    return json_stream_feed(&s->js, data, len);
+}
+
+// Blank line: the event is complete.
+static bool sse_dispatch(mbta_stream_t *s)
+{
+    if (s->data_started) {
+        if (!json_stream_finish(&s->js)) {
+            // The table may be half-applied; reconnect to get a fresh reset.
+            ESP_LOGW(TAG, "bad '%s' payload (offset=%u)", s->event_name,
+                     (unsigned)json_stream_offset(&s->js));
+            return false;
+        }
+        if (s->event == SSE_EVENT_RESET) {
+            s->got_reset = true;
+        }
+        s->events++;
+        stream_publish(s);
+    }
+    sse_event_reset(s);
+    return true;
+}
+
+static bool sse_feed(mbta_stream_t *s, const char *data, size_t len)
+{
+    size_t i = 0;
+    while (i < len) {
+        char c = data[i];
+
+        if (s->line_state == SSE_LINE_VALUE && strcmp(s->field, "data") == 0 && c != '\n' && c != '\r') {
+            // Hand the whole run up to the end of line to the JSON parser.
+            size_t j = i;
+            while (j < len && data[j] != '\n' && data[j] != '\r') {
+                j++;
+            }
+            if (!sse_data(s, data + i, j - i)) {
+                return false;
+            }
+            i = j;
+            continue;
+        }
+        i++;
+
+        if (c == '\r') {
+            continue;
+        }
+
+        switch (s->line_state) {
+        case SSE_LINE_FIELD:
+            if (c == '\n') {
+                if (s->field_len == 0 && !sse_dispatch(s)) {
+                    return false;
+                }
+                s->field_len = 0;
+                s->field[0] = '\0';
+                break;
+            }
+            if (s->event_us == 0) {
+                s->event_us = now_us32();
+            }
+            if (c == ':') {
+                s->line_state = (s->field_len == 0) ? SSE_LINE_SKIP : SSE_LINE_VALUE_START;
+                break;
+            }
+            if ((size_t)s->field_len + 1 < sizeof(s->field)) {
+                s->field[s->field_len++] = c;
+                s->field[s->field_len] = '\0';
+            } else {
+                // Longer than any field we handle.
+                s->field[0] = '\0';
+                s->line_state = SSE_LINE_SKIP;
+            }
+            break;
+
+        case SSE_LINE_VALUE_START:
+            s->line_state = SSE_LINE_VALUE;
+            if (c != ' ') {
+                i--; // not the optional space: it is part of the value
+            }
+            break;
+
+        case SSE_LINE_VALUE:
+            if (c == '\n') {
+                if (strcmp(s->field, "data") == 0) {
+                    // Lines of one event are joined with '\n', which is JSON whitespace.
+                    if (!sse_data(s, "\n", 1)) {
+                        return false;
+                    }
+                } else if (strcmp(s->field, "event") == 0) {
+                    sse_event_name_done(s);
+                }
+                s->line_state = SSE_LINE_FIELD;
+                s->field_len = 0;
+                s->field[0] = '\0';
+            } else if (strcmp(s->field, "event") == 0) {
+                if ((size_t)s->event_len + 1 < sizeof(s->event_name)) {
+                    s->event_name[s->event_len++] = c;
+                }
+            }
+            break;
+
+        case SSE_LINE_SKIP:
+        default:
+            if (c == '\n') {
+                s->line_state = SSE_LINE_FIELD;
+                s->field_len = 0;
+                s->field[0] = '\0';
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+static bool stream_on_body(const char *data, size_t len, void *ctx)
+{
+    mbta_stream_t *s = (mbta_stream_t *)ctx;
+    if (!s_enabled) {
+        return false;
+    }
+    return sse_feed(s, data, len);
+}
+
+static void stream_restart(mbta_stream_t *s)
+{
+    s->count = 0;
+    s->got_reset = false;
+    s->events = 0;
+    s->line_state = SSE_LINE_FIELD;
+    s->field_len = 0;
+    s->field[0] = '\0';
+    sse_event_reset(s);
+}
+
+static void mbta_stream_task(void *arg)
+{
+    mbta_stream_t *s = (mbta_stream_t *)arg;
+    uint32_t retry_ms = MBTA_STREAM_RETRY_MIN_MS;
+
+    ESP_LOGI(TAG, "stream task started (%d stops)", s->slot_count);
+
+    while (1) {
+        if (!s_enabled || Wireless_GetStatus() != WIRELESS_STATUS_CONNECTED) {
+            vTaskDelay(pdMS_TO_TICKS(1000));
+            continue;
+        }
+
+        stream_restart(s);
+        http_conn_request_t req = {
+            .url = s->url,
+            .timeout_ms = MBTA_STREAM_IDLE_TIMEOUT_MS,
+            .extra_headers = MBTA_STREAM_HEADERS,
+            .on_body = stream_on_body,
+            .ctx = s,
+        };
+
+        int64_t opened_us = esp_timer_get_time();
+        int http_status = 0;
+        esp_err_t err = HttpConn_Stream(&req, &http_status);
+
+        // Whatever we had is no longer being kept up to date.
+        stream_restart(s);
+        s->event_us = 0;
+        stream_publish(s);
+
+        if (!s_enabled) {
+            ESP_LOGI(TAG, "stream closed");
+            continue;
+        }
+
+        // A stream that stayed up for a while was healthy; start the backoff over.
+        if (esp_timer_get_time() - opened_us > (int64_t)MBTA_STREAM_RETRY_MAX_MS * 1000) {
+            retry_ms = MBTA_STREAM_RETRY_MIN_MS;
+        }
+        ESP_LOGW(TAG, "stream ended (%s, status=%d), retry in %ums", esp_err_to_name(err), http_status,
+                 (unsigned)retry_ms);
+        vTaskDelay(pdMS_TO_TICKS(retry_ms));
+        retry_ms = (retry_ms * 2 > MBTA_STREAM_RETRY_MAX_MS) ? MBTA_STREAM_RETRY_MAX_MS : retry_ms * 2;
+    }
+}
+
+bool MBTA_StreamStart(const char *url, const mbta_stream_slot_t *slots, int slot_count,
+                      mbta_stream_changed_cb_t on_changed, void *ctx)
+{
+    if (url == NULL || slots == NULL || slot_count <= 0 || slot_count > MBTA_STREAM_SLOT_MAX || s_mu != NULL) {
+        return false;
+    }
+    s_mu = xSemaphoreCreateMutex();
+
+    mbta_stream_t *s = &s_stream;
+    memset(s, 0, sizeof(*s));
+    s->url = url;
+    s->slots = slots;
+    s->slot_count = slot_count;
+    s->on_changed = on_changed;
+    s->ctx = ctx;
+
+    return xTaskCreatePinnedToCore(
+               mbta_stream_task,
+               "mbta_sse",
+               MBTA_STREAM_TASK_STACK,
+               s,
+               3,
+               NULL,
+               0) == pdPASS;
+}
+
+void MBTA_StreamSetEnabled(bool enabled)
+{
+    s_enabled = enabled;
+}
+
+bool MBTA_StreamGetEpochs(int slot, time_t *out_epochs, int max_epochs, int *out_count)
+{
+    if (out_count) {
+        *out_count = 0;
+    }
+    mbta_stream_t *s = &s_stream;
+    if (s_mu == NULL || slot < 0 || slot >= s->slot_count || out_epochs == NULL) {
+        return false;
+    }
+
+    xSemaphoreTake(s_mu, portMAX_DELAY);
+    bool live = s->live;
+    int n = (s->head_count[slot] < max_epochs) ? s->head_count[slot] : max_epochs;
+    memcpy(out_epochs, s->head[slot], (size_t)n * sizeof(time_t));
+    xSemaphoreGive(s_mu);
+
+    if (out_count) {
+        *out_count = n;
+    }
+    return live;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "mbta.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Streaming predictions (MBTA V3 Server-Sent Events).
+//
+// One connection, opened with "Accept: text/event-stream", carries the
+// predictions for every configured stop. The server sends a `reset` with
+// the full prediction set, then `add`, `update` and `remove` events as
+// predictions change. Events are applied to a small table keyed by
+// prediction id; each entry remembers which slots (stop + route filters)
+// its relationships.stop / relationships.route match, the same split the
+// combined poll does. The owner is only notified when the earliest
+// arrivals of some slot change.
+
+#define MBTA_STREAM_SLOT_MAX  MBTA_MAX_STOPS   // one per stop
+#define MBTA_STREAM_HEAD_MAX  8
+
+// Predictions collected for one slot: those at stop_id on route_id
+// ("" == any route).
+typedef struct {
+    const char *stop_id;
+    const char *route_id;
+} mbta_stream_slot_t;
+
+// Called from the stream task. event_us is the low 32 bits of
+// esp_timer_get_time() when the first byte of the triggering event arrived.
+typedef void (*mbta_stream_changed_cb_t)(uint32_t event_us, void *ctx);
+
+// Start the stream task (once). `url` must ask for the predictions of
+// every slot's stop; url and slots must stay valid. The task connects while
+// streaming is enabled and WiFi is up, and reconnects with backoff.
+bool MBTA_StreamStart(const char *url, const mbta_stream_slot_t *slots, int slot_count,
+                      mbta_stream_changed_cb_t on_changed, void *ctx);
+
+// Open (true) or close (false) the stream, e.g. outside display hours.
+void MBTA_StreamSetEnabled(bool enabled);
+
+// Copy the earliest arrival epochs of `slot` (ascending). Returns false
+// while the stream is not connected or has not received its initial reset
+// yet.
+bool MBTA_StreamGetEpochs(int slot, time_t *out_epochs, int max_epochs, int *out_count);
+
+#ifdef __cplusplus
+}
+#endif
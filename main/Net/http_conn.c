@@ -0,0 +1,696 @@
+#include "http_conn.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp_crt_bundle.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_tls.h"
+
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+#include "mbedtls/ssl.h"
+#endif
+
+#define HTTP_CONN_RX_BYTES     (512)
+#define HTTP_CONN_LINE_BYTES   (256)
+#define HTTP_CONN_REQ_BYTES    (640)
+#define HTTP_CONN_HOST_MAX     (64)
+#define HTTP_CONN_USER_AGENT   "mbta-lcd/1.0"
+
+static const char *TAG = "HTTP";
+
+typedef struct {
+    char host[HTTP_CONN_HOST_MAX];
+    int port;
+    esp_tls_t *tls;
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    // Last negotiated session, offered on the next connect.
+    esp_tls_client_session_t *session;
+    uint32_t session_tag;
+#endif
+    int64_t last_used_us;
+    SemaphoreHandle_t mu;
+    http_conn_stats_t stats;
+} http_conn_t;
+
+static SemaphoreHandle_t s_pool_mu;
+static http_conn_t s_pool[HTTP_CONN_MAX_HOSTS];
+
+typedef struct {
+    esp_tls_t *tls;
+    char buf[HTTP_CONN_RX_BYTES];
+    size_t pos;
+    size_t len;
+    int64_t deadline_us;
+    int64_t timeout_us;
+    bool got_bytes;
+} http_rx_t;
+
+typedef enum {
+    BODY_NONE = 0,
+    BODY_LENGTH,
+    BODY_CHUNKED,
+    BODY_UNTIL_CLOSE,
+} body_framing_t;
+
+typedef struct {
+    int status;
+    bool http11;
+    bool conn_close;
+    body_framing_t framing;
+    size_t content_len;
+} http_resp_t;
+
+static int64_t now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static bool parse_url(const char *url, char *host, size_t host_size, int *port, const char **path)
+{
+    static const char prefix[] = "https://";
+    if (url == NULL || strncmp(url, prefix, sizeof(prefix) - 1) != 0) {
+        return false;
+    }
+
+    const char *h = url + sizeof(prefix) - 1;
+    const char *slash = strchr(h, '/');
+    const char *end = slash ? slash : h + strlen(h);
+    const char *colon = memchr(h, ':', (size_t)(end - h));
+    const char *host_end = colon ? colon : end;
+
+    size_t n = (size_t)(host_end - h);
+    if (n == 0 || n >= host_size) {
+        return false;
+    }
+    memcpy(host, h, n);
+    host[n] = '\0';
+
+    *port = colon ? atoi(colon + 1) : 443;
+    *path = slash ? slash : "/";
+    return *port > 0;
+}
+
+static void conn_drop(http_conn_t *c)
+{
+    if (c->tls != NULL) {
+        esp_tls_conn_destroy(c->tls);
+        c->tls = NULL;
+    }
+}
+
+static void conn_forget_session(http_conn_t *c)
+{
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    if (c->session != NULL) {
+        esp_tls_free_client_session(c->session);
+        c->session = NULL;
+        c->session_tag = 0;
+    }
+#else
+    (void)c;
+#endif
+}
+
+// Find (or claim) the pool slot for a host. Evicts the least recently used
+// host if the pool is full.
+static http_conn_t *conn_for_host(const char *host, int port)
+{
+    xSemaphoreTake(s_pool_mu, portMAX_DELAY);
+
+    http_conn_t *found = NULL;
+    http_conn_t *free_slot = NULL;
+    http_conn_t *lru = NULL;
+    for (int i = 0; i < HTTP_CONN_MAX_HOSTS; i++) {
+        http_conn_t *c = &s_pool[i];
+        if (c->host[0] == '\0') {
+            if (free_slot == NULL) {
+                free_slot = c;
+            }
+            continue;
+        }
+        if (c->port == port && strcmp(c->host, host) == 0) {
+            found = c;
+            break;
+        }
+        if (lru == NULL || c->last_used_us < lru->last_used_us) {
+            lru = c;
+        }
+    }
+
+    if (found == NULL) {
+        found = free_slot ? free_slot : lru;
+        xSemaphoreTake(found->mu, portMAX_DELAY);
+        conn_drop(found);
+        conn_forget_session(found);
+        strlcpy(found->host, host, sizeof(found->host));
+        found->port = port;
+        memset(&found->stats, 0, sizeof(found->stats));
+        xSemaphoreGive(found->mu);
+    }
+
+    xSemaphoreGive(s_pool_mu);
+    return found;
+}
+
+// Close idle connections to other hosts until `c` can connect within
+// HTTP_CONN_MAX_OPEN. Called with c->mu held, so the others are only
+// try-locked; one busy in another request is left alone.
+static void conn_limit_open(const http_conn_t *c)
+{
+    while (1) {
+        int open = 1;
+        http_conn_t *lru = NULL;
+        for (int i = 0; i < HTTP_CONN_MAX_HOSTS; i++) {
+            http_conn_t *o = &s_pool[i];
+            if (o == c || o->tls == NULL) {
+                continue;
+            }
+            open++;
+            if (lru == NULL || o->last_used_us < lru->last_used_us) {
+                lru = o;
+            }
+        }
+        if (open <= HTTP_CONN_MAX_OPEN || lru == NULL || xSemaphoreTake(lru->mu, 0) != pdTRUE) {
+            break;
+        }
+        ESP_LOGD(TAG, "%s: closing idle connection", lru->host);
+        conn_drop(lru);
+        xSemaphoreGive(lru->mu);
+    }
+}
+
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+// esp-tls does not report whether the server took the offered session. A
+// resumed TLS 1.2 session keeps the master secret of the one offered while
+// a full handshake derives a new one, so compare a digest of it.
+static uint32_t session_tag(esp_tls_t *tls)
+{
+    const mbedtls_ssl_context *ssl = esp_tls_get_ssl_context(tls);
+    if (ssl == NULL || ssl->MBEDTLS_PRIVATE(session) == NULL) {
+        return 0;
+    }
+    const unsigned char *m = ssl->MBEDTLS_PRIVATE(session)->MBEDTLS_PRIVATE(master);
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < sizeof(ssl->MBEDTLS_PRIVATE(session)->MBEDTLS_PRIVATE(master)); i++) {
+        h = (h ^ m[i]) * 16777619u;
+    }
+    return h;
+}
+#endif
+
+static esp_err_t conn_handshake(http_conn_t *c, int timeout_ms, bool resume, uint32_t *out_ms)
+{
+    esp_tls_cfg_t cfg = {
+        .crt_bundle_attach = esp_crt_bundle_attach,
+        .timeout_ms = timeout_ms,
+    };
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    if (resume) {
+        cfg.client_session = c->session;
+    }
+#endif
+
+    esp_tls_t *tls = esp_tls_init();
+    if (tls == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    int64_t t0 = now_ms();
+    int ok = esp_tls_conn_new_sync(c->host, (int)strlen(c->host), c->port, &cfg, tls);
+    uint32_t ms = (uint32_t)(now_ms() - t0);
+    *out_ms += ms;
+
+    if (ok != 1) {
+        ESP_LOGW(TAG, "TLS connect to %s failed (resume=%d)", c->host, (int)resume);
+        esp_tls_conn_destroy(tls);
+        return ESP_FAIL;
+    }
+
+    bool resumed = false;
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    uint32_t tag = session_tag(tls);
+    resumed = resume && tag != 0 && tag == c->session_tag;
+#endif
+
+    c->tls = tls;
+    c->stats.handshakes++;
+    c->stats.last_handshake_ms = ms;
+    c->stats.total_handshake_ms += ms;
+    if (resume) {
+        c->stats.resume_attempts++;
+    }
+    if (resumed) {
+        c->stats.resumed++;
+        c->stats.resume_handshake_ms += ms;
+    } else {
+        c->stats.full_handshakes++;
+        c->stats.full_handshake_ms += ms;
+    }
+
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    // Keep the freshest session (the server may have issued a new ticket).
+    esp_tls_client_session_t *session = esp_tls_get_client_session(tls);
+    if (session != NULL) {
+        conn_forget_session(c);
+        c->session = session;
+        c->session_tag = tag;
+    }
+#endif
+    return ESP_OK;
+}
+
+static esp_err_t conn_connect(http_conn_t *c, int timeout_ms, uint32_t *out_ms)
+{
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    if (c->session != NULL) {
+        if (conn_handshake(c, timeout_ms, true, out_ms) == ESP_OK) {
+            return ESP_OK;
+        }
+        // A stale or rejected ticket must not wedge the host; fall back to a
+        // full handshake once.
+        c->stats.resume_failures++;
+        conn_forget_session(c);
+    }
+#endif
+    return conn_handshake(c, timeout_ms, false, out_ms);
+}
+
+static int rx_fill(http_rx_t *rx)
+{
+    while (1) {
+        ssize_t r = esp_tls_conn_read(rx->tls, rx->buf, sizeof(rx->buf));
+        if (r > 0) {
+            rx->pos = 0;
+            rx->len = (size_t)r;
+            rx->got_bytes = true;
+            // The timeout is an idle timeout, like esp_http_client's.
+            rx->deadline_us = esp_timer_get_time() + rx->timeout_us;
+            return (int)r;
+        }
+        if (r == ESP_TLS_ERR_SSL_WANT_READ || r == ESP_TLS_ERR_SSL_WANT_WRITE) {
+            if (esp_timer_get_time() > rx->deadline_us) {
+                return -1;
+            }
+            continue;
+        }
+        // 0 == closed by peer, < 0 == error
+        return (int)r;
+    }
+}
+
+// Read one CRLF-terminated line (CRLF stripped). Overlong lines are truncated
+// but fully consumed. Returns the line length or -1 on EOF/error.
+static int rx_line(http_rx_t *rx, char *line, size_t size)
+{
+    size_t n = 0;
+    while (1) {
+        if (rx->pos == rx->len && rx_fill(rx) <= 0) {
+            return -1;
+        }
+        char ch = rx->buf[rx->pos++];
+        if (ch == '\n') {
+            break;
+        }
+        if (ch != '\r' && n + 1 < size) {
+            line[n++] = ch;
+        }
+    }
+    line[n] = '\0';
+    return (int)n;
+}
+
+// Pass `len` body bytes to the callback (or discard them if cb is NULL).
+// len == SIZE_MAX reads until the peer closes.
+static esp_err_t rx_body(http_rx_t *rx, size_t len, http_conn_body_cb_t cb, void *ctx)
+{
+    while (len > 0) {
+        if (rx->pos == rx->len) {
+            int r = rx_fill(rx);
+            if (r == 0 && len == SIZE_MAX) {
+                return ESP_OK;
+            }
+            if (r <= 0) {
+                return ESP_FAIL;
+            }
+        }
+        size_t take = rx->len - rx->pos;
+        if (take > len) {
+            take = len;
+        }
+        if (cb != NULL && !cb(rx->buf + rx->pos, take, ctx)) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        rx->pos += take;
+        if (len != SIZE_MAX) {
+            len -= take;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t rx_headers(http_rx_t *rx, http_resp_t *resp, const http_conn_request_t *req)
+{
+    char line[HTTP_CONN_LINE_BYTES];
+
+    if (rx_line(rx, line, sizeof(line)) < 0) {
+        return ESP_FAIL;
+    }
+    int major = 0, minor = 0;
+    if (sscanf(line, "HTTP/%d.%d %d", &major, &minor, &resp->status) != 3) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    resp->http11 = (major > 1) || (major == 1 && minor >= 1);
+    resp->conn_close = !resp->http11;
+    resp->framing = BODY_UNTIL_CLOSE;
+
+    while (1) {
+        int n = rx_line(rx, line, sizeof(line));
+        if (n < 0) {
+            return ESP_FAIL;
+        }
+        if (n == 0) {
+            break;
+        }
+
+        char *colon = strchr(line, ':');
+        if (colon == NULL) {
+            continue;
+        }
+        *colon = '\0';
+        const char *value = colon + 1;
+        while (*value == ' ' || *value == '\t') {
+            value++;
+        }
+
+        if (strcasecmp(line, "Content-Length") == 0) {
+            if (resp->framing != BODY_CHUNKED) {
+                resp->framing = BODY_LENGTH;
+                resp->content_len = (size_t)strtoul(value, NULL, 10);
+            }
+        } else if (strcasecmp(line, "Transfer-Encoding") == 0) {
+            if (strstr(value, "chunked") != NULL) {
+                resp->framing = BODY_CHUNKED;
+            }
+        } else if (strcasecmp(line, "Connection") == 0) {
+            if (strcasecmp(value, "close") == 0) {
+                resp->conn_close = true;
+            } else if (strcasecmp(value, "keep-alive") == 0) {
+                resp->conn_close = false;
+            }
+        }
+
+        if (req->on_header != NULL) {
+            req->on_header(line, value, req->ctx);
+        }
+    }
+
+    // No body for 1xx/204/304.
+    if ((resp->status >= 100 && resp->status < 200) || resp->status == 204 || resp->status == 304) {
+        resp->framing = BODY_NONE;
+    }
+    if (resp->framing == BODY_UNTIL_CLOSE) {
+        resp->conn_close = true;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t rx_chunked(http_rx_t *rx, http_conn_body_cb_t cb, void *ctx)
+{
+    char line[32];
+    while (1) {
+        if (rx_line(rx, line, sizeof(line)) < 0) {
+            return ESP_FAIL;
+        }
+        size_t size = (size_t)strtoul(line, NULL, 16);
+        if (size == 0) {
+            break;
+        }
+        esp_err_t err = rx_body(rx, size, cb, ctx);
+        if (err != ESP_OK) {
+            return err;
+        }
+        // CRLF after chunk data
+        if (rx_line(rx, line, sizeof(line)) != 0) {
+            return ESP_FAIL;
+        }
+    }
+
+    // Trailers, terminated by an empty line.
+    int n;
+    do {
+        n = rx_line(rx, line, sizeof(line));
+    } while (n > 0);
+    return (n == 0) ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t send_all(esp_tls_t *tls, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t w = esp_tls_conn_write(tls, data, len);
+        if (w == ESP_TLS_ERR_SSL_WANT_READ || w == ESP_TLS_ERR_SSL_WANT_WRITE) {
+            continue;
+        }
+        if (w <= 0) {
+            return ESP_FAIL;
+        }
+        data += w;
+        len -= (size_t)w;
+    }
+    return ESP_OK;
+}
+
+// One request/response exchange on an open connection. *out_keep tells
+// whether the connection can serve another request.
+static esp_err_t conn_exchange(http_conn_t *c, const http_conn_request_t *req, const char *path,
+                               http_rx_t *rx, http_resp_t *resp, bool *out_keep)
+{
+    *out_keep = false;
+
+    char request[HTTP_CONN_REQ_BYTES];
+    int n = snprintf(request, sizeof(request),
+                     "GET %s HTTP/1.1\r\n"
+                     "Host: %s\r\n"
+                     "User-Agent: " HTTP_CONN_USER_AGENT "\r\n"
+                     "Connection: keep-alive\r\n"
+                     "%s"
+                     "\r\n",
+                     path, c->host, req->extra_headers ? req->extra_headers : "");
+    if (n < 0 || n >= (int)sizeof(request)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t err = send_all(c->tls, request, (size_t)n);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    rx->tls = c->tls;
+    rx->pos = 0;
+    rx->len = 0;
+    rx->got_bytes = false;
+    rx->timeout_us = (int64_t)req->timeout_ms * 1000;
+    rx->deadline_us = esp_timer_get_time() + rx->timeout_us;
+
+    memset(resp, 0, sizeof(*resp));
+    err = rx_headers(rx, resp, req);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Error bodies are drained (to keep the connection) but not delivered.
+    bool deliver = resp->status >= 200 && resp->status < 300;
+    http_conn_body_cb_t cb = deliver ? req->on_body : NULL;
+
+    switch (resp->framing) {
+    case BODY_LENGTH:
+        err = rx_body(rx, resp->content_len, cb, req->ctx);
+        break;
+    case BODY_CHUNKED:
+        err = rx_chunked(rx, cb, req->ctx);
+        break;
+    case BODY_UNTIL_CLOSE:
+        err = rx_body(rx, SIZE_MAX, cb, req->ctx);
+        break;
+    case BODY_NONE:
+    default:
+        break;
+    }
+
+    *out_keep = (err == ESP_OK) && !resp->conn_close;
+    return err;
+}
+
+void HttpConn_Init(void)
+{
+    if (s_pool_mu != NULL) {
+        return;
+    }
+
+    for (int i = 0; i < HTTP_CONN_MAX_HOSTS; i++) {
+        s_pool[i].mu = xSemaphoreCreateMutex();
+    }
+    s_pool_mu = xSemaphoreCreateMutex();
+}
+
+esp_err_t HttpConn_Get(const http_conn_request_t *req, int *out_http_status)
+{
+    if (out_http_status) {
+        *out_http_status = 0;
+    }
+    if (req == NULL || s_pool_mu == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char host[HTTP_CONN_HOST_MAX];
+    int port = 0;
+    const char *path = NULL;
+    if (!parse_url(req->url, host, sizeof(host), &port, &path)) {
+        ESP_LOGW(TAG, "Unsupported URL: %s", req->url ? req->url : "(null)");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    http_conn_t *c = NULL;
+    while (1) {
+        c = conn_for_host(host, port);
+        xSemaphoreTake(c->mu, portMAX_DELAY);
+        // The slot may have been handed to another host between lookup and lock.
+        if (c->port == port && strcmp(c->host, host) == 0) {
+            break;
+        }
+        xSemaphoreGive(c->mu);
+    }
+
+    // Large enough to be worth keeping off the caller's stack for the whole exchange.
+    static http_rx_t s_rx[HTTP_CONN_MAX_HOSTS];
+    http_rx_t *rx = &s_rx[c - s_pool];
+
+    http_resp_t resp;
+    esp_err_t err = ESP_FAIL;
+    bool keep = false;
+    bool reused = false;
+    uint32_t handshake_ms = 0;
+    int64_t t0 = now_ms();
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        reused = (c->tls != NULL);
+        if (!reused) {
+            conn_limit_open(c);
+            err = conn_connect(c, req->timeout_ms, &handshake_ms);
+            if (err != ESP_OK) {
+                break;
+            }
+        }
+
+        err = conn_exchange(c, req, path, rx, &resp, &keep);
+        if (err == ESP_OK || !reused || rx->got_bytes) {
+            break;
+        }
+
+        // The server closed the idle keep-alive connection before we noticed.
+        // Nothing was delivered yet, so reconnect and retry once.
+        ESP_LOGI(TAG, "%s: keep-alive connection closed by peer, reconnecting", c->host);
+        c->stats.stale_reconnects++;
+        conn_drop(c);
+    }
+
+    if (!keep) {
+        conn_drop(c);
+    }
+
+    uint32_t total_ms = (uint32_t)(now_ms() - t0);
+    c->stats.requests++;
+    if (reused) {
+        c->stats.reused++;
+    }
+    // Request time excludes the handshake when one happened.
+    uint32_t request_ms = total_ms - handshake_ms;
+    c->stats.last_request_ms = request_ms;
+    c->stats.total_request_ms += request_ms;
+    c->last_used_us = esp_timer_get_time();
+
+    if (err == ESP_OK && out_http_status) {
+        *out_http_status = resp.status;
+    }
+
+    ESP_LOGI(TAG, "%s: status=%d reused=%d handshake=%ums request=%ums (%u full + %u resumed handshakes / %u requests)",
+             c->host, (err == ESP_OK) ? resp.status : -1, (int)reused,
+             (unsigned)handshake_ms, (unsigned)request_ms,
+             (unsigned)c->stats.full_handshakes, (unsigned)c->stats.resumed,
+             (unsigned)c->stats.requests);
+
+    xSemaphoreGive(c->mu);
+    return err;
+}
+
+esp_err_t HttpConn_Stream(const http_conn_request_t *req, int *out_http_status)
+{
+    if (out_http_status) {
+        *out_http_status = 0;
+    }
+    if (req == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Not pooled: a stream holds its connection indefinitely and must not
+    // block polled requests to the same host.
+    http_conn_t c = {0};
+    const char *path = NULL;
+    if (!parse_url(req->url, c.host, sizeof(c.host), &c.port, &path)) {
+        ESP_LOGW(TAG, "Unsupported URL: %s", req->url ? req->url : "(null)");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    http_rx_t *rx = calloc(1, sizeof(http_rx_t));
+    if (rx == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint32_t handshake_ms = 0;
+    esp_err_t err = conn_handshake(&c, req->timeout_ms, false, &handshake_ms);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "%s: stream opened (handshake=%ums)", c.host, (unsigned)handshake_ms);
+
+        http_resp_t resp = {0};
+        bool keep = false;
+        err = conn_exchange(&c, req, path, rx, &resp, &keep);
+        // status stays 0 unless the exchange got as far as the status line.
+        if (resp.status != 0 && out_http_status) {
+            *out_http_status = resp.status;
+        }
+        conn_drop(&c);
+    }
+
+    conn_forget_session(&c);
+    free(rx);
+    return err;
+}
+
+bool HttpConn_GetStats(const char *host, http_conn_stats_t *out_stats)
+{
+    if (host == NULL || out_stats == NULL || s_pool_mu == NULL) {
+        return false;
+    }
+
+    bool ok = false;
+    xSemaphoreTake(s_pool_mu, portMAX_DELAY);
+    for (int i = 0; i < HTTP_CONN_MAX_HOSTS; i++) {
+        if (strcmp(s_pool[i].host, host) == 0) {
+            xSemaphoreTake(s_pool[i].mu, portMAX_DELAY);
+            *out_stats = s_pool[i].stats;
+            xSemaphoreGive(s_pool[i].mu);
+            ok = true;
+            break;
+        }
+    }
+    xSemaphoreGive(s_pool_mu);
+    return ok;
+}
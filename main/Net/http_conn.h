@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Persistent HTTPS connections shared by all fetchers.
+//
+// One TLS connection per host is kept open between requests (HTTP/1.1
+// keep-alive), so a poll only pays for the handshake when the server has
+// dropped the connection. Requests to the same host are serialized.
+//
+// When the server does drop it, the last TLS session (ticket / session id)
+// for that host is offered on reconnect so the server can resume it instead
+// of running a full ECDHE exchange and certificate chain verification.
+
+//
+// Only HTTP_CONN_MAX_OPEN connections stay open at once: connecting to a
+// host first closes the least recently used idle one (its session is kept
+// for resumption), so idle sockets do not pin mbedTLS buffers.
+
+#define HTTP_CONN_MAX_HOSTS 2
+
+#ifndef HTTP_CONN_MAX_OPEN
+#define HTTP_CONN_MAX_OPEN 1
+#endif
+
+// Receives 2xx response bodies as they come off the socket.
+// Return false to abort the request (the connection is then dropped).
+typedef bool (*http_conn_body_cb_t)(const char *data, size_t len, void *ctx);
+
+// Receives each response header (name without the colon, trimmed value).
+typedef void (*http_conn_header_cb_t)(const char *name, const char *value, void *ctx);
+
+typedef struct {
+    const char *url;          // https://host[:port]/path?query
+    int timeout_ms;
+    const char *extra_headers; // optional, each line terminated by "\r\n"
+    http_conn_header_cb_t on_header;
+    http_conn_body_cb_t on_body;
+    void *ctx;
+} http_conn_request_t;
+
+typedef struct {
+    uint32_t requests;
+    uint32_t handshakes;
+    uint32_t reused;          // requests served on an already-open connection
+    uint32_t stale_reconnects; // reused connection found closed by the server
+    uint32_t last_handshake_ms;
+    uint32_t last_request_ms;
+    uint32_t total_handshake_ms;
+    uint32_t total_request_ms;
+
+    // Handshakes split by whether the server resumed the cached session.
+    uint32_t full_handshakes;  // including those where it declined it
+    uint32_t resumed;
+    uint32_t resume_attempts;  // cached session offered
+    uint32_t resume_failures;  // offered session failed the connect, retried without
+    uint32_t full_handshake_ms;
+    uint32_t resume_handshake_ms;
+} http_conn_stats_t;
+
+void HttpConn_Init(void);
+
+// Perform a GET (fetchers go through net_service.h instead). Returns ESP_OK once the full response was read (check
+// out_http_status), ESP_ERR_INVALID_RESPONSE if on_body aborted, or another
+// error on connection/protocol failure.
+esp_err_t HttpConn_Get(const http_conn_request_t *req, int *out_http_status);
+
+// Open a dedicated connection (outside the pool) and deliver the body until
+// the server closes it or on_body returns false, e.g. for text/event-stream.
+// timeout_ms is an idle timeout here: the stream fails if nothing arrives
+// for that long. Blocks for the lifetime of the stream.
+esp_err_t HttpConn_Stream(const http_conn_request_t *req, int *out_http_status);
+
+// Snapshot counters for a host (e.g. "api-v3.mbta.com"). Returns false if unknown.
+bool HttpConn_GetStats(const char *host, http_conn_stats_t *out_stats);
+
+#ifdef __cplusplus
+}
+#endif
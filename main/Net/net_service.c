@@ -0,0 +1,299 @@
+#include "net_service.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#include "Wireless.h"
+#include "time_sync.h"
+
+#define NET_SERVICE_MAX_JOBS   (8)
+// Sized for a TLS handshake plus the body parsers running in callbacks.
+#define NET_SERVICE_TASK_STACK (8192)
+#define NET_SERVICE_TASK_PRIO  (3)
+// How long a request waits for SNTP before trying TLS anyway.
+#define NET_SERVICE_TIME_WAIT_MS (10000)
+
+static const char *TAG = "NET";
+
+typedef enum {
+    SLOT_FREE = 0,
+    SLOT_QUEUED,
+    SLOT_RUNNING,
+} slot_state_t;
+
+typedef struct {
+    net_job_t job;
+    slot_state_t state;
+    uint32_t seq;
+    int64_t start_us;
+    int64_t deadline_us; // 0 == none
+
+    // NetService_Get: the caller waits on `done`, then frees the slot.
+    bool sync;
+    SemaphoreHandle_t done;
+    esp_err_t err;
+    int http_status;
+} net_slot_t;
+
+static SemaphoreHandle_t s_mu;
+static SemaphoreHandle_t s_wake;
+static net_slot_t s_slots[NET_SERVICE_MAX_JOBS];
+static uint32_t s_seq;
+static net_service_stats_t s_stats;
+
+// True if a should run before b.
+static bool slot_before(const net_slot_t *a, const net_slot_t *b)
+{
+    if (a->job.prio != b->job.prio) {
+        return a->job.prio > b->job.prio;
+    }
+    if (a->deadline_us != b->deadline_us) {
+        if (a->deadline_us == 0 || b->deadline_us == 0) {
+            return b->deadline_us == 0;
+        }
+        return a->deadline_us < b->deadline_us;
+    }
+    return (int32_t)(a->seq - b->seq) < 0;
+}
+
+// Next job to run, marked running; *expired if it missed its deadline.
+// Otherwise NULL, with *wake_us set to the earliest delayed start.
+static net_slot_t *net_pick(int64_t now_us, int64_t *wake_us, bool *expired)
+{
+    net_slot_t *best = NULL;
+    *expired = false;
+
+    xSemaphoreTake(s_mu, portMAX_DELAY);
+    for (int i = 0; i < NET_SERVICE_MAX_JOBS; i++) {
+        net_slot_t *s = &s_slots[i];
+        if (s->state != SLOT_QUEUED) {
+            continue;
+        }
+        if (s->deadline_us != 0 && now_us > s->deadline_us) {
+            best = s;
+            *expired = true;
+            break;
+        }
+        if (s->start_us > now_us) {
+            if (s->start_us < *wake_us) {
+                *wake_us = s->start_us;
+            }
+            continue;
+        }
+        if (best == NULL || slot_before(s, best)) {
+            best = s;
+        }
+    }
+    if (best != NULL) {
+        best->state = SLOT_RUNNING;
+    }
+    xSemaphoreGive(s_mu);
+    return best;
+}
+
+static void net_complete(net_slot_t *s, esp_err_t err, int http_status)
+{
+    if (s->sync) {
+        s->err = err;
+        s->http_status = http_status;
+        xSemaphoreGive(s->done);
+        return;
+    }
+
+    // Free the slot first: on_done usually queues the next run.
+    net_job_t job = s->job;
+    xSemaphoreTake(s_mu, portMAX_DELAY);
+    s->state = SLOT_FREE;
+    xSemaphoreGive(s_mu);
+    if (job.on_done != NULL) {
+        job.on_done(err, http_status, job.req.ctx);
+    }
+}
+
+static void net_run(net_slot_t *s, int64_t now_us)
+{
+    // Avoid touching LWIP (DNS/TLS) until WiFi is connected, otherwise
+    // tcpip_send_msg_wait_sem can assert with "Invalid mbox".
+    if (Wireless_GetStatus() != WIRELESS_STATUS_CONNECTED) {
+        net_complete(s, ESP_ERR_INVALID_STATE, 0);
+        return;
+    }
+
+    // Certificate validity checks need the real date.
+    if (!TimeSync_Wait(NET_SERVICE_TIME_WAIT_MS)) {
+        ESP_LOGW(TAG, "Time not synced (TLS may fail)");
+    }
+
+    uint32_t wait_ms = (uint32_t)((now_us - s->start_us) / 1000);
+    if (s_stats.jobs == 0) {
+        ESP_LOGI(TAG, "First request %u ms after boot (waited %u ms)",
+                 (unsigned)(esp_timer_get_time() / 1000), (unsigned)wait_ms);
+    }
+    if (s->job.on_start != NULL) {
+        s->job.on_start(s->job.req.ctx);
+    }
+
+    uint32_t heap_before = esp_get_free_heap_size();
+    int http_status = 0;
+    esp_err_t err = HttpConn_Get(&s->job.req, &http_status);
+    uint32_t heap_after = esp_get_free_heap_size();
+    uint32_t heap_min = esp_get_minimum_free_heap_size();
+    uint32_t stack_free = (uint32_t)uxTaskGetStackHighWaterMark(NULL);
+
+    xSemaphoreTake(s_mu, portMAX_DELAY);
+    s_stats.jobs++;
+    if (wait_ms > s_stats.max_wait_ms) {
+        s_stats.max_wait_ms = wait_ms;
+    }
+    bool new_low = s_stats.min_free_heap == 0 || heap_min < s_stats.min_free_heap;
+    s_stats.min_free_heap = heap_min;
+    s_stats.stack_free_min = stack_free;
+    xSemaphoreGive(s_mu);
+
+    ESP_LOGD(TAG, "prio %d job: waited %u ms, heap %u -> %u B", (int)s->job.prio, (unsigned)wait_ms,
+             (unsigned)heap_before, (unsigned)heap_after);
+    if (new_low) {
+        ESP_LOGI(TAG, "heap low-water %u B (stack free %u B) after prio %d job", (unsigned)heap_min,
+                 (unsigned)stack_free, (int)s->job.prio);
+    }
+
+    net_complete(s, err, http_status);
+}
+
+static void net_task(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        int64_t now_us = esp_timer_get_time();
+        int64_t wake_us = INT64_MAX;
+        bool expired = false;
+        net_slot_t *s = net_pick(now_us, &wake_us, &expired);
+
+        if (s == NULL) {
+            TickType_t ticks = portMAX_DELAY;
+            if (wake_us != INT64_MAX) {
+                ticks = pdMS_TO_TICKS((wake_us - now_us + 999) / 1000) + 1;
+            }
+            xSemaphoreTake(s_wake, ticks);
+            continue;
+        }
+
+        if (expired) {
+            ESP_LOGW(TAG, "prio %d job dropped: deadline missed", (int)s->job.prio);
+            xSemaphoreTake(s_mu, portMAX_DELAY);
+            s_stats.dropped++;
+            xSemaphoreGive(s_mu);
+            net_complete(s, ESP_ERR_TIMEOUT, 0);
+            continue;
+        }
+        net_run(s, now_us);
+    }
+}
+
+static net_slot_t *net_enqueue(const net_job_t *job, bool sync)
+{
+    if (s_mu == NULL) {
+        return NULL;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    net_slot_t *s = NULL;
+    xSemaphoreTake(s_mu, portMAX_DELAY);
+    for (int i = 0; i < NET_SERVICE_MAX_JOBS; i++) {
+        if (s_slots[i].state == SLOT_FREE) {
+            s = &s_slots[i];
+            break;
+        }
+    }
+    if (s != NULL) {
+        s->job = *job;
+        s->state = SLOT_QUEUED;
+        s->seq = s_seq++;
+        s->start_us = now_us + (int64_t)job->delay_ms * 1000;
+        s->deadline_us = job->deadline_ms ? now_us + (int64_t)job->deadline_ms * 1000 : 0;
+        s->sync = sync;
+    }
+    xSemaphoreGive(s_mu);
+
+    if (s == NULL) {
+        ESP_LOGE(TAG, "job queue full");
+        return NULL;
+    }
+    xSemaphoreGive(s_wake);
+    return s;
+}
+
+void NetService_Start(void)
+{
+    // Start only once
+    if (s_mu != NULL) {
+        return;
+    }
+
+    for (int i = 0; i < NET_SERVICE_MAX_JOBS; i++) {
+        s_slots[i].done = xSemaphoreCreateBinary();
+    }
+    s_wake = xSemaphoreCreateBinary();
+    s_mu = xSemaphoreCreateMutex();
+
+    ESP_LOGI(TAG, "free heap before the first job: %u B", (unsigned)esp_get_free_heap_size());
+    xTaskCreatePinnedToCore(net_task, "net", NET_SERVICE_TASK_STACK, NULL, NET_SERVICE_TASK_PRIO, NULL, 0);
+}
+
+bool NetService_Submit(const net_job_t *job)
+{
+    return job != NULL && net_enqueue(job, false) != NULL;
+}
+
+esp_err_t NetService_Get(const http_conn_request_t *req, net_prio_t prio, uint32_t deadline_ms,
+                         int *out_http_status)
+{
+    if (out_http_status) {
+        *out_http_status = 0;
+    }
+    if (req == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    net_job_t job = {
+        .req = *req,
+        .prio = prio,
+        .deadline_ms = deadline_ms,
+    };
+    net_slot_t *s = net_enqueue(&job, true);
+    if (s == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s->done, portMAX_DELAY);
+    esp_err_t err = s->err;
+    if (out_http_status) {
+        *out_http_status = s->http_status;
+    }
+    xSemaphoreTake(s_mu, portMAX_DELAY);
+    s->state = SLOT_FREE;
+    xSemaphoreGive(s_mu);
+    return err;
+}
+
+void NetService_GetStats(net_service_stats_t *out_stats)
+{
+    if (out_stats == NULL) {
+        return;
+    }
+    memset(out_stats, 0, sizeof(*out_stats));
+    if (s_mu == NULL) {
+        return;
+    }
+    xSemaphoreTake(s_mu, portMAX_DELAY);
+    *out_stats = s_stats;
+    xSemaphoreGive(s_mu);
+}
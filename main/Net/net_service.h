@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "http_conn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Single task that owns the HTTPS stack (see http_conn.h).
+//
+// Fetchers queue jobs instead of calling HttpConn_Get from their own tasks,
+// so only one TLS exchange (and its mbedTLS buffers) is ever in flight and
+// no other task needs a stack sized for a handshake. Jobs run one at a time:
+// highest priority first, then earliest deadline, then submission order.
+// A running job is never interrupted.
+//
+// Body and header callbacks, on_start and on_done all run on the service
+// task. Everything a job points to must stay valid until on_done.
+
+typedef enum {
+    NET_PRIO_LOW = 0, // weather, alerts
+    NET_PRIO_NORMAL,  // daily schedule
+    NET_PRIO_HIGH,    // predictions
+} net_prio_t;
+
+// Called right before the request is sent.
+typedef void (*net_start_cb_t)(void *ctx);
+
+// Called once per job with the HttpConn_Get result. err is ESP_ERR_TIMEOUT
+// if the job missed its deadline, ESP_ERR_INVALID_STATE if WiFi was down.
+typedef void (*net_done_cb_t)(esp_err_t err, int http_status, void *ctx);
+
+typedef struct {
+    http_conn_request_t req;
+    net_prio_t prio;
+    uint32_t delay_ms;     // earliest start, from submission
+    uint32_t deadline_ms;  // dropped if not started by then (from submission, 0 == none)
+    net_start_cb_t on_start;
+    net_done_cb_t on_done;
+} net_job_t;
+
+typedef struct {
+    uint32_t jobs;
+    uint32_t dropped;         // deadline missed
+    uint32_t max_wait_ms;     // longest time a due job waited for the service
+    uint32_t min_free_heap;   // lowest free heap seen right after a job
+    uint32_t stack_free_min;  // service task stack high-water mark (bytes)
+} net_service_stats_t;
+
+// Starts the service task (once). Call after HttpConn_Init().
+void NetService_Start(void);
+
+// Queue a job (copied). Returns false if the queue is full.
+bool NetService_Submit(const net_job_t *job);
+
+// Queue a request and wait for it; same results as HttpConn_Get, plus the
+// on_done errors above.
+esp_err_t NetService_Get(const http_conn_request_t *req, net_prio_t prio, uint32_t deadline_ms,
+                         int *out_http_status);
+
+void NetService_GetStats(net_service_stats_t *out_stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,58 @@
+#include "seqlock.h"
+
+#include <string.h>
+
+void seqlock_init(seqlock_t *sl, void *bufs, size_t size)
+{
+    memset(bufs, 0, 2 * size);
+    sl->buf[0] = bufs;
+    sl->buf[1] = (char *)bufs + size;
+    sl->size = size;
+    atomic_store_explicit(&sl->seq, 0, memory_order_release);
+}
+
+void *seqlock_write_begin(seqlock_t *sl)
+{
+    unsigned seq = atomic_load_explicit(&sl->seq, memory_order_relaxed);
+    unsigned latest = (seq >> 1) & 1;
+    void *next = sl->buf[latest ^ 1];
+
+    // Mark the publish as started before touching the copy: a reader still
+    // on that copy from two publishes ago must see it and retry.
+    atomic_store_explicit(&sl->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    memcpy(next, sl->buf[latest], sl->size);
+    return next;
+}
+
+void seqlock_write_end(seqlock_t *sl)
+{
+    unsigned seq = atomic_load_explicit(&sl->seq, memory_order_relaxed);
+    atomic_store_explicit(&sl->seq, seq + 1, memory_order_release);
+}
+
+uint32_t seqlock_read(const seqlock_t *sl, void *out)
+{
+    while (1) {
+        unsigned seq = atomic_load_explicit(&sl->seq, memory_order_acquire);
+        memcpy(out, sl->buf[(seq >> 1) & 1], sl->size);
+        atomic_thread_fence(memory_order_acquire);
+
+        // The copy just read is only rewritten by the publish after next,
+        // which starts when seq reaches (seq & ~1) + 3.
+        unsigned now = atomic_load_explicit(&sl->seq, memory_order_relaxed);
+        if (now - (seq & ~1u) < 3) {
+            return seq >> 1;
+        }
+    }
+}
+
+bool seqlock_read_if_changed(const seqlock_t *sl, void *out, uint32_t *seen)
+{
+    if (seqlock_version(sl) == *seen) {
+        return false;
+    }
+    *seen = seqlock_read(sl, out);
+    return true;
+}
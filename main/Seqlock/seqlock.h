@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Single-writer state publication: a sequence counter over two copies of
+// the state. The writer edits the copy readers are not using and flips
+// to it when done. Readers never block and never see a half-written
+// state. They only retry when the writer got two publishes in during one
+// copy.
+//
+// One task writes (or writers serialize among themselves); any number of
+// tasks read. Not for ISRs.
+
+typedef struct {
+    // Even when idle, odd while a publish is in progress; (seq >> 1) is
+    // the number of completed publishes and its low bit picks the copy.
+    atomic_uint seq;
+    void *buf[2];
+    size_t size;
+} seqlock_t;
+
+// `bufs` holds two states of `size` bytes each; both are zeroed.
+void seqlock_init(seqlock_t *sl, void *bufs, size_t size);
+
+// Returns the copy to publish next, already holding the latest state.
+// Edit it in place, then call seqlock_write_end(). Writer only.
+void *seqlock_write_begin(seqlock_t *sl);
+void seqlock_write_end(seqlock_t *sl);
+
+// Copy the latest state into `out`. Returns its version (publish count).
+uint32_t seqlock_read(const seqlock_t *sl, void *out);
+
+// Version of the latest state, without copying it.
+static inline uint32_t seqlock_version(const seqlock_t *sl)
+{
+    return atomic_load_explicit(&sl->seq, memory_order_acquire) >> 1;
+}
+
+// Copy the latest state only if its version differs from *seen (which is
+// then updated). Returns true if `out` was written.
+bool seqlock_read_if_changed(const seqlock_t *sl, void *out, uint32_t *seen);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,124 @@
+#include "snapshot.h"
+
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+#ifndef SNAPSHOT_NVS_MIN_INTERVAL_MS
+#define SNAPSHOT_NVS_MIN_INTERVAL_MS (10 * 60 * 1000)
+#endif
+
+#define SNAPSHOT_MAGIC     0x534E4150u // "SNAP"
+#define SNAPSHOT_NAMESPACE "snapshot"
+
+static const char *TAG = "SNAPSHOT";
+
+static const char *const s_keys[SNAPSHOT_COUNT] = {"mbta", "weather"};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t checksum;
+    uint32_t size;
+    uint8_t data[SNAPSHOT_MAX_SIZE];
+} snapshot_slot_t;
+
+// Not cleared by the startup code: still valid after a software reset.
+static RTC_NOINIT_ATTR snapshot_slot_t s_rtc[SNAPSHOT_COUNT];
+
+// What NVS holds, and when it was last written (0 == not this boot).
+static struct {
+    uint8_t data[SNAPSHOT_MAX_SIZE];
+    uint32_t size;
+    int64_t written_us;
+} s_nvs[SNAPSHOT_COUNT];
+
+static uint32_t snapshot_checksum(const uint8_t *p, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static bool nvs_read(snapshot_id_t id, void *buf, size_t size)
+{
+    nvs_handle_t h;
+    if (nvs_open(SNAPSHOT_NAMESPACE, NVS_READONLY, &h) != ESP_OK) {
+        return false;
+    }
+    size_t len = size;
+    esp_err_t err = nvs_get_blob(h, s_keys[id], buf, &len);
+    nvs_close(h);
+    return err == ESP_OK && len == size;
+}
+
+static void nvs_write(snapshot_id_t id, const void *buf, size_t size)
+{
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(SNAPSHOT_NAMESPACE, NVS_READWRITE, &h);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(h, s_keys[id], buf, size);
+        if (err == ESP_OK) {
+            err = nvs_commit(h);
+        }
+        nvs_close(h);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "NVS write of %s failed (%s)", s_keys[id], esp_err_to_name(err));
+        return;
+    }
+    memcpy(s_nvs[id].data, buf, size);
+    s_nvs[id].size = (uint32_t)size;
+    s_nvs[id].written_us = esp_timer_get_time();
+}
+
+bool Snapshot_Load(snapshot_id_t id, void *buf, size_t size)
+{
+    if (id >= SNAPSHOT_COUNT || size > SNAPSHOT_MAX_SIZE) {
+        return false;
+    }
+
+    const snapshot_slot_t *rtc = &s_rtc[id];
+    if (rtc->magic == SNAPSHOT_MAGIC && rtc->size == size && rtc->checksum == snapshot_checksum(rtc->data, size)) {
+        memcpy(buf, rtc->data, size);
+        ESP_LOGI(TAG, "%s restored from RTC memory", s_keys[id]);
+        return true;
+    }
+
+    if (nvs_read(id, buf, size)) {
+        // Same content as NVS: no rewrite needed until it changes.
+        memcpy(s_nvs[id].data, buf, size);
+        s_nvs[id].size = (uint32_t)size;
+        ESP_LOGI(TAG, "%s restored from NVS", s_keys[id]);
+        return true;
+    }
+    return false;
+}
+
+void Snapshot_Save(snapshot_id_t id, const void *buf, size_t size)
+{
+    if (id >= SNAPSHOT_COUNT || size > SNAPSHOT_MAX_SIZE) {
+        return;
+    }
+
+    snapshot_slot_t *rtc = &s_rtc[id];
+    memcpy(rtc->data, buf, size);
+    rtc->size = (uint32_t)size;
+    rtc->checksum = snapshot_checksum(rtc->data, size);
+    rtc->magic = SNAPSHOT_MAGIC;
+
+    if (s_nvs[id].size == size && memcmp(s_nvs[id].data, buf, size) == 0) {
+        return;
+    }
+    // Changes in between are coalesced into the next write.
+    int64_t now_us = esp_timer_get_time();
+    if (s_nvs[id].written_us != 0 && now_us - s_nvs[id].written_us < (int64_t)SNAPSHOT_NVS_MIN_INTERVAL_MS * 1000) {
+        return;
+    }
+    nvs_write(id, buf, size);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Last-known state kept across resets, so the first frame after boot can
+// show something before WiFi, SNTP and the first fetch are done.
+//
+// Each save lands in RTC memory right away (survives software resets,
+// panics and watchdog resets). The NVS copy, needed after a power loss, is
+// only rewritten when the content changed and at most once per
+// SNAPSHOT_NVS_MIN_INTERVAL_MS per snapshot, to limit flash wear.
+
+typedef enum {
+    SNAPSHOT_MBTA = 0,
+    SNAPSHOT_WEATHER,
+    SNAPSHOT_COUNT,
+} snapshot_id_t;
+
+#define SNAPSHOT_MAX_SIZE 384
+
+// Copy the saved snapshot into buf (exactly `size` bytes). Returns false if
+// there is none of that size. NVS must be initialized for the fallback.
+bool Snapshot_Load(snapshot_id_t id, void *buf, size_t size);
+
+// Called by one task per id.
+void Snapshot_Save(snapshot_id_t id, const void *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
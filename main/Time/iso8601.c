@@ -0,0 +1,119 @@
+#include "iso8601.h"
+
+#include <stddef.h>
+
+// Reads exactly `n` decimal digits.
+static bool read_digits(const char **p, int n, int *out)
+{
+    int v = 0;
+    for (int i = 0; i < n; i++) {
+        char c = (*p)[i];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        v = v * 10 + (c - '0');
+    }
+    *p += n;
+    *out = v;
+    return true;
+}
+
+static bool expect(const char **p, char c)
+{
+    if (**p != c) {
+        return false;
+    }
+    (*p)++;
+    return true;
+}
+
+static int days_in_month(int year, int month)
+{
+    static const uint8_t s_days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (month == 2 && (year % 4 == 0) && (year % 100 != 0 || year % 400 == 0)) {
+        return 29;
+    }
+    return s_days[month - 1];
+}
+
+int64_t iso8601_days_from_civil(int year, int month, int day)
+{
+    // Howard Hinnant's days_from_civil: shift the year to start in March so
+    // the leap day is last, then count whole 400-year eras.
+    int64_t y = (int64_t)year - (month <= 2);
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;                                   // [0, 399]
+    int64_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1; // [0, 365]
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;          // [0, 146096]
+    return era * 146097 + doe - 719468;
+}
+
+bool iso8601_to_epoch_utc(const char *s, time_t *out_epoch)
+{
+    if (s == NULL || out_epoch == NULL) {
+        return false;
+    }
+
+    const char *p = s;
+    int year, mon, day, hour, min, sec;
+    if (!read_digits(&p, 4, &year) || !expect(&p, '-') ||
+        !read_digits(&p, 2, &mon) || !expect(&p, '-') ||
+        !read_digits(&p, 2, &day) || !expect(&p, 'T') ||
+        !read_digits(&p, 2, &hour) || !expect(&p, ':') ||
+        !read_digits(&p, 2, &min) || !expect(&p, ':') ||
+        !read_digits(&p, 2, &sec)) {
+        return false;
+    }
+    // sec == 60 is a leap second; like timegm() it lands on the next minute.
+    if (mon < 1 || mon > 12 || day < 1 || day > days_in_month(year, mon) ||
+        hour > 23 || min > 59 || sec > 60) {
+        return false;
+    }
+
+    // Optional fractional seconds (dropped).
+    if (*p == '.') {
+        p++;
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+
+    int tz_offset_sec = 0;
+    if (*p == 'Z') {
+        p++;
+    } else if (*p == '+' || *p == '-') {
+        int sign = (*p == '-') ? -1 : 1;
+        int tzh = 0, tzm = 0;
+        p++;
+        if (!read_digits(&p, 2, &tzh)) {
+            return false;
+        }
+        if (expect(&p, ':') || (*p >= '0' && *p <= '9')) {
+            if (!read_digits(&p, 2, &tzm)) {
+                return false;
+            }
+        }
+        if (tzh > 23 || tzm > 59) {
+            return false;
+        }
+        tz_offset_sec = sign * (tzh * 3600 + tzm * 60);
+    }
+    if (*p != '\0') {
+        return false;
+    }
+
+    int64_t t = iso8601_days_from_civil(year, mon, day) * 86400 +
+                hour * 3600 + min * 60 + sec;
+
+    // The wall clock is local to the offset, so UTC = local - offset.
+    // Example: 12:00-05:00 => offset=-18000 => UTC = 17:00Z.
+    t -= tz_offset_sec;
+    if ((int64_t)(time_t)t != t) {
+        return false;
+    }
+    *out_epoch = (time_t)t;
+    return true;
+}
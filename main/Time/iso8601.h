@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Timestamp helpers that only do integer arithmetic. Unlike mktime() they
+// never read or change TZ, so any task may call them while others use
+// localtime_r(), and they do not allocate.
+
+// Days since 1970-01-01 for a proleptic Gregorian date (month 1..12).
+int64_t iso8601_days_from_civil(int year, int month, int day);
+
+// Parses YYYY-MM-DDTHH:MM:SS(.sss)?(Z|±HH:MM|±HHMM|±HH)? into a UTC epoch.
+// A missing zone designator is taken as UTC. Returns false on malformed or
+// out-of-range input.
+bool iso8601_to_epoch_utc(const char *s, time_t *out_epoch);
+
+#ifdef __cplusplus
+}
+#endif
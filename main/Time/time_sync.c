@@ -0,0 +1,96 @@
+#include "time_sync.h"
+
+#include <sys/time.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_sntp.h"
+#include "esp_timer.h"
+
+#define TIME_SYNCED_BIT BIT0
+
+static const char *TAG = "TIME";
+
+static EventGroupHandle_t s_events;
+static bool s_sntp_started;
+
+static bool time_is_sane(void)
+{
+    return time(NULL) > 1577836800; // 2020-01-01
+}
+
+static void time_on_sync(struct timeval *tv)
+{
+    (void)tv;
+    if (xEventGroupGetBits(s_events) & TIME_SYNCED_BIT) {
+        ESP_LOGD(TAG, "Time resynced");
+        return;
+    }
+    ESP_LOGI(TAG, "Time synced %u ms after boot", (unsigned)(esp_timer_get_time() / 1000));
+    xEventGroupSetBits(s_events, TIME_SYNCED_BIT);
+}
+
+static void time_on_got_ip(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
+{
+    (void)arg;
+    (void)event_base;
+    (void)event_id;
+    (void)event_data;
+
+    if (s_sntp_started) {
+        // Reconnected before the first sync: ask again right away rather
+        // than at the next poll interval.
+        if (!(xEventGroupGetBits(s_events) & TIME_SYNCED_BIT)) {
+            esp_sntp_restart();
+        }
+        return;
+    }
+    s_sntp_started = true;
+
+    esp_sntp_setoperatingmode(ESP_SNTP_OPMODE_POLL);
+    esp_sntp_setservername(0, "pool.ntp.org");
+    sntp_set_time_sync_notification_cb(time_on_sync);
+    sntp_set_sync_mode(SNTP_SYNC_MODE_SMOOTH);
+    esp_sntp_init();
+    ESP_LOGI(TAG, "SNTP started %u ms after boot", (unsigned)(esp_timer_get_time() / 1000));
+}
+
+void TimeSync_Start(void)
+{
+    // Start only once
+    if (s_events != NULL) {
+        return;
+    }
+    s_events = xEventGroupCreate();
+
+    // The RTC keeps running across software resets.
+    if (time_is_sane()) {
+        xEventGroupSetBits(s_events, TIME_SYNCED_BIT);
+    }
+
+    // Wireless creates the loop too; whoever comes second gets INVALID_STATE.
+    esp_err_t err = esp_event_loop_create_default();
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_ERROR_CHECK(err);
+    }
+    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &time_on_got_ip, NULL));
+}
+
+bool TimeSync_IsSynced(void)
+{
+    return s_events != NULL && (xEventGroupGetBits(s_events) & TIME_SYNCED_BIT) != 0;
+}
+
+bool TimeSync_Wait(uint32_t timeout_ms)
+{
+    if (s_events == NULL) {
+        return time_is_sane();
+    }
+    EventBits_t bits = xEventGroupWaitBits(s_events, TIME_SYNCED_BIT, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeout_ms));
+    return (bits & TIME_SYNCED_BIT) != 0;
+}
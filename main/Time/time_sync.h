@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The one place SNTP is started. It starts as soon as the station gets an
+// IP (again on every reconnect until the first sync). Waiters block on an
+// event group bit instead of polling the clock.
+//
+// After the first sync, corrections are slewed with adjtime() rather than
+// stepped. The clock and the countdowns derived from it never jump by the
+// few hundred ms a resync usually corrects. Only the first sync, or an
+// error too large to slew, sets the time outright.
+
+// Call before Wireless_Init() so the GOT_IP event is not missed.
+void TimeSync_Start(void);
+
+// True once the clock is good enough for TLS certificate checks: synced
+// this boot, or kept across a software reset.
+bool TimeSync_IsSynced(void);
+
+// Wait up to timeout_ms for TimeSync_IsSynced(). Returns it.
+bool TimeSync_Wait(uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
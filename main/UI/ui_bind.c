@@ -0,0 +1,67 @@
+#include "ui_bind.h"
+
+#include <string.h>
+
+static ui_bind_stats_t s_stats;
+
+static bool bind_skip(bool same)
+{
+    if (same) {
+        s_stats.skipped++;
+    } else {
+        s_stats.applied++;
+    }
+    return same;
+}
+
+void UiBind_Text(lv_obj_t *label, const char *text)
+{
+    if (bind_skip(strcmp(lv_label_get_text(label), text) == 0)) {
+        return;
+    }
+    lv_label_set_text(label, text);
+}
+
+void UiBind_TextColor(lv_obj_t *obj, lv_color_t color)
+{
+    if (bind_skip(lv_obj_get_style_text_color(obj, LV_PART_MAIN).full == color.full)) {
+        return;
+    }
+    lv_obj_set_style_text_color(obj, color, 0);
+}
+
+void UiBind_Hidden(lv_obj_t *obj, bool hidden)
+{
+    if (bind_skip(lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN) == hidden)) {
+        return;
+    }
+    if (hidden) {
+        lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_clear_flag(obj, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+void UiBind_BarValue(lv_obj_t *bar, int32_t value)
+{
+    int32_t min = lv_bar_get_min_value(bar);
+    int32_t range = lv_bar_get_max_value(bar) - min;
+    int32_t width = lv_obj_get_content_width(bar);
+    int32_t cur = lv_bar_get_value(bar);
+    bool same = cur == value;
+    if (!same && range > 0 && width > 0) {
+        same = (int64_t)(cur - min) * width / range == (int64_t)(value - min) * width / range;
+    }
+    if (bind_skip(same)) {
+        return;
+    }
+    lv_bar_set_value(bar, value, LV_ANIM_OFF);
+}
+
+void UiBind_TakeStats(ui_bind_stats_t *out_stats)
+{
+    if (out_stats != NULL) {
+        *out_stats = s_stats;
+    }
+    memset(&s_stats, 0, sizeof(s_stats));
+}
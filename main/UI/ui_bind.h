@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Widget setters that only call into LVGL when what is shown would change.
+// LVGL invalidates the object, so it gets redrawn and re-flushed over SPI,
+// on every lv_label_set_text(), local style change and hidden-flag change,
+// even when the value is the same. The widget's own current value is the
+// cache. UI task only.
+
+typedef struct {
+    uint32_t applied; // calls that changed a widget
+    uint32_t skipped; // invalidations avoided
+} ui_bind_stats_t;
+
+void UiBind_Text(lv_obj_t *label, const char *text);
+void UiBind_TextColor(lv_obj_t *obj, lv_color_t color);
+void UiBind_Hidden(lv_obj_t *obj, bool hidden);
+
+// Skips steps that would not move the indicator by a whole pixel.
+void UiBind_BarValue(lv_obj_t *bar, int32_t value);
+
+// Counts since the last call, then resets them.
+void UiBind_TakeStats(ui_bind_stats_t *out_stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,30 @@
+#include "ui_notify.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static TaskHandle_t s_ui_task;
+
+void UiNotify_Init(void)
+{
+    s_ui_task = xTaskGetCurrentTaskHandle();
+}
+
+void UiNotify_Signal(void)
+{
+    TaskHandle_t task = s_ui_task;
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+    }
+}
+
+bool UiNotify_Wait(uint32_t timeout_ms)
+{
+    // Round up: waking a tick early would just spin lv_timer_handler().
+    TickType_t ticks = portMAX_DELAY;
+    if (timeout_ms < UINT32_MAX - portTICK_PERIOD_MS) {
+        ticks = (timeout_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+    }
+    // Several signals since the last wait are one wakeup.
+    return ulTaskNotifyTake(pdTRUE, ticks) > 0;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Wakes the UI loop in app_main when something it renders was published
+// (MBTA/alerts/weather state, WiFi status). The loop otherwise sleeps until
+// the next LVGL timer is due, so data tasks must signal after every change.
+
+// Call from the UI task before it first waits.
+void UiNotify_Init(void);
+
+// Any task (not ISRs). A no-op before UiNotify_Init().
+void UiNotify_Signal(void);
+
+// UI task only. True if signalled, false on timeout.
+bool UiNotify_Wait(uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,22 +1,20 @@
 #include "weather.h"
 #include "config.h"
 
-#include "Wireless.h"
-
 #include <math.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
 #include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
-#include "freertos/task.h"
 
-#include "esp_crt_bundle.h"
-#include "esp_http_client.h"
 #include "esp_log.h"
-#include "esp_sntp.h"
 
-#include "cJSON.h"
+#include "json_stream.h"
+#include "net_service.h"
+#include "seqlock.h"
+#include "snapshot.h"
+#include "ui_notify.h"
 
 #ifndef WEATHER_FETCH_PERIOD_MS
 #define WEATHER_FETCH_PERIOD_MS (10 * 60 * 1000)
@@ -26,44 +24,57 @@
 #define WEATHER_HTTP_TIMEOUT_MS (8000)
 #endif
 
+#define WEATHER_WIFI_RETRY_MS (1000)
+
+// Older snapshots are not worth showing, even marked stale.
+#define WEATHER_SNAPSHOT_MAX_AGE_S (12 * 60 * 60)
+
 static const char *TAG = "WEATHER";
 
-static SemaphoreHandle_t s_state_mu;
-static weather_state_t s_state;
+// Written from the network service's callbacks (and Weather_TaskStart
+// before the first job is queued), never concurrently.
+static seqlock_t s_state_pub;
+static weather_state_t s_state_bufs[2];
 static uint32_t s_state_version;
 
+// Last-known weather restored at boot; has_data is cleared by the first
+// successful fetch.
+static weather_state_t s_restored;
+
+typedef struct {
+    int64_t fetched_at;
+    int32_t temp_c;
+    int32_t high_c;
+    int32_t low_c;
+    char condition[24];
+} weather_snapshot_t;
+
 static void weather_state_set(const weather_state_t *src)
 {
-    if (s_state_mu == NULL) {
-        return;
-    }
-
-    xSemaphoreTake(s_state_mu, portMAX_DELAY);
-    s_state = *src;
+    weather_state_t *st = seqlock_write_begin(&s_state_pub);
+    *st = *src;
     s_state_version++;
-    s_state.version = s_state_version;
-    xSemaphoreGive(s_state_mu);
+    st->version = s_state_version;
+    seqlock_write_end(&s_state_pub);
+    UiNotify_Signal();
 }
 
 bool Weather_GetState(weather_state_t *out_state)
 {
-    if (out_state == NULL || s_state_mu == NULL) {
+    // Nothing published before Weather_TaskStart().
+    if (out_state == NULL || seqlock_version(&s_state_pub) == 0) {
         return false;
     }
-
-    bool ok = false;
-    if (xSemaphoreTake(s_state_mu, pdMS_TO_TICKS(10)) == pdTRUE) {
-        *out_state = s_state;
-        ok = true;
-        xSemaphoreGive(s_state_mu);
-    }
-    return ok;
+    seqlock_read(&s_state_pub, out_state);
+    return true;
 }
 
-static void weather_set_timezone(void)
+bool Weather_GetStateIfChanged(weather_state_t *out_state, uint32_t *seen)
 {
-    setenv("TZ", DEFAULT_TIMEZONE, 1);
-    tzset();
+    if (out_state == NULL || seen == NULL) {
+        return false;
+    }
+    return seqlock_read_if_changed(&s_state_pub, out_state, seen);
 }
 
 static bool weather_time_is_sane(void)
@@ -72,88 +83,79 @@ static bool weather_time_is_sane(void)
     return now > 1577836800; // 2020-01-01
 }
 
-static void weather_time_sync_sntp(void)
+// Open-Meteo's fields, picked out while the body streams in.
+typedef struct {
+    json_stream_t js;
+    char tok[32];
+
+    double temp;
+    double precip_mm;
+    double rain_mm;
+    double snow_mm;
+    double high;
+    double low;
+    int code;
+    bool has_temp;
+    bool has_code;
+    bool has_high;
+    bool has_low;
+    // Values seen in each daily array; only the first (today) is used.
+    int high_seen;
+    int low_seen;
+} weather_parser_t;
+
+static bool weather_on_json(json_stream_t *js, json_stream_event_t ev, const char *value, size_t len, void *ctx)
 {
-    if (weather_time_is_sane()) {
-        return;
+    (void)len;
+    weather_parser_t *p = (weather_parser_t *)ctx;
+    int depth = json_stream_depth(js);
+    bool number = ev == JSON_STREAM_NUMBER;
+
+    // current.{temperature_2m,weather_code,precipitation,rain,snowfall}
+    if (depth == 2 && number && strcmp(json_stream_key(js, 0), "current") == 0) {
+        const char *key = json_stream_key(js, 1);
+        double v = strtod(value, NULL);
+        if (strcmp(key, "temperature_2m") == 0) {
+            p->temp = v;
+            p->has_temp = true;
+        } else if (strcmp(key, "weather_code") == 0) {
+            p->code = (int)v;
+            p->has_code = true;
+        } else if (strcmp(key, "precipitation") == 0) {
+            p->precip_mm = v;
+        } else if (strcmp(key, "rain") == 0) {
+            p->rain_mm = v;
+        } else if (strcmp(key, "snowfall") == 0) {
+            p->snow_mm = v;
+        }
+        return true;
     }
 
-    weather_set_timezone();
-
-    esp_sntp_setoperatingmode(ESP_SNTP_OPMODE_POLL);
-    esp_sntp_setservername(0, "pool.ntp.org");
-    esp_sntp_init();
-
-    for (int i = 0; i < 20; i++) {
-        if (weather_time_is_sane()) {
-            ESP_LOGI(TAG, "Time synced");
-            return;
+    // daily.temperature_2m_{max,min}[0]
+    if (depth == 3 && json_stream_in_array(js, 2) && ev != JSON_STREAM_ARRAY_BEGIN &&
+        ev != JSON_STREAM_OBJECT_BEGIN && strcmp(json_stream_key(js, 0), "daily") == 0) {
+        const char *key = json_stream_key(js, 1);
+        if (strcmp(key, "temperature_2m_max") == 0 && p->high_seen++ == 0 && number) {
+            p->high = strtod(value, NULL);
+            p->has_high = true;
+        } else if (strcmp(key, "temperature_2m_min") == 0 && p->low_seen++ == 0 && number) {
+            p->low = strtod(value, NULL);
+            p->has_low = true;
         }
-        vTaskDelay(pdMS_TO_TICKS(500));
     }
-
-    ESP_LOGW(TAG, "Time not synced (TLS may fail)");
+    return true;
 }
 
-static esp_err_t http_get_to_buffer(const char *url, char *buf, size_t buf_size, int *out_http_status)
+static bool weather_on_body(const char *data, size_t len, void *ctx)
 {
-    if (buf == NULL || buf_size == 0) {
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    esp_http_client_config_t config = {
-        .url = url,
-        .method = HTTP_METHOD_GET,
-        .timeout_ms = WEATHER_HTTP_TIMEOUT_MS,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-        .user_agent = "mbta-lcd/1.0",
-    };
-
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == NULL) {
-        return ESP_FAIL;
-    }
-
-    esp_err_t err = esp_http_client_open(client, 0);
-    if (err != ESP_OK) {
-        esp_http_client_cleanup(client);
-        return err;
-    }
-
-    (void)esp_http_client_fetch_headers(client);
-
-    int status = esp_http_client_get_status_code(client);
-    if (out_http_status) {
-        *out_http_status = status;
-    }
-
-    int total = 0;
-    while (total < (int)buf_size - 1) {
-        int r = esp_http_client_read(client, buf + total, (int)buf_size - 1 - total);
-        if (r < 0) {
-            esp_http_client_close(client);
-            esp_http_client_cleanup(client);
-            return ESP_FAIL;
-        }
-        if (r == 0) {
-            break;
-        }
-        total += r;
-    }
-    buf[total] = '\0';
-
-    // Detect truncation
-    if (total == (int)buf_size - 1) {
-        char extra;
-        int more = esp_http_client_read(client, &extra, 1);
-        if (more > 0) {
-            ESP_LOGW(TAG, "Response truncated (buf_size=%d)", (int)buf_size);
-        }
-    }
+    weather_parser_t *p = (weather_parser_t *)ctx;
+    return json_stream_feed(&p->js, data, len);
+}
 
-    esp_http_client_close(client);
-    esp_http_client_cleanup(client);
-    return ESP_OK;
+static void weather_parser_init(weather_parser_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    json_stream_init(&p->js, p->tok, sizeof(p->tok), weather_on_json, p);
 }
 
 static const char *weather_code_to_condition(int code)
@@ -167,140 +169,135 @@ static const char *weather_code_to_condition(int code)
     return "Weather";
 }
 
-static bool parse_weather_json(const char *json, weather_state_t *out)
+static bool weather_parser_result(weather_parser_t *p, weather_state_t *out)
 {
-    if (json == NULL || out == NULL) {
-        return false;
-    }
-
-    cJSON *root = cJSON_Parse(json);
-    if (root == NULL) {
+    if (!json_stream_finish(&p->js) || !p->has_temp || !p->has_code || !p->has_high || !p->has_low) {
         return false;
     }
 
-    bool ok = false;
-
-    // current.temperature_2m, current.weather_code (+ precipitation fields when available)
-    cJSON *current = cJSON_GetObjectItem(root, "current");
-    cJSON *daily = cJSON_GetObjectItem(root, "daily");
-
-    if (!cJSON_IsObject(current) || !cJSON_IsObject(daily)) {
-        goto out;
-    }
-
-    cJSON *temp = cJSON_GetObjectItem(current, "temperature_2m");
-    cJSON *wcode = cJSON_GetObjectItem(current, "weather_code");
-    if (!cJSON_IsNumber(temp) || !cJSON_IsNumber(wcode)) {
-        goto out;
-    }
-
-    cJSON *precip = cJSON_GetObjectItem(current, "precipitation");
-    cJSON *rain = cJSON_GetObjectItem(current, "rain");
-    cJSON *snowfall = cJSON_GetObjectItem(current, "snowfall");
-    double precip_mm = cJSON_IsNumber(precip) ? precip->valuedouble : 0.0;
-    double rain_mm = cJSON_IsNumber(rain) ? rain->valuedouble : 0.0;
-    double snow_mm = cJSON_IsNumber(snowfall) ? snowfall->valuedouble : 0.0;
-
-    cJSON *tmax_arr = cJSON_GetObjectItem(daily, "temperature_2m_max");
-    cJSON *tmin_arr = cJSON_GetObjectItem(daily, "temperature_2m_min");
-    if (!cJSON_IsArray(tmax_arr) || !cJSON_IsArray(tmin_arr)) {
-        goto out;
-    }
-
-    cJSON *tmax0 = cJSON_GetArrayItem(tmax_arr, 0);
-    cJSON *tmin0 = cJSON_GetArrayItem(tmin_arr, 0);
-    if (!cJSON_IsNumber(tmax0) || !cJSON_IsNumber(tmin0)) {
-        goto out;
-    }
-
     memset(out, 0, sizeof(*out));
-    out->temp_c = (int)lround(temp->valuedouble);
-    out->high_c = (int)lround(tmax0->valuedouble);
-    out->low_c = (int)lround(tmin0->valuedouble);
+    out->temp_c = (int)lround(p->temp);
+    out->high_c = (int)lround(p->high);
+    out->low_c = (int)lround(p->low);
 
-    if (snow_mm > 0.0) {
+    if (p->snow_mm > 0.0) {
         strlcpy(out->condition, "Snowing", sizeof(out->condition));
-    } else if (rain_mm > 0.0 || precip_mm > 0.0) {
+    } else if (p->rain_mm > 0.0 || p->precip_mm > 0.0) {
         strlcpy(out->condition, "Raining", sizeof(out->condition));
     } else {
-        const char *cond = weather_code_to_condition(wcode->valueint);
-        strlcpy(out->condition, cond, sizeof(out->condition));
+        strlcpy(out->condition, weather_code_to_condition(p->code), sizeof(out->condition));
     }
 
     out->has_data = true;
-    ok = true;
+    return true;
+}
 
-out:
-    cJSON_Delete(root);
-    return ok;
+static void weather_snapshot_save(const weather_state_t *st)
+{
+    weather_snapshot_t snap = {0};
+    snap.fetched_at = time(NULL);
+    snap.temp_c = st->temp_c;
+    snap.high_c = st->high_c;
+    snap.low_c = st->low_c;
+    strlcpy(snap.condition, st->condition, sizeof(snap.condition));
+    Snapshot_Save(SNAPSHOT_WEATHER, &snap, sizeof(snap));
 }
 
-static void weather_task(void *arg)
+static void weather_snapshot_restore(void)
 {
-    (void)arg;
+    weather_snapshot_t snap;
+    if (!Snapshot_Load(SNAPSHOT_WEATHER, &snap, sizeof(snap))) {
+        return;
+    }
+    // The age is unknown until SNTP after a power loss; show it anyway.
+    time_t now = time(NULL);
+    if (weather_time_is_sane() && now - (time_t)snap.fetched_at > WEATHER_SNAPSHOT_MAX_AGE_S) {
+        return;
+    }
+    memset(&s_restored, 0, sizeof(s_restored));
+    s_restored.temp_c = snap.temp_c;
+    s_restored.high_c = snap.high_c;
+    s_restored.low_c = snap.low_c;
+    strlcpy(s_restored.condition, snap.condition, sizeof(s_restored.condition));
+    s_restored.has_data = true;
+    s_restored.stale = true;
+}
 
-    if (s_state_mu == NULL) {
-        s_state_mu = xSemaphoreCreateMutex();
+// Placeholder state while there is no fresh data: the restored snapshot if
+// any, otherwise `condition` with no data.
+static void weather_state_placeholder(weather_state_t *st, const char *condition)
+{
+    if (s_restored.has_data) {
+        *st = s_restored;
+        return;
     }
+    memset(st, 0, sizeof(*st));
+    strlcpy(st->condition, condition, sizeof(st->condition));
+}
 
-    weather_state_t init = {0};
-    init.has_data = false;
-    init.is_fetching = false;
-    strlcpy(init.condition, "Weather", sizeof(init.condition));
-    weather_state_set(&init);
+static char s_url[256];
+static weather_parser_t s_parser;
 
-    bool sntp_attempted = false;
+static void weather_fetch_queue(uint32_t delay_ms);
 
-    char url[256];
-    snprintf(
-        url,
-        sizeof(url),
-        "https://api.open-meteo.com/v1/forecast?latitude=%.6f&longitude=%.6f&current=temperature_2m,weather_code,precipitation,rain,snowfall&daily=temperature_2m_max,temperature_2m_min&temperature_unit=celsius&timezone=auto",
-        (double)WEATHER_LATITUDE,
-        (double)WEATHER_LONGITUDE);
+static void weather_on_start(void *ctx)
+{
+    (void)ctx;
 
-    char json_buf[4096];
-
-    while (1) {
-        // WiFi/netif init happens asynchronously in Wireless_Init().
-        // Avoid touching LWIP (DNS/TLS/HTTP/SNTP) until WiFi is connected,
-        // otherwise tcpip_send_msg_wait_sem can assert with "Invalid mbox".
-        if (Wireless_GetStatus() != WIRELESS_STATUS_CONNECTED) {
-            weather_state_t no_wifi = {0};
-            no_wifi.has_data = false;
-            no_wifi.is_fetching = false;
-            strlcpy(no_wifi.condition, "No WiFi", sizeof(no_wifi.condition));
-            weather_state_set(&no_wifi);
-            vTaskDelay(pdMS_TO_TICKS(500));
-            continue;
-        }
+    weather_state_t st;
+    weather_state_placeholder(&st, "Weather");
+    st.is_fetching = true;
+    weather_state_set(&st);
 
-        if (!sntp_attempted) {
-            sntp_attempted = true;
-            weather_time_sync_sntp();
-        }
+    weather_parser_init(&s_parser);
+}
 
-        weather_state_t st = {0};
-        st.is_fetching = true;
-        strlcpy(st.condition, "Weather", sizeof(st.condition));
-        weather_state_set(&st);
+static void weather_on_done(esp_err_t err, int http_status, void *ctx)
+{
+    (void)ctx;
+
+    // WiFi/netif init happens asynchronously in Wireless_Init().
+    if (err == ESP_ERR_INVALID_STATE) {
+        weather_state_t no_wifi;
+        weather_state_placeholder(&no_wifi, "No WiFi");
+        weather_state_set(&no_wifi);
+        weather_fetch_queue(WEATHER_WIFI_RETRY_MS);
+        return;
+    }
 
-        int http_status = 0;
-        esp_err_t err = http_get_to_buffer(url, json_buf, sizeof(json_buf), &http_status);
+    weather_state_t new_state = {0};
+    new_state.is_fetching = false;
 
-        weather_state_t new_state = {0};
-        new_state.is_fetching = false;
+    if (err == ESP_OK && http_status == 200 && weather_parser_result(&s_parser, &new_state)) {
+        s_restored.has_data = false;
+        weather_snapshot_save(&new_state);
+    } else {
+        weather_state_placeholder(&new_state, "No data");
+        ESP_LOGW(TAG, "Weather fetch failed: err=%s status=%d", esp_err_to_name(err), http_status);
+    }
 
-        if (err == ESP_OK && http_status == 200 && parse_weather_json(json_buf, &new_state)) {
-            // parsed OK
-        } else {
-            new_state.has_data = false;
-            strlcpy(new_state.condition, "No data", sizeof(new_state.condition));
-            ESP_LOGW(TAG, "Weather fetch failed: err=%s status=%d", esp_err_to_name(err), http_status);
-        }
+    weather_state_set(&new_state);
+    weather_fetch_queue(WEATHER_FETCH_PERIOD_MS);
+}
 
-        weather_state_set(&new_state);
-        vTaskDelay(pdMS_TO_TICKS(WEATHER_FETCH_PERIOD_MS));
+// No task of its own: each fetch is a low-priority job on the network
+// service, which queues the next one when it completes.
+static void weather_fetch_queue(uint32_t delay_ms)
+{
+    net_job_t job = {
+        .req = {
+            .url = s_url,
+            .timeout_ms = WEATHER_HTTP_TIMEOUT_MS,
+            .on_body = weather_on_body,
+            .ctx = &s_parser,
+        },
+        .prio = NET_PRIO_LOW,
+        .delay_ms = delay_ms,
+        .on_start = weather_on_start,
+        .on_done = weather_on_done,
+    };
+    if (!NetService_Submit(&job)) {
+        ESP_LOGE(TAG, "Could not queue the weather fetch");
     }
 }
 
@@ -313,5 +310,20 @@ void Weather_TaskStart(void)
     }
     started = true;
 
-    xTaskCreatePinnedToCore(weather_task, "weather", 8192, NULL, 1, NULL, 0);
+    // Seed with the last-known weather so the first frame has something.
+    weather_snapshot_restore();
+    seqlock_init(&s_state_pub, s_state_bufs, sizeof(weather_state_t));
+    // Shown until the first job runs.
+    weather_state_t init;
+    weather_state_placeholder(&init, "Weather");
+    weather_state_set(&init);
+
+    snprintf(
+        s_url,
+        sizeof(s_url),
+        "https://api.open-meteo.com/v1/forecast?latitude=%.6f&longitude=%.6f&current=temperature_2m,weather_code,precipitation,rain,snowfall&daily=temperature_2m_max,temperature_2m_min&temperature_unit=celsius&timezone=auto",
+        (double)WEATHER_LATITUDE,
+        (double)WEATHER_LONGITUDE);
+
+    weather_fetch_queue(0);
 }
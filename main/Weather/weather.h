@@ -21,15 +21,23 @@ typedef struct {
     bool has_data;
     bool is_fetching;
 
+    // True while the data is the last-known snapshot from before a reset.
+    bool stale;
+
     // Monotonic version, incremented on update.
     uint32_t version;
 } weather_state_t;
 
+// Starts periodic fetching on the network service (start that first).
 void Weather_TaskStart(void);
 
-// Snapshot the latest state. Returns true on success.
+// Snapshot the latest state. Never blocks; false before Weather_TaskStart().
 bool Weather_GetState(weather_state_t *out_state);
 
+// Like Weather_GetState(), but only copies when something was published
+// since *seen (start at 0), then updates *seen.
+bool Weather_GetStateIfChanged(weather_state_t *out_state, uint32_t *seen);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,25 +1,57 @@
 #include "Wireless.h"
 #include "config.h"
+#include "wifi_reconnect.h"
+#include "ui_notify.h"
 
-#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
 
 #include "esp_event.h"
+#include "esp_mac.h"
 #include "esp_netif.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "nvs.h"
 
 #define WIFI_CONNECT_SSID WIFI_SSID
 #define WIFI_CONNECT_PASS WIFI_PASS
 
-#define WIFI_MAXIMUM_RETRY 5
+// Reuse the last DHCP lease as a static address when reconnecting to the
+// cached AP, skipping DHCP. Only safe with a DHCP reservation: nothing
+// detects a lease that has since gone to another device.
+#ifndef WIFI_USE_CACHED_IP
+#define WIFI_USE_CACHED_IP 0
+#endif
+
+#define WIFI_CACHE_NAMESPACE "wifi"
+#define WIFI_CACHE_KEY       "ap"
+
+static const char *TAG = "WIFI";
 
-static EventGroupHandle_t s_wifi_event_group;
-static int s_wifi_retry_num;
 static esp_netif_t *s_wifi_sta_netif;
 
 static volatile wireless_status_t s_status = WIRELESS_STATUS_CONNECTING;
 static char s_ip_str[16] = {0};
 
-#define WIFI_CONNECTED_BIT BIT0
-#define WIFI_FAIL_BIT      BIT1
+// Last AP (and lease) that gave us an IP, kept in NVS.
+typedef struct {
+    uint32_t ssid_hash;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t has_ip;
+    uint32_t ip;
+    uint32_t gw;
+    uint32_t netmask;
+    uint32_t dns;
+} wifi_cache_t;
+
+static wifi_cache_t s_cache;
+
+// The reconnect state machine is driven from the event loop task and the
+// retry timer (esp_timer task).
+static SemaphoreHandle_t s_rc_mu;
+static wifi_rc_t s_rc;
+static esp_timer_handle_t s_rc_timer;
+static bool s_static_ip;
 
 wireless_status_t Wireless_GetStatus(void)
 {
@@ -31,29 +63,224 @@ const char *Wireless_GetIpStr(void)
     return s_ip_str;
 }
 
+static int64_t wifi_now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static uint32_t wifi_ssid_hash(void)
+{
+    uint32_t h = 2166136261u;
+    for (const char *p = WIFI_CONNECT_SSID; *p; p++) {
+        h ^= (uint8_t)*p;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static bool wifi_cache_load(void)
+{
+    nvs_handle_t h;
+    if (nvs_open(WIFI_CACHE_NAMESPACE, NVS_READONLY, &h) != ESP_OK) {
+        return false;
+    }
+    size_t len = sizeof(s_cache);
+    esp_err_t err = nvs_get_blob(h, WIFI_CACHE_KEY, &s_cache, &len);
+    nvs_close(h);
+    // Stale after an SSID change in config.h.
+    if (err != ESP_OK || len != sizeof(s_cache) || s_cache.ssid_hash != wifi_ssid_hash() || s_cache.channel == 0) {
+        memset(&s_cache, 0, sizeof(s_cache));
+        return false;
+    }
+    ESP_LOGI(TAG, "Cached AP " MACSTR " on channel %u", MAC2STR(s_cache.bssid), (unsigned)s_cache.channel);
+    return true;
+}
+
+// Remember the AP and lease we just got an IP from (written only on change).
+static bool wifi_cache_update(const esp_netif_ip_info_t *ip_info)
+{
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return false;
+    }
+
+    wifi_cache_t next = {0};
+    next.ssid_hash = wifi_ssid_hash();
+    memcpy(next.bssid, ap.bssid, sizeof(next.bssid));
+    next.channel = ap.primary;
+    if (!s_static_ip) {
+        esp_netif_dns_info_t dns = {0};
+        esp_netif_get_dns_info(s_wifi_sta_netif, ESP_NETIF_DNS_MAIN, &dns);
+        next.has_ip = 1;
+        next.ip = ip_info->ip.addr;
+        next.gw = ip_info->gw.addr;
+        next.netmask = ip_info->netmask.addr;
+        next.dns = dns.ip.u_addr.ip4.addr;
+    } else {
+        next.has_ip = s_cache.has_ip;
+        next.ip = s_cache.ip;
+        next.gw = s_cache.gw;
+        next.netmask = s_cache.netmask;
+        next.dns = s_cache.dns;
+    }
+    if (memcmp(&next, &s_cache, sizeof(next)) == 0) {
+        return false;
+    }
+    s_cache = next;
+
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(WIFI_CACHE_NAMESPACE, NVS_READWRITE, &h);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(h, WIFI_CACHE_KEY, &s_cache, sizeof(s_cache));
+        if (err == ESP_OK) {
+            err = nvs_commit(h);
+        }
+        nvs_close(h);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Could not save the AP cache (%s)", esp_err_to_name(err));
+    }
+    return true;
+}
+
+static void wifi_set_sta_config(bool use_cached)
+{
+    wifi_config_t wifi_config = {0};
+    strlcpy((char *)wifi_config.sta.ssid, WIFI_CONNECT_SSID, sizeof(wifi_config.sta.ssid));
+    strlcpy((char *)wifi_config.sta.password, WIFI_CONNECT_PASS, sizeof(wifi_config.sta.password));
+    wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA_WPA2_PSK;
+    if (use_cached) {
+        // Known BSSID and channel: the driver probes one channel instead of
+        // scanning all of them.
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, s_cache.bssid, sizeof(wifi_config.sta.bssid));
+        wifi_config.sta.channel = s_cache.channel;
+    }
+    esp_err_t err = esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "esp_wifi_set_config failed (%s)", esp_err_to_name(err));
+    }
+}
+
+// Once associated: static address from the cache, or DHCP.
+static void wifi_ip_setup(void)
+{
+#if WIFI_USE_CACHED_IP
+    if (s_rc.attempt_cached && s_cache.has_ip) {
+        esp_netif_dhcpc_stop(s_wifi_sta_netif);
+        esp_netif_ip_info_t info = {0};
+        info.ip.addr = s_cache.ip;
+        info.gw.addr = s_cache.gw;
+        info.netmask.addr = s_cache.netmask;
+        esp_netif_dns_info_t dns = {0};
+        dns.ip.type = ESP_IPADDR_TYPE_V4;
+        dns.ip.u_addr.ip4.addr = s_cache.dns;
+        s_static_ip = true;
+        // Posts IP_EVENT_STA_GOT_IP.
+        esp_netif_set_ip_info(s_wifi_sta_netif, &info);
+        esp_netif_set_dns_info(s_wifi_sta_netif, ESP_NETIF_DNS_MAIN, &dns);
+        return;
+    }
+    if (s_static_ip) {
+        s_static_ip = false;
+        esp_netif_dhcpc_start(s_wifi_sta_netif);
+    }
+#endif
+}
+
+static void wifi_update_status(void)
+{
+    wireless_status_t status;
+    if (s_rc.state == WIFI_RC_CONNECTED) {
+        status = WIRELESS_STATUS_CONNECTED;
+    } else {
+        // Still retrying either way; FAILED only drives the status icon.
+        status = wifi_rc_is_failing(&s_rc) ? WIRELESS_STATUS_FAILED : WIRELESS_STATUS_CONNECTING;
+    }
+    if (status != s_status) {
+        s_status = status;
+        UiNotify_Signal();
+    }
+}
+
+// Carry out what the state machine asked for. Called with s_rc_mu held.
+static void wifi_apply(wifi_rc_action_t a)
+{
+    if (a.act == WIFI_RC_ACT_NONE) {
+        return;
+    }
+
+    esp_timer_stop(s_rc_timer);
+    if (a.disconnect) {
+        ESP_LOGW(TAG, "Attempt %u timed out", (unsigned)s_rc.attempts);
+        esp_wifi_disconnect();
+    }
+
+    if (a.act == WIFI_RC_ACT_CONNECT) {
+        ESP_LOGI(TAG, "Attempt %u (%s)", (unsigned)s_rc.attempts, a.use_cached ? "cached AP" : "scan");
+        wifi_set_sta_config(a.use_cached);
+        esp_err_t err = esp_wifi_connect();
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "esp_wifi_connect failed (%s)", esp_err_to_name(err));
+        }
+    } else {
+        ESP_LOGI(TAG, "Retry in %u ms (%u failed in a row)", (unsigned)a.delay_ms, (unsigned)s_rc.failures);
+    }
+    esp_timer_start_once(s_rc_timer, (uint64_t)a.delay_ms * 1000);
+}
+
+static void wifi_rc_timer_cb(void *arg)
+{
+    (void)arg;
+
+    xSemaphoreTake(s_rc_mu, portMAX_DELAY);
+    wifi_apply(wifi_rc_on_timer(&s_rc, wifi_now_ms()));
+    wifi_update_status();
+    xSemaphoreGive(s_rc_mu);
+}
+
 static void wifi_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
 {
     (void)arg;
 
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        xSemaphoreTake(s_rc_mu, portMAX_DELAY);
+        wifi_ip_setup();
+        xSemaphoreGive(s_rc_mu);
+        return;
+    }
+
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        s_status = WIRELESS_STATUS_CONNECTING;
-        if (s_wifi_retry_num < WIFI_MAXIMUM_RETRY) {
-            s_wifi_retry_num++;
-            esp_wifi_connect();
-        } else {
-            s_status = WIRELESS_STATUS_FAILED;
-            xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
+        const wifi_event_sta_disconnected_t *event = (const wifi_event_sta_disconnected_t *)event_data;
+        xSemaphoreTake(s_rc_mu, portMAX_DELAY);
+        if (s_rc.state != WIFI_RC_BACKOFF) {
+            ESP_LOGW(TAG, "Disconnected (reason %d) %u ms into attempt %u", (int)event->reason,
+                     (unsigned)(wifi_now_ms() - s_rc.attempt_start_ms), (unsigned)s_rc.attempts);
         }
+        wifi_apply(wifi_rc_on_disconnected(&s_rc, wifi_now_ms()));
+        wifi_update_status();
+        xSemaphoreGive(s_rc_mu);
         return;
     }
 
     if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
-        s_wifi_retry_num = 0;
-
         snprintf(s_ip_str, sizeof(s_ip_str), IPSTR, IP2STR(&event->ip_info.ip));
-        s_status = WIRELESS_STATUS_CONNECTED;
-        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+
+        xSemaphoreTake(s_rc_mu, portMAX_DELAY);
+        esp_timer_stop(s_rc_timer);
+        bool cached = s_rc.attempt_cached;
+        uint32_t ms = wifi_rc_on_got_ip(&s_rc, wifi_now_ms());
+        ESP_LOGI(TAG, "Got IP %s in %u ms (attempt %u, %s%s)", s_ip_str, (unsigned)ms, (unsigned)s_rc.attempts,
+                 cached ? "cached AP" : "scan", s_static_ip ? ", cached lease" : "");
+        if (wifi_cache_update(&event->ip_info)) {
+            wifi_rc_set_cache(&s_rc, true);
+        }
+        wifi_update_status();
+        xSemaphoreGive(s_rc_mu);
+
+        WIFI_NUM = 1;
+        Scan_finish = 1;
         return;
     }
 }
@@ -88,6 +315,8 @@ void Wireless_Init(void)
         0);
 }
 
+// Brings the station up and issues the first attempt; from then on the
+// event handler and the retry timer keep it connected.
 static void WIFI_Init(void *arg)
 {
     esp_err_t err = esp_netif_init();
@@ -103,8 +332,15 @@ static void WIFI_Init(void *arg)
     if (s_wifi_sta_netif == NULL) {
         s_wifi_sta_netif = esp_netif_create_default_wifi_sta();
     }
-    if (s_wifi_event_group == NULL) {
-        s_wifi_event_group = xEventGroupCreate();
+    if (s_rc_mu == NULL) {
+        s_rc_mu = xSemaphoreCreateMutex();
+    }
+    if (s_rc_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = wifi_rc_timer_cb,
+            .name = "wifi_retry",
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_rc_timer));
     }
 
     err = esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL);
@@ -122,36 +358,19 @@ static void WIFI_Init(void *arg)
         ESP_ERROR_CHECK(err);
     }
 
-    wifi_config_t wifi_config = {0};
-    strlcpy((char *)wifi_config.sta.ssid, WIFI_CONNECT_SSID, sizeof(wifi_config.sta.ssid));
-    strlcpy((char *)wifi_config.sta.password, WIFI_CONNECT_PASS, sizeof(wifi_config.sta.password));
-    wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA_WPA2_PSK;
+    bool have_cache = wifi_cache_load();
 
     s_status = WIRELESS_STATUS_CONNECTING;
-    s_wifi_retry_num = 0;
-    xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT);
 
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     // Must set STA config before starting/connecting, otherwise ESP_ERR_WIFI_STATE can happen.
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    wifi_set_sta_config(false);
     ESP_ERROR_CHECK(esp_wifi_start());
-    ESP_ERROR_CHECK(esp_wifi_connect());
 
-    EventBits_t bits = xEventGroupWaitBits(
-        s_wifi_event_group,
-        WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
-        pdFALSE,
-        pdFALSE,
-        pdMS_TO_TICKS(15000));
+    xSemaphoreTake(s_rc_mu, portMAX_DELAY);
+    wifi_rc_init(&s_rc, have_cache, esp_random());
+    wifi_apply(wifi_rc_on_start(&s_rc, wifi_now_ms()));
+    xSemaphoreGive(s_rc_mu);
 
-    if (bits & WIFI_CONNECTED_BIT) {
-        WIFI_NUM = 1;
-        Scan_finish = 1;
-    } else {
-        WIFI_NUM = 0;
-        Scan_finish = 0;
-        s_status = WIRELESS_STATUS_FAILED;
-    }
-    
     vTaskDelete(NULL);
 }
\ No newline at end of file
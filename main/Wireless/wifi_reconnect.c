@@ -0,0 +1,119 @@
+#include "wifi_reconnect.h"
+
+#include <string.h>
+
+static uint32_t rc_rand(wifi_rc_t *rc)
+{
+    // xorshift32: enough to keep a roomful of displays from retrying in step.
+    uint32_t x = rc->rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rc->rand_state = x;
+    return x;
+}
+
+static wifi_rc_action_t rc_attempt(wifi_rc_t *rc, int64_t now_ms)
+{
+    rc->state = WIFI_RC_CONNECTING;
+    rc->attempt_cached = rc->have_cache && rc->cached_failures < WIFI_RC_CACHED_TRIES;
+    rc->attempt_start_ms = now_ms;
+    rc->attempts++;
+
+    wifi_rc_action_t a = {
+        .act = WIFI_RC_ACT_CONNECT,
+        .use_cached = rc->attempt_cached,
+        .delay_ms = WIFI_RC_ATTEMPT_TIMEOUT_MS,
+    };
+    return a;
+}
+
+static wifi_rc_action_t rc_fail(wifi_rc_t *rc, bool disconnect)
+{
+    rc->failures++;
+    if (rc->attempt_cached) {
+        rc->cached_failures++;
+    }
+
+    uint32_t shift = rc->failures - 1;
+    uint32_t delay = WIFI_RC_BACKOFF_MAX_MS;
+    if (shift < 16 && ((uint32_t)WIFI_RC_BACKOFF_BASE_MS << shift) < WIFI_RC_BACKOFF_MAX_MS) {
+        delay = (uint32_t)WIFI_RC_BACKOFF_BASE_MS << shift;
+    }
+    // 75%..125% of the nominal delay.
+    delay = delay - delay / 4 + rc_rand(rc) % (delay / 2 + 1);
+
+    rc->state = WIFI_RC_BACKOFF;
+    wifi_rc_action_t a = {
+        .act = WIFI_RC_ACT_WAIT,
+        .disconnect = disconnect,
+        .delay_ms = delay,
+    };
+    return a;
+}
+
+void wifi_rc_init(wifi_rc_t *rc, bool have_cache, uint32_t seed)
+{
+    memset(rc, 0, sizeof(*rc));
+    rc->have_cache = have_cache;
+    rc->rand_state = seed ? seed : 0x9E3779B9u;
+}
+
+wifi_rc_action_t wifi_rc_on_start(wifi_rc_t *rc, int64_t now_ms)
+{
+    return rc_attempt(rc, now_ms);
+}
+
+wifi_rc_action_t wifi_rc_on_disconnected(wifi_rc_t *rc, int64_t now_ms)
+{
+    wifi_rc_action_t none = {0};
+    switch (rc->state) {
+    case WIFI_RC_CONNECTED:
+        // Link lost (AP reboot, roaming): the AP is probably the same one.
+        return rc_attempt(rc, now_ms);
+    case WIFI_RC_CONNECTING:
+        return rc_fail(rc, false);
+    case WIFI_RC_BACKOFF:
+    case WIFI_RC_IDLE:
+    default:
+        // Tail of an attempt already given up on.
+        return none;
+    }
+}
+
+uint32_t wifi_rc_on_got_ip(wifi_rc_t *rc, int64_t now_ms)
+{
+    uint32_t ms = 0;
+    if (rc->state == WIFI_RC_CONNECTING) {
+        ms = (uint32_t)(now_ms - rc->attempt_start_ms);
+        rc->last_connect_ms = ms;
+    }
+    rc->state = WIFI_RC_CONNECTED;
+    rc->failures = 0;
+    rc->cached_failures = 0;
+    return ms;
+}
+
+wifi_rc_action_t wifi_rc_on_timer(wifi_rc_t *rc, int64_t now_ms)
+{
+    wifi_rc_action_t none = {0};
+    if (rc->state == WIFI_RC_BACKOFF) {
+        return rc_attempt(rc, now_ms);
+    }
+    if (rc->state == WIFI_RC_CONNECTING && now_ms - rc->attempt_start_ms >= WIFI_RC_ATTEMPT_TIMEOUT_MS) {
+        // Associated without an IP (DHCP) or stuck: abort and back off.
+        return rc_fail(rc, true);
+    }
+    return none;
+}
+
+void wifi_rc_set_cache(wifi_rc_t *rc, bool have_cache)
+{
+    rc->have_cache = have_cache;
+    rc->cached_failures = 0;
+}
+
+bool wifi_rc_is_failing(const wifi_rc_t *rc)
+{
+    return rc->failures >= WIFI_RC_FAILING_AFTER;
+}
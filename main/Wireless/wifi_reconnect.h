@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Station (re)connect policy, kept free of ESP-IDF calls so it can be driven
+// by a mocked event source on the host. Wireless.c feeds it the WiFi/IP
+// events and a timer, and carries out the returned actions.
+//
+// It never gives up: failed attempts back off exponentially (with jitter)
+// up to WIFI_RC_BACKOFF_MAX_MS and keep retrying. While a cached AP
+// (BSSID + channel) is known, the first attempts go straight to it without
+// a full scan; after WIFI_RC_CACHED_TRIES failures in a row it is dropped
+// in favour of a normal scan.
+
+#define WIFI_RC_BACKOFF_BASE_MS  (500)
+#define WIFI_RC_BACKOFF_MAX_MS   (60 * 1000)
+// No IP this long after esp_wifi_connect() counts as a failed attempt.
+#define WIFI_RC_ATTEMPT_TIMEOUT_MS (20 * 1000)
+#define WIFI_RC_CACHED_TRIES     (2)
+// Reported as failing (still retrying) from this many failures in a row.
+#define WIFI_RC_FAILING_AFTER    (5)
+
+typedef enum {
+    WIFI_RC_IDLE = 0,
+    WIFI_RC_CONNECTING, // esp_wifi_connect() issued, waiting for an IP
+    WIFI_RC_CONNECTED,
+    WIFI_RC_BACKOFF,    // waiting for the retry timer
+} wifi_rc_state_t;
+
+typedef enum {
+    WIFI_RC_ACT_NONE = 0,
+    WIFI_RC_ACT_CONNECT, // call esp_wifi_connect() (cached AP if use_cached)
+    WIFI_RC_ACT_WAIT,    // back off
+} wifi_rc_act_t;
+
+// For CONNECT and WAIT, the timer is (re)armed for delay_ms and calls
+// wifi_rc_on_timer() when it fires.
+typedef struct {
+    wifi_rc_act_t act;
+    bool use_cached;
+    bool disconnect; // abort the attempt in progress first
+    uint32_t delay_ms;
+} wifi_rc_action_t;
+
+typedef struct {
+    wifi_rc_state_t state;
+    bool have_cache;
+    uint32_t failures;       // consecutive, reset on an IP
+    uint32_t cached_failures;
+    bool attempt_cached;
+    int64_t attempt_start_ms;
+    uint32_t attempts;       // total, for logs
+    uint32_t last_connect_ms; // latency of the last successful attempt
+    uint32_t rand_state;
+} wifi_rc_t;
+
+void wifi_rc_init(wifi_rc_t *rc, bool have_cache, uint32_t seed);
+
+// esp_wifi_start() done.
+wifi_rc_action_t wifi_rc_on_start(wifi_rc_t *rc, int64_t now_ms);
+
+// STA_DISCONNECTED, whether it was a failed attempt or a dropped link.
+wifi_rc_action_t wifi_rc_on_disconnected(wifi_rc_t *rc, int64_t now_ms);
+
+// GOT_IP. Returns the attempt's connect latency in ms.
+uint32_t wifi_rc_on_got_ip(wifi_rc_t *rc, int64_t now_ms);
+
+// Timer expiry: either the backoff elapsed or the attempt timed out.
+wifi_rc_action_t wifi_rc_on_timer(wifi_rc_t *rc, int64_t now_ms);
+
+// The cached AP was saved (or found invalid).
+void wifi_rc_set_cache(wifi_rc_t *rc, bool have_cache);
+
+bool wifi_rc_is_failing(const wifi_rc_t *rc);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,9 +1,14 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include <sys/time.h>
 #include <time.h>
 #include <string.h>
 
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
 #include "lvgl.h"
 
 #include "ST7789.h"
@@ -12,8 +17,14 @@
 
 #include "RGB.h"
 
+#include "http_conn.h"
+#include "net_service.h"
+#include "time_sync.h"
 #include "mbta.h"
+#include "mbta_alerts.h"
 #include "weather.h"
+#include "ui_bind.h"
+#include "ui_notify.h"
 
 typedef enum {
     UI_MODE_MBTA = 0,
@@ -30,6 +41,64 @@ static void ui_set_screen_bg(lv_obj_t *screen)
     lv_obj_set_style_bg_opa(screen, LV_OPA_COVER, 0);
 }
 
+// Text restored from the last boot, not yet refreshed.
+#define UI_STALE_COLOR 0x9E9E9E
+
+// Boot milestones, logged once each (ms since reset).
+static struct {
+    bool frame_done;
+    bool arrivals_done;
+    bool fresh_done;
+    bool arrivals_pending; // arrivals set on the labels, not yet drawn
+    bool arrivals_fresh;
+} s_boot;
+
+static void ui_boot_mark_frame(void)
+{
+    uint32_t ms = (uint32_t)(esp_timer_get_time() / 1000);
+    if (!s_boot.frame_done) {
+        s_boot.frame_done = true;
+        ESP_LOGI("BOOT", "first frame at %u ms", (unsigned)ms);
+    }
+    if (!s_boot.arrivals_pending) {
+        return;
+    }
+    s_boot.arrivals_pending = false;
+    if (!s_boot.arrivals_done) {
+        s_boot.arrivals_done = true;
+        ESP_LOGI("BOOT", "first arrivals at %u ms%s", (unsigned)ms, s_boot.arrivals_fresh ? "" : " (restored)");
+    }
+    if (s_boot.arrivals_fresh && !s_boot.fresh_done) {
+        s_boot.fresh_done = true;
+        ESP_LOGI("BOOT", "first live arrivals at %u ms", (unsigned)ms);
+    }
+}
+
+// Latest published state, re-copied only when a data task published
+// since the last call. NULL until the first publish.
+static const mbta_state_t *ui_mbta_state(void)
+{
+    static mbta_state_t st;
+    static uint32_t seen;
+    MBTA_GetStateIfChanged(&st, &seen);
+    return seen != 0 ? &st : NULL;
+}
+
+static const weather_state_t *ui_weather_state(void)
+{
+    static weather_state_t st;
+    static uint32_t seen;
+    Weather_GetStateIfChanged(&st, &seen);
+    return seen != 0 ? &st : NULL;
+}
+
+// 12-bit color is plenty for the MBTA screen's flat colors and text; the
+// weather loader's fade would band at 16 levels.
+static void ui_set_wire_format(ui_mode_t mode)
+{
+    LVGL_SetRgb444(LCD_USE_RGB444 && mode == UI_MODE_MBTA);
+}
+
 static void ui_switch_mode(ui_mode_t mode)
 {
     if (mode == s_ui_mode) {
@@ -37,6 +106,7 @@ static void ui_switch_mode(ui_mode_t mode)
     }
 
     s_ui_mode = mode;
+    ui_set_wire_format(mode);
     if (mode == UI_MODE_WEATHER && s_screen_weather != NULL) {
         lv_scr_load(s_screen_weather);
     } else if (mode == UI_MODE_MBTA && s_screen_mbta != NULL) {
@@ -46,7 +116,11 @@ static void ui_switch_mode(ui_mode_t mode)
 
 static lv_obj_t *s_mbta_no_bus_banner;
 static lv_obj_t *s_mbta_no_bus_label;
+static lv_obj_t *s_mbta_alert_banner;
+static lv_obj_t *s_mbta_alert_label;
+static uint32_t s_mbta_alerts_version;
 static lv_obj_t *s_mbta_title;
+static lv_obj_t *s_mbta_detail;
 static lv_obj_t *s_mbta_big_box;
 static lv_obj_t *s_mbta_big_minutes;
 static lv_obj_t *s_mbta_big_suffix;
@@ -55,8 +129,9 @@ static lv_obj_t *s_mbta_row2;
 static lv_obj_t *s_mbta_weather_label;
 static lv_obj_t *s_mbta_time_label;
 static lv_obj_t *s_mbta_loader;
-static uint32_t s_mbta_last_version;
 static bool s_mbta_is_fetching = false;
+// Countdown currently on screen, derived from the state's epochs.
+static mbta_countdown_t s_mbta_shown = {.count = -1};
 
 static lv_obj_t *s_weather_title;
 static lv_obj_t *s_weather_temp;
@@ -144,16 +219,16 @@ static void ui_weather_init(lv_obj_t *parent)
 
 static void ui_weather_update(void)
 {
-    weather_state_t st;
-    if (!Weather_GetState(&st)) {
+    const weather_state_t *st = ui_weather_state();
+    if (st == NULL) {
         return;
     }
 
     // Handle Loader/Fetching Animation
-    if (st.is_fetching != s_weather_is_fetching) {
-        s_weather_is_fetching = st.is_fetching;
+    if (st->is_fetching != s_weather_is_fetching) {
+        s_weather_is_fetching = st->is_fetching;
         if (s_weather_is_fetching) {
-            lv_obj_clear_flag(s_weather_loader, LV_OBJ_FLAG_HIDDEN);
+            UiBind_Hidden(s_weather_loader, false);
             // Signal Fetching: Yellow + Flash
             lv_obj_set_style_bg_color(s_weather_loader, lv_color_hex(0xFBC02D), LV_PART_INDICATOR);
             lv_bar_set_value(s_weather_loader, 1000, LV_ANIM_OFF);
@@ -174,8 +249,8 @@ static void ui_weather_update(void)
             lv_obj_set_style_opa(s_weather_loader, LV_OPA_COVER, 0);
             lv_obj_set_style_bg_color(s_weather_loader, lv_color_white(), LV_PART_INDICATOR);
 
-            if (st.has_data) {
-                lv_obj_clear_flag(s_weather_loader, LV_OBJ_FLAG_HIDDEN);
+            if (st->has_data) {
+                UiBind_Hidden(s_weather_loader, false);
                 lv_anim_t a;
                 lv_anim_init(&a);
                 lv_anim_set_var(&a, s_weather_loader);
@@ -184,31 +259,36 @@ static void ui_weather_update(void)
                 lv_anim_set_exec_cb(&a, set_loader_value_cb);
                 lv_anim_start(&a);
             } else {
-                lv_obj_add_flag(s_weather_loader, LV_OBJ_FLAG_HIDDEN);
+                UiBind_Hidden(s_weather_loader, true);
             }
         }
     }
 
-    if (st.version == s_weather_last_version) {
+    if (st->version == s_weather_last_version) {
         return;
     }
-    s_weather_last_version = st.version;
+    s_weather_last_version = st->version;
 
-    if (!st.has_data) {
-        lv_label_set_text(s_weather_temp, "--°C");
-        lv_label_set_text(s_weather_hilo, "H: --°C   L: --°C");
-        lv_label_set_text(s_weather_cond, st.is_fetching ? "Updating..." : st.condition);
+    if (!st->has_data) {
+        UiBind_Text(s_weather_temp, "--°C");
+        UiBind_Text(s_weather_hilo, "H: --°C   L: --°C");
+        UiBind_Text(s_weather_cond, st->is_fetching ? "Updating..." : st->condition);
         return;
     }
 
     char buf[48];
-    snprintf(buf, sizeof(buf), "%d" "\xC2\xB0" "C", st.temp_c);
-    lv_label_set_text(s_weather_temp, buf);
+    snprintf(buf, sizeof(buf), "%d" "\xC2\xB0" "C", st->temp_c);
+    UiBind_Text(s_weather_temp, buf);
 
-    snprintf(buf, sizeof(buf), "H: %d" "\xC2\xB0" "C   L: %d" "\xC2\xB0" "C", st.high_c, st.low_c);
-    lv_label_set_text(s_weather_hilo, buf);
+    snprintf(buf, sizeof(buf), "H: %d" "\xC2\xB0" "C   L: %d" "\xC2\xB0" "C", st->high_c, st->low_c);
+    UiBind_Text(s_weather_hilo, buf);
 
-    lv_label_set_text(s_weather_cond, st.condition);
+    UiBind_Text(s_weather_cond, st->condition);
+
+    lv_color_t color = st->stale ? lv_color_hex(UI_STALE_COLOR) : lv_color_white();
+    UiBind_TextColor(s_weather_temp, color);
+    UiBind_TextColor(s_weather_hilo, color);
+    UiBind_TextColor(s_weather_cond, color);
 }
 
 static void set_loader_opa_cb(void * var, int32_t v)
@@ -218,7 +298,7 @@ static void set_loader_opa_cb(void * var, int32_t v)
 
 static void set_loader_value_cb(void * var, int32_t v)
 {
-    lv_bar_set_value((lv_obj_t *)var, v, LV_ANIM_OFF);
+    UiBind_BarValue((lv_obj_t *)var, v);
 }
 
 static void ui_mbta_init(lv_obj_t *parent)
@@ -242,6 +322,30 @@ static void ui_mbta_init(lv_obj_t *parent)
 #endif
     lv_obj_add_flag(s_mbta_no_bus_banner, LV_OBJ_FLAG_HIDDEN);
 
+    // Service alert banner (sits on top of the no-service banner when both show)
+    s_mbta_alert_banner = lv_obj_create(parent);
+    lv_obj_set_size(s_mbta_alert_banner, lv_pct(100), 18);
+    lv_obj_align(s_mbta_alert_banner, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_obj_set_style_radius(s_mbta_alert_banner, 0, 0);
+    lv_obj_set_style_border_width(s_mbta_alert_banner, 0, 0);
+    lv_obj_set_style_pad_all(s_mbta_alert_banner, 2, 0);
+    lv_obj_set_style_bg_color(s_mbta_alert_banner, lv_color_hex(0xFFB74D), 0);
+    lv_obj_clear_flag(s_mbta_alert_banner, LV_OBJ_FLAG_SCROLLABLE);
+
+    s_mbta_alert_label = lv_label_create(s_mbta_alert_banner);
+    lv_obj_set_width(s_mbta_alert_label, lv_pct(100));
+    // Dots rather than scrolling: no redraws while the alert stays the same.
+    lv_label_set_long_mode(s_mbta_alert_label, LV_LABEL_LONG_DOT);
+    lv_obj_set_style_text_color(s_mbta_alert_label, lv_color_black(), 0);
+    lv_obj_set_style_text_align(s_mbta_alert_label, LV_TEXT_ALIGN_CENTER, 0);
+#if LV_FONT_MONTSERRAT_12
+    lv_obj_set_style_text_font(s_mbta_alert_label, &lv_font_montserrat_12, 0);
+#endif
+    lv_obj_align(s_mbta_alert_label, LV_ALIGN_CENTER, 0, 0);
+    lv_label_set_text(s_mbta_alert_label, "");
+
+    lv_obj_add_flag(s_mbta_alert_banner, LV_OBJ_FLAG_HIDDEN);
+
     // Title (centered)
     s_mbta_title = lv_label_create(parent);
     lv_obj_set_width(s_mbta_title, lv_pct(100));
@@ -257,6 +361,17 @@ static void ui_mbta_init(lv_obj_t *parent)
     lv_obj_set_style_text_align(s_mbta_title, LV_TEXT_ALIGN_CENTER, 0);
     lv_label_set_text(s_mbta_title, "Loading...");
 
+    // Headsign / stops away / crowding of the next arrival
+    s_mbta_detail = lv_label_create(parent);
+    lv_obj_set_width(s_mbta_detail, lv_pct(100));
+    lv_obj_align(s_mbta_detail, LV_ALIGN_TOP_MID, 0, 44);
+    lv_obj_set_style_text_color(s_mbta_detail, lv_color_hex(0xBDBDBD), 0);
+#if LV_FONT_MONTSERRAT_12
+    lv_obj_set_style_text_font(s_mbta_detail, &lv_font_montserrat_12, 0);
+#endif
+    lv_obj_set_style_text_align(s_mbta_detail, LV_TEXT_ALIGN_CENTER, 0);
+    lv_label_set_text(s_mbta_detail, "");
+
     // Big minutes box
     s_mbta_big_box = lv_obj_create(parent);
     lv_obj_set_size(s_mbta_big_box, 140, 120);
@@ -352,9 +467,113 @@ static void ui_mbta_init(lv_obj_t *parent)
     lv_obj_set_style_bg_color(s_mbta_loader, lv_color_hex(0x444444), LV_PART_MAIN);
     lv_obj_set_style_bg_color(s_mbta_loader, lv_color_white(), LV_PART_INDICATOR);
 
-    s_mbta_last_version = 0;
+    s_mbta_shown.version = 0;
+}
+
+static const char *mbta_occupancy_text(uint8_t occupancy)
+{
+    switch (occupancy) {
+        case MBTA_OCCUPANCY_MANY_SEATS: return "Many seats";
+        case MBTA_OCCUPANCY_FEW_SEATS:  return "Few seats";
+        case MBTA_OCCUPANCY_STANDING:   return "Standing room";
+        case MBTA_OCCUPANCY_FULL:       return "Full";
+        default:                        return NULL;
+    }
+}
+
+// "Kenmore - 3 stops away - Few seats" for the first arrival not yet gone.
+static void ui_mbta_set_detail(const mbta_state_t *st, time_t now)
+{
+    const mbta_arrival_detail_t *d = NULL;
+    for (int i = 0; i < st->arrival_count; i++) {
+        if (MBTA_MinutesUntil(st->arrivals_epoch[i], now) >= 0) {
+            d = &st->arrival_details[i];
+            break;
+        }
+    }
+
+    char buf[64] = "";
+    if (st->stale) {
+        // Restored at boot: say how old the times are until a fetch lands.
+        struct tm tm_fetched;
+        localtime_r(&st->fetched_at, &tm_fetched);
+        strftime(buf, sizeof(buf), "Last update %H:%M", &tm_fetched);
+    } else if (st->scheduled) {
+        strlcpy(buf, "Scheduled", sizeof(buf));
+    } else if (d) {
+        size_t len = 0;
+        if (d->headsign[0] != '\0') {
+            len += snprintf(buf + len, sizeof(buf) - len, "%s", d->headsign);
+        }
+        if (d->stops_away >= 0 && len < sizeof(buf)) {
+            len += snprintf(buf + len, sizeof(buf) - len, "%s%d stop%s away",
+                            len ? " - " : "", d->stops_away, d->stops_away == 1 ? "" : "s");
+        }
+        const char *occ = mbta_occupancy_text(d->occupancy);
+        if (occ && len < sizeof(buf)) {
+            snprintf(buf + len, sizeof(buf) - len, "%s%s", len ? " - " : "", occ);
+        }
+    }
+    UiBind_Text(s_mbta_detail, buf);
+}
+
+#if LCD_USE_HW_TICKER
+static char s_mbta_alert_text[112];
+#endif
+
+static void ui_mbta_place_alert_banner(void)
+{
+    bool no_bus = !lv_obj_has_flag(s_mbta_no_bus_banner, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_align(s_mbta_alert_banner, LV_ALIGN_BOTTOM_MID, 0, no_bus ? -18 : 0);
+}
+
+// Only touches the banner when the alerts themselves changed.
+static void ui_mbta_alerts_update(void)
+{
+    mbta_alerts_state_t al;
+    if (!MBTA_GetAlerts(&al) || al.version == s_mbta_alerts_version) {
+        return;
+    }
+    s_mbta_alerts_version = al.version;
+
+    if (!al.has_data || al.count == 0) {
+        UiBind_Hidden(s_mbta_alert_banner, true);
+        return;
+    }
+
+    char buf[112];
+    if (al.count > 1) {
+        snprintf(buf, sizeof(buf), "%s (+%d)", al.header, al.count - 1);
+    } else {
+        strlcpy(buf, al.header, sizeof(buf));
+    }
+    UiBind_Text(s_mbta_alert_label, buf);
+#if LCD_USE_HW_TICKER
+    strlcpy(s_mbta_alert_text, buf, sizeof(s_mbta_alert_text));
+#endif
+    // Severe (7+) in red like the no-service banner.
+    lv_obj_set_style_bg_color(s_mbta_alert_banner, lv_color_hex(al.severity >= 7 ? 0xE57373 : 0xFFB74D), 0);
+    UiBind_Hidden(s_mbta_alert_banner, false);
 }
 
+#if LCD_USE_HW_TICKER
+// The whole alert, scrolled through the banner by the panel while the MBTA
+// screen is up. The label underneath shows again once the ticker stops.
+static void ui_mbta_alert_ticker(void)
+{
+    if (s_ui_mode != UI_MODE_MBTA || lv_obj_has_flag(s_mbta_alert_banner, LV_OBJ_FLAG_HIDDEN)) {
+        LVGL_TickerHide();
+        return;
+    }
+
+    lv_area_t a;
+    lv_obj_update_layout(s_mbta_alert_banner);
+    lv_obj_get_coords(s_mbta_alert_banner, &a);
+    LVGL_TickerShow(a.y1, lv_area_get_height(&a), s_mbta_alert_text, &lv_font_montserrat_12, lv_color_black(),
+                    lv_obj_get_style_bg_color(s_mbta_alert_banner, LV_PART_MAIN));
+}
+#endif
+
 static void ui_mbta_update(void)
 {
     // Update Time
@@ -370,25 +589,27 @@ static void ui_mbta_update(void)
         if (now > 1577836800) { // Sane time check (> 2020)
             char time_buf[32];
             strftime(time_buf, sizeof(time_buf), "%b %d %H:%M", &timeinfo);
-            lv_label_set_text(s_mbta_time_label, time_buf);
+            UiBind_Text(s_mbta_time_label, time_buf);
         } else {
-            lv_label_set_text(s_mbta_time_label, "");
+            UiBind_Text(s_mbta_time_label, "");
         }
 
         // Update Weather on MBTA screen
-        weather_state_t wst;
-        if (Weather_GetState(&wst) && wst.has_data) {
+        const weather_state_t *wst = ui_weather_state();
+        if (wst != NULL && wst->has_data) {
             char w_buf[64];
             snprintf(w_buf, sizeof(w_buf), "%d  L: %d H: %d  %s", 
-                     wst.temp_c, wst.low_c, wst.high_c, wst.condition);
-            lv_label_set_text(s_mbta_weather_label, w_buf);
+                     wst->temp_c, wst->low_c, wst->high_c, wst->condition);
+            UiBind_Text(s_mbta_weather_label, w_buf);
         } else {
-            lv_label_set_text(s_mbta_weather_label, "");
+            UiBind_Text(s_mbta_weather_label, "");
         }
     }
 
-    mbta_state_t st;
-    if (!MBTA_GetState(&st)) {
+    ui_mbta_alerts_update();
+
+    const mbta_state_t *st = ui_mbta_state();
+    if (st == NULL) {
         return;
     }
 
@@ -396,10 +617,10 @@ static void ui_mbta_update(void)
     // We no longer turn the backlight off here; main loop will swap to Weather.
 
     // Handle Loader/Fetching Animation
-    if (st.is_fetching != s_mbta_is_fetching) {
-        s_mbta_is_fetching = st.is_fetching;
+    if (st->is_fetching != s_mbta_is_fetching) {
+        s_mbta_is_fetching = st->is_fetching;
         if (s_mbta_is_fetching) {
-            lv_obj_clear_flag(s_mbta_loader, LV_OBJ_FLAG_HIDDEN);
+            UiBind_Hidden(s_mbta_loader, false);
             // Signal Fetching: Yellow + Flash
             lv_obj_set_style_bg_color(s_mbta_loader, lv_color_hex(0xFBC02D), LV_PART_INDICATOR);
             lv_bar_set_value(s_mbta_loader, 1000, LV_ANIM_OFF);
@@ -415,88 +636,96 @@ static void ui_mbta_update(void)
             lv_anim_set_exec_cb(&a, set_loader_opa_cb);
             lv_anim_start(&a);
         } else {
-            // Fetch Done: White + Restart 30s Countdown
+            // Fetch Done: White + Countdown to the next fetch
             lv_anim_del(s_mbta_loader, set_loader_opa_cb);
             lv_obj_set_style_opa(s_mbta_loader, LV_OPA_COVER, 0);
             lv_obj_set_style_bg_color(s_mbta_loader, lv_color_white(), LV_PART_INDICATOR);
             
-            if (st.has_data) {
-                lv_obj_clear_flag(s_mbta_loader, LV_OBJ_FLAG_HIDDEN);
+            // A streamed stop (refresh_ms == 0) has no next fetch to count down to.
+            if (st->has_data && st->refresh_ms != 0) {
+                UiBind_Hidden(s_mbta_loader, false);
                 lv_anim_t a;
                 lv_anim_init(&a);
                 lv_anim_set_var(&a, s_mbta_loader);
                 lv_anim_set_values(&a, 1000, 0);
-                lv_anim_set_time(&a, MBTA_FETCH_PERIOD_MS);
+                lv_anim_set_time(&a, st->refresh_ms);
                 lv_anim_set_exec_cb(&a, set_loader_value_cb);
                 lv_anim_start(&a);
             } else {
-                lv_obj_add_flag(s_mbta_loader, LV_OBJ_FLAG_HIDDEN);
+                UiBind_Hidden(s_mbta_loader, true);
             }
         }
     }
 
-    if (st.version == s_mbta_last_version) {
+    // Minutes are re-derived from the absolute epochs every pass; only
+    // re-render when the rounded values change (or the state itself did).
+    if (!MBTA_CountdownUpdate(&s_mbta_shown, st, now)) {
         return;
     }
-    s_mbta_last_version = st.version;
+    const int *mins = s_mbta_shown.minutes;
+    int mins_count = s_mbta_shown.count;
 
-    if (st.no_bus_service_banner) {
-        lv_obj_clear_flag(s_mbta_no_bus_banner, LV_OBJ_FLAG_HIDDEN);
-    } else {
-        lv_obj_add_flag(s_mbta_no_bus_banner, LV_OBJ_FLAG_HIDDEN);
-    }
+    UiBind_Hidden(s_mbta_no_bus_banner, !st->no_bus_service_banner);
+    ui_mbta_place_alert_banner();
 
-    if (st.title[0] != '\0') {
-        lv_label_set_text(s_mbta_title, st.title);
+    if (st->title[0] != '\0') {
+        UiBind_Text(s_mbta_title, st->title);
     }
 
-    if (!st.has_data) {
-        lv_label_set_text(s_mbta_big_minutes, "--");
-        lv_obj_add_flag(s_mbta_big_suffix, LV_OBJ_FLAG_HIDDEN);
+    if (!st->has_data) {
+        UiBind_Text(s_mbta_big_minutes, "--");
+        UiBind_Hidden(s_mbta_big_suffix, true);
 
-        if (strcmp(st.title, "Sleep Mode") == 0) {
-            lv_obj_add_flag(s_mbta_big_box, LV_OBJ_FLAG_HIDDEN);
-            lv_label_set_text(s_mbta_row1, "Service resumes at 6am");
+        if (strcmp(st->title, "Sleep Mode") == 0) {
+            UiBind_Hidden(s_mbta_big_box, true);
+            UiBind_Text(s_mbta_row1, "Service resumes at 6am");
         } else {
-            lv_obj_clear_flag(s_mbta_big_box, LV_OBJ_FLAG_HIDDEN);
-            lv_label_set_text(s_mbta_row1, "No data");
+            UiBind_Hidden(s_mbta_big_box, false);
+            UiBind_Text(s_mbta_row1, "No data");
         }
-        lv_label_set_text(s_mbta_row2, "");
+        UiBind_Text(s_mbta_row2, "");
+        UiBind_Text(s_mbta_detail, "");
         return;
     }
 
-    lv_obj_clear_flag(s_mbta_big_box, LV_OBJ_FLAG_HIDDEN);
+    UiBind_Hidden(s_mbta_big_box, false);
+    ui_mbta_set_detail(st, now);
+    UiBind_TextColor(s_mbta_big_minutes, st->stale ? lv_color_hex(UI_STALE_COLOR) : lv_color_white());
 
-    if (st.arrival_count <= 0) {
-        lv_label_set_text(s_mbta_big_minutes, "--");
-        lv_obj_add_flag(s_mbta_big_suffix, LV_OBJ_FLAG_HIDDEN);
-        lv_label_set_text(s_mbta_row1, "No upcoming arrivals");
-        lv_label_set_text(s_mbta_row2, "");
+    if (mins_count <= 0) {
+        UiBind_Text(s_mbta_big_minutes, "--");
+        UiBind_Hidden(s_mbta_big_suffix, true);
+        UiBind_Text(s_mbta_row1, "No upcoming arrivals");
+        UiBind_Text(s_mbta_row2, "");
         return;
     }
 
+    // Shown from the next frame on.
+    s_boot.arrivals_pending = true;
+    s_boot.arrivals_fresh = !st->stale && !st->scheduled;
+
     char buf[32];
-    if (st.arrivals_min[0] <= 0) {
-        lv_label_set_text(s_mbta_big_minutes, "ARR");
-        lv_obj_add_flag(s_mbta_big_suffix, LV_OBJ_FLAG_HIDDEN);
+    if (mins[0] <= 0) {
+        UiBind_Text(s_mbta_big_minutes, "ARR");
+        UiBind_Hidden(s_mbta_big_suffix, true);
     } else {
-        snprintf(buf, sizeof(buf), "%d", st.arrivals_min[0]);
-        lv_label_set_text(s_mbta_big_minutes, buf);
-        lv_obj_clear_flag(s_mbta_big_suffix, LV_OBJ_FLAG_HIDDEN);
+        snprintf(buf, sizeof(buf), "%d", mins[0]);
+        UiBind_Text(s_mbta_big_minutes, buf);
+        UiBind_Hidden(s_mbta_big_suffix, false);
     }
 
-    if (st.arrival_count >= 2) {
-        snprintf(buf, sizeof(buf), "Next: %d min", st.arrivals_min[1]);
-        lv_label_set_text(s_mbta_row1, buf);
+    if (mins_count >= 2) {
+        snprintf(buf, sizeof(buf), "Next: %d min", mins[1]);
+        UiBind_Text(s_mbta_row1, buf);
     } else {
-        lv_label_set_text(s_mbta_row1, "");
+        UiBind_Text(s_mbta_row1, "");
     }
 
-    if (st.arrival_count >= 3) {
-        snprintf(buf, sizeof(buf), "Then: %d min", st.arrivals_min[2]);
-        lv_label_set_text(s_mbta_row2, buf);
+    if (mins_count >= 3) {
+        snprintf(buf, sizeof(buf), "Then: %d min", mins[2]);
+        UiBind_Text(s_mbta_row2, buf);
     } else {
-        lv_label_set_text(s_mbta_row2, "");
+        UiBind_Text(s_mbta_row2, "");
     }
 }
 
@@ -554,8 +783,63 @@ static void ui_wifi_status_update(void)
     }
 }
 
+// The loop sleeps until the next LVGL timer is due or a data task publishes
+// (UiNotify_Signal), and at least once a second: the clock and the countdowns
+// are derived from time(), not published.
+#define UI_MAX_SLEEP_MS    (1000)
+#define UI_STATS_PERIOD_MS (60 * 1000)
+
+static struct {
+    uint32_t wakeups;
+    uint32_t signalled;
+    int64_t idle_us;
+    int64_t since_us;
+} s_loop;
+
+static uint32_t ui_sleep_ms(uint32_t lv_next_ms)
+{
+    // Wake just after the next whole second so the clock ticks on time.
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    uint32_t ms = UI_MAX_SLEEP_MS - (uint32_t)(tv.tv_usec / 1000);
+    // LV_NO_TIMER_READY when nothing is animating or invalidated.
+    return lv_next_ms < ms ? lv_next_ms : ms;
+}
+
+static void ui_loop_wait(uint32_t timeout_ms)
+{
+    int64_t start_us = esp_timer_get_time();
+    bool signalled = UiNotify_Wait(timeout_ms);
+    int64_t now_us = esp_timer_get_time();
+
+    s_loop.wakeups++;
+    if (signalled) {
+        s_loop.signalled++;
+    }
+    s_loop.idle_us += now_us - start_us;
+
+    int64_t period_us = now_us - s_loop.since_us;
+    if (period_us >= (int64_t)UI_STATS_PERIOD_MS * 1000) {
+        ui_bind_stats_t bind;
+        UiBind_TakeStats(&bind);
+        lvgl_flush_stats_t flush;
+        LVGL_TakeFlushStats(&flush);
+        ESP_LOGI("UI", "%u wakeups in %u s (%u signalled), idle %u%%, widgets %u set / %u unchanged",
+                 (unsigned)s_loop.wakeups, (unsigned)(period_us / 1000000), (unsigned)s_loop.signalled,
+                 (unsigned)(s_loop.idle_us * 100 / period_us), (unsigned)bind.applied, (unsigned)bind.skipped);
+        ESP_LOGI("UI", "%u frames: render %u ms, wire %u ms, waiting on the wire %u ms", (unsigned)flush.frames,
+                 (unsigned)(flush.render_us / 1000), (unsigned)(flush.wire_us / 1000), (unsigned)(flush.wait_us / 1000));
+        s_loop.wakeups = 0;
+        s_loop.signalled = 0;
+        s_loop.idle_us = 0;
+        s_loop.since_us = now_us;
+    }
+}
+
 void app_main(void)
 {
+    ESP_LOGI("BOOT", "reset reason %d", (int)esp_reset_reason());
+
     // US Eastern with DST rules (set early for UI)
     setenv("TZ", DEFAULT_TIMEZONE, 1);
     tzset();
@@ -582,7 +866,13 @@ void app_main(void)
     ui_mbta_init(s_screen_mbta);
     ui_weather_init(s_screen_weather);
 
+    // Before the data tasks start, so no publish is missed.
+    UiNotify_Init();
+
+    TimeSync_Start();
     Wireless_Init();
+    HttpConn_Init();
+    NetService_Start();
     Weather_TaskStart();
     if (!UI_FORCE_WEATHER) {
         MBTA_TaskStart();
@@ -596,11 +886,11 @@ void app_main(void)
         s_ui_mode = UI_MODE_MBTA;
         lv_scr_load(s_screen_mbta);
     }
+    ui_set_wire_format(s_ui_mode);
 
+    s_loop.since_us = esp_timer_get_time();
     while (1)
     {
-        vTaskDelay(pdMS_TO_TICKS(10));
-        lv_timer_handler();
         ui_wifi_status_update();
 
         // Update both screens (objects can be updated even when not active).
@@ -609,10 +899,20 @@ void app_main(void)
             ui_mbta_update();
 
             // Switch to Weather when MBTA is in its scheduled "display_off" period.
-            mbta_state_t st;
-            if (MBTA_GetState(&st)) {
-                ui_switch_mode(st.display_off ? UI_MODE_WEATHER : UI_MODE_MBTA);
+            const mbta_state_t *st = ui_mbta_state();
+            if (st != NULL) {
+                ui_switch_mode(st->display_off ? UI_MODE_WEATHER : UI_MODE_MBTA);
             }
+#if LCD_USE_HW_TICKER
+            ui_mbta_alert_ticker();
+#endif
         }
+
+        // After the updates, so what they invalidated is drawn before sleeping.
+        LVGL_TickUpdate();
+        uint32_t lv_next_ms = lv_timer_handler();
+        ui_boot_mark_frame();
+
+        ui_loop_wait(ui_sleep_ms(lv_next_ms));
     }
 }
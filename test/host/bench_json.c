@@ -0,0 +1,309 @@
+// Prediction parsing: the streaming parser in mbta.c (fed in socket-sized
+// chunks) against the cJSON path it replaced (whole body in a 16 KB buffer,
+// then a DOM). Reports time per response and peak memory for each.
+//
+// The responses are built in the layout of
+// /predictions?filter[stop]=...&include=trip,vehicle. Recorded ones can be
+// passed as arguments instead; predictions older than now are filtered out
+// by both paths alike, so those only compare time and memory.
+//
+// The cJSON side is built when CJSON_DIR points at cJSON's sources (see
+// the Makefile).
+
+#include "mbta.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if HAVE_CJSON
+#include "cJSON.h"
+#endif
+
+#define BENCH_CHUNK   512   // bytes per socket read
+#define BENCH_OLD_BUF 16384 // the old body buffer
+
+static const char *s_body;
+static size_t s_body_len;
+
+// Fakes for what mbta.c calls outside the parser.
+int64_t esp_timer_get_time(void) { return 0; }
+uint32_t esp_random(void) { return 0; }
+wireless_status_t Wireless_GetStatus(void) { return WIRELESS_STATUS_CONNECTED; }
+bool TimeSync_Wait(uint32_t timeout_ms) { (void)timeout_ms; return true; }
+void UiNotify_Signal(void) {}
+bool Snapshot_Load(snapshot_id_t id, void *buf, size_t size) { (void)id; (void)buf; (void)size; return false; }
+void Snapshot_Save(snapshot_id_t id, const void *buf, size_t size) { (void)id; (void)buf; (void)size; }
+void vTaskDelay(TickType_t ticks) { (void)ticks; }
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void *), const char *name, uint32_t stack, void *arg,
+                                   int prio, TaskHandle_t *out_handle, int core)
+{
+    (void)fn; (void)name; (void)stack; (void)arg; (void)prio; (void)out_handle; (void)core;
+    return pdPASS;
+}
+
+esp_err_t NetService_Get(const http_conn_request_t *req, net_prio_t prio, uint32_t deadline_ms,
+                         int *out_http_status)
+{
+    (void)prio;
+    (void)deadline_ms;
+    *out_http_status = 200;
+    for (size_t off = 0; off < s_body_len; off += BENCH_CHUNK) {
+        size_t n = s_body_len - off < BENCH_CHUNK ? s_body_len - off : BENCH_CHUNK;
+        if (!req->on_body(s_body + off, n, req->ctx)) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+    return ESP_OK;
+}
+
+// n predictions at stop 1295 on route 65, ascending, with their trips and
+// vehicles included.
+static size_t make_response(char *buf, size_t size, int n, time_t now)
+{
+    size_t len = (size_t)snprintf(buf, size, "{\"data\":[");
+    for (int i = 0; i < n && len < size; i++) {
+        char at[32];
+        time_t t = now + 120 + 90 * i;
+        struct tm tm;
+        localtime_r(&t, &tm);
+        strftime(at, sizeof(at), "%Y-%m-%dT%H:%M:%S%z", &tm);
+        // %z gives -0400; V3 sends -04:00.
+        memmove(at + 23, at + 22, 3);
+        at[22] = ':';
+        len += (size_t)snprintf(buf + len, size - len,
+            "%s{\"attributes\":{\"arrival_time\":\"%s\",\"arrival_uncertainty\":60,\"departure_time\":\"%s\","
+            "\"departure_uncertainty\":60,\"direction_id\":1,\"revenue\":\"REVENUE\",\"schedule_relationship\":null,"
+            "\"status\":null,\"stop_sequence\":%d,\"update_type\":\"MID_TRIP\"},\"id\":\"prediction-7006%04d-1295-%d\","
+            "\"relationships\":{\"route\":{\"data\":{\"id\":\"65\",\"type\":\"route\"}},"
+            "\"stop\":{\"data\":{\"id\":\"1295\",\"type\":\"stop\"}},"
+            "\"trip\":{\"data\":{\"id\":\"7006%04d\",\"type\":\"trip\"}},"
+            "\"vehicle\":{\"data\":{\"id\":\"y%04d\",\"type\":\"vehicle\"}}},\"type\":\"prediction\"}",
+            i ? "," : "", at, at, 20, i, 20, i, i);
+    }
+    len += (size_t)snprintf(buf + len, size > len ? size - len : 0, "],\"included\":[");
+    for (int i = 0; i < n && len < size; i++) {
+        len += (size_t)snprintf(buf + len, size - len,
+            "%s{\"attributes\":{\"bikes_allowed\":1,\"block_id\":\"T65-%d\",\"direction_id\":1,"
+            "\"headsign\":\"Kenmore\",\"name\":\"\",\"wheelchair_accessible\":1},\"id\":\"7006%04d\",\"type\":\"trip\"},"
+            "{\"attributes\":{\"bearing\":90,\"current_status\":\"IN_TRANSIT_TO\",\"current_stop_sequence\":%d,"
+            "\"label\":\"%04d\",\"latitude\":42.34,\"longitude\":-71.14,\"occupancy_status\":\"MANY_SEATS_AVAILABLE\","
+            "\"speed\":null,\"updated_at\":\"2026-10-16T08:00:00-04:00\"},\"id\":\"y%04d\",\"type\":\"vehicle\"}",
+            i ? "," : "", i, i, 20 - i % 5, 1000 + i, i);
+    }
+    len += (size_t)snprintf(buf + len, size > len ? size - len : 0, "],\"jsonapi\":{\"version\":\"1.0\"}}");
+    return len < size ? len : 0;
+}
+
+static double elapsed_us(const struct timespec *a, const struct timespec *b)
+{
+    return (double)(b->tv_sec - a->tv_sec) * 1e6 + (double)(b->tv_nsec - a->tv_nsec) / 1e3;
+}
+
+static bool stream_parse(mbta_epoch_list_t *out)
+{
+    static mbta_job_t job;
+    strlcpy(job.url, "bench", sizeof(job.url));
+    job.last_modified[0] = '\0';
+    return fetch_predictions(&job, &s_match_all, 1, out);
+}
+
+#if HAVE_CJSON
+// Heap high-water mark of cJSON's allocations.
+static size_t s_heap_now;
+static size_t s_heap_peak;
+
+typedef union {
+    size_t size;
+    max_align_t align;
+} heap_hdr_t;
+
+static void *counting_malloc(size_t size)
+{
+    heap_hdr_t *h = malloc(sizeof(*h) + size);
+    if (h == NULL) {
+        return NULL;
+    }
+    h->size = size;
+    s_heap_now += size;
+    if (s_heap_now > s_heap_peak) {
+        s_heap_peak = s_heap_now;
+    }
+    return h + 1;
+}
+
+static void counting_free(void *p)
+{
+    if (p != NULL) {
+        heap_hdr_t *h = (heap_hdr_t *)p - 1;
+        s_heap_now -= h->size;
+        free(h);
+    }
+}
+
+static int cmp_time_t(const void *a, const void *b)
+{
+    const time_t *ta = (const time_t *)a;
+    const time_t *tb = (const time_t *)b;
+    return (*ta > *tb) - (*ta < *tb);
+}
+
+// The removed parse_prediction_epochs(), minus its logging.
+static bool cjson_parse(const char *json, time_t *out_epochs, int max_epochs, int *out_count)
+{
+    *out_count = 0;
+    cJSON *root = cJSON_Parse(json);
+    if (root == NULL) {
+        return false;
+    }
+    cJSON *data = cJSON_GetObjectItemCaseSensitive(root, "data");
+    if (!cJSON_IsArray(data)) {
+        cJSON_Delete(root);
+        return false;
+    }
+
+    int count = 0;
+    time_t now = time(NULL);
+    cJSON *item = NULL;
+    cJSON_ArrayForEach(item, data) {
+        if (count >= max_epochs) {
+            break;
+        }
+        cJSON *attributes = cJSON_GetObjectItemCaseSensitive(item, "attributes");
+        if (!cJSON_IsObject(attributes)) {
+            continue;
+        }
+        const cJSON *arrival = cJSON_GetObjectItemCaseSensitive(attributes, "arrival_time");
+        const cJSON *departure = cJSON_GetObjectItemCaseSensitive(attributes, "departure_time");
+        const char *tstr = NULL;
+        if (cJSON_IsString(arrival) && arrival->valuestring) {
+            tstr = arrival->valuestring;
+        } else if (cJSON_IsString(departure) && departure->valuestring) {
+            tstr = departure->valuestring;
+        }
+        time_t epoch = 0;
+        if (tstr == NULL || !iso8601_to_epoch_utc(tstr, &epoch) || epoch < now - 30) {
+            continue;
+        }
+        out_epochs[count++] = epoch;
+    }
+    cJSON_Delete(root);
+
+    qsort(out_epochs, (size_t)count, sizeof(time_t), cmp_time_t);
+    *out_count = count;
+    return true;
+}
+
+// The old fetch: read at most BENCH_OLD_BUF - 1 bytes, then parse.
+static bool cjson_fetch(time_t *out_epochs, int *out_count, bool *truncated)
+{
+    char *buf = calloc(1, BENCH_OLD_BUF);
+    if (buf == NULL) {
+        return false;
+    }
+    size_t n = s_body_len < BENCH_OLD_BUF - 1 ? s_body_len : BENCH_OLD_BUF - 1;
+    memcpy(buf, s_body, n);
+    *truncated = n < s_body_len;
+    bool ok = cjson_parse(buf, out_epochs, MBTA_MAX_EPOCHS, out_count);
+    free(buf);
+    return ok;
+}
+#endif
+
+static int bench_one(const char *name, int reps)
+{
+    struct timespec t0, t1;
+    mbta_epoch_list_t list = {0};
+    bool ok = false;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int r = 0; r < reps; r++) {
+        ok = stream_parse(&list);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("%-22s %7zu B  stream: %s %d kept, %8.1f us, %zu B static, 0 B heap\n", name, s_body_len,
+           ok ? "ok" : "FAILED", list.count, elapsed_us(&t0, &t1) / reps, sizeof(prediction_parser_t));
+    if (!ok) {
+        return 1;
+    }
+
+#if HAVE_CJSON
+    time_t epochs[MBTA_MAX_EPOCHS];
+    int count = 0;
+    bool truncated = false;
+    bool cok = false;
+    s_heap_peak = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int r = 0; r < reps; r++) {
+        cok = cjson_fetch(epochs, &count, &truncated);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("%-22s %9s  cJSON:  %s %d kept, %8.1f us, %d B buffer + %zu B DOM peak\n", "", "",
+           truncated ? "TRUNCATED" : cok ? "ok" : "failed", count, elapsed_us(&t0, &t1) / reps, BENCH_OLD_BUF,
+           s_heap_peak);
+    // Same earliest arrivals wherever the old path still worked.
+    if (cok && !truncated && (count != list.count || memcmp(epochs, list.epochs, (size_t)count * sizeof(time_t)) != 0)) {
+        printf("MISMATCH between the two parsers\n");
+        return 1;
+    }
+#endif
+    return 0;
+}
+
+static char *read_file(const char *path, size_t *out_len)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = malloc((size_t)size + 1);
+    if (buf != NULL && fread(buf, 1, (size_t)size, f) == (size_t)size) {
+        buf[size] = '\0';
+        *out_len = (size_t)size;
+    } else {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    return buf;
+}
+
+int main(int argc, char **argv)
+{
+    int fail = 0;
+#if HAVE_CJSON
+    cJSON_Hooks hooks = {.malloc_fn = counting_malloc, .free_fn = counting_free};
+    cJSON_InitHooks(&hooks);
+#else
+    printf("(cJSON not built: set CJSON_DIR for the comparison)\n");
+#endif
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            char *body = read_file(argv[i], &s_body_len);
+            if (body == NULL) {
+                fprintf(stderr, "cannot read %s\n", argv[i]);
+                return 1;
+            }
+            s_body = body;
+            fail |= bench_one(argv[i], 200);
+            free(body);
+        }
+        return fail;
+    }
+
+    // page[limit]=10 (the old URLs), then bigger pages and combined fetches.
+    static const int sizes[] = {10, 20, 40, 80, 160};
+    static char body[1 << 20];
+    time_t now = time(NULL);
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        s_body_len = make_response(body, sizeof(body), sizes[i], now);
+        s_body = body;
+        char name[32];
+        snprintf(name, sizeof(name), "%d predictions", sizes[i]);
+        fail |= bench_one(name, 200);
+    }
+    return fail;
+}
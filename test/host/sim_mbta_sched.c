@@ -0,0 +1,295 @@
+// The poll scheduler in mbta_task, run against a simulated clock and API:
+// SIM_STOPS stops (built as 2, 8, 8 combined and 32, see the Makefile),
+// two healthy hours, a ten-minute outage, then half an hour to recover.
+//
+// Every request takes 300 ms. Stop i sees a vehicle every few minutes on
+// its own headway, so the adaptive interval moves between MBTA_POLL_MIN_MS
+// and MBTA_POLL_MAX_MS. Checked:
+//   - request rate: no job more often than once per MBTA_POLL_MIN_MS
+//   - bursts: requests of different jobs MBTA_JOB_SPACING_MS apart, so any
+//     5 s window sees a few however many stops
+//   - staleness: no stop goes longer than MBTA_POLL_MAX_MS unfetched
+//   - recovery: every stop is fetched again within the backoff cap (plus
+//     jitter) of the outage ending
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef SIM_STOPS
+#define SIM_STOPS 2
+#endif
+
+// Stops "1000".."1031" on any route.
+#define SIM_STOP(n) {"10" #n, "", "Stop " #n},
+#define SIM_STOPS_2 SIM_STOP(00) SIM_STOP(01)
+#define SIM_STOPS_8 SIM_STOPS_2 SIM_STOP(02) SIM_STOP(03) SIM_STOP(04) SIM_STOP(05) SIM_STOP(06) SIM_STOP(07)
+#define SIM_STOPS_32 SIM_STOPS_8 \
+    SIM_STOP(08) SIM_STOP(09) SIM_STOP(10) SIM_STOP(11) SIM_STOP(12) SIM_STOP(13) SIM_STOP(14) SIM_STOP(15) \
+    SIM_STOP(16) SIM_STOP(17) SIM_STOP(18) SIM_STOP(19) SIM_STOP(20) SIM_STOP(21) SIM_STOP(22) SIM_STOP(23) \
+    SIM_STOP(24) SIM_STOP(25) SIM_STOP(26) SIM_STOP(27) SIM_STOP(28) SIM_STOP(29) SIM_STOP(30) SIM_STOP(31)
+#define SIM_CAT_(a, b) a##b
+#define SIM_CAT(a, b) SIM_CAT_(a, b)
+#define MBTA_STOPS SIM_CAT(SIM_STOPS_, SIM_STOPS)
+
+// mbta.c reads the wall clock through time(); the simulation owns it.
+static time_t sim_time(time_t *out);
+#define time(out) sim_time(out)
+
+#include "mbta.c"
+
+#define SIM_LATENCY_MS  300
+#define SIM_HEALTHY_MS  (2 * 3600 * 1000LL)
+#define SIM_OUTAGE_MS   (10 * 60 * 1000LL)
+#define SIM_RECOVER_MS  (30 * 60 * 1000LL)
+#define SIM_END_MS      (SIM_HEALTHY_MS + SIM_OUTAGE_MS + SIM_RECOVER_MS)
+#define SIM_WINDOW_MS   5000
+#define SIM_MAX_REQUESTS 100000
+
+static const time_t s_epoch0 = 1792152000; // 2026-10-16 12:00:00 UTC, for a sane RTC
+static int64_t s_now_us;
+static jmp_buf s_done;
+static uint32_t s_rand = 1;
+
+static int64_t s_request_ms[SIM_MAX_REQUESTS];
+static int s_requests;
+static int s_healthy_requests;
+static int s_outage_requests;
+static int64_t s_last_ok_ms[SIM_STOPS];
+static int64_t s_worst_gap_ms[SIM_STOPS];
+static int64_t s_recovered_ms[SIM_STOPS];
+
+static time_t sim_time(time_t *out)
+{
+    time_t t = s_epoch0 + (time_t)(s_now_us / 1000000);
+    if (out != NULL) {
+        *out = t;
+    }
+    return t;
+}
+
+// Fakes for what mbta.c calls.
+int64_t esp_timer_get_time(void) { return s_now_us; }
+uint32_t esp_random(void)
+{
+    s_rand = s_rand * 1103515245u + 12345u;
+    return s_rand >> 8;
+}
+wireless_status_t Wireless_GetStatus(void) { return WIRELESS_STATUS_CONNECTED; }
+bool TimeSync_Wait(uint32_t timeout_ms) { (void)timeout_ms; return true; }
+void UiNotify_Signal(void) {}
+bool Snapshot_Load(snapshot_id_t id, void *buf, size_t size) { (void)id; (void)buf; (void)size; return false; }
+void Snapshot_Save(snapshot_id_t id, const void *buf, size_t size) { (void)id; (void)buf; (void)size; }
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void *), const char *name, uint32_t stack, void *arg,
+                                   int prio, TaskHandle_t *out_handle, int core)
+{
+    (void)fn; (void)name; (void)stack; (void)arg; (void)prio; (void)out_handle; (void)core;
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    s_now_us += (int64_t)ticks * 1000;
+    if (s_now_us >= SIM_END_MS * 1000) {
+        longjmp(s_done, 1);
+    }
+}
+
+static int sim_stop_index(const char *id, size_t len)
+{
+    for (int i = 0; i < SIM_STOPS; i++) {
+        if (strlen(s_stops[i].stop_id) == len && strncmp(s_stops[i].stop_id, id, len) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Stop i: a vehicle every 4..23 minutes, each stop on its own phase.
+static void sim_arrivals(int stop, time_t now, time_t *out, int count)
+{
+    time_t headway = (time_t)(4 + (stop * 7) % 20) * 60;
+    time_t phase = (time_t)(stop * 97) % headway;
+    time_t first = now - (now - phase) % headway + headway;
+    for (int k = 0; k < count; k++) {
+        out[k] = first + k * headway;
+    }
+}
+
+static size_t sim_body(char *buf, size_t size, const bool *want)
+{
+    time_t now = sim_time(NULL);
+    size_t len = (size_t)snprintf(buf, size, "{\"data\":[");
+    bool first = true;
+    for (int i = 0; i < SIM_STOPS; i++) {
+        if (!want[i]) {
+            continue;
+        }
+        time_t at[3];
+        sim_arrivals(i, now, at, 3);
+        for (int k = 0; k < 3 && len < size; k++) {
+            char iso[32];
+            struct tm tm;
+            gmtime_r(&at[k], &tm);
+            strftime(iso, sizeof(iso), "%Y-%m-%dT%H:%M:%SZ", &tm);
+            len += (size_t)snprintf(buf + len, size - len,
+                "%s{\"attributes\":{\"arrival_time\":\"%s\",\"departure_time\":null},\"id\":\"p-%d-%d\","
+                "\"relationships\":{\"route\":{\"data\":{\"id\":\"1\",\"type\":\"route\"}},"
+                "\"stop\":{\"data\":{\"id\":\"%s\",\"type\":\"stop\"}}},\"type\":\"prediction\"}",
+                first ? "" : ",", iso, i, k, s_stops[i].stop_id);
+            first = false;
+        }
+    }
+    len += (size_t)snprintf(buf + len, size > len ? size - len : 0, "],\"included\":[]}");
+    return len;
+}
+
+esp_err_t NetService_Get(const http_conn_request_t *req, net_prio_t prio, uint32_t deadline_ms,
+                         int *out_http_status)
+{
+    (void)prio;
+    (void)deadline_ms;
+    int64_t start_ms = s_now_us / 1000;
+    s_now_us += SIM_LATENCY_MS * 1000;
+    if (s_requests < SIM_MAX_REQUESTS) {
+        s_request_ms[s_requests++] = start_ms;
+    }
+
+    bool outage = start_ms >= SIM_HEALTHY_MS && start_ms < SIM_HEALTHY_MS + SIM_OUTAGE_MS;
+    if (start_ms < SIM_HEALTHY_MS) {
+        s_healthy_requests++;
+    } else if (outage) {
+        s_outage_requests++;
+    }
+    if (outage) {
+        *out_http_status = 0;
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // The stops asked for, from filter[stop]=a,b,...
+    bool want[SIM_STOPS] = {0};
+    const char *ids = strstr(req->url, "filter[stop]=");
+    if (ids == NULL) {
+        *out_http_status = 400;
+        return ESP_OK;
+    }
+    ids += strlen("filter[stop]=");
+    while (*ids != '\0' && *ids != '&') {
+        size_t n = strcspn(ids, ",&");
+        int i = sim_stop_index(ids, n);
+        if (i >= 0) {
+            want[i] = true;
+        }
+        ids += n;
+        if (*ids == ',') {
+            ids++;
+        }
+    }
+
+    int64_t end_ms = s_now_us / 1000;
+    for (int i = 0; i < SIM_STOPS; i++) {
+        if (!want[i]) {
+            continue;
+        }
+        if (start_ms < SIM_HEALTHY_MS && s_last_ok_ms[i] > 0 && end_ms - s_last_ok_ms[i] > s_worst_gap_ms[i]) {
+            s_worst_gap_ms[i] = end_ms - s_last_ok_ms[i];
+        }
+        if (start_ms >= SIM_HEALTHY_MS + SIM_OUTAGE_MS && s_recovered_ms[i] == 0) {
+            s_recovered_ms[i] = end_ms - (SIM_HEALTHY_MS + SIM_OUTAGE_MS);
+        }
+        s_last_ok_ms[i] = end_ms;
+    }
+
+    static char body[SIM_STOPS * 3 * 320 + 64];
+    size_t len = sim_body(body, sizeof(body), want);
+    *out_http_status = 200;
+    // Socket-sized reads, as HttpConn delivers them.
+    for (size_t off = 0; off < len; off += 512) {
+        if (!req->on_body(body + off, len - off < 512 ? len - off : 512, req->ctx)) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+    return ESP_OK;
+}
+
+static int max_in_window(int64_t from_ms, int64_t to_ms)
+{
+    int most = 0;
+    for (int a = 0, b = 0; b < s_requests; b++) {
+        if (s_request_ms[b] < from_ms || s_request_ms[b] >= to_ms) {
+            continue;
+        }
+        while (s_request_ms[a] < from_ms || s_request_ms[b] - s_request_ms[a] >= SIM_WINDOW_MS) {
+            a++;
+        }
+        if (b - a + 1 > most) {
+            most = b - a + 1;
+        }
+    }
+    return most;
+}
+
+int main(void)
+{
+    MBTA_TaskStart();
+    if (setjmp(s_done) == 0) {
+        mbta_task(NULL);
+    }
+
+    int fail = 0;
+    double minutes = (double)SIM_HEALTHY_MS / 60000.0;
+    double rate = s_healthy_requests / minutes;
+    double bound = MBTA_JOB_COUNT * 60000.0 / MBTA_POLL_MIN_MS;
+    // The spread starts the jobs apart and MBTA_JOB_SPACING_MS keeps them
+    // apart once their intervals drift into step.
+    int burst = max_in_window(0, SIM_HEALTHY_MS);
+    int burst_bound = 1 + SIM_WINDOW_MS / MBTA_JOB_SPACING_MS;
+
+    int64_t worst_gap = 0;
+    int64_t worst_recovery = 0;
+    for (int i = 0; i < SIM_STOPS; i++) {
+        if (s_worst_gap_ms[i] > worst_gap) {
+            worst_gap = s_worst_gap_ms[i];
+        }
+        if (s_recovered_ms[i] == 0) {
+            printf("FAIL stop %d never fetched after the outage\n", i);
+            fail = 1;
+        } else if (s_recovered_ms[i] > worst_recovery) {
+            worst_recovery = s_recovered_ms[i];
+        }
+    }
+    // Jobs due together wait their turn: up to one spacing per other job.
+    int64_t gap_bound = MBTA_POLL_MAX_MS + MBTA_POLL_MIN_MS + (int64_t)MBTA_JOB_COUNT * SIM_LATENCY_MS;
+    // A job failing at the end of the outage may have just begun its
+    // longest backoff.
+    int64_t recovery_bound = MBTA_RETRY_MAX_MS + MBTA_RETRY_MAX_MS / 4 + MBTA_POLL_MIN_MS +
+                             (int64_t)MBTA_JOB_COUNT * SIM_LATENCY_MS;
+
+    printf("%d stops, %d job(s)%s\n", SIM_STOPS, MBTA_JOB_COUNT, MBTA_USE_COMBINED_FETCH ? ", combined" : "");
+    printf("  healthy:  %6.2f req/min (bound %.2f), at most %d in %d s (bound %d)\n", rate, bound, burst,
+           SIM_WINDOW_MS / 1000, burst_bound);
+    printf("  staleness: worst %llds between fetches of a stop (bound %llds)\n", (long long)(worst_gap / 1000),
+           (long long)(gap_bound / 1000));
+    printf("  outage:   %d request(s) in %lld min, every stop back %llds after it ended (bound %llds)\n",
+           s_outage_requests, (long long)(SIM_OUTAGE_MS / 60000), (long long)(worst_recovery / 1000),
+           (long long)(recovery_bound / 1000));
+
+    if (rate > bound) {
+        printf("FAIL request rate over the MBTA_POLL_MIN_MS bound\n");
+        fail = 1;
+    }
+    if (burst > burst_bound) {
+        printf("FAIL burst of %d requests\n", burst);
+        fail = 1;
+    }
+    if (worst_gap > gap_bound) {
+        printf("FAIL a stop went %llds without a fetch\n", (long long)(worst_gap / 1000));
+        fail = 1;
+    }
+    if (worst_recovery > recovery_bound) {
+        printf("FAIL recovery took %llds\n", (long long)(worst_recovery / 1000));
+        fail = 1;
+    }
+    return fail;
+}
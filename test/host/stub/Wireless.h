@@ -0,0 +1,11 @@
+#pragma once
+
+// Host stand-in for main/Wireless/Wireless.h (status only).
+
+typedef enum {
+    WIRELESS_STATUS_CONNECTING = 0,
+    WIRELESS_STATUS_CONNECTED,
+    WIRELESS_STATUS_FAILED,
+} wireless_status_t;
+
+wireless_status_t Wireless_GetStatus(void);
@@ -0,0 +1,39 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+// Host test config: main/config.h.example with test-friendly defaults.
+// Every setting can be overridden with -D or by defining it before the
+// first include.
+
+#ifndef MBTA_FETCH_PERIOD_MS
+#define MBTA_FETCH_PERIOD_MS 60000
+#endif
+#ifndef MBTA_SHOW_START_HOUR
+#define MBTA_SHOW_START_HOUR 0
+#endif
+#ifndef MBTA_SHOW_END_HOUR
+#define MBTA_SHOW_END_HOUR 24
+#endif
+
+#ifndef MBTA_STOPS
+#define MBTA_STOPS \
+    { "1295",  "65", "Bus 65 to Kenmore" }, \
+    { "70176", "",   "T @ Beaconsfield" },
+#endif
+
+#ifndef WEATHER_LATITUDE
+#define WEATHER_LATITUDE 42.342110
+#endif
+#ifndef WEATHER_LONGITUDE
+#define WEATHER_LONGITUDE -71.145805
+#endif
+
+// Modules with their own tests are left out of the others.
+#ifndef MBTA_USE_ALERTS
+#define MBTA_USE_ALERTS 0
+#endif
+#ifndef MBTA_USE_SCHEDULE_CACHE
+#define MBTA_USE_SCHEDULE_CACHE 0
+#endif
+
+#endif // CONFIG_H
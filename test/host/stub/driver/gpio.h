@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// Host stand-in for ESP-IDF's driver/gpio.h: no pins to drive.
+
+#define GPIO_MODE_OUTPUT 2
+
+typedef struct {
+    uint64_t pin_bit_mask;
+    int mode;
+} gpio_config_t;
+
+static inline esp_err_t gpio_config(const gpio_config_t *cfg) { (void)cfg; return ESP_OK; }
+static inline esp_err_t gpio_reset_pin(int gpio_num) { (void)gpio_num; return ESP_OK; }
+static inline esp_err_t gpio_set_level(int gpio_num, uint32_t level) { (void)gpio_num; (void)level; return ESP_OK; }
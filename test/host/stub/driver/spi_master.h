@@ -0,0 +1,3 @@
+#pragma once
+
+// Host stand-in: the SPI bus is the test's panel IO.
@@ -0,0 +1,6 @@
+#pragma once
+
+#include "esp_err.h"
+
+// Host stand-in: the stand-in server's certificate is never checked.
+esp_err_t esp_crt_bundle_attach(void *conf);
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_lcd_types.h"
+
+// Host stand-in for ESP-IDF's esp_lcd_panel_io.h: the test provides the
+// panel IO, and calls the transfer-done callback itself.
+
+typedef struct {
+    int unused;
+} esp_lcd_panel_io_event_data_t;
+
+esp_err_t esp_lcd_panel_io_tx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *param, size_t param_size);
+esp_err_t esp_lcd_panel_io_tx_color(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *color, size_t color_size);
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "esp_lcd_panel_interface.h"
+
+// Host stand-in for ESP-IDF's esp_lcd_panel_ops.h: straight through to
+// the driver.
+
+static inline esp_err_t esp_lcd_panel_reset(esp_lcd_panel_handle_t panel) { return panel->reset(panel); }
+static inline esp_err_t esp_lcd_panel_init(esp_lcd_panel_handle_t panel) { return panel->init(panel); }
+static inline esp_err_t esp_lcd_panel_draw_bitmap(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end,
+                                                  int y_end, const void *color_data)
+{
+    return panel->draw_bitmap(panel, x_start, y_start, x_end, y_end, color_data);
+}
+static inline esp_err_t esp_lcd_panel_mirror(esp_lcd_panel_handle_t panel, bool x_axis, bool y_axis)
+{
+    return panel->mirror(panel, x_axis, y_axis);
+}
+static inline esp_err_t esp_lcd_panel_swap_xy(esp_lcd_panel_handle_t panel, bool swap_axes)
+{
+    return panel->swap_xy(panel, swap_axes);
+}
+static inline esp_err_t esp_lcd_panel_set_gap(esp_lcd_panel_handle_t panel, int x_gap, int y_gap)
+{
+    return panel->set_gap(panel, x_gap, y_gap);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Host stand-in for ESP-IDF's esp_lcd_types.h.
+
+typedef struct esp_lcd_panel_io_t *esp_lcd_panel_io_handle_t;
+typedef struct esp_lcd_panel_t *esp_lcd_panel_handle_t;
+
+typedef enum {
+    LCD_RGB_ENDIAN_RGB = 0,
+    LCD_RGB_ENDIAN_BGR,
+} lcd_color_rgb_endian_t;
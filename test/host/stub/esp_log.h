@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdio.h>
+
+// Host stand-in for ESP-IDF's esp_log.h. Silent unless built with
+// HOST_LOG=1, but the arguments are still type-checked.
+
+#if HOST_LOG
+#define ESP_LOG_HOST(level, tag, fmt, ...) printf(level " (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#else
+#define ESP_LOG_HOST(level, tag, fmt, ...)          \
+    do {                                            \
+        (void)(tag);                                \
+        if (0) {                                    \
+            printf(fmt, ##__VA_ARGS__);             \
+        }                                           \
+    } while (0)
+#endif
+
+#define ESP_LOGE(tag, fmt, ...) ESP_LOG_HOST("E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) ESP_LOG_HOST("W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) ESP_LOG_HOST("I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) ESP_LOG_HOST("D", tag, fmt, ##__VA_ARGS__)
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+#define esp_log_level_set(tag, level) ((void)(tag), (void)(level))
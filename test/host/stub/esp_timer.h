@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// Host stand-in: each test provides its own clock.
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "esp_err.h"
+
+// Host stand-in for ESP-IDF's esp_tls.h: the calls http_conn.c makes, same
+// signatures. The test provides them, with the server behind them.
+
+#define ESP_TLS_ERR_SSL_WANT_READ  (-0x6900)
+#define ESP_TLS_ERR_SSL_WANT_WRITE (-0x6880)
+
+typedef struct esp_tls esp_tls_t;
+typedef struct esp_tls_client_session esp_tls_client_session_t;
+
+typedef struct {
+    esp_err_t (*crt_bundle_attach)(void *conf);
+    int timeout_ms;
+    esp_tls_client_session_t *client_session;
+} esp_tls_cfg_t;
+
+esp_tls_t *esp_tls_init(void);
+int esp_tls_conn_new_sync(const char *hostname, int hostlen, int port, const esp_tls_cfg_t *cfg, esp_tls_t *tls);
+ssize_t esp_tls_conn_read(esp_tls_t *tls, void *data, size_t datalen);
+ssize_t esp_tls_conn_write(esp_tls_t *tls, const void *data, size_t datalen);
+int esp_tls_conn_destroy(esp_tls_t *tls);
+void *esp_tls_get_ssl_context(esp_tls_t *tls);
+esp_tls_client_session_t *esp_tls_get_client_session(esp_tls_t *tls);
+void esp_tls_free_client_session(esp_tls_client_session_t *client_session);
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+
+// Host stand-in: just the types and macros the modules under test use.
+// One tick is one millisecond.
+
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+typedef void *TaskHandle_t;
+typedef void *SemaphoreHandle_t;
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdPASS  1
+
+#define portMAX_DELAY      ((TickType_t)0xffffffffu)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(ms))
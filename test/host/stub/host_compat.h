@@ -0,0 +1,11 @@
+#pragma once
+
+// Forced into every host build (-include): what newlib has and glibc may not.
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+#define HOST_NEED_STRLCPY 1
+size_t strlcpy(char *dst, const char *src, size_t size);
+#endif
@@ -0,0 +1,14 @@
+#pragma once
+
+// Host stand-in for mbedTLS's ssl.h: the session fields http_conn.c reads
+// to tell a resumed session from a new one.
+
+#define MBEDTLS_PRIVATE(member) private_##member
+
+typedef struct {
+    unsigned char MBEDTLS_PRIVATE(master)[48];
+} mbedtls_ssl_session;
+
+typedef struct {
+    mbedtls_ssl_session *MBEDTLS_PRIVATE(session);
+} mbedtls_ssl_context;
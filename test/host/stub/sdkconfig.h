@@ -0,0 +1,3 @@
+#pragma once
+
+// Host stand-in: no Kconfig options set.
@@ -0,0 +1,608 @@
+// The connection pool against a stand-in TLS server that counts handshakes:
+// the real http_conn.c over a fake esp-tls whose connections answer GETs
+// with Content-Length or chunked bodies, handed out in pieces. Checks that
+// polls reuse the open connection, that the MBTA and weather hosts keep
+// their own slots and stats in one pool with at most HTTP_CONN_MAX_OPEN
+// connections open, that a connection the server closed while idle is
+// replaced and the request retried exactly once, that nothing is retried
+// once response bytes arrived, that Connection: close and error statuses
+// are honoured, and that a third host evicts the least recently used one.
+//
+// Reconnects offer the host's last TLS session: the server resumes it
+// (keeping its master secret) unless its ticket keys rotated, and the
+// stats must count only the resumptions the server accepted.
+//
+// With -b, also an hour of MBTA and weather polls against servers that drop
+// idle connections, with and without session tickets. There is no mbedTLS
+// on the host, so the handshake costs are the stand-in's (FULL_ and
+// RESUME_HANDSHAKE_MS), not measured ones: the bench shows how many
+// handshakes resumption turns cheap, the device's HttpConn stats what each
+// kind costs there.
+
+#include "http_conn.h"
+
+#include "esp_crt_bundle.h"
+#include "esp_tls.h"
+#include "freertos/semphr.h"
+#include "mbedtls/ssl.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MBTA    "api-v3.mbta.com"
+#define WEATHER "api.open-meteo.com"
+#define OTHER   "example.com"
+
+#define FULL_HANDSHAKE_MS   150
+#define RESUME_HANDSHAKE_MS 40
+#define REQUEST_MS          20
+
+static int s_fail;
+
+static int64_t s_now_us = 1000000;
+int64_t esp_timer_get_time(void) { return s_now_us; }
+
+// Mutexes: one task, so a blocking take of a held one would never return.
+typedef struct {
+    bool held;
+} host_mu_t;
+
+static host_mu_t s_mus[HTTP_CONN_MAX_HOSTS + 1];
+static int s_mu_count;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) { return &s_mus[s_mu_count++]; }
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    host_mu_t *m = (host_mu_t *)sem;
+    if (m->held) {
+        if (ticks != 0) {
+            printf("FAIL blocking take of a held mutex\n");
+            s_fail++;
+        }
+        return pdFALSE;
+    }
+    m->held = true;
+    return pdTRUE;
+}
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    ((host_mu_t *)sem)->held = false;
+    return pdTRUE;
+}
+
+// ---- The stand-in server ----
+
+static struct {
+    const char *name;
+    bool chunked;   // answer with Transfer-Encoding: chunked
+    bool close;     // answer with Connection: close
+    bool refuse;    // fail handshakes
+    bool no_tickets;   // never resume
+    bool fail_resume;  // fail handshakes that offer a session
+    int key_gen;       // ticket keys; tickets from older ones are declined
+    int idle_ms;       // close connections idle for longer (0: never)
+    int handshakes; // completed
+    int resumed;
+    int attempts;
+    int requests;
+} s_hosts[] = {
+    {.name = MBTA},
+    {.name = WEATHER, .chunked = true},
+    {.name = OTHER},
+};
+#define HOSTS ((int)(sizeof(s_hosts) / sizeof(s_hosts[0])))
+
+struct esp_tls {
+    int host;  // -1 until connected
+    bool dead; // closed by the server: reads return 0 once drained
+    bool cut;  // close right after the headers of the next response
+    char req[1024];
+    size_t req_len;
+    char resp[2048];
+    size_t resp_len;
+    size_t resp_pos;
+    int reads;
+    int64_t last_us; // last request
+    int key_gen;
+    mbedtls_ssl_session session;
+    mbedtls_ssl_context ssl;
+};
+
+struct esp_tls_client_session {
+    mbedtls_ssl_session saved_session;
+    int host;
+    int key_gen;
+};
+
+static uint32_t s_secrets;
+
+#define MAX_CONNS 8
+static esp_tls_t *s_conns[MAX_CONNS];
+static int s_sessions;
+
+static int open_conns(int host)
+{
+    int n = 0;
+    for (int i = 0; i < MAX_CONNS; i++) {
+        n += s_conns[i] != NULL && s_conns[i]->host >= 0 && (host < 0 || s_conns[i]->host == host);
+    }
+    return n;
+}
+
+// The server drops every idle connection to a host (keep-alive timeout).
+static void server_close_idle(int host)
+{
+    for (int i = 0; i < MAX_CONNS; i++) {
+        if (s_conns[i] != NULL && s_conns[i]->host == host) {
+            s_conns[i]->dead = true;
+        }
+    }
+}
+
+// Idle connections past the host's timeout.
+static void server_expire(void)
+{
+    for (int i = 0; i < MAX_CONNS; i++) {
+        esp_tls_t *t = s_conns[i];
+        if (t != NULL && t->host >= 0 && s_hosts[t->host].idle_ms > 0 &&
+            s_now_us - t->last_us > (int64_t)s_hosts[t->host].idle_ms * 1000) {
+            t->dead = true;
+        }
+    }
+}
+
+static esp_tls_t *conn_of(int host)
+{
+    for (int i = 0; i < MAX_CONNS; i++) {
+        if (s_conns[i] != NULL && s_conns[i]->host == host) {
+            return s_conns[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t esp_crt_bundle_attach(void *conf)
+{
+    (void)conf;
+    return ESP_OK;
+}
+
+esp_tls_t *esp_tls_init(void)
+{
+    for (int i = 0; i < MAX_CONNS; i++) {
+        if (s_conns[i] == NULL) {
+            s_conns[i] = calloc(1, sizeof(esp_tls_t));
+            s_conns[i]->host = -1;
+            return s_conns[i];
+        }
+    }
+    printf("FAIL more than %d connection objects\n", MAX_CONNS);
+    s_fail++;
+    return NULL;
+}
+
+int esp_tls_conn_new_sync(const char *hostname, int hostlen, int port, const esp_tls_cfg_t *cfg, esp_tls_t *tls)
+{
+    if (port != 443 || cfg->crt_bundle_attach == NULL || cfg->timeout_ms <= 0) {
+        printf("FAIL connect to %.*s:%d without certificate checks or timeout\n", hostlen, hostname, port);
+        s_fail++;
+    }
+    const esp_tls_client_session_t *offer = cfg->client_session;
+    for (int h = 0; h < HOSTS; h++) {
+        if ((int)strlen(s_hosts[h].name) == hostlen && memcmp(s_hosts[h].name, hostname, (size_t)hostlen) == 0) {
+            if (offer != NULL && offer->host != h) {
+                printf("FAIL %s offered a session of %s\n", s_hosts[h].name, s_hosts[offer->host].name);
+                s_fail++;
+                offer = NULL;
+            }
+            bool resume = offer != NULL && !s_hosts[h].no_tickets && offer->key_gen == s_hosts[h].key_gen;
+            s_hosts[h].attempts++;
+            s_now_us += (resume ? RESUME_HANDSHAKE_MS : FULL_HANDSHAKE_MS) * 1000;
+            if (s_hosts[h].refuse || (offer != NULL && s_hosts[h].fail_resume)) {
+                return -1;
+            }
+            s_hosts[h].handshakes++;
+            if (resume) {
+                // Resumed: the session (and its master secret) carries on.
+                s_hosts[h].resumed++;
+                tls->session = offer->saved_session;
+            } else {
+                s_secrets++;
+                memset(&tls->session, 0, sizeof(tls->session));
+                memcpy(tls->session.MBEDTLS_PRIVATE(master), &s_secrets, sizeof(s_secrets));
+            }
+            tls->ssl.MBEDTLS_PRIVATE(session) = &tls->session;
+            tls->key_gen = s_hosts[h].key_gen;
+            tls->last_us = s_now_us;
+            tls->host = h;
+            return 1;
+        }
+    }
+    return -1;
+}
+
+void *esp_tls_get_ssl_context(esp_tls_t *tls)
+{
+    return tls->host >= 0 ? &tls->ssl : NULL;
+}
+
+int esp_tls_conn_destroy(esp_tls_t *tls)
+{
+    for (int i = 0; i < MAX_CONNS; i++) {
+        if (s_conns[i] == tls) {
+            s_conns[i] = NULL;
+        }
+    }
+    free(tls);
+    return 0;
+}
+
+esp_tls_client_session_t *esp_tls_get_client_session(esp_tls_t *tls)
+{
+    esp_tls_client_session_t *s = malloc(sizeof(*s));
+    s->saved_session = tls->session;
+    s->host = tls->host;
+    s->key_gen = tls->key_gen;
+    s_sessions++;
+    return s;
+}
+
+void esp_tls_free_client_session(esp_tls_client_session_t *client_session)
+{
+    s_sessions--;
+    free(client_session);
+}
+
+static void respond(esp_tls_t *tls)
+{
+    char path[128];
+    char host[64];
+    if (sscanf(tls->req, "GET %127s HTTP/1.1\r\nHost: %63[^\r]", path, host) != 2 ||
+        strcmp(host, s_hosts[tls->host].name) != 0 || strstr(tls->req, "\r\nConnection: keep-alive\r\n") == NULL) {
+        printf("FAIL request on a connection to %s:\n%s", s_hosts[tls->host].name, tls->req);
+        s_fail++;
+    }
+    s_hosts[tls->host].requests++;
+    s_now_us += REQUEST_MS * 1000;
+    tls->last_us = s_now_us;
+
+    char body[256];
+    int status = 200;
+    if (strcmp(path, "/missing") == 0) {
+        status = 404;
+        snprintf(body, sizeof(body), "no such page");
+    } else {
+        snprintf(body, sizeof(body), "%s%s #%d", host, path, s_hosts[tls->host].requests);
+    }
+
+    size_t n = (size_t)snprintf(tls->resp, sizeof(tls->resp), "HTTP/1.1 %d %s\r\nServer: stand-in\r\n%s", status,
+                                status == 200 ? "OK" : "Not Found",
+                                s_hosts[tls->host].close ? "Connection: close\r\n" : "");
+    if (s_hosts[tls->host].chunked) {
+        n += (size_t)snprintf(tls->resp + n, sizeof(tls->resp) - n, "Transfer-Encoding: chunked\r\n\r\n");
+        size_t len = strlen(body);
+        for (size_t off = 0; off < len; off += 7) {
+            size_t k = len - off < 7 ? len - off : 7;
+            n += (size_t)snprintf(tls->resp + n, sizeof(tls->resp) - n, "%zx\r\n%.*s\r\n", k, (int)k, body + off);
+        }
+        n += (size_t)snprintf(tls->resp + n, sizeof(tls->resp) - n, "0\r\n\r\n");
+    } else {
+        n += (size_t)snprintf(tls->resp + n, sizeof(tls->resp) - n, "Content-Length: %zu\r\n\r\n%s", strlen(body),
+                              body);
+    }
+    tls->resp_len = n;
+    tls->resp_pos = 0;
+    if (tls->cut) {
+        tls->resp_len = (size_t)(strstr(tls->resp, "\r\n\r\n") + 4 - tls->resp);
+        tls->dead = true;
+    }
+    if (s_hosts[tls->host].close) {
+        tls->dead = true;
+    }
+}
+
+ssize_t esp_tls_conn_write(esp_tls_t *tls, const void *data, size_t datalen)
+{
+    // A write to a connection the peer closed still succeeds; the read
+    // after it finds the close.
+    if (tls->dead) {
+        return (ssize_t)datalen;
+    }
+    if (tls->req_len + datalen >= sizeof(tls->req)) {
+        printf("FAIL request too long\n");
+        s_fail++;
+        return -1;
+    }
+    memcpy(tls->req + tls->req_len, data, datalen);
+    tls->req_len += datalen;
+    tls->req[tls->req_len] = '\0';
+    if (strstr(tls->req, "\r\n\r\n") != NULL) {
+        respond(tls);
+        tls->req_len = 0;
+    }
+    return (ssize_t)datalen;
+}
+
+ssize_t esp_tls_conn_read(esp_tls_t *tls, void *data, size_t datalen)
+{
+    // Every third read would block; the caller must come back.
+    if (++tls->reads % 3 == 0) {
+        return ESP_TLS_ERR_SSL_WANT_READ;
+    }
+    if (tls->resp_pos < tls->resp_len) {
+        size_t n = tls->resp_len - tls->resp_pos;
+        n = n < datalen ? n : datalen;
+        n = n < 40 ? n : 40;
+        memcpy(data, tls->resp + tls->resp_pos, n);
+        tls->resp_pos += n;
+        return (ssize_t)n;
+    }
+    if (tls->dead) {
+        return 0;
+    }
+    // Nothing asked: the client would wait for its timeout.
+    s_now_us += 1000;
+    return ESP_TLS_ERR_SSL_WANT_READ;
+}
+
+// ---- The client side ----
+
+typedef struct {
+    char body[256];
+    size_t len;
+    int calls;
+} body_t;
+
+static bool on_body(const char *data, size_t len, void *ctx)
+{
+    body_t *b = (body_t *)ctx;
+    b->calls++;
+    if (b->len + len < sizeof(b->body)) {
+        memcpy(b->body + b->len, data, len);
+        b->len += len;
+        b->body[b->len] = '\0';
+    }
+    return true;
+}
+
+static void get(const char *what, const char *host, const char *path, esp_err_t want_err, int want_status,
+                const char *want_body)
+{
+    char url[128];
+    snprintf(url, sizeof(url), "https://%s%s", host, path);
+    body_t b = {0};
+    http_conn_request_t req = {
+        .url = url,
+        .timeout_ms = 5000,
+        .on_body = on_body,
+        .ctx = &b,
+    };
+    int status = -1;
+    esp_err_t err = HttpConn_Get(&req, &status);
+    if (err != want_err || status != want_status || (want_body != NULL && strcmp(b.body, want_body) != 0)) {
+        printf("FAIL %s: err %s status %d body '%s', want %s %d '%s'\n", what, esp_err_to_name(err), status, b.body,
+               esp_err_to_name(want_err), want_status, want_body ? want_body : "(any)");
+        s_fail++;
+    }
+    if (open_conns(-1) > HTTP_CONN_MAX_OPEN) {
+        printf("FAIL %s: %d connections open\n", what, open_conns(-1));
+        s_fail++;
+    }
+}
+
+static http_conn_stats_t stats(const char *host)
+{
+    http_conn_stats_t st = {0};
+    if (!HttpConn_GetStats(host, &st)) {
+        printf("FAIL no stats for %s\n", host);
+        s_fail++;
+    }
+    return st;
+}
+
+static void expect(const char *what, uint32_t got, uint32_t want)
+{
+    if (got != want) {
+        printf("FAIL %s: %u, want %u\n", what, (unsigned)got, (unsigned)want);
+        s_fail++;
+    }
+}
+
+static void check_resume(void)
+{
+    // Dropped while idle: the reconnect offers the session, the server
+    // takes it.
+    http_conn_stats_t st = stats(MBTA);
+    int resumed = s_hosts[0].resumed;
+    server_close_idle(0);
+    get("resume", MBTA, "/predictions", ESP_OK, 200, NULL);
+    http_conn_stats_t now = stats(MBTA);
+    expect("resume: stats.resume_attempts", now.resume_attempts, st.resume_attempts + 1);
+    expect("resume: stats.resumed", now.resumed, st.resumed + 1);
+    expect("resume: stats.full_handshakes", now.full_handshakes, st.full_handshakes);
+    expect("resume: stats.resume_handshake_ms", now.resume_handshake_ms, st.resume_handshake_ms + RESUME_HANDSHAKE_MS);
+    expect("resume: server resumptions", (uint32_t)(s_hosts[0].resumed - resumed), 1);
+
+    // The server rotated its ticket keys: offered, declined, full handshake.
+    st = now;
+    s_hosts[0].key_gen++;
+    server_close_idle(0);
+    get("declined", MBTA, "/predictions", ESP_OK, 200, NULL);
+    now = stats(MBTA);
+    expect("declined: stats.resume_attempts", now.resume_attempts, st.resume_attempts + 1);
+    expect("declined: stats.resumed", now.resumed, st.resumed);
+    expect("declined: stats.full_handshakes", now.full_handshakes, st.full_handshakes + 1);
+    expect("declined: stats.full_handshake_ms", now.full_handshake_ms, st.full_handshake_ms + FULL_HANDSHAKE_MS);
+
+    // The new session is the one offered next.
+    st = now;
+    server_close_idle(0);
+    get("resume new session", MBTA, "/predictions", ESP_OK, 200, NULL);
+    expect("resume new session: stats.resumed", stats(MBTA).resumed, st.resumed + 1);
+
+    // A connect offering the session fails: forgotten, retried without.
+    st = stats(MBTA);
+    s_hosts[0].fail_resume = true;
+    server_close_idle(0);
+    get("resume fails", MBTA, "/predictions", ESP_OK, 200, NULL);
+    s_hosts[0].fail_resume = false;
+    now = stats(MBTA);
+    expect("resume fails: stats.resume_failures", now.resume_failures, st.resume_failures + 1);
+    expect("resume fails: stats.resume_attempts", now.resume_attempts, st.resume_attempts);
+    expect("resume fails: stats.full_handshakes", now.full_handshakes, st.full_handshakes + 1);
+    expect("resume fails: stats.handshakes", now.handshakes, st.handshakes + 1);
+    expect("total handshakes", now.handshakes, now.full_handshakes + now.resumed);
+}
+
+static http_conn_stats_t stats_or_zero(const char *host)
+{
+    http_conn_stats_t st = {0};
+    HttpConn_GetStats(host, &st);
+    return st;
+}
+
+// An hour of polls: MBTA every 30 s, weather every 10 min, both servers
+// closing connections idle for more than 20 s.
+static void bench_run(const char *what, bool tickets)
+{
+    for (int h = 0; h < HOSTS; h++) {
+        s_hosts[h].no_tickets = !tickets;
+        s_hosts[h].idle_ms = 20000;
+    }
+    http_conn_stats_t m0 = stats_or_zero(MBTA);
+    http_conn_stats_t w0 = stats_or_zero(WEATHER);
+    int64_t start_us = s_now_us;
+    for (int s = 0; s < 3600; s += 15) {
+        s_now_us = start_us + (int64_t)s * 1000000;
+        server_expire();
+        if (s % 30 == 0) {
+            get("bench MBTA", MBTA, "/predictions", ESP_OK, 200, NULL);
+        }
+        if (s % 600 == 15) {
+            get("bench weather", WEATHER, "/v1/forecast", ESP_OK, 200, NULL);
+        }
+    }
+    http_conn_stats_t m = stats_or_zero(MBTA);
+    http_conn_stats_t w = stats_or_zero(WEATHER);
+    uint32_t polls = m.requests - m0.requests + w.requests - w0.requests;
+    uint32_t full = m.full_handshakes - m0.full_handshakes + w.full_handshakes - w0.full_handshakes;
+    uint32_t resumed = m.resumed - m0.resumed + w.resumed - w0.resumed;
+    uint32_t ms = m.total_handshake_ms - m0.total_handshake_ms + w.total_handshake_ms - w0.total_handshake_ms;
+    printf("%-16s %u polls: %3u full + %3u resumed handshakes, %5.1f ms/poll handshaking\n", what, (unsigned)polls,
+           (unsigned)full, (unsigned)resumed, (double)ms / polls);
+}
+
+static void bench(void)
+{
+    printf("stand-in costs: full handshake %d ms, resumed %d ms\n", FULL_HANDSHAKE_MS, RESUME_HANDSHAKE_MS);
+    bench_run("without tickets", false);
+    bench_run("with tickets", true);
+}
+
+int main(int argc, char **argv)
+{
+    HttpConn_Init();
+
+    get("not https", "", "", ESP_ERR_INVALID_ARG, 0, "");
+    int status = -1;
+    if (HttpConn_Get(&(http_conn_request_t){.url = "http://" MBTA "/"}, &status) != ESP_ERR_INVALID_ARG ||
+        status != 0) {
+        printf("FAIL plain http accepted\n");
+        s_fail++;
+    }
+
+    // Keep-alive: three polls, one handshake.
+    get("poll 1", MBTA, "/predictions", ESP_OK, 200, MBTA "/predictions #1");
+    get("poll 2", MBTA, "/predictions", ESP_OK, 200, MBTA "/predictions #2");
+    get("poll 3", MBTA, "/predictions", ESP_OK, 200, MBTA "/predictions #3");
+    http_conn_stats_t st = stats(MBTA);
+    expect("handshakes after 3 polls", (uint32_t)s_hosts[0].handshakes, 1);
+    expect("stats.handshakes", st.handshakes, 1);
+    expect("stats.requests", st.requests, 3);
+    expect("stats.reused", st.reused, 2);
+    expect("stats.last_handshake_ms", st.last_handshake_ms, FULL_HANDSHAKE_MS);
+    expect("stats.last_request_ms", st.last_request_ms, REQUEST_MS);
+
+    // Weather shares the pool: its own slot and stats, and the idle MBTA
+    // connection is closed for it (HTTP_CONN_MAX_OPEN).
+    get("weather", WEATHER, "/v1/forecast", ESP_OK, 200, WEATHER "/v1/forecast #1");
+    expect("open MBTA connections while weather polls", (uint32_t)open_conns(0), HTTP_CONN_MAX_OPEN > 1);
+    expect("weather stats.requests", stats(WEATHER).requests, 1);
+    expect("MBTA stats.requests", stats(MBTA).requests, 3);
+    get("poll after weather", MBTA, "/predictions", ESP_OK, 200, MBTA "/predictions #4");
+    expect("MBTA handshakes after weather", (uint32_t)s_hosts[0].handshakes, HTTP_CONN_MAX_OPEN > 1 ? 1 : 2);
+    get("poll 5", MBTA, "/predictions", ESP_OK, 200, MBTA "/predictions #5");
+    expect("MBTA handshakes", (uint32_t)s_hosts[0].handshakes, HTTP_CONN_MAX_OPEN > 1 ? 1 : 2);
+
+    // An error status: body drained, not delivered, connection kept.
+    get("404", MBTA, "/missing", ESP_OK, 404, "");
+    get("after 404", MBTA, "/predictions", ESP_OK, 200, MBTA "/predictions #7");
+    expect("MBTA handshakes after 404", (uint32_t)s_hosts[0].handshakes, HTTP_CONN_MAX_OPEN > 1 ? 1 : 2);
+
+    // The server dropped the idle connection: reconnect and retry, once.
+    st = stats(MBTA);
+    int handshakes = s_hosts[0].handshakes;
+    server_close_idle(0);
+    get("stale", MBTA, "/predictions", ESP_OK, 200, MBTA "/predictions #8");
+    expect("stale: handshakes", (uint32_t)(s_hosts[0].handshakes - handshakes), 1);
+    expect("stale: stats.stale_reconnects", stats(MBTA).stale_reconnects, st.stale_reconnects + 1);
+    expect("stale: stats.reused", stats(MBTA).reused, st.reused);
+
+    // Stale, and the reconnect fails: one retry only, then the error.
+    server_close_idle(0);
+    s_hosts[0].refuse = true;
+    int requests = s_hosts[0].requests;
+    get("stale, refused", MBTA, "/predictions", ESP_FAIL, 0, "");
+    s_hosts[0].refuse = false;
+    expect("stale, refused: requests", (uint32_t)(s_hosts[0].requests - requests), 0);
+    expect("stale, refused: stats.stale_reconnects", stats(MBTA).stale_reconnects, st.stale_reconnects + 2);
+    get("after refused", MBTA, "/predictions", ESP_OK, 200, MBTA "/predictions #9");
+
+    // Closed after the headers: bytes arrived, so no retry.
+    handshakes = s_hosts[0].handshakes;
+    esp_tls_t *conn = conn_of(0);
+    if (conn == NULL) {
+        printf("FAIL no connection kept open\n");
+        return 1;
+    }
+    conn->cut = true;
+    get("cut", MBTA, "/predictions", ESP_FAIL, 0, "");
+    expect("cut: handshakes", (uint32_t)(s_hosts[0].handshakes - handshakes), 0);
+    expect("cut: open connections", (uint32_t)open_conns(0), 0);
+    get("after cut", MBTA, "/predictions", ESP_OK, 200, MBTA "/predictions #11");
+
+    // Connection: close, honoured.
+    s_hosts[0].close = true;
+    get("close", MBTA, "/predictions", ESP_OK, 200, MBTA "/predictions #12");
+    s_hosts[0].close = false;
+    handshakes = s_hosts[0].handshakes;
+    get("after close", MBTA, "/predictions", ESP_OK, 200, MBTA "/predictions #13");
+    expect("after close: handshakes", (uint32_t)(s_hosts[0].handshakes - handshakes), 1);
+
+    check_resume();
+    st = stats(MBTA);
+
+    // A third host takes the least recently used slot (weather's).
+    get("other host", OTHER, "/", ESP_OK, 200, OTHER "/ #1");
+    http_conn_stats_t gone;
+    if (HttpConn_GetStats(WEATHER, &gone) || !HttpConn_GetStats(MBTA, &gone)) {
+        printf("FAIL the third host did not evict the least recently used one\n");
+        s_fail++;
+    }
+    get("weather again", WEATHER, "/v1/forecast", ESP_OK, 200, WEATHER "/v1/forecast #2");
+    expect("weather stats after eviction", stats(WEATHER).requests, 1);
+
+    if (s_sessions > HTTP_CONN_MAX_HOSTS) {
+        printf("FAIL %d TLS sessions held\n", s_sessions);
+        s_fail++;
+    }
+    if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+        bench();
+    }
+
+    printf("%s: %u requests, %u handshakes (%u resumed), %u reused, %u stale: %s\n", MBTA, (unsigned)st.requests,
+           (unsigned)st.handshakes, (unsigned)st.resumed, (unsigned)st.reused, (unsigned)st.stale_reconnects,
+           s_fail ? "FAIL" : "ok");
+    return s_fail != 0;
+}
@@ -0,0 +1,212 @@
+// iso8601_to_epoch_utc() against glibc's timegm(): every calendar day of
+// years 1..9999, every second of a day, every zone offset, and the inputs
+// it must reject. With -b, also a microbenchmark against the sscanf +
+// setenv("TZ")/mktime() conversion it replaced.
+
+#include "iso8601.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static long s_checked;
+static long s_failed;
+
+static void check(const char *s, bool want_ok, time_t want)
+{
+    time_t got = 0;
+    bool ok = iso8601_to_epoch_utc(s, &got);
+    s_checked++;
+    if (ok != want_ok || (ok && got != want)) {
+        if (s_failed++ < 10) {
+            printf("FAIL %s: got %s %lld, want %s %lld\n", s, ok ? "ok" : "reject", (long long)got,
+                   want_ok ? "ok" : "reject", (long long)want);
+        }
+    }
+}
+
+static time_t utc(int year, int mon, int day, int hour, int min, int sec)
+{
+    struct tm tm = {
+        .tm_year = year - 1900,
+        .tm_mon = mon - 1,
+        .tm_mday = day,
+        .tm_hour = hour,
+        .tm_min = min,
+        .tm_sec = sec,
+    };
+    return timegm(&tm);
+}
+
+// Every day, walked by timegm() itself so its idea of the calendar decides
+// which dates exist. The time of day and the zone suffix vary with the day.
+static void every_day(void)
+{
+    static const struct {
+        const char *suffix;
+        int offset;
+    } zones[] = {
+        {"", 0}, {"Z", 0}, {".5Z", 0}, {"-04:00", -4 * 3600}, {"-0500", -5 * 3600},
+        {"+05:30", 5 * 3600 + 30 * 60}, {"+14", 14 * 3600}, {".123456-12:00", -12 * 3600},
+    };
+    time_t day0 = utc(1, 1, 1, 0, 0, 0);
+    time_t end = utc(10000, 1, 1, 0, 0, 0);
+    long n = 0;
+    for (time_t d = day0; d < end; d += 86400, n++) {
+        struct tm tm;
+        gmtime_r(&d, &tm);
+        int hour = (int)(n % 24), min = (int)(n * 7 % 60), sec = (int)(n * 13 % 60);
+        int z = (int)(n % (sizeof(zones) / sizeof(zones[0])));
+        char s[64];
+        snprintf(s, sizeof(s), "%04d-%02d-%02dT%02d:%02d:%02d%s", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                 hour, min, sec, zones[z].suffix);
+        check(s, true, d + hour * 3600 + min * 60 + sec - zones[z].offset);
+    }
+    printf("every day 0001-9999: %ld days\n", n);
+}
+
+static void every_second(void)
+{
+    time_t day = utc(2026, 3, 8, 0, 0, 0); // a US DST change, for no reason but habit
+    for (int t = 0; t < 86400; t++) {
+        char s[32];
+        snprintf(s, sizeof(s), "2026-03-08T%02d:%02d:%02d-04:00", t / 3600, t / 60 % 60, t % 60);
+        check(s, true, day + t + 4 * 3600);
+    }
+    // A leap second lands on the next minute, as with timegm().
+    check("2016-12-31T23:59:60Z", true, utc(2017, 1, 1, 0, 0, 0));
+}
+
+static void every_offset(void)
+{
+    time_t base = utc(2026, 10, 16, 12, 0, 0);
+    for (int sign = -1; sign <= 1; sign += 2) {
+        for (int h = 0; h < 24; h++) {
+            for (int m = 0; m < 60; m++) {
+                char s[64];
+                int off = sign * (h * 3600 + m * 60);
+                char c = sign < 0 ? '-' : '+';
+                snprintf(s, sizeof(s), "2026-10-16T12:00:00%c%02d:%02d", c, h, m);
+                check(s, true, base - off);
+                snprintf(s, sizeof(s), "2026-10-16T12:00:00%c%02d%02d", c, h, m);
+                check(s, true, base - off);
+            }
+            char s[64];
+            snprintf(s, sizeof(s), "2026-10-16T12:00:00%c%02d", sign < 0 ? '-' : '+', h);
+            check(s, true, base - sign * h * 3600);
+        }
+    }
+}
+
+// Days 0..32 of every month over the leap-year cases; timegm() normalizes
+// the ones that do not exist, the parser must reject them.
+static void every_month_end(void)
+{
+    static const int years[] = {1900, 1970, 2000, 2023, 2024, 2100, 2400};
+    for (size_t y = 0; y < sizeof(years) / sizeof(years[0]); y++) {
+        for (int mon = 0; mon <= 13; mon++) {
+            for (int day = 0; day <= 32; day++) {
+                struct tm tm = {.tm_year = years[y] - 1900, .tm_mon = mon - 1, .tm_mday = day};
+                time_t t = timegm(&tm);
+                bool exists = tm.tm_mon == mon - 1 && tm.tm_mday == day;
+                char s[32];
+                snprintf(s, sizeof(s), "%04d-%02d-%02dT00:00:00Z", years[y], mon, day);
+                check(s, exists, t);
+            }
+        }
+    }
+}
+
+static void malformed(void)
+{
+    static const char *bad[] = {
+        "", "2026", "2026-10-16", "2026-10-16T12:00", "2026-10-16 12:00:00Z", "2026-10-16T12:00:00ZZ",
+        "2026-1-16T12:00:00Z", "2026-10-16T1:00:00Z", "26-10-16T12:00:00Z", "2026/10/16T12:00:00Z",
+        "2026-10-16T24:00:00Z", "2026-10-16T12:60:00Z", "2026-10-16T12:00:61Z", "2026-10-16T12:00:00.Z",
+        "2026-10-16T12:00:00.", "2026-10-16T12:00:00-", "2026-10-16T12:00:00-4", "2026-10-16T12:00:00-04:",
+        "2026-10-16T12:00:00-04:0", "2026-10-16T12:00:00-24:00", "2026-10-16T12:00:00+04:60",
+        "2026-10-16T12:00:00-04:00 ", " 2026-10-16T12:00:00Z", "2026-10-16T12:00:00+-4:00",
+        "2026-10-16t12:00:00Z", "2026-10-16T12:00:00z", "2026-1a-16T12:00:00Z",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        check(bad[i], false, 0);
+    }
+    time_t t;
+    if (iso8601_to_epoch_utc(NULL, &t) || iso8601_to_epoch_utc("2026-10-16T12:00:00Z", NULL)) {
+        printf("FAIL NULL accepted\n");
+        s_failed++;
+    }
+}
+
+// The conversion iso8601_to_epoch_utc() replaced: sscanf, then mktime()
+// with TZ switched to UTC and back.
+static bool old_to_epoch_utc(const char *s, time_t *out)
+{
+    int year, mon, day, hour, min, sec, tzh = 0, tzm = 0;
+    char sign = 0;
+    if (sscanf(s, "%4d-%2d-%2dT%2d:%2d:%2d%c%2d:%2d", &year, &mon, &day, &hour, &min, &sec, &sign, &tzh, &tzm) < 6) {
+        return false;
+    }
+    struct tm tm = {.tm_year = year - 1900, .tm_mon = mon - 1, .tm_mday = day,
+                    .tm_hour = hour, .tm_min = min, .tm_sec = sec, .tm_isdst = -1};
+    char old_tz[64];
+    const char *old = getenv("TZ");
+    if (old) {
+        snprintf(old_tz, sizeof(old_tz), "%s", old);
+    }
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    time_t t = mktime(&tm);
+    setenv("TZ", old ? old_tz : "EST5EDT,M3.2.0,M11.1.0", 1);
+    tzset();
+    int off = (tzh * 3600 + tzm * 60) * (sign == '-' ? -1 : 1);
+    *out = t - (sign == '+' || sign == '-' ? off : 0);
+    return t != (time_t)-1;
+}
+
+static double bench_ns(bool (*fn)(const char *, time_t *), long reps)
+{
+    static const char *inputs[] = {
+        "2026-10-16T08:04:12-04:00", "2026-10-16T08:11:45-04:00", "2026-12-01T17:30:00-05:00",
+        "2026-10-16T12:04:12Z",
+    };
+    struct timespec a, b;
+    volatile time_t sink = 0;
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (long i = 0; i < reps; i++) {
+        time_t t = 0;
+        fn(inputs[i & 3], &t);
+        sink += t;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    (void)sink;
+    return ((double)(b.tv_sec - a.tv_sec) * 1e9 + (double)(b.tv_nsec - a.tv_nsec)) / (double)reps;
+}
+
+int main(int argc, char **argv)
+{
+    every_day();
+    every_second();
+    every_offset();
+    every_month_end();
+    malformed();
+    printf("%ld inputs, %ld failed\n", s_checked, s_failed);
+    if (s_failed != 0) {
+        return 1;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+        setenv("TZ", "EST5EDT,M3.2.0,M11.1.0", 1);
+        tzset();
+        time_t a, b;
+        if (!old_to_epoch_utc("2026-10-16T08:04:12-04:00", &a) ||
+            !iso8601_to_epoch_utc("2026-10-16T08:04:12-04:00", &b) || a != b) {
+            printf("FAIL old and new conversions disagree\n");
+            return 1;
+        }
+        printf("iso8601_to_epoch_utc: %7.1f ns/call\n", bench_ns(iso8601_to_epoch_utc, 20000000));
+        printf("sscanf + TZ/mktime:   %7.1f ns/call\n", bench_ns(old_to_epoch_utc, 200000));
+    }
+    return 0;
+}
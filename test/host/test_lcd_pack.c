@@ -0,0 +1,121 @@
+// RGB444 packing: every one of the 65536 RGB565 values against a reference
+// conversion (each channel rounded to the nearest of 16 levels), the byte
+// layout of pairs and of an odd last pixel, and packing in place against
+// packing into a separate buffer, for every length up to a few rows.
+//
+// With -b, also the packing speed over a full 172x320 frame.
+
+#include "lcd_pack.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define HOR_RES 172
+#define VER_RES 320
+
+static int s_fail;
+
+// The nearest 4-bit level of an n-bit channel value.
+static uint32_t ref_level(uint32_t v, uint32_t max)
+{
+    return (uint32_t)lround((double)v * 15.0 / (double)max);
+}
+
+static uint32_t ref_444(uint16_t c)
+{
+    return ref_level(c >> 11, 31) << 8 | ref_level((c >> 5) & 0x3F, 63) << 4 | ref_level(c & 0x1F, 31);
+}
+
+static void check_all_colors(void)
+{
+    int bad = 0;
+    for (uint32_t c = 0; c <= 0xFFFF; c++) {
+        // The pair (c, ~c) exercises both halves of the three bytes.
+        uint16_t src[2] = {(uint16_t)c, (uint16_t)~c};
+        uint8_t out[3];
+        lcd_pack_rgb444(out, src, 2);
+        uint32_t a = (uint32_t)out[0] << 4 | out[1] >> 4;
+        uint32_t b = (uint32_t)(out[1] & 0x0F) << 8 | out[2];
+        if (a != ref_444(src[0]) || b != ref_444(src[1])) {
+            if (bad++ < 5) {
+                printf("FAIL %04x: %03x, want %03x\n", (unsigned)c, (unsigned)a, (unsigned)ref_444(src[0]));
+            }
+        }
+    }
+    printf("65536 colors: %d off the nearest level\n", bad);
+    s_fail += bad;
+}
+
+static void check_layout(void)
+{
+    // Pure red, green, blue, white: R1G1 B1R2 G2B2, then an odd tail R G / B 0.
+    const uint16_t src[5] = {0xF800, 0x07E0, 0x001F, 0xFFFF, 0x8410};
+    const uint8_t want[] = {0xF0, 0x00, 0xF0, 0x00, 0xFF, 0xFF, 0x88, 0x80};
+    uint8_t out[sizeof(want) + 1];
+    memset(out, 0xAA, sizeof(out));
+    size_t n = lcd_pack_rgb444(out, src, 5);
+    if (n != sizeof(want) || memcmp(out, want, sizeof(want)) != 0 || out[sizeof(want)] != 0xAA) {
+        printf("FAIL layout: %zu bytes:", n);
+        for (size_t i = 0; i < n; i++) {
+            printf(" %02x", out[i]);
+        }
+        printf("\n");
+        s_fail++;
+    }
+}
+
+static void check_in_place(void)
+{
+    static uint16_t src[HOR_RES * 4];
+    static uint16_t buf[HOR_RES * 4];
+    static uint8_t out[LCD_RGB444_BYTES(HOR_RES * 4)];
+    uint32_t seed = 1;
+    for (size_t i = 0; i < sizeof(src) / sizeof(src[0]); i++) {
+        seed = seed * 1103515245u + 12345u;
+        src[i] = (uint16_t)(seed >> 16);
+    }
+
+    for (size_t px = 0; px <= sizeof(src) / sizeof(src[0]); px++) {
+        memcpy(buf, src, sizeof(buf));
+        size_t a = lcd_pack_rgb444(out, src, px);
+        size_t b = lcd_pack_rgb444((uint8_t *)buf, buf, px);
+        if (a != LCD_RGB444_BYTES(px) || b != a || memcmp(out, buf, a) != 0) {
+            printf("FAIL %zu pixels: %zu / %zu bytes, want %zu\n", px, a, b, (size_t)LCD_RGB444_BYTES(px));
+            s_fail++;
+            return;
+        }
+    }
+}
+
+static void bench(void)
+{
+    static uint16_t fb[HOR_RES * VER_RES];
+    for (size_t i = 0; i < sizeof(fb) / sizeof(fb[0]); i++) {
+        fb[i] = (uint16_t)(i * 40503u);
+    }
+    const int frames = 500;
+    struct timespec a, b;
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (int f = 0; f < frames; f++) {
+        fb[f] ^= 1;
+        lcd_pack_rgb444((uint8_t *)fb, fb, HOR_RES * VER_RES);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    double ns = ((double)(b.tv_sec - a.tv_sec) * 1e9 + (double)(b.tv_nsec - a.tv_nsec)) / frames;
+    printf("pack %dx%d: %.0f us/frame, %.2f ns/pixel; %d bytes instead of %d\n", HOR_RES, VER_RES, ns / 1000,
+           ns / (HOR_RES * VER_RES), LCD_RGB444_BYTES(HOR_RES * VER_RES), HOR_RES * VER_RES * 2);
+}
+
+int main(int argc, char **argv)
+{
+    check_all_colors();
+    check_layout();
+    check_in_place();
+    if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+        bench();
+    }
+    printf("%s\n", s_fail ? "FAIL" : "ok");
+    return s_fail != 0;
+}
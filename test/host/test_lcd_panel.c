@@ -0,0 +1,678 @@
+// The display pipeline end to end against a model of the ST7789: the real
+// LVGL_Driver.c and Vernon_ST7789T.c, with LVGL, drive a panel IO that
+// keeps frame memory, the address window, RAMWR/RAMWRC, RAMCTRL, COLMOD and
+// the vertical scroll (VSCRDEF/VSCSAD/NORON). Pixel transfers take the
+// time they would at the panel's SPI clock and land in frame memory only
+// when done, read from the caller's buffer then: a buffer reused while on
+// the wire shows up as wrong pixels. As in esp_lcd's SPI IO, the next
+// command first waits for the transfer in flight, and a driver blocked on
+// a semaphore waits for it too. Every band of a multi-band redraw after the
+// first must have been rendered while the one before it was still being
+// sent, after one address window and RAMWR, with RAMWRC. The countdown
+// reports the command bytes, SPI transactions and CS toggles per frame.
+//
+// After every refresh the image the panel shows, rebuilt from frame memory
+// and the scroll registers, must equal a golden image: LVGL's own render of
+// the screen (lv_snapshot), each pixel in the wire format it was last
+// written in. A screen of labels and a bar changes from frame to frame, the
+// screen is swapped, and the whole run is repeated in RGB444.
+//
+// Built once per driver configuration (see PANELS in the Makefile). With
+// LCD_USE_HW_TICKER the ticker band is checked against a tape of the text
+// rendered by LVGL as one tall label, one line per band, at the row the
+// steps taken have reached: the scroll reconstruction on real pixels.
+
+#include "LVGL_Driver.h"
+#include "esp_lcd_panel_commands.h"
+#include "freertos/semphr.h"
+#include "lcd_pack.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#if LCD_USE_DIRECT_MODE && LCD_USE_HW_TICKER
+#define MODE "direct mode, hw ticker"
+#elif LCD_USE_DIRECT_MODE
+#define MODE "direct mode"
+#elif LCD_USE_HW_TICKER
+#define MODE "partial, hw ticker"
+#else
+#define MODE "partial"
+#endif
+
+static int s_fail;
+
+// Defined in ST7789.c on the device.
+esp_lcd_panel_handle_t panel_handle;
+
+// Fakes for FreeRTOS and esp_timer. A take that finds nothing waits for the
+// transfer in flight; with none, it would wait forever.
+static int64_t s_now_us = 1000000;
+int64_t esp_timer_get_time(void) { return s_now_us; }
+void vTaskDelay(TickType_t ticks) { (void)ticks; }
+
+typedef struct {
+    unsigned count;
+    unsigned max;
+} host_sem_t;
+
+static host_sem_t s_sems[4];
+static int s_sem_count;
+
+static SemaphoreHandle_t sem_new(unsigned max, unsigned count)
+{
+    host_sem_t *s = &s_sems[s_sem_count++];
+    s->max = max;
+    s->count = count;
+    return s;
+}
+SemaphoreHandle_t xSemaphoreCreateBinary(void) { return sem_new(1, 0); }
+SemaphoreHandle_t xSemaphoreCreateCounting(unsigned max, unsigned initial) { return sem_new(max, initial); }
+static void lcd_wait_tx(bool next_ready);
+static bool lvgl_moved_on(void);
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    host_sem_t *s = (host_sem_t *)sem;
+    (void)ticks;
+    if (s->count == 0) {
+        lcd_wait_tx(lvgl_moved_on());
+    }
+    if (s->count == 0) {
+        printf("FAIL take on a semaphore nothing will give\n");
+        s_fail++;
+        return pdFALSE;
+    }
+    s->count--;
+    return pdTRUE;
+}
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *woken)
+{
+    host_sem_t *s = (host_sem_t *)sem;
+    if (s->count < s->max) {
+        s->count++;
+    }
+    *woken = pdFALSE;
+    return pdTRUE;
+}
+
+// ---- The panel ----
+
+#define GRAM_W 240
+#define GRAM_H 320
+
+static uint16_t s_gram[GRAM_H][GRAM_W];
+static bool s_gram_444[GRAM_H][GRAM_W]; // written as RGB444
+
+static struct {
+    int x0, x1, y0, y1; // address window
+    int x, y;           // write pointer
+    bool writing;       // last command was RAMWR/RAMWRC
+    uint8_t colmod;
+    uint8_t ramctrl;
+    int tfa, vsa, bfa;
+    int vscsad;
+    bool scrolling;
+    long scroll_cmds;
+    long pixel_bytes;
+    long cmd_bytes;
+
+    // The SPI traffic, counted as esp_lcd's SPI IO sends it. tx_param: the
+    // command and its parameters are polled transactions under one CS
+    // assertion. tx_color: the command is polled under its own, then the
+    // pixels go in one queued transaction (max_transfer_sz is a whole
+    // frame) under another. A CS toggle is one assert-release.
+    long transactions;
+    long cs_toggles;
+    long casets;
+    long rasets;
+    long ramwrs;
+    long ramwrcs;
+
+    // The pixel transfer on the wire.
+    bool tx_busy;
+    int tx_cmd;
+    const uint8_t *tx_data;
+    size_t tx_size;
+    int64_t tx_done_us;
+    bool tx_overlapped; // the next band was ready before it was done
+    long sends;        // pixel transfers
+    long overlapped;   // of those, issued while the one before was on the wire
+} s_lcd = {.x1 = GRAM_W - 1, .y1 = GRAM_H - 1, .colmod = 0x55, .ramctrl = 0xE8, .vsa = GRAM_H};
+
+static void lcd_error(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    printf("FAIL panel: ");
+    vprintf(fmt, ap);
+    printf("\n");
+    va_end(ap);
+    s_fail++;
+}
+
+static int be16(const uint8_t *p) { return p[0] << 8 | p[1]; }
+
+static void lcd_write_pixels(int lcd_cmd, const uint8_t *b, size_t color_size);
+
+// Let the transfer on the wire finish: time passes, its pixels land, and
+// the transfer-done ISR runs. next_ready: whoever waits already has the
+// next band drawn.
+static void lcd_wait_tx(bool next_ready)
+{
+    if (!s_lcd.tx_busy) {
+        return;
+    }
+    s_lcd.tx_busy = false;
+    s_lcd.tx_overlapped = next_ready;
+    if (s_now_us < s_lcd.tx_done_us) {
+        s_now_us = s_lcd.tx_done_us;
+    }
+    lcd_write_pixels(s_lcd.tx_cmd, s_lcd.tx_data, s_lcd.tx_size);
+    example_notify_lvgl_flush_ready(NULL, NULL, &disp_drv);
+}
+
+// The last band of a refresh is still on the wire when LVGL returns; by
+// the next pass (or a look at the panel) it is done.
+static void lcd_settle(void)
+{
+    lcd_wait_tx(false);
+}
+
+// Whether a take that has to wait is LVGL's, with the next band drawn into
+// its other buffer, rather than the driver's waiting on the band it has
+// just sent (LVGL's buffer is still that one then).
+static bool lvgl_moved_on(void)
+{
+    const lv_disp_draw_buf_t *db = lv_disp_get_draw_buf(lv_disp_get_default());
+    const uint8_t *act = (const uint8_t *)db->buf_act;
+    return s_lcd.tx_data < act || s_lcd.tx_data >= act + db->size * sizeof(lv_color_t);
+}
+
+esp_err_t esp_lcd_panel_io_tx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *param, size_t param_size)
+{
+    const uint8_t *p = param;
+    (void)io;
+    lcd_wait_tx(true);
+    s_lcd.cmd_bytes += 1 + (long)param_size;
+    s_lcd.transactions += 1 + (param_size != 0);
+    s_lcd.cs_toggles++;
+    s_lcd.writing = false;
+    switch (lcd_cmd) {
+    case LCD_CMD_CASET:
+        s_lcd.casets++;
+        s_lcd.x0 = be16(p);
+        s_lcd.x1 = be16(p + 2);
+        if (s_lcd.x0 > s_lcd.x1 || s_lcd.x1 >= GRAM_W) {
+            lcd_error("CASET %d-%d", s_lcd.x0, s_lcd.x1);
+        }
+        break;
+    case LCD_CMD_RASET:
+        s_lcd.rasets++;
+        s_lcd.y0 = be16(p);
+        s_lcd.y1 = be16(p + 2);
+        if (s_lcd.y0 > s_lcd.y1 || s_lcd.y1 >= GRAM_H) {
+            lcd_error("RASET %d-%d", s_lcd.y0, s_lcd.y1);
+        }
+        break;
+    case LCD_CMD_COLMOD:
+        s_lcd.colmod = p[0];
+        break;
+    case 0xB0: // RAMCTRL
+        s_lcd.ramctrl = p[1];
+        break;
+    case LCD_CMD_VSCRDEF:
+        s_lcd.tfa = be16(p);
+        s_lcd.vsa = be16(p + 2);
+        s_lcd.bfa = be16(p + 4);
+        if (s_lcd.tfa + s_lcd.vsa + s_lcd.bfa != GRAM_H) {
+            lcd_error("VSCRDEF %d+%d+%d", s_lcd.tfa, s_lcd.vsa, s_lcd.bfa);
+        }
+        break;
+    case LCD_CMD_VSCSAD:
+        s_lcd.vscsad = be16(p);
+        s_lcd.scrolling = true;
+        s_lcd.scroll_cmds++;
+        if (s_lcd.vscsad < s_lcd.tfa || s_lcd.vscsad >= s_lcd.tfa + s_lcd.vsa) {
+            lcd_error("VSCSAD %d outside %d+%d", s_lcd.vscsad, s_lcd.tfa, s_lcd.vsa);
+        }
+        break;
+    case LCD_CMD_NORON:
+        s_lcd.scrolling = false;
+        break;
+    }
+    return ESP_OK;
+}
+
+static void lcd_put(uint16_t c, bool is444)
+{
+    if (s_lcd.y > s_lcd.y1) {
+        lcd_error("write past the window");
+        return;
+    }
+    s_gram[s_lcd.y][s_lcd.x] = c;
+    s_gram_444[s_lcd.y][s_lcd.x] = is444;
+    if (++s_lcd.x > s_lcd.x1) {
+        s_lcd.x = s_lcd.x0;
+        s_lcd.y++;
+    }
+}
+
+// A 4-bit level as the panel shows it, back in RGB565 terms.
+static uint16_t rgb444_to_565(unsigned r, unsigned g, unsigned b)
+{
+    return (uint16_t)((r << 1 | r >> 3) << 11 | (g << 2 | g >> 2) << 5 | (b << 1 | b >> 3));
+}
+
+esp_err_t esp_lcd_panel_io_tx_color(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *color, size_t color_size)
+{
+    (void)io;
+    lcd_wait_tx(true);
+    s_lcd.cmd_bytes++;
+    s_lcd.pixel_bytes += (long)color_size;
+    s_lcd.transactions += 2;
+    s_lcd.cs_toggles += 2;
+    s_lcd.ramwrs += lcd_cmd == LCD_CMD_RAMWR;
+    s_lcd.ramwrcs += lcd_cmd == LCD_CMD_RAMWRC;
+    s_lcd.sends++;
+    s_lcd.overlapped += s_lcd.tx_overlapped;
+    s_lcd.tx_overlapped = false;
+
+    int64_t start_us = s_now_us;
+    s_lcd.tx_busy = true;
+    s_lcd.tx_cmd = lcd_cmd;
+    s_lcd.tx_data = color;
+    s_lcd.tx_size = color_size;
+    s_lcd.tx_done_us = start_us + (int64_t)color_size * 8 * 1000000 / EXAMPLE_LCD_PIXEL_CLOCK_HZ;
+    return ESP_OK;
+}
+
+static void lcd_write_pixels(int lcd_cmd, const uint8_t *b, size_t color_size)
+{
+    if (lcd_cmd == LCD_CMD_RAMWR) {
+        s_lcd.x = s_lcd.x0;
+        s_lcd.y = s_lcd.y0;
+    } else if (lcd_cmd != LCD_CMD_RAMWRC || !s_lcd.writing) {
+        lcd_error("pixels with command %02x", lcd_cmd);
+    }
+    if (s_lcd.colmod == 0x55) {
+        bool le = s_lcd.ramctrl & 0x08;
+        for (size_t i = 0; i + 1 < color_size; i += 2) {
+            lcd_put((uint16_t)(le ? b[i] | b[i + 1] << 8 : b[i] << 8 | b[i + 1]), false);
+        }
+    } else if (s_lcd.colmod == 0x53) {
+        for (size_t i = 0; i + 1 < color_size; i += 3) {
+            lcd_put(rgb444_to_565(b[i] >> 4, b[i] & 0x0F, b[i + 1] >> 4), true);
+            if (i + 2 < color_size) {
+                lcd_put(rgb444_to_565(b[i + 1] & 0x0F, b[i + 2] >> 4, b[i + 2] & 0x0F), true);
+            }
+        }
+    } else {
+        lcd_error("COLMOD %02x", s_lcd.colmod);
+    }
+    s_lcd.writing = true;
+}
+
+// Frame memory position shown at screen pixel x, y.
+static void shown(int x, int y, int *gx, int *gy)
+{
+    *gx = x + Offset_X;
+    *gy = y + Offset_Y;
+    if (s_lcd.scrolling && *gy >= s_lcd.tfa && *gy < s_lcd.tfa + s_lcd.vsa) {
+        *gy = s_lcd.tfa + (s_lcd.vscsad - s_lcd.tfa + *gy - s_lcd.tfa) % s_lcd.vsa;
+    }
+}
+
+// ---- Golden images ----
+
+static uint16_t s_snap[EXAMPLE_LCD_H_RES * EXAMPLE_LCD_V_RES];
+
+static uint16_t as_444(uint16_t c)
+{
+    uint16_t two[2] = {c, c};
+    uint8_t b[3];
+    lcd_pack_rgb444(b, two, 2);
+    return rgb444_to_565(b[0] >> 4, b[0] & 0x0F, b[1] >> 4);
+}
+
+#if LCD_USE_HW_TICKER
+#define BAND_H 18
+static const char *TICKER_TEXT =
+    "Route 57: Detour in effect at Kenmore due to construction. Expect delays of 10 to 15 minutes (+2)";
+static uint16_t s_tape[EXAMPLE_LCD_H_RES * BAND_H * 16];
+static int s_tape_rows;
+static int s_band_y = -1; // ticker rows, -1 when hidden
+static long s_steps_base;
+#endif
+
+static void snapshot(lv_obj_t *obj, uint16_t *buf, size_t size)
+{
+    lv_img_dsc_t dsc;
+    if (lv_snapshot_take_to_buf(obj, LV_IMG_CF_TRUE_COLOR, &dsc, buf, (uint32_t)size) != LV_RES_OK) {
+        printf("FAIL snapshot\n");
+        s_fail++;
+    }
+}
+
+static int s_checks;
+
+static void check(const char *what)
+{
+    lcd_settle();
+    snapshot(lv_scr_act(), s_snap, sizeof(s_snap));
+    long bad = 0;
+    for (int y = 0; y < EXAMPLE_LCD_V_RES; y++) {
+        const uint16_t *want = &s_snap[y * EXAMPLE_LCD_H_RES];
+#if LCD_USE_HW_TICKER
+        if (s_band_y >= 0 && y >= s_band_y && y < s_band_y + BAND_H) {
+            long steps = s_lcd.scroll_cmds - s_steps_base;
+            want = &s_tape[((steps + y - s_band_y) % s_tape_rows) * EXAMPLE_LCD_H_RES];
+        }
+#endif
+        for (int x = 0; x < EXAMPLE_LCD_H_RES; x++) {
+            int gx, gy;
+            shown(x, y, &gx, &gy);
+            uint16_t w = s_gram_444[gy][gx] ? as_444(want[x]) : want[x];
+            if (s_gram[gy][gx] != w) {
+                if (bad++ == 0) {
+                    printf("FAIL %s: %d,%d shows %04x, want %04x\n", what, x, y, s_gram[gy][gx], w);
+                }
+            }
+        }
+    }
+    s_fail += bad != 0;
+    s_checks++;
+}
+
+// What the last frame sent.
+static struct {
+    long sends;
+    long overlapped;
+    long cmd_bytes;
+    long transactions;
+    long cs_toggles;
+    long casets;
+    long rasets;
+    long ramwrs;
+    long ramwrcs;
+} s_frame;
+
+// One pass of the UI loop, ms after the last.
+static void frame(int ms)
+{
+    lcd_settle();
+    s_now_us += (int64_t)ms * 1000;
+    long sends = s_lcd.sends;
+    long overlapped = s_lcd.overlapped;
+    long cmd_bytes = s_lcd.cmd_bytes;
+    long transactions = s_lcd.transactions;
+    long cs_toggles = s_lcd.cs_toggles;
+    long casets = s_lcd.casets;
+    long rasets = s_lcd.rasets;
+    long ramwrs = s_lcd.ramwrs;
+    long ramwrcs = s_lcd.ramwrcs;
+    LVGL_TickUpdate();
+    lv_timer_handler();
+    s_frame.sends = s_lcd.sends - sends;
+    s_frame.overlapped = s_lcd.overlapped - overlapped;
+    s_frame.cmd_bytes = s_lcd.cmd_bytes - cmd_bytes;
+    s_frame.transactions = s_lcd.transactions - transactions;
+    s_frame.cs_toggles = s_lcd.cs_toggles - cs_toggles;
+    s_frame.casets = s_lcd.casets - casets;
+    s_frame.rasets = s_lcd.rasets - rasets;
+    s_frame.ramwrs = s_lcd.ramwrs - ramwrs;
+    s_frame.ramwrcs = s_lcd.ramwrcs - ramwrcs;
+}
+
+// A redraw of many bands: each one after the first was rendered while the
+// one before it was being sent.
+static void check_overlap(const char *what)
+{
+    if (s_frame.sends < 2 || s_frame.overlapped != s_frame.sends - 1) {
+        printf("FAIL %s: %ld of %ld bands rendered while the previous one was on the wire\n", what,
+               s_frame.overlapped, s_frame.sends);
+        s_fail++;
+    }
+}
+
+// A redraw of many bands sets the address window at most once and starts
+// one memory write; every band after it continues that write with RAMWRC.
+static void check_window(const char *what)
+{
+    if (s_frame.sends == 0) {
+        return;
+    }
+    if (s_frame.casets > 1 || s_frame.rasets > 1 || s_frame.ramwrs != 1 || s_frame.ramwrcs != s_frame.sends - 1) {
+        printf("FAIL %s: %ld bands sent with %ld CASET, %ld RASET, %ld RAMWR, %ld RAMWRC\n", what, s_frame.sends,
+               s_frame.casets, s_frame.rasets, s_frame.ramwrs, s_frame.ramwrcs);
+        s_fail++;
+    }
+}
+
+// ---- The screens ----
+
+static lv_obj_t *s_main;
+static lv_obj_t *s_other;
+static lv_obj_t *s_clock;
+static lv_obj_t *s_minutes;
+static lv_obj_t *s_unit;
+static lv_obj_t *s_bar;
+static lv_obj_t *s_banner;
+
+static lv_obj_t *label(lv_obj_t *parent, const lv_font_t *font, lv_align_t align, int y, const char *text)
+{
+    lv_obj_t *l = lv_label_create(parent);
+    lv_obj_set_style_text_font(l, font, 0);
+    lv_obj_set_style_text_color(l, lv_color_white(), 0);
+    lv_obj_align(l, align, 0, y);
+    lv_label_set_text(l, text);
+    return l;
+}
+
+static void build_screens(void)
+{
+    s_main = lv_scr_act();
+    lv_obj_set_style_bg_color(s_main, lv_color_hex(0x101820), 0);
+    s_clock = label(s_main, &lv_font_montserrat_12, LV_ALIGN_TOP_MID, 8, "12:00");
+    lv_obj_t *title = label(s_main, &lv_font_montserrat_16, LV_ALIGN_TOP_MID, 30, "Harvard Ave @ Commonwealth");
+    lv_obj_set_width(title, 160);
+    lv_label_set_long_mode(title, LV_LABEL_LONG_DOT);
+    s_minutes = label(s_main, &lv_font_montserrat_48, LV_ALIGN_CENTER, -20, "7");
+    s_unit = label(s_main, &lv_font_montserrat_16, LV_ALIGN_CENTER, 20, "min");
+    s_bar = lv_bar_create(s_main);
+    lv_obj_set_size(s_bar, 140, 6);
+    lv_obj_align(s_bar, LV_ALIGN_CENTER, 0, 50);
+    label(s_main, &lv_font_montserrat_24, LV_ALIGN_BOTTOM_MID, -50, "Kenmore");
+
+    // The alert band at the bottom, where the ticker goes.
+    s_banner = lv_obj_create(s_main);
+    lv_obj_set_size(s_banner, lv_pct(100), 18);
+    lv_obj_align(s_banner, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_obj_set_style_radius(s_banner, 0, 0);
+    lv_obj_set_style_border_width(s_banner, 0, 0);
+    lv_obj_set_style_pad_all(s_banner, 2, 0);
+    lv_obj_set_style_bg_color(s_banner, lv_color_hex(0xFFB74D), 0);
+    lv_obj_clear_flag(s_banner, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_t *alert = label(s_banner, &lv_font_montserrat_12, LV_ALIGN_CENTER, 0, "Route 57: Detour");
+    lv_obj_set_style_text_color(alert, lv_color_black(), 0);
+
+    s_other = lv_obj_create(NULL);
+    lv_obj_set_style_bg_color(s_other, lv_color_hex(0x1E3A5F), 0);
+    label(s_other, &lv_font_montserrat_48, LV_ALIGN_CENTER, -30, "13\xC2\xB0");
+    label(s_other, &lv_font_montserrat_16, LV_ALIGN_CENTER, 20, "Cloudy");
+    label(s_other, &lv_font_montserrat_12, LV_ALIGN_BOTTOM_MID, -10, "H 15  L 9");
+}
+
+// Label and bar updates, one second apart, as the countdown does them.
+static void run_countdown(const char *what, int seconds)
+{
+    char buf[16];
+    long bytes = s_lcd.pixel_bytes;
+    long cmd_bytes = s_lcd.cmd_bytes;
+    long transactions = s_lcd.transactions;
+    long cs_toggles = s_lcd.cs_toggles;
+    for (int i = 0; i < seconds; i++) {
+        snprintf(buf, sizeof(buf), "%d", (i / 3) % 20);
+        lv_label_set_text(s_minutes, buf);
+        if (i % 10 == 0) {
+            snprintf(buf, sizeof(buf), "12:%02d", i / 10);
+            lv_label_set_text(s_clock, buf);
+        }
+        lv_bar_set_value(s_bar, (i * 7) % 100, LV_ANIM_OFF);
+        if (i % 13 == 0) {
+            lv_obj_add_flag(s_unit, LV_OBJ_FLAG_HIDDEN);
+        } else {
+            lv_obj_clear_flag(s_unit, LV_OBJ_FLAG_HIDDEN);
+        }
+        frame(1000);
+        check(what);
+    }
+    printf("  %-24s %7.0f pixel bytes/s, per frame %4.1f command bytes, %4.1f transactions, %4.1f CS toggles\n",
+           what, (double)(s_lcd.pixel_bytes - bytes) / seconds, (double)(s_lcd.cmd_bytes - cmd_bytes) / seconds,
+           (double)(s_lcd.transactions - transactions) / seconds, (double)(s_lcd.cs_toggles - cs_toggles) / seconds);
+}
+
+#if LCD_USE_HW_TICKER
+// The tape: the text in one label as wide as the ticker's lines, one line
+// per band, centred in it like the ticker's cards.
+static void build_tape(void)
+{
+    const lv_font_t *font = &lv_font_montserrat_12;
+    int lh = lv_font_get_line_height(font);
+    lv_obj_t *scr = lv_obj_create(NULL);
+    lv_obj_t *box = lv_obj_create(scr);
+    lv_obj_set_style_radius(box, 0, 0);
+    lv_obj_set_style_border_width(box, 0, 0);
+    lv_obj_set_style_pad_all(box, 0, 0);
+    lv_obj_set_style_pad_left(box, 4, 0);
+    lv_obj_set_style_pad_top(box, (BAND_H - lh) / 2, 0);
+    lv_obj_set_style_bg_color(box, lv_color_hex(0xFFB74D), 0);
+    lv_obj_clear_flag(box, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_t *l = lv_label_create(box);
+    lv_obj_set_width(l, EXAMPLE_LCD_H_RES - 8);
+    lv_label_set_long_mode(l, LV_LABEL_LONG_WRAP);
+    lv_obj_set_style_text_font(l, font, 0);
+    lv_obj_set_style_text_color(l, lv_color_black(), 0);
+    lv_obj_set_style_text_align(l, LV_TEXT_ALIGN_CENTER, 0);
+    lv_obj_set_style_text_line_space(l, BAND_H - lh, 0);
+    lv_label_set_text(l, TICKER_TEXT);
+    lv_obj_set_size(box, EXAMPLE_LCD_H_RES, 1000);
+    lv_obj_update_layout(box);
+    int lines = (lv_obj_get_height(l) + BAND_H - lh) / BAND_H;
+    lv_obj_set_height(box, lines * BAND_H);
+    lv_obj_update_layout(box);
+    snapshot(box, s_tape, sizeof(s_tape));
+    s_tape_rows = lines * BAND_H;
+    lv_obj_del(scr);
+}
+
+static void ticker_show(void)
+{
+    lv_area_t a;
+    lv_obj_update_layout(s_banner);
+    lv_obj_get_coords(s_banner, &a);
+    LVGL_TickerShow(a.y1, lv_area_get_height(&a), TICKER_TEXT, &lv_font_montserrat_12, lv_color_black(),
+                    lv_color_hex(0xFFB74D));
+    s_band_y = a.y1;
+    s_steps_base = s_lcd.scroll_cmds; // the show ends unscrolled
+}
+
+// Twice through the tape, holding on each line, with LVGL redrawing
+// around the band now and then; then the band moves up and goes away.
+static void run_ticker(void)
+{
+    long step_bytes = 0;
+    long steps = 0;
+    ticker_show();
+    frame(30);
+    check("ticker shown");
+    for (int i = 0; i < 2 * s_tape_rows + 5; i++) {
+        long bytes = s_lcd.pixel_bytes;
+        long before = s_lcd.scroll_cmds;
+        bool redraw = i % 7 == 3;
+        if (redraw) {
+            lv_bar_set_value(s_bar, i % 100, LV_ANIM_OFF);
+        }
+        if (i % 29 == 0) {
+            lv_obj_invalidate(lv_scr_act());
+            redraw = true;
+        }
+        frame(i % BAND_H == 0 ? 2500 : 60);
+        if (s_lcd.scroll_cmds != before + 1) {
+            printf("FAIL ticker step %d: %ld scroll commands\n", i, s_lcd.scroll_cmds - before);
+            s_fail++;
+        } else if (!redraw) {
+            step_bytes += s_lcd.pixel_bytes - bytes;
+            steps++;
+        }
+        check("ticker step");
+    }
+    printf("  %-24s %7.0f pixel bytes/step (the band: %d)\n", "ticker", (double)step_bytes / steps,
+           EXAMPLE_LCD_H_RES * BAND_H * 2);
+
+    lv_obj_align(s_banner, LV_ALIGN_BOTTOM_MID, 0, -BAND_H);
+    ticker_show();
+    frame(30);
+    check("ticker moved");
+    for (int i = 0; i < 40; i++) {
+        frame(i == 0 ? 2500 : 60);
+        check("ticker moved, step");
+    }
+
+    // The banner LVGL drew under the ticker has not changed: its rows must
+    // go out again all the same.
+    LVGL_TickerHide();
+    s_band_y = -1;
+    frame(30);
+    check("ticker hidden");
+    lv_obj_align(s_banner, LV_ALIGN_BOTTOM_MID, 0, 0);
+    frame(30);
+    check("banner back");
+}
+#endif
+
+int main(void)
+{
+    esp_lcd_panel_dev_st7789t_config_t cfg = {
+        .reset_gpio_num = -1,
+        .rgb_endian = LCD_RGB_ENDIAN_BGR,
+        .bits_per_pixel = 16,
+    };
+    esp_lcd_new_panel_st7789t((esp_lcd_panel_io_handle_t)&s_lcd, &cfg, &panel_handle);
+    esp_lcd_panel_reset(panel_handle);
+    esp_lcd_panel_init(panel_handle);
+    esp_lcd_panel_mirror(panel_handle, true, false);
+    LVGL_Init();
+#if LCD_USE_HW_TICKER
+    build_tape();
+#endif
+    build_screens();
+
+    printf("%s:\n", MODE);
+    for (int rgb444 = 0; rgb444 <= 1; rgb444++) {
+        LVGL_SetRgb444(rgb444);
+        lv_obj_invalidate(lv_scr_act());
+        frame(30);
+        if (!rgb444) {
+            // In direct mode, the second time nothing changed to send.
+            check_overlap("full redraw");
+        }
+        check_window("full redraw");
+        check("full redraw");
+        run_countdown(rgb444 ? "countdown, RGB444" : "countdown", 60);
+
+        lv_scr_load(s_other);
+        frame(30);
+        check("other screen");
+        lv_scr_load(s_main);
+        frame(30);
+        check("back");
+#if LCD_USE_HW_TICKER
+        run_ticker();
+#endif
+    }
+
+    printf("%d frames checked: %s\n", s_checks, s_fail ? "FAIL" : "ok");
+    return s_fail != 0;
+}
@@ -0,0 +1,112 @@
+// The hardware-scrolled ticker against a model of the panel's frame memory
+// and vertical scroll: every step writes its row where the step says and
+// moves the scroll start, and after every step the band on screen, rebuilt
+// from frame memory the way the panel scans it out, must be the window of
+// the tape the ticker has reached. Also checks that the writes stay in the
+// band, that hold comes exactly at card boundaries, that
+// lcd_ticker_mem_row() agrees with the scroll start, and the wrap from the
+// last line back to the first, for several band heights and line counts.
+
+#include "lcd_ticker.h"
+
+#include <stdio.h>
+
+#define VER_RES 320
+
+static int s_fail;
+
+// Frame memory, one tape row number per row (-1: outside the band).
+static int s_mem[VER_RES];
+// Vertical scroll area and start, as VSCRDEF/VSCSAD set them.
+static int s_top;
+static int s_height;
+static int s_start;
+
+// The frame memory row the panel shows at screen row y.
+static int shown(int y)
+{
+    if (y < s_top || y >= s_top + s_height) {
+        return y;
+    }
+    return s_top + (s_start - s_top + y - s_top) % s_height;
+}
+
+static void run(int y0, int h, int lines)
+{
+    int tape = lines * h;
+    lcd_ticker_t t;
+    lcd_ticker_init(&t, (int16_t)y0, (int16_t)h, (uint16_t)lines);
+
+    // LVGL_TickerShow: card 0 into the band, scroll start at its top.
+    for (int y = 0; y < VER_RES; y++) {
+        s_mem[y] = y >= y0 && y < y0 + h ? y - y0 : -1;
+    }
+    s_top = y0;
+    s_height = h;
+    s_start = y0;
+
+    int bad = 0;
+    int holds = 0;
+    for (int step = 1; step <= 2 * tape + h + 3 && bad == 0; step++) {
+        lcd_ticker_step_t s = lcd_ticker_step(&t);
+        if (s.mem_y < y0 || s.mem_y >= y0 + h || s.scroll_y < y0 || s.scroll_y >= y0 + h) {
+            printf("FAIL y0 %d h %d lines %d step %d: row %d, scroll %d outside the band\n", y0, h, lines, step,
+                   s.mem_y, s.scroll_y);
+            bad++;
+            break;
+        }
+        if (s.line >= lines || s.line_row < 0 || s.line_row >= h) {
+            printf("FAIL y0 %d h %d lines %d step %d: line %d row %d\n", y0, h, lines, step, s.line, s.line_row);
+            bad++;
+            break;
+        }
+        s_mem[s.mem_y] = s.line * h + s.line_row;
+        s_start = s.scroll_y;
+
+        int pos = step % tape;
+        for (int y = 0; y < VER_RES; y++) {
+            int want = y >= y0 && y < y0 + h ? (pos + y - y0) % tape : -1;
+            if (s_mem[shown(y)] != want) {
+                printf("FAIL y0 %d h %d lines %d step %d: screen row %d shows tape row %d, want %d\n", y0, h, lines,
+                       step, y, s_mem[shown(y)], want);
+                bad++;
+                break;
+            }
+            if (want >= 0 && lcd_ticker_mem_row(&t, (int16_t)y) != shown(y)) {
+                printf("FAIL y0 %d h %d lines %d step %d: mem_row(%d) %d, panel shows %d\n", y0, h, lines, step, y,
+                       lcd_ticker_mem_row(&t, (int16_t)y), shown(y));
+                bad++;
+                break;
+            }
+        }
+        if (s.hold != (step % h == 0)) {
+            printf("FAIL y0 %d h %d lines %d step %d: hold %d\n", y0, h, lines, step, s.hold);
+            bad++;
+        }
+        holds += s.hold;
+        if (t.pos != (uint32_t)pos) {
+            printf("FAIL y0 %d h %d lines %d step %d: pos %u, want %d\n", y0, h, lines, step, (unsigned)t.pos, pos);
+            bad++;
+        }
+    }
+    if (bad == 0 && holds != (2 * tape + h + 3) / h) {
+        printf("FAIL y0 %d h %d lines %d: %d holds\n", y0, h, lines, holds);
+        bad++;
+    }
+    s_fail += bad;
+}
+
+int main(void)
+{
+    static const int bands[][2] = {{302, 18}, {284, 18}, {0, 24}, {150, 1}, {100, 2}, {0, VER_RES}};
+    static const int lines[] = {1, 2, 3, 7};
+    int runs = 0;
+    for (size_t b = 0; b < sizeof(bands) / sizeof(bands[0]); b++) {
+        for (size_t l = 0; l < sizeof(lines) / sizeof(lines[0]); l++) {
+            run(bands[b][0], bands[b][1], lines[l]);
+            runs++;
+        }
+    }
+    printf("%d bands x lines: %s\n", runs, s_fail ? "FAIL" : "ok");
+    return s_fail != 0;
+}
@@ -0,0 +1,246 @@
+// Dirty-tile diffing against a mock panel: random edits to a 172x320
+// framebuffer, the areas around them marked the way LVGL invalidates (often
+// much larger than what changed, sometimes redrawn with the same pixels,
+// sometimes off the screen), then a flush whose spans are copied to the
+// panel. After every flush the panel must equal the framebuffer, every span
+// must be tile-aligned, on screen and made of changed tiles only, and the
+// returned count must match the spans. Also checks that a forgotten area
+// goes out again unchanged, including the clipped tiles at the right and
+// bottom edges.
+//
+// With -b, also the flush time and the pixels sent for typical UI redraws,
+// against sending the marked areas as LVGL does without the tiles.
+
+#include "lcd_tiles.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define HOR_RES 172
+#define VER_RES 320
+#define COLS    LCD_TILES_COLS(HOR_RES)
+#define ROWS    LCD_TILES_ROWS(VER_RES)
+
+static int s_fail;
+
+static uint16_t s_fb[HOR_RES * VER_RES];
+static uint16_t s_panel[HOR_RES * VER_RES];
+static uint32_t s_hash[COLS * ROWS];
+static uint8_t s_marked[COLS * ROWS];
+static lcd_tiles_t s_tiles;
+
+static uint32_t s_seed = 1;
+
+static int rnd(int n)
+{
+    s_seed = s_seed * 1103515245u + 12345u;
+    return (int)((s_seed >> 8) % (uint32_t)n);
+}
+
+typedef struct {
+    int spans;
+    uint32_t px;
+    int bad;
+    bool check; // spans must hold changed tiles only
+} flush_ctx_t;
+
+// A tile whose pixels differ between the panel and the framebuffer.
+static bool tile_differs(int c, int r)
+{
+    for (int y = r * LCD_TILE_H; y < (r + 1) * LCD_TILE_H && y < VER_RES; y++) {
+        for (int x = c * LCD_TILE_W; x < (c + 1) * LCD_TILE_W && x < HOR_RES; x++) {
+            if (s_panel[y * HOR_RES + x] != s_fb[y * HOR_RES + x]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// The mock panel: a draw_bitmap of the span straight from the framebuffer.
+static void on_span(const lcd_span_t *sp, void *arg)
+{
+    flush_ctx_t *ctx = (flush_ctx_t *)arg;
+    ctx->spans++;
+    ctx->px += (uint32_t)(sp->x2 - sp->x1 + 1) * (uint32_t)(sp->y2 - sp->y1 + 1);
+
+    bool aligned = sp->x1 % LCD_TILE_W == 0 && sp->y1 % LCD_TILE_H == 0 && sp->y1 / LCD_TILE_H == sp->y2 / LCD_TILE_H &&
+                   ((sp->x2 + 1) % LCD_TILE_W == 0 || sp->x2 == HOR_RES - 1) &&
+                   ((sp->y2 + 1) % LCD_TILE_H == 0 || sp->y2 == VER_RES - 1);
+    if (!aligned || sp->x1 < 0 || sp->y1 < 0 || sp->x2 >= HOR_RES || sp->y2 >= VER_RES || sp->x1 > sp->x2) {
+        printf("FAIL span %d,%d-%d,%d\n", sp->x1, sp->y1, sp->x2, sp->y2);
+        ctx->bad++;
+        return;
+    }
+    for (int c = sp->x1 / LCD_TILE_W; ctx->check && c <= sp->x2 / LCD_TILE_W; c++) {
+        if (!tile_differs(c, sp->y1 / LCD_TILE_H)) {
+            printf("FAIL unchanged tile %d,%d sent\n", c, sp->y1 / LCD_TILE_H);
+            ctx->bad++;
+        }
+    }
+    for (int y = sp->y1; y <= sp->y2; y++) {
+        memcpy(&s_panel[y * HOR_RES + sp->x1], &s_fb[y * HOR_RES + sp->x1], (size_t)(sp->x2 - sp->x1 + 1) * 2);
+    }
+}
+
+static flush_ctx_t flush(const char *what, bool check)
+{
+    flush_ctx_t ctx = {.check = check};
+    uint32_t px = lcd_tiles_flush(&s_tiles, s_fb, on_span, &ctx);
+    if (px != ctx.px) {
+        printf("FAIL %s: flush returned %u pixels, spans hold %u\n", what, (unsigned)px, (unsigned)ctx.px);
+        ctx.bad++;
+    }
+    if (memcmp(s_panel, s_fb, sizeof(s_fb)) != 0) {
+        printf("FAIL %s: panel differs from the framebuffer\n", what);
+        ctx.bad++;
+    }
+    s_fail += ctx.bad;
+    return ctx;
+}
+
+static void fill(int x1, int y1, int x2, int y2, uint16_t color)
+{
+    for (int y = y1 < 0 ? 0 : y1; y <= y2 && y < VER_RES; y++) {
+        for (int x = x1 < 0 ? 0 : x1; x <= x2 && x < HOR_RES; x++) {
+            s_fb[y * HOR_RES + x] = color;
+        }
+    }
+}
+
+static void check_random_edits(void)
+{
+    int spans = 0;
+    for (int frame = 0; frame < 3000; frame++) {
+        int edits = 1 + rnd(4);
+        for (int e = 0; e < edits; e++) {
+            int x1 = rnd(HOR_RES + 40) - 20;
+            int y1 = rnd(VER_RES + 40) - 20;
+            int x2 = x1 + rnd(80);
+            int y2 = y1 + rnd(60);
+            int kind = rnd(4);
+            if (kind == 0) {
+                // Redrawn with what is already there.
+            } else if (kind == 1) {
+                // One pixel changed inside a large redraw.
+                int x = x1 + rnd(x2 - x1 + 1);
+                int y = y1 + rnd(y2 - y1 + 1);
+                fill(x, y, x, y, (uint16_t)rnd(0x10000));
+            } else {
+                fill(x1, y1, x2, y2, (uint16_t)rnd(0x10000));
+            }
+            lcd_tiles_mark(&s_tiles, (int16_t)x1, (int16_t)y1, (int16_t)x2, (int16_t)y2);
+        }
+        spans += flush("random edits", true).spans;
+        if (s_fail) {
+            printf("  at frame %d\n", frame);
+            return;
+        }
+    }
+    printf("3000 frames of random edits: %d spans\n", spans);
+}
+
+static void check_forget(void)
+{
+    // The same pixels, marked again: nothing goes out.
+    lcd_tiles_mark(&s_tiles, 0, 0, HOR_RES - 1, VER_RES - 1);
+    flush_ctx_t ctx = flush("remark", true);
+    if (ctx.spans != 0) {
+        printf("FAIL unchanged frame sent %d spans\n", ctx.spans);
+        s_fail++;
+    }
+
+    // The panel lost the bottom-right corner (another writer drew there):
+    // forgotten tiles go out again when marked, even though the
+    // framebuffer did not change, and only those.
+    fill(150, 300, HOR_RES - 1, VER_RES - 1, 0);
+    memcpy(s_panel, s_fb, sizeof(s_fb));
+    lcd_tiles_mark(&s_tiles, 150, 300, HOR_RES - 1, VER_RES - 1);
+    flush("corner", false);
+    for (int y = 300; y < VER_RES; y++) {
+        memset(&s_panel[y * HOR_RES + 150], 0xFF, (HOR_RES - 150) * 2);
+    }
+    lcd_tiles_forget(&s_tiles, 150, 300, 400, 400);
+    lcd_tiles_mark(&s_tiles, -10, -10, 400, 400);
+    ctx = flush("forgotten corner", false);
+    // Columns 9-10 (x 144-171, the last one 12 wide) of rows 18-19.
+    uint32_t want = (uint32_t)(HOR_RES - 9 * LCD_TILE_W) * 2 * LCD_TILE_H;
+    if (ctx.spans != 2 || ctx.px != want) {
+        printf("FAIL forgotten corner: %d spans, %u pixels, want 2 and %u\n", ctx.spans, (unsigned)ctx.px,
+               (unsigned)want);
+        s_fail++;
+    }
+
+    // Entirely off the screen: nothing marked, nothing forgotten.
+    lcd_tiles_mark(&s_tiles, HOR_RES, 0, HOR_RES + 10, 10);
+    lcd_tiles_mark(&s_tiles, -20, -20, -1, -1);
+    lcd_tiles_forget(&s_tiles, 0, VER_RES, 10, VER_RES + 10);
+    lcd_tiles_mark(&s_tiles, 0, VER_RES - 1, 10, VER_RES + 10);
+    ctx = flush("off screen", true);
+    if (ctx.spans != 0) {
+        printf("FAIL off-screen areas sent %d spans\n", ctx.spans);
+        s_fail++;
+    }
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// The redraws a countdown screen does: LVGL's area, and what changes in it.
+static void bench_case(const char *what, int x1, int y1, int x2, int y2, int cx1, int cy1, int cx2, int cy2)
+{
+    const int frames = 2000;
+    uint32_t sent = 0;
+    double t = 0;
+    for (int f = 0; f < frames; f++) {
+        fill(cx1, cy1, cx2, cy2, (uint16_t)(f * 2654435761u >> 16));
+        lcd_tiles_mark(&s_tiles, (int16_t)x1, (int16_t)y1, (int16_t)x2, (int16_t)y2);
+        flush_ctx_t ctx = {0};
+        double a = now_ns();
+        sent += lcd_tiles_flush(&s_tiles, s_fb, on_span, &ctx);
+        t += now_ns() - a;
+    }
+    int marked = (x2 - x1 + 1) * (y2 - y1 + 1);
+    printf("%-22s %6.1f us/flush, %6u px sent (LVGL's area %6d, full frame %d)\n", what, t / frames / 1000,
+           (unsigned)(sent / frames), marked, HOR_RES * VER_RES);
+}
+
+static void bench(void)
+{
+    bench_case("minutes digit", 20, 120, 151, 167, 60, 126, 87, 161);
+    bench_case("clock label", 40, 8, 131, 31, 110, 10, 121, 29);
+    bench_case("progress bar 1 px", 10, 200, 161, 207, 90, 201, 90, 206);
+    bench_case("full screen, 1 digit", 0, 0, HOR_RES - 1, VER_RES - 1, 60, 126, 87, 161);
+    bench_case("full screen, all", 0, 0, HOR_RES - 1, VER_RES - 1, 0, 0, HOR_RES - 1, VER_RES - 1);
+}
+
+int main(int argc, char **argv)
+{
+    lcd_tiles_init(&s_tiles, HOR_RES, VER_RES, s_hash, s_marked);
+    if (s_tiles.cols != 11 || s_tiles.rows != 20) {
+        printf("FAIL %dx%d tiles\n", s_tiles.cols, s_tiles.rows);
+        return 1;
+    }
+
+    // Nothing has been sent yet: the first frame goes out whole.
+    memset(s_panel, 0xA5, sizeof(s_panel));
+    lcd_tiles_mark(&s_tiles, 0, 0, HOR_RES - 1, VER_RES - 1);
+    flush_ctx_t ctx = flush("first frame", false);
+    if (ctx.px != HOR_RES * VER_RES || ctx.spans != s_tiles.rows) {
+        printf("FAIL first frame: %d spans, %u pixels\n", ctx.spans, (unsigned)ctx.px);
+        s_fail++;
+    }
+
+    check_random_edits();
+    check_forget();
+    if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+        bench();
+    }
+    printf("%s\n", s_fail ? "FAIL" : "ok");
+    return s_fail != 0;
+}
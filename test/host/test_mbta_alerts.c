@@ -0,0 +1,152 @@
+// The alerts fetch against a stand-in server that honours If-Modified-Since
+// and sends its body in 13-byte pieces. The state must change only when
+// the set of alerts (ids and updated_at) does: not on a 304, not on a new
+// Last-Modified with the same alerts in another order, not on a failure.
+
+#include "mbta_alerts.c"
+
+#include <stdio.h>
+
+static int s_fail;
+
+// Fakes for what mbta_alerts.c calls outside fetch_alerts().
+bool MBTA_GetState(mbta_state_t *out_state) { (void)out_state; return false; }
+wireless_status_t Wireless_GetStatus(void) { return WIRELESS_STATUS_CONNECTED; }
+bool TimeSync_IsSynced(void) { return true; }
+void UiNotify_Signal(void) {}
+void vTaskDelay(TickType_t ticks) { (void)ticks; }
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void *), const char *name, uint32_t stack, void *arg,
+                                   int prio, TaskHandle_t *out_handle, int core)
+{
+    (void)fn; (void)name; (void)stack; (void)arg; (void)prio; (void)out_handle; (void)core;
+    return pdPASS;
+}
+
+// The stand-in server: one body and its Last-Modified.
+static struct {
+    const char *body;
+    const char *last_modified;
+    esp_err_t err;
+    int requests;
+    int bodies;
+} s_server;
+
+esp_err_t NetService_Get(const http_conn_request_t *req, net_prio_t prio, uint32_t deadline_ms,
+                         int *out_http_status)
+{
+    (void)deadline_ms;
+    s_server.requests++;
+    if (prio != NET_PRIO_LOW) {
+        printf("FAIL alerts asked for priority %d\n", (int)prio);
+        s_fail++;
+    }
+    if (strcmp(req->url, s_alerts_url) != 0) {
+        printf("FAIL request for %s\n", req->url);
+        s_fail++;
+    }
+    if (s_server.err != ESP_OK) {
+        *out_http_status = 0;
+        return s_server.err;
+    }
+
+    char ims[80];
+    snprintf(ims, sizeof(ims), "If-Modified-Since: %s\r\n", s_server.last_modified);
+    if (req->extra_headers != NULL && strcmp(req->extra_headers, ims) == 0) {
+        *out_http_status = 304;
+        return ESP_OK;
+    }
+
+    *out_http_status = 200;
+    req->on_header("last-modified", s_server.last_modified, req->ctx);
+    s_server.bodies++;
+    size_t len = strlen(s_server.body);
+    for (size_t off = 0; off < len; off += 13) {
+        if (!req->on_body(s_server.body + off, len - off < 13 ? len - off : 13, req->ctx)) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+    return ESP_OK;
+}
+
+#define ALERT(id, sev, header, updated)                                                                  \
+    "{\"attributes\":{\"active_period\":[{\"end\":null,\"start\":\"2026-10-16T05:00:00-04:00\"}],"      \
+    "\"severity\":" #sev ",\"short_header\":\"" header "\",\"updated_at\":\"" updated "\"},"            \
+    "\"id\":\"" id "\",\"type\":\"alert\"}"
+
+#define DETOUR      ALERT("100", 3, "Route 65 detour", "2026-10-16T08:00:00-04:00")
+#define DETOUR_LATER ALERT("100", 3, "Route 65 detour", "2026-10-16T09:00:00-04:00")
+#define CLOSED      ALERT("200", 7, "Stop 1295 closed", "2026-10-16T07:00:00-04:00")
+
+static char s_last_modified[40];
+static mbta_alerts_state_t s_cur;
+
+static void step(const char *what, const char *body, const char *last_modified, bool want_ok,
+                 bool want_changed, bool want_body, int want_count, const char *want_header)
+{
+    s_server.body = body;
+    s_server.last_modified = last_modified;
+    int bodies = s_server.bodies;
+
+    mbta_alerts_state_t next;
+    bool changed = false;
+    bool ok = fetch_alerts(s_last_modified, sizeof(s_last_modified), &s_cur, &next, &changed);
+    if (changed) {
+        uint32_t version = s_cur.version;
+        s_cur = next;
+        s_cur.version = version + 1;
+    }
+
+    bool sent = s_server.bodies != bodies;
+    if (ok != want_ok || changed != want_changed || sent != want_body || s_cur.count != want_count ||
+        strcmp(s_cur.header, want_header) != 0) {
+        printf("FAIL %s: ok=%d changed=%d body=%d count=%d header '%s'\n", what, ok, changed, sent,
+               s_cur.count, s_cur.header);
+        s_fail++;
+    }
+}
+
+int main(void)
+{
+    strlcpy(s_alerts_url, "https://api-v3.mbta.com/alerts?filter[stop]=1295", sizeof(s_alerts_url));
+
+    step("first fetch", "{\"data\":[" DETOUR "," CLOSED "]}", "Fri, 16 Oct 2026 12:00:00 GMT",
+         true, true, true, 2, "Stop 1295 closed");
+    uint32_t fingerprint = s_cur.fingerprint;
+    step("304", "{\"data\":[" DETOUR "," CLOSED "]}", "Fri, 16 Oct 2026 12:00:00 GMT",
+         true, false, false, 2, "Stop 1295 closed");
+    step("same alerts, reordered", "{\"data\":[" CLOSED "," DETOUR "]}", "Fri, 16 Oct 2026 12:05:00 GMT",
+         true, false, true, 2, "Stop 1295 closed");
+    if (s_cur.fingerprint != fingerprint) {
+        printf("FAIL fingerprint depends on order\n");
+        s_fail++;
+    }
+    step("updated_at moved", "{\"data\":[" CLOSED "," DETOUR_LATER "]}", "Fri, 16 Oct 2026 12:10:00 GMT",
+         true, true, true, 2, "Stop 1295 closed");
+
+    // A failure keeps what is shown and drops the validator.
+    s_server.err = ESP_ERR_TIMEOUT;
+    step("timeout", "", "Fri, 16 Oct 2026 12:10:00 GMT", false, false, false, 2, "Stop 1295 closed");
+    s_server.err = ESP_OK;
+    if (s_last_modified[0] != '\0') {
+        printf("FAIL Last-Modified kept after a failure\n");
+        s_fail++;
+    }
+    step("after timeout", "{\"data\":[" CLOSED "," DETOUR_LATER "]}", "Fri, 16 Oct 2026 12:10:00 GMT",
+         true, false, true, 2, "Stop 1295 closed");
+    step("truncated", "{\"data\":[{\"id\":", "Fri, 16 Oct 2026 12:15:00 GMT",
+         false, false, true, 2, "Stop 1295 closed");
+    step("no data", "{\"errors\":[]}", "Fri, 16 Oct 2026 12:15:00 GMT",
+         false, false, true, 2, "Stop 1295 closed");
+
+    step("cleared", "{\"data\":[]}", "Fri, 16 Oct 2026 12:20:00 GMT", true, true, true, 0, "");
+    if (s_cur.fingerprint != 0 || !s_cur.has_data) {
+        printf("FAIL cleared state: fingerprint %08x has_data %d\n", (unsigned)s_cur.fingerprint, s_cur.has_data);
+        s_fail++;
+    }
+    step("still clear", "{\"data\":[]}", "Fri, 16 Oct 2026 12:25:00 GMT", true, false, true, 0, "");
+    step("back", "{\"data\":[" DETOUR "]}", "Fri, 16 Oct 2026 12:30:00 GMT", true, true, true, 1, "Route 65 detour");
+
+    printf("%d requests, %d bodies, state version %u: %s\n", s_server.requests, s_server.bodies,
+           (unsigned)s_cur.version, s_fail ? "FAIL" : "ok");
+    return s_fail != 0;
+}
@@ -0,0 +1,106 @@
+// The countdown against a fixed snapshot while the clock moves: one state
+// (arrivals as absolute epochs), then the clock, a second at a time for 12
+// minutes and then in jumps. At every step the minutes on screen must be those of
+// the stored epochs at that time, rounded up, with the departed arrivals
+// dropped; and the screen must be re-rendered exactly when one of them
+// changed, or when a new state was published, never in between.
+
+#include "mbta.h"
+
+#include <stdio.h>
+
+static int s_fail;
+
+static const time_t s_epoch0 = 1792152000; // 2026-10-16 12:00:00 UTC
+
+// What the screen should show, worked out from the epochs alone: whole
+// minutes rounded up, "due" (0) until two minutes past, then gone.
+static int expected(const mbta_state_t *st, time_t now, int *out)
+{
+    int n = 0;
+    for (int i = 0; i < st->arrival_count && n < 3; i++) {
+        long delta = (long)(st->arrivals_epoch[i] - now);
+        if (delta > 0) {
+            out[n++] = (int)((delta + 59) / 60);
+        } else if (delta > -119) {
+            out[n++] = 0;
+        }
+    }
+    return n;
+}
+
+static int s_renders;
+
+static void step(mbta_countdown_t *shown, const mbta_state_t *st, time_t now, const char *what)
+{
+    mbta_countdown_t before = *shown;
+    bool render = MBTA_CountdownUpdate(shown, st, now);
+    s_renders += render;
+
+    int want[3] = {0};
+    int n = expected(st, now, want);
+    bool changed = n != before.count || memcmp(want, before.minutes, sizeof(want)) != 0 ||
+                   st->version != before.version;
+    if (shown->count != n || memcmp(shown->minutes, want, sizeof(want)) != 0 || render != changed) {
+        printf("FAIL %s at +%llds: %d arrivals %d/%d/%d (want %d: %d/%d/%d), render=%d (want %d)\n", what,
+               (long long)(now - s_epoch0), shown->count, shown->minutes[0], shown->minutes[1], shown->minutes[2],
+               n, want[0], want[1], want[2], render, changed);
+        s_fail++;
+    }
+}
+
+int main(void)
+{
+    mbta_state_t st = {0};
+    st.version = 7;
+    st.has_data = true;
+    st.arrival_count = 3;
+    st.arrivals_epoch[0] = s_epoch0 + 95;        // 2 min
+    st.arrivals_epoch[1] = s_epoch0 + 10 * 60;   // exactly 10 min
+    st.arrivals_epoch[2] = s_epoch0 + 20 * 60 + 34;
+
+    mbta_countdown_t shown = {.count = -1};
+    step(&shown, &st, s_epoch0, "first");
+    if (s_renders != 1) {
+        printf("FAIL nothing rendered at first\n");
+        s_fail++;
+    }
+
+    // A second at a time: never twice for the same minutes.
+    int renders = s_renders;
+    int changes = 0;
+    int prev[3] = {0};
+    int prev_n = expected(&st, s_epoch0, prev);
+    for (time_t now = s_epoch0; now <= s_epoch0 + 12 * 60; now++) {
+        step(&shown, &st, now, "tick");
+        step(&shown, &st, now, "same second");
+        int cur[3] = {0};
+        int n = expected(&st, now, cur);
+        changes += n != prev_n || memcmp(cur, prev, sizeof(cur)) != 0;
+        prev_n = n;
+        memcpy(prev, cur, sizeof(cur));
+    }
+    if (s_renders - renders != changes) {
+        printf("FAIL %d renders for %d minute changes\n", s_renders - renders, changes);
+        s_fail++;
+    }
+    printf("12 min at 1 s: %d renders\n", s_renders - renders);
+
+    // The UI loop can sleep through several minutes: one render on waking.
+    step(&shown, &st, s_epoch0 + 18 * 60, "jump");
+
+    // A new publish re-renders even with the same minutes.
+    st.version++;
+    step(&shown, &st, s_epoch0 + 18 * 60, "new version");
+    step(&shown, &st, s_epoch0 + 18 * 60 + 20, "after new version");
+
+    // Everything departed.
+    step(&shown, &st, s_epoch0 + 40 * 60, "all gone");
+    if (shown.count != 0) {
+        printf("FAIL %d arrivals left after all departed\n", shown.count);
+        s_fail++;
+    }
+
+    printf("%s\n", s_fail ? "FAIL" : "ok");
+    return s_fail != 0;
+}
@@ -0,0 +1,274 @@
+// The predictions fetch against a stand-in server that honours
+// If-Modified-Since, its data changing on every other poll, so the
+// answers alternate 200 and 304. Each poll goes through the task's path:
+// mbta_run_job(), then the stops filled and the state published. A 304
+// must leave the parser untouched (no body, nothing fed) and the arrivals
+// as the last 200 left them, and must not bump the state version; a 200
+// bumps it only when the arrivals changed. A failure drops the validator,
+// so the next poll is unconditional. Also checks that a loader-only change
+// wakes the UI without a new version.
+
+#include <stdio.h>
+#include <time.h>
+
+// mbta.c reads the wall clock through time(); the test owns it.
+static time_t test_time(time_t *out);
+#define time(out) test_time(out)
+
+#include "mbta.c"
+
+static int s_fail;
+
+static const time_t s_epoch0 = 1792152000; // 2026-10-16 12:00:00 UTC
+static int64_t s_now_us;
+
+static time_t test_time(time_t *out)
+{
+    time_t t = s_epoch0 + (time_t)(s_now_us / 1000000);
+    if (out != NULL) {
+        *out = t;
+    }
+    return t;
+}
+
+// Fakes for what mbta.c calls.
+int64_t esp_timer_get_time(void) { return s_now_us; }
+uint32_t esp_random(void) { return 0; }
+wireless_status_t Wireless_GetStatus(void) { return WIRELESS_STATUS_CONNECTED; }
+bool TimeSync_Wait(uint32_t timeout_ms) { (void)timeout_ms; return true; }
+bool Snapshot_Load(snapshot_id_t id, void *buf, size_t size) { (void)id; (void)buf; (void)size; return false; }
+void Snapshot_Save(snapshot_id_t id, const void *buf, size_t size) { (void)id; (void)buf; (void)size; }
+void vTaskDelay(TickType_t ticks) { (void)ticks; }
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void *), const char *name, uint32_t stack, void *arg,
+                                   int prio, TaskHandle_t *out_handle, int core)
+{
+    (void)fn; (void)name; (void)stack; (void)arg; (void)prio; (void)out_handle; (void)core;
+    return pdPASS;
+}
+
+static int s_signals;
+void UiNotify_Signal(void) { s_signals++; }
+
+// The stand-in server: per stop, the arrivals (minutes from the first
+// poll) and the Last-Modified of the last change.
+static struct {
+    int minutes[MBTA_STOP_COUNT][3];
+    char last_modified[MBTA_STOP_COUNT][40];
+    esp_err_t err;
+    int requests;
+    int bodies;
+    bool conditional; // last request carried If-Modified-Since
+    prediction_parser_t *parser;
+} s_server;
+
+static void server_change(int stop, int shift, int second)
+{
+    for (int k = 0; k < 3; k++) {
+        s_server.minutes[stop][k] += shift;
+    }
+    snprintf(s_server.last_modified[stop], sizeof(s_server.last_modified[stop]),
+             "Fri, 16 Oct 2026 12:%02d:%02d GMT", second / 60, second % 60);
+}
+
+static int stop_of(const char *url)
+{
+    for (int i = 0; i < MBTA_STOP_COUNT; i++) {
+        char filter[48];
+        snprintf(filter, sizeof(filter), "filter[stop]=%s&", s_stops[i].stop_id);
+        if (strstr(url, filter) != NULL) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+esp_err_t NetService_Get(const http_conn_request_t *req, net_prio_t prio, uint32_t deadline_ms,
+                         int *out_http_status)
+{
+    (void)deadline_ms;
+    s_server.requests++;
+    s_server.parser = (prediction_parser_t *)req->ctx;
+    *out_http_status = 0;
+    int stop = stop_of(req->url);
+    if (stop < 0 || prio != NET_PRIO_HIGH) {
+        printf("FAIL request for %s at priority %d\n", req->url, (int)prio);
+        s_fail++;
+        return ESP_FAIL;
+    }
+    s_server.conditional = req->extra_headers != NULL && req->extra_headers[0] != '\0';
+    if (s_server.err != ESP_OK) {
+        return s_server.err;
+    }
+
+    char ims[80];
+    snprintf(ims, sizeof(ims), "If-Modified-Since: %s\r\n", s_server.last_modified[stop]);
+    if (s_server.conditional && strcmp(req->extra_headers, ims) == 0) {
+        *out_http_status = 304;
+        return ESP_OK;
+    }
+
+    char body[1024];
+    size_t len = (size_t)snprintf(body, sizeof(body), "{\"data\":[");
+    for (int k = 0; k < 3; k++) {
+        time_t at = s_epoch0 + s_server.minutes[stop][k] * 60;
+        struct tm tm;
+        char iso[32];
+        gmtime_r(&at, &tm);
+        strftime(iso, sizeof(iso), "%Y-%m-%dT%H:%M:%SZ", &tm);
+        len += (size_t)snprintf(body + len, sizeof(body) - len,
+                                "%s{\"attributes\":{\"arrival_time\":\"%s\",\"departure_time\":null},"
+                                "\"id\":\"p-%d-%d\",\"relationships\":{\"stop\":{\"data\":{\"id\":\"%s\","
+                                "\"type\":\"stop\"}}},\"type\":\"prediction\"}",
+                                k ? "," : "", iso, stop, k, s_stops[stop].stop_id);
+    }
+    len += (size_t)snprintf(body + len, sizeof(body) - len, "],\"included\":[]}");
+
+    *out_http_status = 200;
+    req->on_header("Last-Modified", s_server.last_modified[stop], req->ctx);
+    s_server.bodies++;
+    for (size_t off = 0; off < len; off += 100) {
+        if (!req->on_body(body + off, len - off < 100 ? len - off : 100, req->ctx)) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+    }
+    return ESP_OK;
+}
+
+// One pass of mbta_task for `job`.
+static bool poll_job(int job)
+{
+    mbta_state_set_fetching(true);
+    bool ok = mbta_run_job(job);
+    mbta_state_t next = {0};
+    strlcpy(next.title, s_stops[0].name, sizeof(next.title));
+    mbta_state_fill_stops(&next);
+    next.is_fetching = false;
+    mbta_state_set(&next);
+    return ok;
+}
+
+static void step(const char *what, int job, bool want_ok, int want_status, bool want_conditional,
+                 bool want_bump)
+{
+    mbta_state_t before;
+    MBTA_GetState(&before);
+    int bodies = s_server.bodies;
+    uint32_t not_modified = s_fetch_stats.not_modified;
+
+    bool ok = poll_job(job);
+    s_now_us += 30 * 1000000LL;
+
+    mbta_state_t after;
+    MBTA_GetState(&after);
+    bool got_body = s_server.bodies != bodies;
+    bool was_304 = s_fetch_stats.not_modified != not_modified;
+    bool bumped = after.version != before.version;
+    bool bad = ok != want_ok || got_body != (want_status == 200) || was_304 != (want_status == 304) ||
+               s_server.conditional != want_conditional || bumped != want_bump;
+    if (was_304) {
+        // Nothing fed to the parser, and the arrivals are the last 200's.
+        const prediction_parser_t *p = s_server.parser;
+        if (p->body_bytes != 0 || p->saw_data || json_stream_offset(&p->js) != 0 ||
+            memcmp(before.stops[job].arrivals_epoch, after.stops[job].arrivals_epoch,
+                   sizeof(after.stops[job].arrivals_epoch)) != 0) {
+            printf("FAIL %s: the 304 was parsed or changed the arrivals\n", what);
+            bad = true;
+        }
+    }
+    if (want_ok && after.stops[job].arrival_count == 3) {
+        for (int k = 0; k < 3; k++) {
+            if (after.stops[job].arrivals_epoch[k] != s_epoch0 + s_server.minutes[job][k] * 60) {
+                printf("FAIL %s: arrival %d at %lld, server says %lld\n", what, k,
+                       (long long)after.stops[job].arrivals_epoch[k],
+                       (long long)(s_epoch0 + s_server.minutes[job][k] * 60));
+                bad = true;
+            }
+        }
+    } else if (want_ok) {
+        printf("FAIL %s: %d arrivals\n", what, after.stops[job].arrival_count);
+        bad = true;
+    }
+    if (bad) {
+        printf("FAIL %s: ok=%d body=%d 304=%d conditional=%d version %u -> %u\n", what, ok, got_body, was_304,
+               s_server.conditional, (unsigned)before.version, (unsigned)after.version);
+        s_fail++;
+    }
+}
+
+// The loader (is_fetching, refresh_ms) changing alone wakes the UI without
+// a new version; an identical publish does neither.
+static void check_loader_only(void)
+{
+    mbta_state_t st;
+    MBTA_GetState(&st);
+    static const struct {
+        const char *what;
+        bool is_fetching;
+        uint32_t refresh_ms;
+        bool want_signal;
+    } steps[] = {
+        {"fetching", true, 0, true},
+        {"fetched", false, 0, true},
+        {"new interval", false, 90000, true},
+        {"identical", false, 90000, false},
+    };
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        mbta_state_t next = st;
+        next.is_fetching = steps[i].is_fetching;
+        next.refresh_ms = steps[i].refresh_ms;
+        int signals = s_signals;
+        mbta_state_set(&next);
+        mbta_state_t after;
+        MBTA_GetState(&after);
+        if ((s_signals != signals) != steps[i].want_signal || after.version != st.version) {
+            printf("FAIL %s: %d signals, version %u -> %u\n", steps[i].what, s_signals - signals,
+                   (unsigned)st.version, (unsigned)after.version);
+            s_fail++;
+        }
+    }
+}
+
+int main(void)
+{
+    MBTA_TaskStart();
+    for (int i = 0; i < MBTA_STOP_COUNT; i++) {
+        for (int k = 0; k < 3; k++) {
+            s_server.minutes[i][k] = 30 + 7 * k + i;
+        }
+        server_change(i, 0, 0);
+    }
+
+    step("first poll", 0, true, 200, false, true);
+    step("other stop", 1, true, 200, false, true);
+
+    // Alternating: a change (200), then nothing new (304).
+    int second = 0;
+    for (int round = 0; round < 6; round++) {
+        server_change(0, 1, ++second);
+        step("changed", 0, true, 200, true, true);
+        step("unchanged", 0, true, 304, true, false);
+        step("other stop unchanged", 1, true, 304, true, false);
+    }
+
+    // New Last-Modified, same arrivals: parsed, but nothing to re-render.
+    server_change(0, 0, ++second);
+    step("touched", 0, true, 200, true, false);
+    step("after touched", 0, true, 304, true, false);
+
+    // A failure drops the validator (and shows the stop as without data);
+    // the next poll is unconditional.
+    s_server.err = ESP_ERR_TIMEOUT;
+    step("timeout", 0, false, 0, true, true);
+    s_server.err = ESP_OK;
+    step("after timeout", 0, true, 200, false, true);
+    step("304 again", 0, true, 304, true, false);
+
+    check_loader_only();
+
+    mbta_state_t st;
+    MBTA_GetState(&st);
+    printf("%d requests, %u answered 304 (~%u bytes saved), %d bodies, state version %u: %s\n", s_server.requests,
+           (unsigned)s_fetch_stats.not_modified, (unsigned)s_fetch_stats.bytes_saved, s_server.bodies,
+           (unsigned)st.version, s_fail ? "FAIL" : "ok");
+    return s_fail != 0;
+}
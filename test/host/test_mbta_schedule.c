@@ -0,0 +1,188 @@
+// The schedule image: a service day in the shape of the real ones (a
+// frequent bus both ways, a light-rail stop on two branches, a sparse
+// commuter-rail stop with a five-hour gap, trips past midnight) is encoded,
+// then every lookup (stop x minute x count) is checked against a plain
+// sorted list. Also reports the image size against the raw minutes.
+
+#include "mbta_schedule.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_STOPS 4 // the last one has no departures
+
+static int s_fail;
+
+// Every departure per stop, ascending. The same minute on two series is
+// two departures; within one series it is one.
+static uint16_t s_ref[TEST_STOPS][MBTA_SCHEDULE_MAX_DEPARTURES];
+static int s_ref_count[TEST_STOPS];
+static int s_departures;
+
+static mbta_schedule_builder_t s_builder;
+
+static void add(int stop, const char *route, int direction, int minute)
+{
+    // A repeat within its series is ignored by the encoder.
+    bool repeat = false;
+    for (int s = 0; s < s_builder.series_count && !repeat; s++) {
+        const mbta_schedule_series_t *ser = &s_builder.series[s];
+        if (ser->stop != stop || ser->direction != direction || strcmp(ser->route, route) != 0) {
+            continue;
+        }
+        for (int d = 0; d < s_builder.dep_count; d++) {
+            repeat |= s_builder.deps[d].series == s && s_builder.deps[d].minute == minute;
+        }
+    }
+    if (!mbta_schedule_builder_add(&s_builder, stop, route, direction, (uint16_t)minute)) {
+        printf("FAIL builder full at %d departures\n", s_builder.dep_count);
+        s_fail++;
+        return;
+    }
+    if (repeat) {
+        return;
+    }
+    uint16_t *ref = s_ref[stop];
+    int n = s_ref_count[stop]++;
+    while (n > 0 && ref[n - 1] > minute) {
+        ref[n] = ref[n - 1];
+        n--;
+    }
+    ref[n] = (uint16_t)minute;
+    s_departures++;
+}
+
+static void build_day(void)
+{
+    mbta_schedule_builder_init(&s_builder);
+    srand(7);
+    // Bus 65 both ways, every 15-40 min from 5:30 to 1:00.
+    for (int dir = 0; dir < 2; dir++) {
+        for (int m = 330 + dir * 7; m < 1500; m += 15 + rand() % 25) {
+            add(0, "65", dir, m);
+        }
+    }
+    // Green-C and Green-D alternating, every 6-12 min until 1:30.
+    for (int dir = 0; dir < 2; dir++) {
+        for (int m = 300 + dir * 3; m < 1530; m += 6 + rand() % 7) {
+            add(1, (m % 2) ? "Green-C" : "Green-D", dir, m);
+        }
+    }
+    // Commuter rail: a few trains with a gap longer than a delta holds.
+    static const int trains[] = {360, 420, 480, 800, 1080, 1140, 1260};
+    for (size_t i = 0; i < sizeof(trains) / sizeof(trains[0]); i++) {
+        add(2, "CR-Worcester", 0, trains[i]);
+    }
+    // The same trip listed twice, and one minute shared by two routes.
+    add(0, "65", 0, 330);
+    add(2, "CR-Worcester", 1, 480);
+}
+
+static void check_lookups(const uint8_t *image)
+{
+    long lookups = 0;
+    for (int stop = 0; stop < TEST_STOPS; stop++) {
+        for (int from = 0; from < 1700; from++) {
+            for (int max = 1; max <= 3; max++) {
+                uint16_t got[3];
+                int n = mbta_schedule_departures(image, stop, (uint16_t)from, got, max);
+                uint16_t want[3];
+                int wn = 0;
+                for (int i = 0; i < s_ref_count[stop] && wn < max; i++) {
+                    if (s_ref[stop][i] >= from) {
+                        want[wn++] = s_ref[stop][i];
+                    }
+                }
+                lookups++;
+                if (n != wn || memcmp(got, want, (size_t)n * sizeof(got[0])) != 0) {
+                    if (s_fail++ < 5) {
+                        printf("FAIL stop %d from %d max %d: got %d, want %d departures\n", stop, from, max, n, wn);
+                    }
+                }
+            }
+        }
+    }
+    printf("%ld lookups checked\n", lookups);
+}
+
+static void check_rejects(uint8_t *image, size_t size)
+{
+    if (mbta_schedule_valid(image, size - 1)) {
+        printf("FAIL truncated image accepted\n");
+        s_fail++;
+    }
+    image[size / 2] ^= 1;
+    if (mbta_schedule_valid(image, size)) {
+        printf("FAIL corrupted image accepted\n");
+        s_fail++;
+    }
+    image[size / 2] ^= 1;
+    ((mbta_schedule_header_t *)image)->version++;
+    if (mbta_schedule_valid(image, size)) {
+        printf("FAIL other version accepted\n");
+        s_fail++;
+    }
+    ((mbta_schedule_header_t *)image)->version--;
+    if (!mbta_schedule_valid(image, size)) {
+        printf("FAIL restored image rejected\n");
+        s_fail++;
+    }
+}
+
+// A full day does not fit: the builder says so and encode gives up.
+static void check_overflow(void)
+{
+    mbta_schedule_builder_init(&s_builder);
+    bool full = false;
+    for (int i = 0; i <= MBTA_SCHEDULE_MAX_DEPARTURES && !full; i++) {
+        full = !mbta_schedule_builder_add(&s_builder, 0, "1", 0, (uint16_t)i);
+    }
+    if (!full || !s_builder.overflow) {
+        printf("FAIL builder took more than %d departures\n", MBTA_SCHEDULE_MAX_DEPARTURES);
+        s_fail++;
+    }
+    static uint8_t small[64];
+    if (mbta_schedule_encode(&s_builder, 0, 0, small, sizeof(small)) != 0) {
+        printf("FAIL encoded into a buffer too small\n");
+        s_fail++;
+    }
+}
+
+int main(void)
+{
+    build_day();
+    static uint8_t image[MBTA_SCHEDULE_IMAGE_MAX];
+    size_t size = mbta_schedule_encode(&s_builder, 1792123200, 0xABCD, image, sizeof(image));
+    if (size == 0 || !mbta_schedule_valid(image, size)) {
+        printf("FAIL encode\n");
+        return 1;
+    }
+    const mbta_schedule_header_t *hdr = (const mbta_schedule_header_t *)image;
+    if ((int)hdr->departures != s_departures || hdr->config_hash != 0xABCD || hdr->day_start != 1792123200) {
+        printf("FAIL header: %u departures (want %d)\n", (unsigned)hdr->departures, s_departures);
+        s_fail++;
+    }
+    printf("%d departures in %u series: %zu bytes (%.2f B/departure; %d as raw minutes, %d of %d image bytes)\n",
+           s_departures, (unsigned)hdr->series_count, size, (double)size / s_departures, s_departures * 2,
+           (int)size, MBTA_SCHEDULE_IMAGE_MAX);
+
+    check_lookups(image);
+    check_rejects(image, size);
+
+    struct timespec a, b;
+    volatile int sink = 0;
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (int r = 0; r < 100000; r++) {
+        uint16_t out[3];
+        sink += mbta_schedule_departures(image, r % 3, (uint16_t)(r % 1600), out, 3);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    (void)sink;
+    printf("lookup: %.0f ns\n", ((double)(b.tv_sec - a.tv_sec) * 1e9 + (double)(b.tv_nsec - a.tv_nsec)) / 100000);
+
+    check_overflow();
+    printf("%s\n", s_fail ? "FAIL" : "ok");
+    return s_fail != 0;
+}
@@ -0,0 +1,367 @@
+// The prediction stream end to end: a stand-in SSE server behind
+// HttpConn_Stream replays a reset, then add, update and remove events, in
+// socket-sized pieces through the stream task into mbta_task, each on its
+// own thread as on the device. After every event the published state must
+// hold what the server holds, and its version must move (and the UI be
+// woken) only when the arrivals the UI shows, three per stop, changed. The
+// loader runs until the reset and again once the connection drops.
+//
+// Also reports the event-to-publish latency: from the first byte of the
+// event to mbta_state_t carrying it.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mbta.c"
+
+static int s_fail;
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Fakes for what mbta.c calls.
+uint32_t esp_random(void) { return 0; }
+wireless_status_t Wireless_GetStatus(void) { return WIRELESS_STATUS_CONNECTED; }
+bool TimeSync_Wait(uint32_t timeout_ms) { (void)timeout_ms; return true; }
+bool Snapshot_Load(snapshot_id_t id, void *buf, size_t size) { (void)id; (void)buf; (void)size; return false; }
+void Snapshot_Save(snapshot_id_t id, const void *buf, size_t size) { (void)id; (void)buf; (void)size; }
+esp_err_t NetService_Get(const http_conn_request_t *req, net_prio_t prio, uint32_t deadline_ms,
+                         int *out_http_status)
+{
+    (void)req; (void)prio; (void)deadline_ms; (void)out_http_status;
+    return ESP_FAIL;
+}
+
+// FreeRTOS on threads: a task is a thread, a notification a counter.
+typedef struct {
+    pthread_t thread;
+    void (*fn)(void *);
+    void *arg;
+    pthread_mutex_t mu;
+    pthread_cond_t cv;
+    uint32_t notified;
+} task_t;
+
+static task_t s_tasks[2];
+static int s_task_count;
+static __thread task_t *s_self;
+
+static void deadline(struct timespec *ts, uint32_t ms)
+{
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+static void *task_main(void *arg)
+{
+    s_self = (task_t *)arg;
+    s_self->fn(s_self->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void *), const char *name, uint32_t stack, void *arg,
+                                   int prio, TaskHandle_t *out_handle, int core)
+{
+    (void)name; (void)stack; (void)prio; (void)core;
+    task_t *t = &s_tasks[s_task_count++];
+    t->fn = fn;
+    t->arg = arg;
+    pthread_mutex_init(&t->mu, NULL);
+    pthread_cond_init(&t->cv, NULL);
+    if (out_handle != NULL) {
+        *out_handle = t;
+    }
+    return pthread_create(&t->thread, NULL, task_main, t) == 0 ? pdPASS : pdFALSE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    task_t *t = s_self;
+    struct timespec ts;
+    deadline(&ts, ticks);
+    pthread_mutex_lock(&t->mu);
+    while (t->notified == 0 && pthread_cond_timedwait(&t->cv, &t->mu, &ts) == 0) {
+    }
+    uint32_t n = t->notified;
+    if (n != 0) {
+        t->notified = clear ? 0 : n - 1;
+    }
+    pthread_mutex_unlock(&t->mu);
+    return n;
+}
+
+void xTaskNotifyGive(TaskHandle_t task)
+{
+    task_t *t = (task_t *)task;
+    pthread_mutex_lock(&t->mu);
+    t->notified++;
+    pthread_cond_signal(&t->cv);
+    pthread_mutex_unlock(&t->mu);
+}
+
+void vTaskDelay(TickType_t ticks) { usleep((useconds_t)ticks * 1000); }
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    pthread_mutex_t *mu = malloc(sizeof(*mu));
+    pthread_mutex_init(mu, NULL);
+    return mu;
+}
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) { (void)ticks; return pthread_mutex_lock(sem) == 0; }
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) { return pthread_mutex_unlock(sem) == 0; }
+
+// The UI side: woken on every publish.
+static pthread_mutex_t s_ui_mu = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_ui_cv = PTHREAD_COND_INITIALIZER;
+static uint32_t s_ui_signals;
+static int64_t s_ui_signal_us;
+
+void UiNotify_Signal(void)
+{
+    pthread_mutex_lock(&s_ui_mu);
+    s_ui_signals++;
+    s_ui_signal_us = esp_timer_get_time();
+    pthread_cond_broadcast(&s_ui_cv);
+    pthread_mutex_unlock(&s_ui_mu);
+}
+
+// Wait up to `ms` for a state whose version is not `version`.
+static bool wait_publish(uint32_t version, uint32_t ms, mbta_state_t *out)
+{
+    struct timespec ts;
+    deadline(&ts, ms);
+    pthread_mutex_lock(&s_ui_mu);
+    while (MBTA_GetState(out) && out->version == version &&
+           pthread_cond_timedwait(&s_ui_cv, &s_ui_mu, &ts) == 0) {
+    }
+    bool published = out->version != version;
+    pthread_mutex_unlock(&s_ui_mu);
+    return published;
+}
+
+// The stand-in server: the first connection replays the script, then drops.
+static time_t s_now;
+static struct {
+    const http_conn_request_t *req;
+    int connects;
+    int events;
+    int publishes;
+    int64_t latency_total_us;
+    int64_t latency_max_us;
+    bool dropped;
+} s_server;
+
+static pthread_mutex_t s_done_mu = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_done_cv = PTHREAD_COND_INITIALIZER;
+
+// A prediction resource arriving `min` minutes from the start.
+static const char *prediction(char *buf, size_t size, const char *id, const char *stop, const char *route, int min)
+{
+    char at[32];
+    time_t t = s_now + min * 60;
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(at, sizeof(at), "%Y-%m-%dT%H:%M:%SZ", &tm);
+    snprintf(buf, size,
+             "{\"attributes\":{\"arrival_time\":\"%s\",\"departure_time\":null},\"id\":\"%s\","
+             "\"relationships\":{\"route\":{\"data\":{\"id\":\"%s\",\"type\":\"route\"}},"
+             "\"stop\":{\"data\":{\"id\":\"%s\",\"type\":\"stop\"}}},\"type\":\"prediction\"}",
+             at, id, route, stop);
+    return buf;
+}
+
+static bool stop_shows(const mbta_state_t *st, int stop, const int *mins)
+{
+    const mbta_stop_state_t *s = &st->stops[stop];
+    int n = 0;
+    while (n < 3 && mins[n] != 0) {
+        n++;
+    }
+    if (s->arrival_count != n) {
+        return false;
+    }
+    for (int k = 0; k < n; k++) {
+        if (s->arrivals_epoch[k] != s_now + mins[k] * 60) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Send one event and check what the UI gets. mins0 and mins1: what stops 0
+// and 1 must show afterwards, 0-terminated.
+static void send(const char *what, const char *text, bool want_publish, const int *mins0, const int *mins1)
+{
+    mbta_state_t before, after;
+    MBTA_GetState(&before);
+    uint32_t signals = s_ui_signals;
+    uint32_t stream_publishes = s_stream_stats.publishes;
+
+    int64_t start_us = esp_timer_get_time();
+    size_t len = strlen(text);
+    for (size_t off = 0; off < len; off += 64) {
+        if (!s_server.req->on_body(text + off, len - off < 64 ? len - off : 64, s_server.req->ctx)) {
+            printf("FAIL %s: the stream refused the event\n", what);
+            s_fail++;
+            return;
+        }
+    }
+    s_server.events++;
+
+    // Nothing is due: a publish within 50 ms was triggered by the event.
+    bool published = wait_publish(before.version, want_publish ? 1000 : 50, &after);
+    if (published) {
+        int64_t latency_us = s_ui_signal_us - start_us;
+        s_server.publishes++;
+        s_server.latency_total_us += latency_us;
+        if (latency_us > s_server.latency_max_us) {
+            s_server.latency_max_us = latency_us;
+        }
+        // mbta_task counts it (in its own latency stats) right after.
+        for (int i = 0; i < 100 && s_stream_stats.publishes == stream_publishes; i++) {
+            usleep(1000);
+        }
+        if (s_stream_stats.publishes != stream_publishes + 1) {
+            printf("FAIL %s: %u stream publishes counted\n", what,
+                   (unsigned)(s_stream_stats.publishes - stream_publishes));
+            s_fail++;
+        }
+    } else if (s_ui_signals != signals || s_stream_stats.publishes != stream_publishes) {
+        printf("FAIL %s: UI woken for an unchanged state\n", what);
+        s_fail++;
+    }
+    if (published != want_publish || !stop_shows(&after, 0, mins0) || !stop_shows(&after, 1, mins1) ||
+        after.is_fetching) {
+        printf("FAIL %s: published=%d (want %d), stops show %d and %d arrivals, fetching=%d\n", what, published,
+               want_publish, after.stops[0].arrival_count, after.stops[1].arrival_count, after.is_fetching);
+        s_fail++;
+    }
+}
+
+static void replay(void)
+{
+    char a[512], b[512], c[512], d[512], e[512], f[512], ev[4096];
+
+    // mbta_task enables the stream before publishing its first state.
+    mbta_state_t st;
+    for (int i = 0; i < 1000 && (!MBTA_GetState(&st) || !st.is_fetching); i++) {
+        usleep(1000);
+    }
+    if (!st.is_fetching) {
+        printf("FAIL no loader while connecting\n");
+        s_fail++;
+    }
+
+    // Stop 0 watches bus 65 at 1295, stop 1 any route at 70176.
+    snprintf(ev, sizeof(ev), "event: reset\ndata: [%s,%s,%s,%s,%s]\n\n",
+             prediction(a, sizeof(a), "p1", "1295", "65", 5),
+             prediction(b, sizeof(b), "p2", "1295", "65", 12),
+             prediction(c, sizeof(c), "p3", "70176", "Green-C", 7),
+             prediction(d, sizeof(d), "p4", "99999", "65", 1),
+             prediction(e, sizeof(e), "p5", "1295", "60", 3));
+    send("reset", ev, true, (int[]){5, 12, 0}, (int[]){7, 0});
+
+    snprintf(ev, sizeof(ev), "event: update\ndata: %s\n\n", prediction(a, sizeof(a), "p2", "1295", "65", 12));
+    send("same time", ev, false, (int[]){5, 12, 0}, (int[]){7, 0});
+
+    snprintf(ev, sizeof(ev), "event: update\ndata: %s\n\n", prediction(a, sizeof(a), "p1", "1295", "65", 4));
+    send("earlier", ev, true, (int[]){4, 12, 0}, (int[]){7, 0});
+
+    snprintf(ev, sizeof(ev), "event: add\ndata: %s\n\n", prediction(a, sizeof(a), "p6", "1295", "60", 2));
+    send("other route", ev, false, (int[]){4, 12, 0}, (int[]){7, 0});
+
+    snprintf(ev, sizeof(ev), "event: add\ndata: %s\n\n", prediction(a, sizeof(a), "p7", "1295", "65", 20));
+    send("third", ev, true, (int[]){4, 12, 20, 0}, (int[]){7, 0});
+
+    snprintf(ev, sizeof(ev), "event: add\ndata: %s\n\n", prediction(a, sizeof(a), "p8", "1295", "65", 25));
+    send("fourth", ev, false, (int[]){4, 12, 20, 0}, (int[]){7, 0});
+
+    snprintf(ev, sizeof(ev), "event: update\ndata: %s\n\n", prediction(a, sizeof(a), "p8", "1295", "65", 26));
+    send("fourth moves", ev, false, (int[]){4, 12, 20, 0}, (int[]){7, 0});
+
+    send("unwatched removed", "event: remove\ndata: {\"id\":\"p4\",\"type\":\"prediction\"}\n\n", false,
+         (int[]){4, 12, 20, 0}, (int[]){7, 0});
+    send("keep-alive", ": keep-alive\n\n", false, (int[]){4, 12, 20, 0}, (int[]){7, 0});
+
+    send("first removed", "event: remove\ndata: {\"id\":\"p1\",\"type\":\"prediction\"}\n\n", true,
+         (int[]){12, 20, 26, 0}, (int[]){7, 0});
+
+    snprintf(ev, sizeof(ev), "event: update\ndata: %s\n\n", prediction(a, sizeof(a), "p3", "70175", "Green-C", 7));
+    send("moved away", ev, true, (int[]){12, 20, 26, 0}, (int[]){0});
+
+    snprintf(ev, sizeof(ev), "event: add\ndata: %s\n\n", prediction(a, sizeof(a), "p9", "70176", "Red", 9));
+    send("other stop", ev, true, (int[]){12, 20, 26, 0}, (int[]){9, 0});
+
+    // What the server would send on a reconnect: the same set again.
+    snprintf(ev, sizeof(ev), "event: reset\ndata: [%s,%s,%s,%s,%s,%s]\n\n",
+             prediction(a, sizeof(a), "p2", "1295", "65", 12),
+             prediction(b, sizeof(b), "p5", "1295", "60", 3),
+             prediction(c, sizeof(c), "p6", "1295", "60", 2),
+             prediction(d, sizeof(d), "p7", "1295", "65", 20),
+             prediction(e, sizeof(e), "p8", "1295", "65", 26),
+             prediction(f, sizeof(f), "p9", "70176", "Red", 9));
+    send("same reset", ev, false, (int[]){12, 20, 26, 0}, (int[]){9, 0});
+}
+
+esp_err_t HttpConn_Stream(const http_conn_request_t *req, int *out_http_status)
+{
+    if (++s_server.connects > 1) {
+        // The test is over; stay connected with nothing to say.
+        pthread_mutex_lock(&s_done_mu);
+        s_server.dropped = true;
+        pthread_cond_signal(&s_done_cv);
+        pthread_mutex_unlock(&s_done_mu);
+        while (1) {
+            pause();
+        }
+    }
+    if (req->extra_headers == NULL || strstr(req->extra_headers, "Accept: text/event-stream\r\n") == NULL) {
+        printf("FAIL stream opened without Accept: text/event-stream\n");
+        s_fail++;
+    }
+    *out_http_status = 200;
+    s_server.req = req;
+    replay();
+    return ESP_ERR_INVALID_RESPONSE; // the server closed the connection
+}
+
+int main(void)
+{
+    s_now = time(NULL);
+    MBTA_TaskStart();
+
+    pthread_mutex_lock(&s_done_mu);
+    struct timespec ts;
+    deadline(&ts, 20 * 1000);
+    while (!s_server.dropped && pthread_cond_timedwait(&s_done_cv, &s_done_mu, &ts) == 0) {
+    }
+    pthread_mutex_unlock(&s_done_mu);
+    if (!s_server.dropped) {
+        printf("FAIL the stream never reconnected (%d events sent)\n", s_server.events);
+        return 1;
+    }
+
+    // Dropped: the stops are no longer live and the loader runs again.
+    mbta_state_t st;
+    MBTA_GetState(&st);
+    if (!st.is_fetching || st.stops[0].arrival_count != 0) {
+        printf("FAIL after the drop: fetching=%d, %d arrivals\n", st.is_fetching, st.stops[0].arrival_count);
+        s_fail++;
+    }
+
+    printf("%d events, %d publishes, event to publish avg %lldus max %lldus: %s\n", s_server.events,
+           s_server.publishes, (long long)(s_server.publishes ? s_server.latency_total_us / s_server.publishes : 0),
+           (long long)s_server.latency_max_us, s_fail ? "FAIL" : "ok");
+    return s_fail != 0;
+}
@@ -0,0 +1,197 @@
+// The prediction stream: one SSE connection for several stops, split per
+// stop on relationships.stop / relationships.route. Events are fed to the
+// SSE parser in small pieces, as the socket would. Also checks that a full
+// table makes room in the past, then at the far end, and never drops an
+// arrival earlier than the ones it keeps.
+
+#include "mbta_stream.c"
+
+#include <stdio.h>
+
+static int s_fail;
+static int s_notified;
+static time_t s_now;
+
+int64_t esp_timer_get_time(void) { return 1; }
+wireless_status_t Wireless_GetStatus(void) { return WIRELESS_STATUS_CONNECTED; }
+SemaphoreHandle_t xSemaphoreCreateMutex(void) { return (SemaphoreHandle_t)1; }
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) { (void)sem; (void)ticks; return pdTRUE; }
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) { (void)sem; return pdTRUE; }
+void vTaskDelay(TickType_t ticks) { (void)ticks; }
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void *), const char *name, uint32_t stack, void *arg,
+                                   int prio, TaskHandle_t *out_handle, int core)
+{
+    (void)fn; (void)name; (void)stack; (void)arg; (void)prio; (void)out_handle; (void)core;
+    return pdPASS;
+}
+esp_err_t HttpConn_Stream(const http_conn_request_t *req, int *out_http_status)
+{
+    (void)req;
+    *out_http_status = 0;
+    return ESP_FAIL;
+}
+
+static void on_changed(uint32_t event_us, void *ctx)
+{
+    (void)event_us;
+    (void)ctx;
+    s_notified++;
+}
+
+static void feed(const char *text)
+{
+    // 7-byte reads split lines, field names and JSON tokens.
+    size_t len = strlen(text);
+    for (size_t off = 0; off < len; off += 7) {
+        size_t n = len - off < 7 ? len - off : 7;
+        if (!sse_feed(&s_stream, text + off, n)) {
+            printf("FAIL sse_feed rejected input\n");
+            s_fail++;
+            return;
+        }
+    }
+}
+
+// A prediction resource arriving `min` minutes from now.
+static const char *prediction(char *buf, size_t size, const char *id, const char *stop, const char *route, int min)
+{
+    char at[32];
+    time_t t = s_now + min * 60;
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(at, sizeof(at), "%Y-%m-%dT%H:%M:%SZ", &tm);
+    snprintf(buf, size,
+             "{\"attributes\":{\"arrival_time\":\"%s\",\"departure_time\":null},\"id\":\"%s\","
+             "\"relationships\":{\"route\":{\"data\":{\"id\":\"%s\",\"type\":\"route\"}},"
+             "\"stop\":{\"data\":{\"id\":\"%s\",\"type\":\"stop\"}},"
+             "\"trip\":{\"data\":{\"id\":\"t-%s\",\"type\":\"trip\"}}},\"type\":\"prediction\"}",
+             at, id, route, stop, id);
+    return buf;
+}
+
+static void expect(const char *what, int slot, const int *mins, int count)
+{
+    time_t epochs[MBTA_STREAM_HEAD_MAX];
+    int n = -1;
+    bool live = MBTA_StreamGetEpochs(slot, epochs, MBTA_STREAM_HEAD_MAX, &n);
+    bool ok = live && n == count;
+    for (int i = 0; ok && i < count; i++) {
+        ok = epochs[i] == s_now + mins[i] * 60;
+    }
+    if (!ok) {
+        printf("FAIL %s: slot %d live=%d count=%d (want %d)\n", what, slot, live, n, count);
+        s_fail++;
+    }
+}
+
+static bool table_has(time_t epoch)
+{
+    for (int i = 0; i < s_stream.count; i++) {
+        if (s_stream.table[i].epoch == epoch) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void check_full_table(void)
+{
+    mbta_stream_t *s = &s_stream;
+    const time_t minute = 60;
+    for (int i = 0; i < MBTA_STREAM_TABLE_SIZE; i++) {
+        table_upsert(s, 1000 + i, 1u << 1, s_now + (30 + i) * minute);
+    }
+    time_t latest = s_now + (30 + MBTA_STREAM_TABLE_SIZE - 1) * minute;
+
+    // Later than everything kept: dropped.
+    table_upsert(s, 2000, 1u << 1, latest + minute);
+    // Earlier: replaces the latest.
+    table_upsert(s, 2001, 1u << 1, s_now + 2 * minute);
+    if (s->count != MBTA_STREAM_TABLE_SIZE || table_has(latest + minute) || table_has(latest) ||
+        !table_has(s_now + 2 * minute)) {
+        printf("FAIL full table: an earlier arrival did not replace the latest\n");
+        s_fail++;
+    }
+
+    // One already departed: it makes room, even for a later arrival.
+    table_upsert(s, 1000, 1u << 1, s_now - 5 * minute);
+    table_upsert(s, 2002, 1u << 1, latest + minute);
+    if (s->count != MBTA_STREAM_TABLE_SIZE || table_has(s_now - 5 * minute) || !table_has(latest + minute) ||
+        !table_has(s_now + 2 * minute)) {
+        printf("FAIL full table: the departed entry was not the one replaced\n");
+        s_fail++;
+    }
+
+    s->got_reset = true;
+    stream_publish(s);
+    expect("full table", 1, (int[]){2, 31, 32, 33, 34, 35, 36, 37}, MBTA_STREAM_HEAD_MAX);
+}
+
+int main(void)
+{
+    static const mbta_stream_slot_t slots[] = {
+        {"1295", "65"},  // bus 65 only
+        {"70176", ""},   // any route
+        {"1295", ""},    // same stop, any route
+    };
+    s_now = time(NULL);
+    if (!MBTA_StreamStart("stream", slots, 3, on_changed, NULL)) {
+        printf("FAIL start\n");
+        return 1;
+    }
+    s_enabled = true;
+    stream_restart(&s_stream);
+
+    char a[512], b[512], c[512], d[512], ev[2560];
+    snprintf(ev, sizeof(ev), "event: reset\ndata: [%s,%s,%s,%s,{\"id\":\"t-p1\",\"type\":\"trip\"}]\n\n",
+             prediction(a, sizeof(a), "p1", "1295", "65", 5),
+             prediction(b, sizeof(b), "p2", "1295", "60", 3),
+             prediction(c, sizeof(c), "p3", "70176", "Green-C", 7),
+             prediction(d, sizeof(d), "p4", "99999", "65", 1));
+    feed(": keep-alive\n");
+    feed(ev);
+    expect("reset", 0, (int[]){5}, 1);
+    expect("reset", 1, (int[]){7}, 1);
+    expect("reset", 2, (int[]){3, 5}, 2);
+    int notified = s_notified;
+
+    // A route-60 bus moves up: only the any-route slot of its stop changes.
+    snprintf(ev, sizeof(ev), "event: update\ndata: %s\n\n", prediction(a, sizeof(a), "p2", "1295", "60", 2));
+    feed(ev);
+    expect("update", 0, (int[]){5}, 1);
+    expect("update", 2, (int[]){2, 5}, 2);
+
+    snprintf(ev, sizeof(ev), "event: add\r\ndata: %s\r\n\r\n", prediction(a, sizeof(a), "p5", "70176", "Green-C", 4));
+    feed(ev);
+    expect("add", 1, (int[]){4, 7}, 2);
+
+    // `remove` only carries the id.
+    feed("event: remove\ndata: {\"id\":\"p1\",\"type\":\"prediction\"}\n\n");
+    expect("remove", 0, NULL, 0);
+    expect("remove", 2, (int[]){2}, 1);
+
+    // An update that moves a prediction to an unwatched stop drops it.
+    snprintf(ev, sizeof(ev), "event: update\ndata: %s\n\n", prediction(a, sizeof(a), "p3", "70175", "Green-C", 7));
+    feed(ev);
+    expect("moved away", 1, (int[]){4}, 1);
+
+    if (s_notified - notified != 4) {
+        printf("FAIL %d notifications for 4 changes\n", s_notified - notified);
+        s_fail++;
+    }
+
+    // An event that changes nothing shown does not notify.
+    notified = s_notified;
+    feed("event: remove\ndata: {\"id\":\"p404\",\"type\":\"prediction\"}\n\n");
+    if (s_notified != notified) {
+        printf("FAIL no-op event notified\n");
+        s_fail++;
+    }
+
+    stream_restart(&s_stream);
+    check_full_table();
+
+    printf("%d stops on one stream, %zu table entries: %s\n", 3, (size_t)MBTA_STREAM_TABLE_SIZE,
+           s_fail ? "FAIL" : "ok");
+    return s_fail != 0;
+}
@@ -0,0 +1,123 @@
+// seqlock under contention: one writer thread publishes a state the size of
+// mbta_state_t, filled with its publish number, while reader threads copy
+// it as fast as they can. A read is torn if its words disagree; versions
+// must match the content and never go backwards.
+//
+// With -n the readers also copy the latest buffer without the sequence
+// check, to show the test can see tearing at all on this machine.
+
+#include "seqlock.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#define WORDS     334 // ~1.3 KB, like mbta_state_t
+#define PUBLISHES 2000000
+#define READERS   4
+
+typedef struct {
+    uint32_t v[WORDS];
+} state_t;
+
+static state_t s_bufs[2];
+static seqlock_t s_sl;
+static atomic_bool s_done;
+static bool s_naive;
+
+typedef struct {
+    long reads;
+    long unchanged;
+    long torn;
+    long naive_torn;
+    long bad_version;
+} reader_stats_t;
+
+static void *writer(void *arg)
+{
+    (void)arg;
+    for (uint32_t i = 1; i <= PUBLISHES; i++) {
+        state_t *w = seqlock_write_begin(&s_sl);
+        for (int k = 0; k < WORDS; k++) {
+            w->v[k] = i;
+        }
+        seqlock_write_end(&s_sl);
+    }
+    atomic_store(&s_done, true);
+    return NULL;
+}
+
+static bool torn(const state_t *s)
+{
+    for (int k = 1; k < WORDS; k++) {
+        if (s->v[k] != s->v[0]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void *reader(void *arg)
+{
+    reader_stats_t *st = (reader_stats_t *)arg;
+    state_t s;
+    uint32_t seen = 0;
+    uint32_t last = 0;
+    int n = 0;
+    while (!atomic_load(&s_done)) {
+        if (s_naive) {
+            unsigned seq = atomic_load(&s_sl.seq);
+            memcpy(&s, s_sl.buf[(seq >> 1) & 1], sizeof(s));
+            st->naive_torn += torn(&s);
+        }
+
+        // Mostly the UI's pattern, every 4th read unconditional.
+        if (++n % 4 == 0) {
+            seen = seqlock_read(&s_sl, &s);
+        } else if (!seqlock_read_if_changed(&s_sl, &s, &seen)) {
+            st->unchanged++;
+            continue;
+        }
+        st->reads++;
+        st->torn += torn(&s);
+        st->bad_version += s.v[0] != seen || s.v[0] < last;
+        last = s.v[0];
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    s_naive = argc > 1 && strcmp(argv[1], "-n") == 0;
+    seqlock_init(&s_sl, s_bufs, sizeof(state_t));
+
+    pthread_t w, r[READERS];
+    reader_stats_t stats[READERS] = {0};
+    for (int i = 0; i < READERS; i++) {
+        pthread_create(&r[i], NULL, reader, &stats[i]);
+    }
+    pthread_create(&w, NULL, writer, NULL);
+    pthread_join(w, NULL);
+
+    reader_stats_t total = {0};
+    for (int i = 0; i < READERS; i++) {
+        pthread_join(r[i], NULL);
+        total.reads += stats[i].reads;
+        total.unchanged += stats[i].unchanged;
+        total.torn += stats[i].torn;
+        total.naive_torn += stats[i].naive_torn;
+        total.bad_version += stats[i].bad_version;
+    }
+
+    state_t s;
+    uint32_t version = seqlock_read(&s_sl, &s);
+    printf("%d publishes, %d readers: %ld reads (%ld unchanged skipped), %ld torn, %ld bad versions\n", PUBLISHES,
+           READERS, total.reads, total.unchanged, total.torn, total.bad_version);
+    if (s_naive) {
+        printf("without the sequence check: %ld torn\n", total.naive_torn);
+    }
+    bool ok = total.reads > 0 && total.torn == 0 && total.bad_version == 0 && version == PUBLISHES &&
+              s.v[0] == PUBLISHES && !torn(&s);
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return !ok;
+}
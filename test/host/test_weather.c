@@ -0,0 +1,96 @@
+// The weather fetch end to end, minus the network: Weather_TaskStart()
+// queues a job, and each step runs it with an Open-Meteo body fed in
+// 11-byte pieces, then checks what was published.
+
+#include "weather.c"
+
+#include <stdio.h>
+
+static int s_fail;
+static net_job_t s_job;
+static int s_queued;
+
+// Fakes for what weather.c calls.
+bool NetService_Submit(const net_job_t *job)
+{
+    s_job = *job;
+    s_queued++;
+    return true;
+}
+bool Snapshot_Load(snapshot_id_t id, void *buf, size_t size) { (void)id; (void)buf; (void)size; return false; }
+void Snapshot_Save(snapshot_id_t id, const void *buf, size_t size) { (void)id; (void)buf; (void)size; }
+void UiNotify_Signal(void) {}
+
+// The response to the URL Weather_TaskStart() builds, as Open-Meteo sends it.
+#define BODY(temp, code, precip, rain, snow, maxes, mins)                                                     \
+    "{\"latitude\":42.34,\"longitude\":-71.14,\"generationtime_ms\":0.05,\"utc_offset_seconds\":-14400,"      \
+    "\"timezone\":\"America/New_York\",\"timezone_abbreviation\":\"GMT-4\",\"elevation\":46.0,"               \
+    "\"current_units\":{\"time\":\"iso8601\",\"interval\":\"seconds\",\"temperature_2m\":\"\\u00b0C\","       \
+    "\"weather_code\":\"wmo code\",\"precipitation\":\"mm\",\"rain\":\"mm\",\"snowfall\":\"cm\"},"            \
+    "\"current\":{\"time\":\"2026-10-16T08:00\",\"interval\":900,\"temperature_2m\":" temp ","              \
+    "\"weather_code\":" code ",\"precipitation\":" precip ",\"rain\":" rain ",\"snowfall\":" snow "},"      \
+    "\"daily_units\":{\"time\":\"iso8601\",\"temperature_2m_max\":\"\\u00b0C\","                              \
+    "\"temperature_2m_min\":\"\\u00b0C\"},"                                                                    \
+    "\"daily\":{\"time\":[\"2026-10-16\",\"2026-10-17\"],\"temperature_2m_max\":" maxes ","                  \
+    "\"temperature_2m_min\":" mins "}}"
+
+static void run(const char *what, const char *body, esp_err_t err, int http_status, bool want_data, int temp,
+                int high, int low, const char *condition)
+{
+    int queued = s_queued;
+    net_job_t job = s_job;
+    job.on_start(job.req.ctx);
+    size_t len = strlen(body);
+    for (size_t off = 0; off < len; off += 11) {
+        if (!job.req.on_body(body + off, len - off < 11 ? len - off : 11, job.req.ctx)) {
+            err = ESP_ERR_INVALID_RESPONSE;
+            break;
+        }
+    }
+    job.on_done(err, http_status, job.req.ctx);
+
+    weather_state_t st;
+    if (!Weather_GetState(&st) || st.has_data != want_data || st.is_fetching ||
+        (want_data && (st.temp_c != temp || st.high_c != high || st.low_c != low)) ||
+        strcmp(st.condition, condition) != 0) {
+        printf("FAIL %s: has_data=%d %d/%d/%d '%s'\n", what, st.has_data, st.temp_c, st.high_c, st.low_c,
+               st.condition);
+        s_fail++;
+    }
+    if (s_queued != queued + 1 || s_job.delay_ms != WEATHER_FETCH_PERIOD_MS) {
+        printf("FAIL %s: next fetch not queued\n", what);
+        s_fail++;
+    }
+}
+
+int main(void)
+{
+    Weather_TaskStart();
+    if (s_queued != 1 || strstr(s_url, "latitude=42.342110") == NULL) {
+        printf("FAIL first fetch: %s\n", s_url);
+        return 1;
+    }
+
+    run("cloudy", BODY("12.6", "3", "0.0", "0.0", "0.0", "[15.4,17.0]", "[8.5,9.9]"), ESP_OK, 200,
+        true, 13, 15, 9, "Cloudy");
+    run("negative", BODY("-3.5", "0", "0.0", "0.0", "0.0", "[-1.2,2.0]", "[-7.6,-3.0]"), ESP_OK, 200,
+        true, -4, -1, -8, "Clear");
+    run("raining", BODY("9.0", "61", "0.4", "0.4", "0.0", "[10,11]", "[5,6]"), ESP_OK, 200,
+        true, 9, 10, 5, "Raining");
+    run("snowing", BODY("-1e0", "71", "0.3", "0.0", "0.21", "[0.4,1]", "[-5,-6]"), ESP_OK, 200,
+        true, -1, 0, -5, "Snowing");
+    run("fog code", BODY("4", "45", "0", "0", "0", "[5]", "[2]"), ESP_OK, 200, true, 4, 5, 2, "Fog");
+
+    // Today's high missing: no data, however many later days there are.
+    run("null high", BODY("12", "3", "0", "0", "0", "[null,17]", "[8,9]"), ESP_OK, 200, false, 0, 0, 0, "No data");
+    run("no current", "{\"daily\":{\"temperature_2m_max\":[1],\"temperature_2m_min\":[0]}}", ESP_OK, 200,
+        false, 0, 0, 0, "No data");
+    run("truncated", "{\"current\":{\"temperature_2m\":12.6,\"weather_code\":3},\"daily\":{\"temperature_2m_max\":[15",
+        ESP_OK, 200, false, 0, 0, 0, "No data");
+    run("not json", "<html>502 Bad Gateway</html>", ESP_OK, 502, false, 0, 0, 0, "No data");
+    run("after failures", BODY("20.4", "95", "0", "0", "0", "[22]", "[14]"), ESP_OK, 200,
+        true, 20, 22, 14, "Storm");
+
+    printf("%d fetches: %s\n", s_queued - 1, s_fail ? "FAIL" : "ok");
+    return s_fail != 0;
+}
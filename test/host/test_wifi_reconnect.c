@@ -0,0 +1,117 @@
+// The WiFi reconnect policy driven by a mocked event source: an AP that
+// connects, drops, stays down for a long while, hangs an attempt without
+// an IP, then comes back. Checks the backoff growth and its cap, the
+// cached-AP attempts and the fallback to a scan after
+// WIFI_RC_CACHED_TRIES, the attempt timeout, and the reset on an IP.
+
+#include "wifi_reconnect.h"
+
+#include <stdio.h>
+
+static int s_fail;
+static int s_checks;
+
+static void expect(bool ok, const char *what)
+{
+    s_checks++;
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        s_fail++;
+    }
+}
+
+// Nominal backoff after `failures` in a row, before jitter.
+static uint32_t nominal_ms(uint32_t failures)
+{
+    uint64_t ms = (uint64_t)WIFI_RC_BACKOFF_BASE_MS << (failures - 1 < 20 ? failures - 1 : 20);
+    return ms < WIFI_RC_BACKOFF_MAX_MS ? (uint32_t)ms : WIFI_RC_BACKOFF_MAX_MS;
+}
+
+int main(void)
+{
+    wifi_rc_t rc;
+    int64_t t = 0;
+    wifi_rc_init(&rc, true, 1234);
+
+    wifi_rc_action_t a = wifi_rc_on_start(&rc, t);
+    expect(a.act == WIFI_RC_ACT_CONNECT && a.use_cached && a.delay_ms == WIFI_RC_ATTEMPT_TIMEOUT_MS,
+           "start: cached attempt with the attempt timeout");
+    t += 800;
+    expect(wifi_rc_on_got_ip(&rc, t) == 800 && rc.state == WIFI_RC_CONNECTED, "got_ip: latency");
+
+    // The router reboots: the link drops and the same AP is tried at once.
+    t += 100000;
+    a = wifi_rc_on_disconnected(&rc, t);
+    expect(a.act == WIFI_RC_ACT_CONNECT && a.use_cached && !a.disconnect, "link drop: cached attempt at once");
+
+    // It stays down for 40 attempts.
+    int cached = 1;
+    bool capped = false;
+    for (uint32_t n = 1; n <= 40; n++) {
+        t += 50;
+        a = wifi_rc_on_disconnected(&rc, t);
+        uint32_t nominal = nominal_ms(n);
+        if (a.act != WIFI_RC_ACT_WAIT || a.delay_ms < nominal - nominal / 4 || a.delay_ms > nominal + nominal / 4) {
+            printf("FAIL failure %u: act %d, %ums (nominal %ums)\n", (unsigned)n, (int)a.act, (unsigned)a.delay_ms,
+                   (unsigned)nominal);
+            s_fail++;
+        }
+        capped |= nominal == WIFI_RC_BACKOFF_MAX_MS;
+        expect(wifi_rc_is_failing(&rc) == (n >= WIFI_RC_FAILING_AFTER), "failing from WIFI_RC_FAILING_AFTER");
+        // The tail of the failed attempt arrives during the backoff.
+        expect(wifi_rc_on_disconnected(&rc, t).act == WIFI_RC_ACT_NONE, "disconnect during backoff ignored");
+
+        t += a.delay_ms;
+        a = wifi_rc_on_timer(&rc, t);
+        expect(a.act == WIFI_RC_ACT_CONNECT, "backoff elapsed: attempt");
+        cached += a.use_cached;
+    }
+    expect(capped, "backoff reaches WIFI_RC_BACKOFF_MAX_MS");
+    expect(cached == WIFI_RC_CACHED_TRIES, "cached AP dropped after WIFI_RC_CACHED_TRIES");
+
+    // An attempt that associates but never gets an IP times out.
+    expect(wifi_rc_on_timer(&rc, t + WIFI_RC_ATTEMPT_TIMEOUT_MS - 1).act == WIFI_RC_ACT_NONE,
+           "no timeout before WIFI_RC_ATTEMPT_TIMEOUT_MS");
+    t += WIFI_RC_ATTEMPT_TIMEOUT_MS;
+    a = wifi_rc_on_timer(&rc, t);
+    expect(a.act == WIFI_RC_ACT_WAIT && a.disconnect && a.delay_ms >= WIFI_RC_BACKOFF_MAX_MS * 3 / 4,
+           "attempt timeout: abort and back off at the cap");
+    // The abort's own disconnect event changes nothing.
+    expect(wifi_rc_on_disconnected(&rc, t + 10).act == WIFI_RC_ACT_NONE, "abort's disconnect ignored");
+
+    // The AP is back.
+    t += a.delay_ms;
+    a = wifi_rc_on_timer(&rc, t);
+    expect(a.act == WIFI_RC_ACT_CONNECT && !a.use_cached, "retry after the timeout scans");
+    t += 3000;
+    expect(wifi_rc_on_got_ip(&rc, t) == 3000 && rc.failures == 0 && !wifi_rc_is_failing(&rc),
+           "got_ip resets the failures");
+
+    // A success gives the cached AP its tries back, and the backoff starts over.
+    a = wifi_rc_on_disconnected(&rc, t + 10);
+    expect(a.act == WIFI_RC_ACT_CONNECT && a.use_cached, "cached AP again after a success");
+    a = wifi_rc_on_disconnected(&rc, t + 20);
+    expect(a.act == WIFI_RC_ACT_WAIT && a.delay_ms <= WIFI_RC_BACKOFF_BASE_MS * 5 / 4, "backoff starts over");
+
+    // The cache went away (invalid on load): scans only.
+    wifi_rc_set_cache(&rc, false);
+    a = wifi_rc_on_timer(&rc, t + 1000);
+    expect(a.act == WIFI_RC_ACT_CONNECT && !a.use_cached, "no cache: scan");
+    wifi_rc_init(&rc, false, 0);
+    expect(!wifi_rc_on_start(&rc, 0).use_cached, "no cache at start: scan");
+
+    // Displays that lost the same AP do not retry in step.
+    wifi_rc_t x, y;
+    wifi_rc_init(&x, false, 1);
+    wifi_rc_init(&y, false, 2);
+    int same = 0;
+    for (int i = 0; i < 8; i++) {
+        wifi_rc_on_start(&x, 0);
+        wifi_rc_on_start(&y, 0);
+        same += wifi_rc_on_disconnected(&x, 0).delay_ms == wifi_rc_on_disconnected(&y, 0).delay_ms;
+    }
+    expect(same < 2, "jitter differs between seeds");
+
+    printf("%d checks: %s\n", s_checks, s_fail ? "FAIL" : "ok");
+    return s_fail != 0;
+}